@@ -0,0 +1,97 @@
+// clustered point lights, shared by the forward and the deferred lighting shaders
+// the scene wide lighting data is bound as set 1 (see `LightClusters`)
+// light 0 casts shadows, so `shadows.glsl` has to be included before this
+
+// has to match `MAX_LIGHTS_PER_CLUSTER` in `lightClusters.h`
+#define MAX_LIGHTS_PER_CLUSTER 256
+
+struct PointLight
+{
+	vec4 position; // xyz = world space position, w = radius
+	vec4 color; // rgb = color, a = intensity
+};
+
+layout(set = 1, binding = 0) uniform ClusterUniformBuffer
+{
+	mat4 viewMat;
+	mat4 invProjMat;
+	uvec4 gridSize; // xyz = cluster grid dimensions, w = light count
+	vec4 screenParams; // xy = framebuffer size, z = near plane, w = far plane of the last slice
+}
+clusterUbo;
+layout(std430, set = 1, binding = 1) readonly buffer LightBuffer
+{
+	PointLight lights[];
+};
+layout(std430, set = 1, binding = 2) readonly buffer LightCountBuffer
+{
+	uint lightCounts[];
+};
+layout(std430, set = 1, binding = 3) readonly buffer LightIndexBuffer
+{
+	uint lightIndices[];
+};
+
+uint GetClusterIndex(vec3 fragPos, vec2 fragCoord)
+{
+	uvec3 grid = clusterUbo.gridSize.xyz;
+	float zNear = clusterUbo.screenParams.z;
+	float zFar = clusterUbo.screenParams.w;
+
+	// the depth slices are exponentially spaced
+	float viewDepth = -(clusterUbo.viewMat * vec4(fragPos, 1.0)).z;
+	float slice = log(viewDepth / zNear) / log(zFar / zNear) * float(grid.z);
+
+	uvec3 cluster;
+	cluster.xy = uvec2(fragCoord / (clusterUbo.screenParams.xy / vec2(grid.xy)));
+	cluster.z = uint(max(slice, 0.0));
+	cluster = min(cluster, grid - 1);
+
+	return cluster.x + cluster.y * grid.x + cluster.z * grid.x * grid.y;
+}
+
+// diffuse and specular (blinn-phong) light of the lights in the fragment's cluster, see `DirectionalLighting()`
+vec3 ClusteredLighting(vec3 fragPos,
+	vec2 fragCoord,
+	vec3 norm,
+	vec3 viewDir,
+	vec3 diffuseColor,
+	vec3 specularColor,
+	float shininess)
+{
+	float diffuseStrength = 0.8;
+
+	vec3 diffuseLight = vec3(0.0);
+	vec3 specularLight = vec3(0.0);
+
+	// only the lights assigned to the fragment's cluster are evaluated
+	uint clusterIdx = GetClusterIndex(fragPos, fragCoord);
+	uint lightCount = lightCounts[clusterIdx];
+	for (uint i = 0; i < lightCount; ++i)
+	{
+		uint lightIdx = lightIndices[clusterIdx * MAX_LIGHTS_PER_CLUSTER + i];
+		PointLight light = lights[lightIdx];
+		vec3 lightColor = light.color.rgb * light.color.a;
+
+		vec3 lightVec = light.position.xyz - fragPos;
+		float dist = length(lightVec);
+		// smooth window so that the light's contribution reaches zero at its radius
+		float attenuation = clamp(1.0 - pow(dist / light.position.w, 4.0), 0.0, 1.0);
+		attenuation *= attenuation;
+		if (attenuation <= 0.0)
+			continue;
+		// only the orbiting light has a shadow map
+		if (lightIdx == 0)
+			attenuation *= PointShadow(fragPos);
+
+		// diffuse light
+		vec3 lightDir = lightVec / dist;
+		diffuseLight += attenuation * diffuseStrength * max(dot(lightDir, norm), 0.0) * lightColor * diffuseColor;
+
+		// spcular light
+		vec3 halfwayDir = normalize(lightDir + viewDir);
+		specularLight += attenuation * pow(max(dot(norm, halfwayDir), 0.0), shininess) * lightColor * specularColor;
+	}
+
+	return diffuseLight + specularLight;
+}
@@ -0,0 +1,53 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+
+#include "shadows.glsl"
+#include "clusteredLighting.glsl"
+
+layout(binding = 0) uniform DeferredLightingUniformBuffer
+{
+	mat4 invViewProjMat;
+	vec4 viewPos;
+}
+ubo;
+// 0 = normal, 1 = albedo, 2 = specular, 3 = depth
+layout(binding = 1) uniform sampler2D gBuffer[4];
+
+layout(location = 0) out vec4 outColor;
+
+// has to match `materials.glsl`, the specular attachment stores the shininess divided by it
+#define MAX_SHININESS 256.0
+
+void main()
+{
+	vec2 uv = gl_FragCoord.xy / clusterUbo.screenParams.xy;
+
+	vec4 albedo = texture(gBuffer[1], uv);
+	if (albedo.a == 0.0) // nothing was drawn to this pixel
+		discard;
+
+	vec3 norm = normalize(texture(gBuffer[0], uv).xyz);
+	vec4 specular = texture(gBuffer[2], uv);
+	float shininess = max(specular.a * MAX_SHININESS, 1.0);
+	float depth = texture(gBuffer[3], uv).r;
+
+	// world space position from the depth
+	vec4 fragPos = ubo.invViewProjMat * vec4(uv * 2.0 - 1.0, depth, 1.0);
+	fragPos /= fragPos.w;
+
+	// ambient light
+	float ambientStrength = 0.1;
+	vec3 ambientLight = ambientStrength * albedo.rgb;
+
+	vec3 viewDir = normalize(ubo.viewPos.xyz - fragPos.xyz);
+	vec3 light = DirectionalLighting(fragPos.xyz, norm, viewDir, albedo.rgb, specular.rgb, shininess);
+	light += ClusteredLighting(fragPos.xyz, gl_FragCoord.xy, norm, viewDir, albedo.rgb, specular.rgb, shininess);
+
+	vec3 cubeColor = albedo.rgb;
+	vec3 result = (ambientLight + light) * cubeColor;
+	result = pow(result.rgb, vec3(1.0 / 2.2)); // because window surface format = VK_FORMAT_B8G8R8A8_UNORM
+	outColor = vec4(result, 1.0);
+
+	// the depth is written so that the forward passes after this (eg: light cube) are depth tested against the scene
+	gl_FragDepth = depth;
+}
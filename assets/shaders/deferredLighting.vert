@@ -0,0 +1,8 @@
+#version 450
+
+void main()
+{
+	// a single triangle that covers the whole screen, drawn without any vertex buffer
+	vec2 uv = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	gl_Position = vec4(uv * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,35 @@
+#version 450
+
+layout(binding = 0) uniform UniformBufferObject
+{
+	vec3 lightPos;
+	vec3 viewPos;
+	mat4 viewProjMat;
+}
+ubo;
+layout(binding = 1) uniform DynamicUniformBufferObject
+{
+	mat4 modelMat;
+	mat4 normMat;
+}
+dUbo;
+
+layout(location = 0) in vec3 inPosition;
+
+// see `VertexDecode`, the identity for full precision vertices
+layout(push_constant) uniform VertexDecode
+{
+	layout(offset = 64) vec4 offset;
+	vec4 scale;
+}
+decode;
+
+// has to produce the exact same depth as `phongLighting.vert` for the `EQUAL` depth test of the shading pass
+invariant gl_Position;
+
+void main()
+{
+	vec3 position = decode.offset.xyz + inPosition * decode.scale.xyz;
+	vec3 fragPos = vec3(dUbo.modelMat * vec4(position, 1.0));
+	gl_Position = ubo.viewProjMat * vec4(fragPos, 1.0);
+}
@@ -0,0 +1,38 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+#extension GL_EXT_nonuniform_qualifier : require
+
+#include "textureFeedback.glsl"
+#include "materials.glsl"
+
+// the occluded fragments don't write texture feedback
+layout(early_fragment_tests) in;
+
+layout(location = 0) in vec3 inNormal;
+layout(location = 1) in vec2 inTexCoord;
+layout(location = 2) in vec3 inFragPos;
+layout(location = 3) in vec3 inViewPos;
+
+// the position is reconstructed from the depth buffer in the lighting pass
+layout(location = 0) out vec4 outNormal;
+layout(location = 1) out vec4 outAlbedo;
+layout(location = 2) out vec4 outSpecular;
+
+void main()
+{
+	Material material = GetMaterial();
+	outNormal = vec4(normalize(inNormal), 0.0);
+	// alpha = 1 marks the pixels covered by geometry
+	outAlbedo = vec4(texture(sampler2D(uTextures[material.diffuseTexture], uSampler), inTexCoord).rgb, 1.0);
+	// the specular strength is applied here, the alpha has the shininess of the material
+	vec3 specular = texture(sampler2D(uTextures[material.specularTexture], uSampler), inTexCoord).rgb;
+	outSpecular = vec4(material.specularStrength * specular, material.shininess / MAX_SHININESS);
+	// queried in uniform control flow, the derivatives are undefined inside the branch
+	float diffuseLod = textureQueryLod(sampler2D(uTextures[material.diffuseTexture], uSampler), inTexCoord).y;
+	float specularLod = textureQueryLod(sampler2D(uTextures[material.specularTexture], uSampler), inTexCoord).y;
+	if (IsTextureFeedbackFragment())
+	{
+		WriteTextureFeedback(material.diffuseTexture, diffuseLod);
+		WriteTextureFeedback(material.specularTexture, specularLod);
+	}
+}
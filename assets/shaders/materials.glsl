@@ -0,0 +1,34 @@
+// the textures and the materials of every lit object, see `BindlessTextures` and `Materials`
+// needs GL_EXT_nonuniform_qualifier for the unsized texture array
+
+// has to match `MAX_SHININESS` in `materials.h`, the g-buffer stores the shininess divided by it
+#define MAX_SHININESS 256.0
+
+// has to match `Material` in `materials.h`
+struct Material
+{
+	uint diffuseTexture; // in `uTextures`
+	uint specularTexture;
+	float shininess; // blinn-phong exponent
+	float specularStrength;
+};
+
+layout(set = 3, binding = 0) uniform texture2D uTextures[];
+layout(set = 3, binding = 1) uniform sampler uSampler;
+layout(set = 3, binding = 3) readonly buffer Materials
+{
+	Material materials[];
+}
+uMaterials;
+
+// the material of the draw in `uMaterials`, see `MaterialIndex`
+layout(push_constant) uniform MaterialIndex
+{
+	uint index;
+}
+uMaterialIndex;
+
+Material GetMaterial()
+{
+	return uMaterials.materials[uMaterialIndex.index];
+}
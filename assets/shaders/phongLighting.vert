@@ -15,26 +15,46 @@ layout(binding = 1) uniform DynamicUniformBufferObject
 dUbo;
 
 layout(location = 0) in vec3 inPosition;
-layout(location = 1) in vec3 inNormal;
+layout(location = 1) in vec3 inNormal; // xy: octahedral encoded, for compact vertices
 layout(location = 2) in vec2 inTexCoord;
 
+// see `VertexDecode`, the identity for full precision vertices
+layout(push_constant) uniform VertexDecode
+{
+	layout(offset = 64) vec4 offset; // w: 1 if the normals are octahedral encoded
+	vec4 scale;
+}
+decode;
+
 layout(location = 0) out vec3 outNormal;
 layout(location = 1) out vec2 outTexCoord;
 layout(location = 2) out vec3 outFragPos;
 layout(location = 3) out vec3 outViewPos;
-layout(location = 4) out vec3 outLightPos;
+
+// the depth pre-pass (`depthPrepass.vert`) has to produce the exact same depth
+invariant gl_Position;
+
+vec3 OctahedralDecode(vec2 e)
+{
+	vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+	float t = max(-n.z, 0.0);
+	n.xy += vec2(n.x >= 0.0 ? -t : t, n.y >= 0.0 ? -t : t);
+	return normalize(n);
+}
 
 void main()
 {
-	outFragPos = vec3(dUbo.modelMat * vec4(inPosition, 1.0));
+	vec3 position = decode.offset.xyz + inPosition * decode.scale.xyz;
+	vec3 normal = decode.offset.w > 0.5 ? OctahedralDecode(inNormal.xy) : inNormal;
+
+	outFragPos = vec3(dUbo.modelMat * vec4(position, 1.0));
 	gl_Position = ubo.viewProjMat * vec4(outFragPos, 1.0);
 
 	// we cannot simply multiply the normal vector by the model matrix,
 	// because we shouldnt translate the normal vector
 	// we use a normal matrix
-	outNormal = mat3(dUbo.normMat) * inNormal;
+	outNormal = mat3(dUbo.normMat) * normal;
 
 	outTexCoord = inTexCoord;
 	outViewPos = ubo.viewPos;
-	outLightPos = ubo.lightPos;
 }
\ No newline at end of file
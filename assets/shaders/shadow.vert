@@ -0,0 +1,19 @@
+#version 450
+
+// light space transform of the caster (light view projection * model), see `ShadowMaps`
+layout(push_constant) uniform PushConstants
+{
+	mat4 mvp;
+	// see `VertexDecode`, the identity for full precision vertices
+	vec4 decodeOffset;
+	vec4 decodeScale;
+}
+pc;
+
+layout(location = 0) in vec3 inPosition;
+
+void main()
+{
+	vec3 position = pc.decodeOffset.xyz + inPosition * pc.decodeScale.xyz;
+	gl_Position = pc.mvp * vec4(position, 1.0);
+}
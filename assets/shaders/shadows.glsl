@@ -0,0 +1,94 @@
+// directional light with cascaded shadow maps and the shadow of the orbiting point light (light 0)
+// shared by the forward and the deferred lighting shaders
+// the shadow data is bound as set 2 (see `ShadowMaps`)
+
+// has to match `SHADOW_CASCADE_COUNT` in `ubo.h`
+#define SHADOW_CASCADE_COUNT 4
+
+layout(set = 2, binding = 0) uniform ShadowUniformBuffer
+{
+	mat4 viewMat;
+	mat4 cascadeViewProjMats[SHADOW_CASCADE_COUNT];
+	vec4 cascadeSplits; // far view space depth of each cascade
+	vec4 sunDirection; // xyz = direction the light travels in
+	vec4 sunColor; // rgb = color, a = intensity
+	vec4 pointLightPos; // xyz = world space position of light 0, w = far plane of its cube map
+	vec4 shadowParams; // x = shadows enabled, y = near plane of the cube map, z = normal offset in texels
+}
+shadowUbo;
+// the depth compare samplers return the lit fraction, bilinearly filtered where supported
+layout(set = 2, binding = 1) uniform sampler2DArrayShadow shadowCascades;
+layout(set = 2, binding = 2) uniform samplerCubeShadow pointShadow;
+
+float CascadeShadow(vec3 fragPos, vec3 norm)
+{
+	if (shadowUbo.shadowParams.x == 0.0)
+		return 1.0;
+
+	float viewDepth = -(shadowUbo.viewMat * vec4(fragPos, 1.0)).z;
+	int cascade = 0;
+	while (cascade < SHADOW_CASCADE_COUNT && viewDepth > shadowUbo.cascadeSplits[cascade])
+		++cascade;
+	if (cascade == SHADOW_CASCADE_COUNT) // beyond the shadow distance
+		return 1.0;
+
+	mat4 viewProjMat = shadowUbo.cascadeViewProjMats[cascade];
+	vec2 texelSize = 1.0 / vec2(textureSize(shadowCascades, 0).xy);
+	// the texels of the outer cascades cover more of the world, so the offset is scaled with the cascade's extent
+	// (the x scale of the orthographic projection is 2 / extent)
+	float worldTexelSize = 2.0 * texelSize.x / length(vec3(viewProjMat[0][0], viewProjMat[1][0], viewProjMat[2][0]));
+	vec3 offsetPos = fragPos + norm * shadowUbo.shadowParams.z * worldTexelSize;
+
+	vec4 lightSpacePos = viewProjMat * vec4(offsetPos, 1.0);
+	vec3 coord = lightSpacePos.xyz / lightSpacePos.w;
+	vec2 uv = coord.xy * 0.5 + 0.5;
+
+	// 3x3 pcf
+	float lit = 0.0;
+	for (int x = -1; x <= 1; ++x)
+	{
+		for (int y = -1; y <= 1; ++y)
+			lit += texture(shadowCascades, vec4(uv + vec2(x, y) * texelSize, float(cascade), coord.z));
+	}
+
+	return lit / 9.0;
+}
+
+float PointShadow(vec3 fragPos)
+{
+	if (shadowUbo.shadowParams.x == 0.0)
+		return 1.0;
+
+	vec3 lightToFrag = fragPos - shadowUbo.pointLightPos.xyz;
+	float zNear = shadowUbo.shadowParams.y;
+	float zFar = shadowUbo.pointLightPos.w;
+
+	// the depth stored in the cube face the direction points to, the face's view depth is the major axis
+	vec3 absVec = abs(lightToFrag);
+	float z = max(absVec.x, max(absVec.y, absVec.z));
+	if (z >= zFar)
+		return 1.0;
+
+	float depth = (zFar * (z - zNear)) / (z * (zFar - zNear));
+	return texture(pointShadow, vec4(lightToFrag, depth));
+}
+
+// diffuse and specular (blinn-phong) light of the sun, `specularColor` is scaled by the specular strength of the
+// material
+vec3 DirectionalLighting(vec3 fragPos, vec3 norm, vec3 viewDir, vec3 diffuseColor, vec3 specularColor, float shininess)
+{
+	float diffuseStrength = 0.8;
+
+	vec3 lightColor = shadowUbo.sunColor.rgb * shadowUbo.sunColor.a;
+	vec3 lightDir = -shadowUbo.sunDirection.xyz;
+	float nDotL = max(dot(lightDir, norm), 0.0);
+	if (nDotL <= 0.0)
+		return vec3(0.0);
+
+	float shadow = CascadeShadow(fragPos, norm);
+	vec3 diffuseLight = diffuseStrength * nDotL * lightColor * diffuseColor;
+	vec3 halfwayDir = normalize(lightDir + viewDir);
+	vec3 specularLight = pow(max(dot(norm, halfwayDir), 0.0), shininess) * lightColor * specularColor;
+
+	return shadow * (diffuseLight + specularLight);
+}
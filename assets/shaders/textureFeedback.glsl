@@ -0,0 +1,27 @@
+// the finest mip level the bindless textures are sampled at, read back by the cpu to stream their levels
+// (see `TextureFeedback`), one slot per texture in the bindless array, bound at binding 2 of its set
+
+// has to match `TextureFeedback::BIAS` in `textureStreamer.h`
+#define TEXTURE_FEEDBACK_BIAS 16
+
+layout(set = 3, binding = 2) buffer TextureFeedback
+{
+	// floor(lod) + bias, relative to the resident level 0 of the texture, 0xffffffff if it wasn't sampled
+	uint minLevel[];
+}
+uFeedback;
+
+// only one in 8x8 pixels writes, the lod doesn't change much between neighbours
+bool IsTextureFeedbackFragment()
+{
+	return ((uint(gl_FragCoord.x) | uint(gl_FragCoord.y)) & 7u) == 0u;
+}
+
+// `lod` is the unclamped lod of the texture (`textureQueryLod().y`), the atomic is skipped when it wouldn't
+// lower the stored level
+void WriteTextureFeedback(uint textureIndex, float lod)
+{
+	uint level = uint(clamp(floor(lod) + TEXTURE_FEEDBACK_BIAS, 0.0, 31.0));
+	if (level < uFeedback.minLevel[textureIndex])
+		atomicMin(uFeedback.minLevel[textureIndex], level);
+}
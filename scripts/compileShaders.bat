@@ -1,8 +1,19 @@
 glslc assets/shaders/phongLighting.vert -o assets/shaders/phongLighting.vert.spv
 glslc assets/shaders/phongLighting.frag -o assets/shaders/phongLighting.frag.spv
+glslc assets/shaders/depthPrepass.vert -o assets/shaders/depthPrepass.vert.spv
+glslc assets/shaders/shadow.vert -o assets/shaders/shadow.vert.spv
+
+glslc assets/shaders/gBuffer.frag -o assets/shaders/gBuffer.frag.spv
+glslc assets/shaders/deferredLighting.vert -o assets/shaders/deferredLighting.vert.spv
+glslc assets/shaders/deferredLighting.frag -o assets/shaders/deferredLighting.frag.spv
 
 glslc assets/shaders/lightCube.vert -o assets/shaders/lightCube.vert.spv
 glslc assets/shaders/lightCube.frag -o assets/shaders/lightCube.frag.spv
 
 glslc assets/shaders/texture.vert -o assets/shaders/texture.vert.spv
-glslc assets/shaders/texture.frag -o assets/shaders/texture.frag.spv
\ No newline at end of file
+glslc assets/shaders/texture.frag -o assets/shaders/texture.frag.spv
+
+glslc assets/shaders/clusterCulling.comp -o assets/shaders/clusterCulling.comp.spv
+glslc assets/shaders/meshletCulling.comp -o assets/shaders/meshletCulling.comp.spv
+glslc assets/shaders/hiZBuffer.comp -o assets/shaders/hiZBuffer.comp.spv
+glslc -DMULTISAMPLED assets/shaders/hiZBuffer.comp -o assets/shaders/hiZBufferMS.comp.spv
\ No newline at end of file
@@ -0,0 +1,8 @@
+#pragma once
+
+
+// registers the benchmarks with `Microbenchmarks`
+void RegisterMeshBenchmarks();
+void RegisterUniformBenchmarks();
+void RegisterTextureBenchmarks();
+void RegisterDescriptorBenchmarks();
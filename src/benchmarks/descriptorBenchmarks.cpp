@@ -0,0 +1,219 @@
+#include "benchmarks/benchmarks.h"
+
+#include <array>
+#include <vector>
+#include "benchmarks/microbenchmark.h"
+#include "renderer/device.h"
+#include "renderer/uniformBuffer.h"
+#include "renderer/descriptor.h"
+#include "renderer/descriptorAllocator.h"
+#include "editor/ubo.h"
+
+
+constexpr VkDeviceSize BENCHMARK_UNIFORM_RANGE = 256; // the largest `minUniformBufferOffsetAlignment` the spec allows
+
+// the data of the update template of `ModelSets`, one range of the buffer per binding
+struct ModelSetData
+{
+	VkDescriptorBufferInfo ubo;
+	VkDescriptorBufferInfo dynamicUbo;
+};
+
+// the set layout of a model (its uniform buffer and dynamic uniform buffer) with an update template, and a buffer
+// with a distinct range for each of `setCount` sets
+struct ModelSets
+{
+	UniformBuffer uniformBuffer;
+	std::vector<VkDescriptorBufferInfo> bufferInfos;
+	DescriptorSet descriptorSet{ 1 };
+
+	ModelSets(uint32_t setCount)
+		: uniformBuffer{ BENCHMARK_UNIFORM_RANGE * setCount,
+			  VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			  BENCHMARK_UNIFORM_RANGE },
+		  bufferInfos(setCount, uniformBuffer.GetBufferInfo())
+	{
+		for (uint32_t i = 0; i < setCount; ++i)
+			bufferInfos[i].offset = BENCHMARK_UNIFORM_RANGE * i;
+
+		descriptorSet.SetupLayout({
+			DescriptorSet::CreateLayout( //
+				DescriptorType::UNIFORM_BUFFER,
+				ShaderType::VERTEX,
+				0,
+				1,
+				bufferInfos.data(),
+				nullptr), //
+			DescriptorSet::CreateLayout( //
+				DescriptorType::UNIFORM_BUFFER_DYNAMIC,
+				ShaderType::VERTEX,
+				1,
+				1,
+				bufferInfos.data(),
+				nullptr), //
+		});
+		descriptorSet.Create();
+	}
+
+	// zero initialized, the cache compares the padding too
+	inline ModelSetData GetData(uint32_t index) const
+	{
+		ModelSetData data{};
+		data.ubo = bufferInfos[index];
+		data.dynamicUbo = bufferInfos[index];
+		return data;
+	}
+};
+
+// creates a descriptor set layout (and pipeline layout) and `size` sets with the buffer bindings of a model
+// the sets are freed by resetting the allocator of the renderer, outside of the measured time
+static void BM_DescriptorSetCreate(MicrobenchmarkState& state)
+{
+	const uint32_t setCount = static_cast<uint32_t>(state.GetSize());
+	UniformBuffer uniformBuffer{ sizeof(UniformBufferObject),
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		sizeof(UniformBufferObject) };
+	std::vector<VkDescriptorBufferInfo> bufferInfos(setCount, uniformBuffer.GetBufferInfo());
+
+	while (state.KeepRunning())
+	{
+		{
+			DescriptorSet descriptorSet{ setCount };
+			descriptorSet.SetupLayout({
+				DescriptorSet::CreateLayout( //
+					DescriptorType::UNIFORM_BUFFER,
+					ShaderType::VERTEX,
+					0,
+					1,
+					bufferInfos.data(),
+					nullptr), //
+				DescriptorSet::CreateLayout( //
+					DescriptorType::UNIFORM_BUFFER_DYNAMIC,
+					ShaderType::VERTEX,
+					1,
+					1,
+					bufferInfos.data(),
+					nullptr), //
+			});
+			descriptorSet.Create();
+			state.PauseTiming();
+		}
+
+		DescriptorPool::GetAllocator().Reset();
+		state.ResumeTiming();
+	}
+}
+
+// the sets of a frame: allocated one by one, then recycled by resetting the pools (the pools of the first iteration
+// are reused by the next ones)
+static void BM_DescriptorAllocatorAllocate(MicrobenchmarkState& state)
+{
+	const uint32_t setCount = static_cast<uint32_t>(state.GetSize());
+	ModelSets modelSets{ 1 };
+	DescriptorAllocator allocator{};
+	state.SetItemsPerIteration(setCount);
+
+	while (state.KeepRunning())
+	{
+		for (uint32_t i = 0; i < setCount; ++i)
+		{
+			VkDescriptorSet descriptorSet = allocator.Allocate(modelSets.descriptorSet.GetDescriptorSetLayout());
+			DoNotOptimize(descriptorSet);
+		}
+
+		allocator.Reset();
+	}
+}
+
+// writes the two bindings of every set with `vkUpdateDescriptorSets()`, like `DescriptorSet::Create()` used to
+static void BM_UpdateDescriptorSets(MicrobenchmarkState& state)
+{
+	const uint32_t setCount = static_cast<uint32_t>(state.GetSize());
+	ModelSets modelSets{ setCount };
+	DescriptorAllocator allocator{};
+	std::vector<VkDescriptorSet> descriptorSets(setCount);
+	for (auto& descriptorSet : descriptorSets)
+		descriptorSet = allocator.Allocate(modelSets.descriptorSet.GetDescriptorSetLayout());
+	state.SetItemsPerIteration(setCount);
+
+	while (state.KeepRunning())
+	{
+		for (uint32_t i = 0; i < setCount; ++i)
+		{
+			std::array<VkWriteDescriptorSet, 2> descriptorWrites{};
+			for (uint32_t binding = 0; binding < 2; ++binding)
+			{
+				descriptorWrites[binding].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+				descriptorWrites[binding].dstSet = descriptorSets[i];
+				descriptorWrites[binding].dstBinding = binding;
+				descriptorWrites[binding].descriptorCount = 1;
+				descriptorWrites[binding].pBufferInfo = &modelSets.bufferInfos[i];
+			}
+			descriptorWrites[0].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+			descriptorWrites[1].descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+
+			vkUpdateDescriptorSets(Device::GetDevice(),
+				static_cast<uint32_t>(descriptorWrites.size()),
+				descriptorWrites.data(),
+				0,
+				nullptr);
+		}
+	}
+}
+
+// the same writes with the update template of the layout
+static void BM_UpdateDescriptorSetWithTemplate(MicrobenchmarkState& state)
+{
+	const uint32_t setCount = static_cast<uint32_t>(state.GetSize());
+	ModelSets modelSets{ setCount };
+	DescriptorAllocator allocator{};
+	std::vector<VkDescriptorSet> descriptorSets(setCount);
+	for (auto& descriptorSet : descriptorSets)
+		descriptorSet = allocator.Allocate(modelSets.descriptorSet.GetDescriptorSetLayout());
+	state.SetItemsPerIteration(setCount);
+
+	while (state.KeepRunning())
+	{
+		for (uint32_t i = 0; i < setCount; ++i)
+		{
+			const ModelSetData data = modelSets.GetData(i);
+			vkUpdateDescriptorSetWithTemplate(
+				Device::GetDevice(), descriptorSets[i], modelSets.descriptorSet.GetUpdateTemplate(), &data);
+		}
+	}
+}
+
+// `size` sets with distinct buffer ranges requested every frame, only the first iteration allocates and writes them
+static void BM_DescriptorCacheGet(MicrobenchmarkState& state)
+{
+	const uint32_t setCount = static_cast<uint32_t>(state.GetSize());
+	ModelSets modelSets{ setCount };
+	DescriptorAllocator allocator{};
+	DescriptorCache cache{ allocator };
+	state.SetItemsPerIteration(setCount);
+
+	while (state.KeepRunning())
+	{
+		for (uint32_t i = 0; i < setCount; ++i)
+		{
+			const ModelSetData data = modelSets.GetData(i);
+			VkDescriptorSet descriptorSet = cache.Get(modelSets.descriptorSet.GetDescriptorSetLayout(),
+				modelSets.descriptorSet.GetUpdateTemplate(),
+				&data,
+				sizeof(data));
+			DoNotOptimize(descriptorSet);
+		}
+	}
+}
+
+void RegisterDescriptorBenchmarks()
+{
+	// up to 100k sets, the allocators grow by chaining pools
+	Microbenchmarks::Register("DescriptorSet::Create", SizeRange(1, 100'000), BM_DescriptorSetCreate, true);
+	Microbenchmarks::Register(
+		"DescriptorAllocator::Allocate + Reset", SizeRange(100, 100'000), BM_DescriptorAllocatorAllocate, true);
+	Microbenchmarks::Register("vkUpdateDescriptorSets", SizeRange(100, 100'000), BM_UpdateDescriptorSets, true);
+	Microbenchmarks::Register(
+		"vkUpdateDescriptorSetWithTemplate", SizeRange(100, 100'000), BM_UpdateDescriptorSetWithTemplate, true);
+	Microbenchmarks::Register("DescriptorCache::Get", SizeRange(100, 100'000), BM_DescriptorCacheGet, true);
+}
@@ -0,0 +1,67 @@
+#include <string>
+#include <cstring>
+#include <memory>
+#include <limits>
+#include "core/core.h"
+#include "benchmarks/benchmarks.h"
+#include "benchmarks/microbenchmark.h"
+#include "renderer/vulkanContext.h"
+#include "renderer/device.h"
+#include "renderer/commandPool.h"
+#include "renderer/descriptor.h"
+#include "renderer/samplerCache.h"
+
+
+// microbenchmarks of the cpu hot paths of the renderer
+// --filter <text>    only run the benchmarks whose names contain `text`
+// --max-size <size>  skip the sizes greater than `size`
+// --gpu              create a headless device and run the benchmarks that need one (uniform buffers, descriptors)
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	std::string filter{};
+	uint64_t maxSize = std::numeric_limits<uint64_t>::max();
+	bool gpu = false;
+	for (int i = 1; i < argc; ++i)
+	{
+		const int remaining = argc - i - 1;
+		if (std::strcmp(argv[i], "--filter") == 0 && remaining >= 1)
+			filter = argv[++i];
+		else if (std::strcmp(argv[i], "--max-size") == 0 && remaining >= 1)
+			maxSize = std::stoull(argv[++i]);
+		else if (std::strcmp(argv[i], "--gpu") == 0)
+			gpu = true;
+		else
+			Logger::Warn("Unknown argument: {}", argv[i]);
+	}
+
+	RegisterMeshBenchmarks();
+	RegisterUniformBenchmarks();
+	RegisterTextureBenchmarks();
+	RegisterDescriptorBenchmarks();
+
+	std::shared_ptr<VulkanContext> vulkanContext{};
+	std::shared_ptr<Device> device{};
+	std::shared_ptr<CommandPool> commandPool{};
+	if (gpu)
+	{
+		VulkanConfig config{ false, 1, {}, {}, true };
+		config.headless = true;
+		vulkanContext = VulkanContext::Create("Microbenchmarks", config, nullptr);
+		device = Device::Create(config, VK_NULL_HANDLE);
+		commandPool = CommandPool::Create();
+		DescriptorPool::Init();
+	}
+
+	Microbenchmarks::Run(filter, maxSize, gpu);
+
+	if (gpu)
+	{
+		DescriptorPool::Cleanup();
+		SamplerCache::Cleanup();
+		commandPool.reset();
+		device.reset();
+		vulkanContext.reset();
+	}
+}
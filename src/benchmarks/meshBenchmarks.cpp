@@ -0,0 +1,400 @@
+#include "benchmarks/benchmarks.h"
+
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <numeric>
+#include <algorithm>
+#include <unordered_map>
+#include <glm/gtc/matrix_transform.hpp>
+#include "benchmarks/microbenchmark.h"
+#include "core/core.h"
+#include "renderer/model.h"
+#include "utils/utils.h"
+#include "utils/meshOptimizer.h"
+#include "utils/meshSimplifier.h"
+#include "utils/meshlets.h"
+
+
+constexpr const char* LOD_BENCHMARK_MODEL = "assets/models/Cerberus/Cerberus_LP.FBX";
+constexpr float LOD_BENCHMARK_SCALE = 0.005f; // of the cerberus in the scene
+constexpr uint32_t LOD_BENCHMARK_VIEWPORT_HEIGHT = 1080;
+
+// unindexed triangles of a grid of quads, each quad is 6 vertices of which 2 are duplicates
+// like an imported mesh before its vertices are welded
+static std::vector<Vertex> CreateTriangleSoup(uint64_t vertexCount)
+{
+	const uint64_t quadCount = std::max<uint64_t>(vertexCount / 6, 1);
+	const uint64_t side = static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(quadCount))));
+
+	auto gridVertex = [side](uint64_t x, uint64_t y) {
+		const float u = static_cast<float>(x) / static_cast<float>(side);
+		const float v = static_cast<float>(y) / static_cast<float>(side);
+		return Vertex{ { u, std::sin(u * 8.0f) * std::cos(v * 8.0f), v }, { 0.0f, 1.0f, 0.0f }, { u, v } };
+	};
+
+	std::vector<Vertex> vertices{};
+	vertices.reserve(quadCount * 6);
+	for (uint64_t i = 0; i < quadCount; ++i)
+	{
+		const uint64_t x = i % side;
+		const uint64_t y = i / side;
+		vertices.push_back(gridVertex(x, y));
+		vertices.push_back(gridVertex(x + 1, y));
+		vertices.push_back(gridVertex(x + 1, y + 1));
+		vertices.push_back(gridVertex(x, y));
+		vertices.push_back(gridVertex(x + 1, y + 1));
+		vertices.push_back(gridVertex(x, y + 1));
+	}
+
+	return vertices;
+}
+
+// an assimp mesh with the layout `aiProcess_Triangulate` produces, the mesh owns (and frees) the arrays
+static std::unique_ptr<aiMesh> CreateAssimpMesh(uint64_t vertexCount)
+{
+	std::vector<Vertex> vertices = CreateTriangleSoup(vertexCount);
+	const uint32_t count = static_cast<uint32_t>(vertices.size());
+
+	auto mesh = std::make_unique<aiMesh>();
+	mesh->mPrimitiveTypes = aiPrimitiveType_TRIANGLE;
+	mesh->mNumVertices = count;
+	mesh->mVertices = new aiVector3D[count];
+	mesh->mNormals = new aiVector3D[count];
+	mesh->mTextureCoords[0] = new aiVector3D[count];
+	mesh->mNumUVComponents[0] = 2;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const Vertex& vertex = vertices[i];
+		mesh->mVertices[i] = { vertex.pos.x, vertex.pos.y, vertex.pos.z };
+		mesh->mNormals[i] = { vertex.normal.x, vertex.normal.y, vertex.normal.z };
+		mesh->mTextureCoords[0][i] = { vertex.texCoord.x, vertex.texCoord.y, 0.0f };
+	}
+
+	mesh->mNumFaces = count / 3;
+	mesh->mFaces = new aiFace[mesh->mNumFaces];
+	for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
+	{
+		aiFace& face = mesh->mFaces[i];
+		face.mNumIndices = 3;
+		face.mIndices = new unsigned int[3]{ i * 3, i * 3 + 1, i * 3 + 2 };
+	}
+
+	return mesh;
+}
+
+// the previous `utils::GetModelData()`, `std::unordered_map` with `std::hash<Vertex>`, the baseline of the welding
+static std::pair<std::vector<uint32_t>, std::vector<Vertex>> GetModelDataUnorderedMap(
+	const std::vector<Vertex>& vertices)
+{
+	std::unordered_map<Vertex, uint32_t> vertexLookup{};
+	std::vector<uint32_t> indices{};
+	std::vector<Vertex> uniqueVertices{};
+	uint32_t i = 0;
+
+	for (const auto& vertex : vertices)
+	{
+		if (vertexLookup.count(vertex) == 0)
+		{
+			vertexLookup[vertex] = i;
+			uniqueVertices.push_back(vertex);
+			++i;
+		}
+
+		indices.push_back(vertexLookup[vertex]);
+	}
+
+	return { indices, uniqueVertices };
+}
+
+static void BM_GetModelDataUnorderedMap(MicrobenchmarkState& state)
+{
+	std::vector<Vertex> vertices = CreateTriangleSoup(state.GetSize());
+	state.SetItemsPerIteration(vertices.size());
+
+	while (state.KeepRunning())
+	{
+		auto [indices, uniqueVertices] = GetModelDataUnorderedMap(vertices);
+		DoNotOptimize(indices);
+		DoNotOptimize(uniqueVertices);
+	}
+}
+
+static void BM_GetModelData(MicrobenchmarkState& state, uint32_t threadCount)
+{
+	std::vector<Vertex> vertices = CreateTriangleSoup(state.GetSize());
+	state.SetItemsPerIteration(vertices.size());
+
+	while (state.KeepRunning())
+	{
+		auto [indices, uniqueVertices] = utils::GetModelData(vertices, threadCount);
+		DoNotOptimize(indices);
+		DoNotOptimize(uniqueVertices);
+	}
+}
+
+static void BM_ConvertMesh(MicrobenchmarkState& state)
+{
+	std::unique_ptr<aiMesh> mesh = CreateAssimpMesh(state.GetSize());
+	state.SetItemsPerIteration(mesh->mNumVertices);
+
+	while (state.KeepRunning())
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+		glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+		Model::ConvertMesh(mesh.get(), vertices, indices, boundsMin, boundsMax);
+		DoNotOptimize(vertices);
+		DoNotOptimize(indices);
+		DoNotOptimize(boundsMin);
+	}
+}
+
+// welding, vertex cache, overdraw and vertex fetch optimization of an imported mesh
+static void BM_OptimizeMesh(MicrobenchmarkState& state)
+{
+	const std::vector<Vertex> soup = CreateTriangleSoup(state.GetSize());
+	std::vector<uint32_t> soupIndices(soup.size());
+	std::iota(soupIndices.begin(), soupIndices.end(), 0);
+	state.SetItemsPerIteration(soup.size());
+
+	while (state.KeepRunning())
+	{
+		state.PauseTiming();
+		std::vector<Vertex> vertices = soup;
+		std::vector<uint32_t> indices = soupIndices;
+		state.ResumeTiming();
+
+		utils::MeshOptimizationStats stats = utils::OptimizeMesh(vertices, indices);
+		DoNotOptimize(stats);
+	}
+}
+
+// the lod chain of a welded and optimized mesh, the optimization is not measured
+static void BM_GenerateLods(MicrobenchmarkState& state)
+{
+	std::vector<Vertex> vertices = CreateTriangleSoup(state.GetSize());
+	std::vector<uint32_t> indices(vertices.size());
+	std::iota(indices.begin(), indices.end(), 0);
+	utils::OptimizeMesh(vertices, indices);
+	state.SetItemsPerIteration(indices.size() / 3);
+
+	while (state.KeepRunning())
+	{
+		state.PauseTiming();
+		std::vector<uint32_t> lodIndices = indices;
+		state.ResumeTiming();
+
+		std::vector<utils::MeshLod> lods = utils::GenerateLods(vertices, lodIndices);
+		DoNotOptimize(lods);
+	}
+}
+
+struct LodBenchmarkMesh
+{
+	std::vector<utils::MeshLod> lods;
+	std::vector<utils::Meshlet> meshlets; // of the full resolution lod
+	// object space bounding sphere
+	glm::vec3 center;
+	float radius;
+};
+
+// the lods and meshlets of the meshes of `LOD_BENCHMARK_MODEL`, generated like `Model` does, loaded once
+static const std::vector<LodBenchmarkMesh>& LoadLodBenchmarkModel()
+{
+	static std::vector<LodBenchmarkMesh> s_Meshes{};
+	static bool s_Loaded = false;
+	if (s_Loaded)
+		return s_Meshes;
+
+	s_Loaded = true;
+	Assimp::Importer importer{};
+	const aiScene* scene = importer.ReadFile(LOD_BENCHMARK_MODEL, aiProcess_Triangulate);
+	if (!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode)
+	{
+		Logger::Warn("Failed to load {} (run from the root directory of the repo)", LOD_BENCHMARK_MODEL);
+		return s_Meshes;
+	}
+
+	for (uint32_t i = 0; i < scene->mNumMeshes; ++i)
+	{
+		std::vector<Vertex> vertices{};
+		std::vector<uint32_t> indices{};
+		glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+		glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+		Model::ConvertMesh(scene->mMeshes[i], vertices, indices, boundsMin, boundsMax);
+		utils::OptimizeMesh(vertices, indices);
+		std::vector<utils::MeshLod> lods = utils::GenerateLods(vertices, indices);
+		std::vector<utils::Meshlet> meshlets =
+			utils::BuildMeshlets(vertices, indices, lods[0].firstIndex, lods[0].indexCount);
+		s_Meshes.push_back({ std::move(lods),
+			std::move(meshlets),
+			(boundsMin + boundsMax) * 0.5f,
+			glm::length(boundsMax - boundsMin) * 0.5f });
+	}
+
+	return s_Meshes;
+}
+
+// `size` instances of the cerberus on a grid in front of the camera (1080p, 45 degrees), the lods are selected with
+// the default screen space error, the triangles with and without the lods are logged once per size
+static void BM_SelectLods(MicrobenchmarkState& state)
+{
+	const std::vector<LodBenchmarkMesh>& meshes = LoadLodBenchmarkModel();
+	if (meshes.empty())
+		return;
+
+	const uint64_t instanceCount = state.GetSize();
+	const uint64_t side = static_cast<uint64_t>(std::ceil(std::sqrt(static_cast<double>(instanceCount))));
+	float modelRadius = 0.0f;
+	for (const auto& mesh : meshes)
+		modelRadius = std::max(modelRadius, glm::length(mesh.center) + mesh.radius);
+	const float spacing = 2.4f * modelRadius * LOD_BENCHMARK_SCALE;
+
+	std::vector<glm::vec3> positions(instanceCount);
+	for (uint64_t i = 0; i < instanceCount; ++i)
+	{
+		const float x = static_cast<float>(i % side) - static_cast<float>(side) * 0.5f;
+		const float z = static_cast<float>(i / side);
+		positions[i] = glm::vec3(x * spacing, -1.0f, -2.0f - z * spacing);
+	}
+
+	LodSelection selection{};
+	selection.cameraPos = glm::vec3(0.0f);
+	selection.pixelsPerUnit =
+		static_cast<float>(LOD_BENCHMARK_VIEWPORT_HEIGHT) / (2.0f * std::tan(glm::radians(45.0f) * 0.5f));
+
+	// the triangles drawn with the selected lods
+	auto selectLods = [&]() {
+		uint64_t triangles = 0;
+		for (const auto& position : positions)
+		{
+			for (const auto& mesh : meshes)
+			{
+				const glm::vec3 center = position + mesh.center * LOD_BENCHMARK_SCALE;
+				const float maxError = selection.GetMaxError(center, mesh.radius, LOD_BENCHMARK_SCALE);
+				triangles += mesh.lods[utils::SelectLod(mesh.lods, maxError)].indexCount / 3;
+			}
+		}
+
+		return triangles;
+	};
+
+	uint64_t fullTriangles = 0;
+	for (const auto& mesh : meshes)
+		fullTriangles += mesh.lods[0].indexCount / 3 * instanceCount;
+	const uint64_t lodTriangles = selectLods();
+	Logger::Info("{} instances: {} triangles, {} with LODs ({:.1f}%)",
+		instanceCount,
+		fullTriangles,
+		lodTriangles,
+		100.0 * static_cast<double>(lodTriangles) / static_cast<double>(fullTriangles));
+
+	state.SetItemsPerIteration(instanceCount * meshes.size());
+	while (state.KeepRunning())
+	{
+		const uint64_t triangles = selectLods();
+		DoNotOptimize(triangles);
+	}
+}
+
+// `size` camera positions around the cerberus (full resolution), spread over the azimuths, elevations up to 45 degrees
+// and three distances: close up, filling the view and at twice that distance
+// the meshlets are culled like `meshletCulling.comp` does, the culled triangles are logged once per size
+static void BM_CullMeshlets(MicrobenchmarkState& state)
+{
+	const std::vector<LodBenchmarkMesh>& meshes = LoadLodBenchmarkModel();
+	if (meshes.empty())
+		return;
+
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	uint64_t meshletCount = 0;
+	uint64_t triangleCount = 0;
+	for (const auto& mesh : meshes)
+	{
+		boundsMin = glm::min(boundsMin, mesh.center - mesh.radius);
+		boundsMax = glm::max(boundsMax, mesh.center + mesh.radius);
+		meshletCount += mesh.meshlets.size();
+		triangleCount += mesh.lods[0].indexCount / 3;
+	}
+
+	const glm::mat4 modelMat = glm::scale(glm::mat4(1.0f), glm::vec3(LOD_BENCHMARK_SCALE));
+	const glm::vec3 center = (boundsMin + boundsMax) * 0.5f * LOD_BENCHMARK_SCALE;
+	const float fovy = glm::radians(45.0f);
+	// the bounding sphere of the model just fits into the view
+	const float fitDistance = glm::length(boundsMax - boundsMin) * 0.5f * LOD_BENCHMARK_SCALE / std::sin(fovy * 0.5f);
+	glm::mat4 projMat = glm::perspective(fovy, 16.0f / 9.0f, 0.01f, 100.0f);
+	projMat[1][1] *= -1.0f;
+
+	const uint64_t cameraCount = state.GetSize();
+	std::vector<glm::vec3> cameraPositions(cameraCount);
+	std::vector<utils::FrustumPlanes> cameraPlanes(cameraCount);
+	for (uint64_t i = 0; i < cameraCount; ++i)
+	{
+		const float azimuth = static_cast<float>(i) * glm::pi<float>() * (3.0f - std::sqrt(5.0f)); // golden angle
+		const float elevation = glm::radians(45.0f) * std::sin(static_cast<float>(i) * 0.7f);
+		const float distance = fitDistance * (i % 3 == 0 ? 0.5f : i % 3 == 1 ? 1.0f : 2.0f);
+		cameraPositions[i] = center
+			+ distance
+				* glm::vec3(std::cos(elevation) * std::sin(azimuth),
+					std::sin(elevation),
+					std::cos(elevation) * std::cos(azimuth));
+		cameraPlanes[i] =
+			utils::GetFrustumPlanes(projMat * glm::lookAt(cameraPositions[i], center, glm::vec3(0.0f, 1.0f, 0.0f)));
+	}
+
+	// the triangles of the visible meshlets from every camera
+	auto cullMeshlets = [&]() {
+		uint64_t drawnTriangles = 0;
+		for (uint64_t i = 0; i < cameraCount; ++i)
+		{
+			for (const auto& mesh : meshes)
+			{
+				for (const auto& meshlet : mesh.meshlets)
+				{
+					if (utils::IsMeshletVisible(
+							meshlet, modelMat, LOD_BENCHMARK_SCALE, cameraPositions[i], cameraPlanes[i]))
+						drawnTriangles += meshlet.triangleCount;
+				}
+			}
+		}
+
+		return drawnTriangles;
+	};
+
+	const uint64_t triangles = triangleCount * cameraCount;
+	const uint64_t drawnTriangles = cullMeshlets();
+	Logger::Info("{} camera positions: {} meshlets, {:.1f}% of the triangles culled",
+		cameraCount,
+		meshletCount,
+		100.0 * static_cast<double>(triangles - drawnTriangles) / static_cast<double>(triangles));
+
+	state.SetItemsPerIteration(cameraCount * meshletCount);
+	while (state.KeepRunning())
+	{
+		const uint64_t result = cullMeshlets();
+		DoNotOptimize(result);
+	}
+}
+
+void RegisterMeshBenchmarks()
+{
+	Microbenchmarks::Register(
+		"GetModelData (unordered_map)", SizeRange(1'000, 10'000'000), BM_GetModelDataUnorderedMap);
+	Microbenchmarks::Register("utils::GetModelData", SizeRange(1'000, 10'000'000), [](MicrobenchmarkState& state) {
+		BM_GetModelData(state, 1);
+	});
+	Microbenchmarks::Register(
+		"utils::GetModelData (all cores)", SizeRange(1'000, 10'000'000), [](MicrobenchmarkState& state) {
+			BM_GetModelData(state, 0);
+		});
+	Microbenchmarks::Register("Model::ConvertMesh", SizeRange(1'000, 10'000'000), BM_ConvertMesh);
+	Microbenchmarks::Register("utils::OptimizeMesh", SizeRange(1'000, 10'000'000), BM_OptimizeMesh);
+	Microbenchmarks::Register("utils::GenerateLods", SizeRange(1'000, 1'000'000), BM_GenerateLods);
+	// 100 to 1600 instances
+	Microbenchmarks::Register("LOD selection (Cerberus)", SizeRange(100, 1'600, 4), BM_SelectLods);
+	// 3 to 243 camera positions
+	Microbenchmarks::Register("Meshlet culling (Cerberus)", SizeRange(3, 243, 3), BM_CullMeshlets);
+}
@@ -0,0 +1,96 @@
+#include "benchmarks/microbenchmark.h"
+
+#include "core/core.h"
+
+
+std::vector<Microbenchmarks::Benchmark> Microbenchmarks::s_Benchmarks{};
+
+bool MicrobenchmarkState::KeepRunning()
+{
+	if (!m_Started)
+	{
+		m_Started = true;
+		m_Start = Clock::now();
+		return true;
+	}
+
+	++m_Iterations;
+	if (!m_Paused)
+	{
+		Clock::time_point now = Clock::now();
+		m_Elapsed += now - m_Start;
+		m_Start = now;
+	}
+
+	return m_Elapsed.count() < MICROBENCHMARK_MIN_TIME && m_Iterations < MICROBENCHMARK_MAX_ITERATIONS;
+}
+
+void MicrobenchmarkState::PauseTiming()
+{
+	if (m_Paused)
+		return;
+
+	m_Elapsed += Clock::now() - m_Start;
+	m_Paused = true;
+}
+
+void MicrobenchmarkState::ResumeTiming()
+{
+	if (!m_Paused)
+		return;
+
+	m_Start = Clock::now();
+	m_Paused = false;
+}
+
+void Microbenchmarks::Register(const char* name, const std::vector<uint64_t>& sizes, BenchmarkFn fn, bool requiresGpu)
+{
+	s_Benchmarks.push_back({ name, sizes, std::move(fn), requiresGpu });
+}
+
+void Microbenchmarks::Run(const std::string& filter, uint64_t maxSize, bool gpu)
+{
+	Logger::Info("{:<40} {:>10} {:>10} {:>14} {:>14}", "Benchmark", "Size", "Iterations", "Time", "Items/s");
+	for (const auto& benchmark : s_Benchmarks)
+	{
+		if (benchmark.name.find(filter) == std::string::npos)
+			continue;
+
+		if (benchmark.requiresGpu && !gpu)
+		{
+			Logger::Info("{:<40} skipped, run with --gpu", benchmark.name);
+			continue;
+		}
+
+		for (uint64_t size : benchmark.sizes)
+		{
+			if (size > maxSize)
+				break;
+
+			MicrobenchmarkState state{ size };
+			benchmark.fn(state);
+			if (state.GetIterations() == 0)
+			{
+				Logger::Warn("{:<40} {:>10} did not run its loop", benchmark.name, size);
+				continue;
+			}
+
+			const double time = state.GetTime();
+			Logger::Info("{:<40} {:>10} {:>10} {:>11.3f} us {:>14.4g}",
+				benchmark.name,
+				size,
+				state.GetIterations(),
+				time * 1.0e6,
+				static_cast<double>(state.GetItemsPerIteration()) / time);
+		}
+	}
+}
+
+std::vector<uint64_t> SizeRange(uint64_t first, uint64_t last, uint64_t multiplier)
+{
+	std::vector<uint64_t> sizes{};
+	for (uint64_t size = first; size <= last; size *= multiplier)
+		sizes.push_back(size);
+
+	return sizes;
+}
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <functional>
+#ifdef _MSC_VER
+	#include <intrin.h>
+#endif
+
+
+constexpr double MICROBENCHMARK_MIN_TIME = 0.5; // s measured per benchmark and size
+constexpr uint64_t MICROBENCHMARK_MAX_ITERATIONS = 1'000'000;
+
+// keeps the compiler from optimizing away a result that is otherwise unused
+// (and, with gcc/clang, from moving memory accesses across it, eg: out of the measured loop)
+template<typename T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "g"(&value) : "memory");
+#else
+	static volatile const void* s_Sink = nullptr;
+	s_Sink = &value;
+	_ReadWriteBarrier();
+#endif
+}
+
+// passed to a benchmark, the measured loop is `while (state.KeepRunning()) { ... }`
+// the setup before the loop is not measured, work inside the loop can be excluded with `PauseTiming()`
+class MicrobenchmarkState
+{
+public:
+	explicit MicrobenchmarkState(uint64_t size)
+		: m_Size{ size }
+	{}
+
+	bool KeepRunning();
+	void PauseTiming();
+	void ResumeTiming();
+
+	// the input size (vertices, objects, bytes, ...) the benchmark is run with
+	inline uint64_t GetSize() const { return m_Size; }
+	inline uint64_t GetIterations() const { return m_Iterations; }
+	// s per iteration
+	inline double GetTime() const { return m_Elapsed.count() / static_cast<double>(m_Iterations); }
+
+	// the items processed per iteration, reported as throughput, defaults to the size
+	inline void SetItemsPerIteration(uint64_t items) { m_ItemsPerIteration = items; }
+	inline uint64_t GetItemsPerIteration() const { return m_ItemsPerIteration; }
+
+private:
+	using Clock = std::chrono::steady_clock;
+
+	uint64_t m_Size;
+	uint64_t m_ItemsPerIteration = m_Size;
+	uint64_t m_Iterations = 0;
+	bool m_Started = false;
+	bool m_Paused = false;
+	Clock::time_point m_Start{};
+	std::chrono::duration<double> m_Elapsed{ 0.0 };
+};
+
+// runs the registered benchmarks once per size and prints a table of the time per iteration and the throughput
+// a benchmark is run repeatedly until `MICROBENCHMARK_MIN_TIME` has been measured
+class Microbenchmarks
+{
+public:
+	using BenchmarkFn = std::function<void(MicrobenchmarkState&)>;
+
+	// `requiresGpu` benchmarks are only run when the gpu is initialized (`--gpu`)
+	static void Register(const char* name,
+		const std::vector<uint64_t>& sizes,
+		BenchmarkFn fn,
+		bool requiresGpu = false);
+	// runs the benchmarks whose names contain `filter`, sizes greater than `maxSize` are skipped
+	static void Run(const std::string& filter, uint64_t maxSize, bool gpu);
+
+private:
+	struct Benchmark
+	{
+		std::string name;
+		std::vector<uint64_t> sizes;
+		BenchmarkFn fn;
+		bool requiresGpu;
+	};
+
+	static std::vector<Benchmark> s_Benchmarks;
+};
+
+// sizes from `first` to `last`, multiplied by `multiplier` each step
+std::vector<uint64_t> SizeRange(uint64_t first, uint64_t last, uint64_t multiplier = 10);
@@ -0,0 +1,112 @@
+#include "benchmarks/benchmarks.h"
+
+#include <vector>
+#include <cstdint>
+#include "benchmarks/microbenchmark.h"
+#include "renderer/device.h"
+#include "renderer/samplerCache.h"
+#include "utils/mipmaps.h"
+
+
+// a square rgba8 image of `side` texels with gradients and hard edges, like the albedo of a model
+static std::vector<uint8_t> CreateAlbedoImage(uint32_t side)
+{
+	std::vector<uint8_t> texels(static_cast<uint64_t>(side) * side * 4);
+	for (uint32_t y = 0; y < side; ++y)
+	{
+		for (uint32_t x = 0; x < side; ++x)
+		{
+			uint8_t* texel = texels.data() + (static_cast<uint64_t>(y) * side + x) * 4;
+			texel[0] = static_cast<uint8_t>(x * 255 / side);
+			texel[1] = static_cast<uint8_t>(y * 255 / side);
+			texel[2] = ((x / 16 + y / 16) % 2) == 0 ? 255 : 32;
+			texel[3] = 255;
+		}
+	}
+
+	return texels;
+}
+
+// the mips of the source image of a `Texture2D` that isn't cooked (or cached)
+static void BM_GenerateMipChain(MicrobenchmarkState& state, utils::MipFilter filter)
+{
+	const uint32_t side = static_cast<uint32_t>(state.GetSize());
+	const std::vector<uint8_t> image = CreateAlbedoImage(side);
+	state.SetItemsPerIteration(static_cast<uint64_t>(side) * side);
+
+	while (state.KeepRunning())
+	{
+		std::vector<std::vector<uint8_t>> levels =
+			utils::GenerateMipChain(image.data(), side, side, utils::MipColorSpace::SRGB, filter);
+		DoNotOptimize(levels);
+	}
+}
+
+// the settings of the sampler of every `Texture2D`
+static VkSamplerCreateInfo GetTextureSamplerInfo()
+{
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.maxAnisotropy = Device::GetDeviceProperties().limits.maxSamplerAnisotropy;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	return samplerInfo;
+}
+
+// one sampler per texture, like the textures did before the sampler cache, destroyed outside of the measured time
+static void BM_SamplerCreate(MicrobenchmarkState& state)
+{
+	const VkSamplerCreateInfo samplerInfo = GetTextureSamplerInfo();
+	std::vector<VkSampler> samplers(state.GetSize());
+
+	while (state.KeepRunning())
+	{
+		for (auto& sampler : samplers)
+			vkCreateSampler(Device::GetDevice(), &samplerInfo, nullptr, &sampler);
+
+		state.PauseTiming();
+		for (auto sampler : samplers)
+			vkDestroySampler(Device::GetDevice(), sampler, nullptr);
+		state.ResumeTiming();
+	}
+}
+
+// the textures get their shared sampler from the cache, only the first one creates it
+static void BM_SamplerCacheGet(MicrobenchmarkState& state)
+{
+	const VkSamplerCreateInfo samplerInfo = GetTextureSamplerInfo();
+	const uint64_t textureCount = state.GetSize();
+
+	while (state.KeepRunning())
+	{
+		for (uint64_t i = 0; i < textureCount; ++i)
+		{
+			VkSampler sampler = SamplerCache::Get(samplerInfo);
+			DoNotOptimize(sampler);
+		}
+	}
+}
+
+void RegisterTextureBenchmarks()
+{
+	// 256x256 to 4096x4096 texels
+	Microbenchmarks::Register(
+		"utils::GenerateMipChain (box)", SizeRange(256, 4'096, 4), [](MicrobenchmarkState& state) {
+			BM_GenerateMipChain(state, utils::MipFilter::BOX);
+		});
+	Microbenchmarks::Register(
+		"utils::GenerateMipChain (kaiser)", SizeRange(256, 4'096, 4), [](MicrobenchmarkState& state) {
+			BM_GenerateMipChain(state, utils::MipFilter::KAISER);
+		});
+	// the samplers of 1 to 1000 textures, the drivers limit the live samplers (`maxSamplerAllocationCount`, >= 4000)
+	Microbenchmarks::Register("vkCreateSampler", SizeRange(1, 1'000), BM_SamplerCreate, true);
+	Microbenchmarks::Register("SamplerCache::Get", SizeRange(1, 1'000), BM_SamplerCacheGet, true);
+}
@@ -0,0 +1,57 @@
+#include "benchmarks/benchmarks.h"
+
+#include <vector>
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/matrix_inverse.hpp>
+#include "benchmarks/microbenchmark.h"
+#include "renderer/uniformBuffer.h"
+#include "editor/ubo.h"
+
+
+constexpr uint64_t MIN_UNIFORM_BUFFER_OFFSET_ALIGNMENT = 256; // the largest alignment the vulkan spec allows
+
+// the per object update of `Renderer::UpdateUniformBuffers()`, model matrix and its inverse transpose
+static void BM_DynamicUboUpdate(MicrobenchmarkState& state)
+{
+	const uint64_t objectCount = state.GetSize();
+	DynamicUniformBufferObject dUbo{};
+	dUbo.Init(MIN_UNIFORM_BUFFER_OFFSET_ALIGNMENT, objectCount);
+
+	float angle = 0.0f;
+	while (state.KeepRunning())
+	{
+		for (uint64_t i = 0; i < objectCount; ++i)
+		{
+			const glm::vec3 position{ static_cast<float>(i % 100), 0.0f, static_cast<float>(i / 100) };
+			glm::mat4* modelMatPtr = dUbo.GetModelMatPtr(i);
+			*modelMatPtr = glm::translate(glm::mat4(1.0f), position);
+			*modelMatPtr = glm::rotate(*modelMatPtr, angle, glm::vec3(0.0f, 1.0f, 0.0f));
+			*modelMatPtr = glm::scale(*modelMatPtr, glm::vec3(0.5f));
+			*dUbo.GetNormalMatPtr(i) = glm::inverseTranspose(*modelMatPtr);
+		}
+
+		DoNotOptimize(*dUbo.buffer);
+		angle += 0.01f;
+	}
+}
+
+// `UniformBuffer::Map()` copies the whole buffer into host visible (coherent) memory
+static void BM_UniformBufferMap(MicrobenchmarkState& state)
+{
+	const VkDeviceSize size = state.GetSize();
+	UniformBuffer uniformBuffer{ size,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		size };
+	std::vector<uint8_t> data(size, 0xab);
+
+	while (state.KeepRunning())
+		uniformBuffer.Map(data.data());
+}
+
+void RegisterUniformBenchmarks()
+{
+	Microbenchmarks::Register("DynamicUniformBufferObject update", SizeRange(1'000, 1'000'000), BM_DynamicUboUpdate);
+	// 256 B to 16 MiB
+	Microbenchmarks::Register("UniformBuffer::Map", SizeRange(256, 16 * 1024 * 1024, 4), BM_UniformBufferMap, true);
+}
@@ -0,0 +1,212 @@
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <cctype>
+#include <algorithm>
+#include <filesystem>
+#define STB_IMAGE_IMPLEMENTATION
+#include "stb_image/stb_image.h"
+#include "core/core.h"
+#include "utils/ktx2.h"
+#include "utils/mipmaps.h"
+#include "utils/textureCompression.h"
+
+
+// how an image is cooked
+struct CookOptions
+{
+	bool autoFormat = true; // bc5 for the normal maps, `format` for the rest
+	utils::BlockFormat format = utils::BlockFormat::BC7;
+	bool linear = false; // the colors aren't srgb, bc5 is always linear
+	utils::MipFilter filter = utils::MipFilter::KAISER;
+	uint32_t threadCount = 0;
+};
+
+static bool IsNormalMap(const std::string& path)
+{
+	std::string name = std::filesystem::path(path).stem().string();
+	std::transform(name.begin(), name.end(), name.begin(), [](char c) {
+		return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+	});
+
+	return name.find("normal") != std::string::npos || name.find("_ddn") != std::string::npos
+		   || (name.size() > 2 && name.compare(name.size() - 2, 2, "_n") == 0);
+}
+
+static VkFormat GetVulkanFormat(utils::BlockFormat format, bool srgb)
+{
+	switch (format)
+	{
+	case utils::BlockFormat::BC1:
+		return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case utils::BlockFormat::BC5:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+	default:
+		return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+}
+
+static const char* GetFormatName(utils::BlockFormat format)
+{
+	switch (format)
+	{
+	case utils::BlockFormat::BC1:
+		return "BC1";
+	case utils::BlockFormat::BC5:
+		return "BC5";
+	default:
+		return "BC7";
+	}
+}
+
+// the peak signal to noise ratio of the channels of the format, in dB
+static double GetPsnr(const std::vector<uint8_t>& source,
+	const std::vector<uint8_t>& decoded,
+	utils::BlockFormat format)
+{
+	const uint32_t channelCount = format == utils::BlockFormat::BC5 ? 2 : (format == utils::BlockFormat::BC1 ? 3 : 4);
+	double squaredError = 0.0;
+	for (size_t i = 0; i < source.size(); i += 4)
+	{
+		for (uint32_t c = 0; c < channelCount; ++c)
+		{
+			const double delta = static_cast<double>(source[i + c]) - static_cast<double>(decoded[i + c]);
+			squaredError += delta * delta;
+		}
+	}
+
+	const double meanSquaredError = squaredError / static_cast<double>(source.size() / 4 * channelCount);
+	return meanSquaredError == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / meanSquaredError);
+}
+
+static void CookTexture(const std::string& path, const CookOptions& options)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+	int width = 0, height = 0, channels = 0;
+	stbi_uc* pixels = stbi_load(path.c_str(), &width, &height, &channels, STBI_rgb_alpha);
+	THROW(!pixels, "Failed to load {}!", path)
+
+	const bool normalMap = options.autoFormat && IsNormalMap(path);
+	const utils::BlockFormat format = normalMap ? utils::BlockFormat::BC5 : options.format;
+	const bool srgb = format != utils::BlockFormat::BC5 && !options.linear;
+	utils::MipColorSpace colorSpace = srgb ? utils::MipColorSpace::SRGB : utils::MipColorSpace::LINEAR;
+	if (normalMap)
+		colorSpace = utils::MipColorSpace::NORMAL;
+
+	const uint32_t imageWidth = static_cast<uint32_t>(width);
+	const uint32_t imageHeight = static_cast<uint32_t>(height);
+	const std::vector<std::vector<uint8_t>> mips =
+		utils::GenerateMipChain(pixels, imageWidth, imageHeight, colorSpace, options.filter);
+	stbi_image_free(pixels);
+
+	utils::Ktx2Image image{};
+	image.format = GetVulkanFormat(format, srgb);
+	image.width = imageWidth;
+	image.height = imageHeight;
+	uint64_t sourceBytes = 0;
+	uint64_t cookedBytes = 0;
+	for (uint32_t level = 0; level < static_cast<uint32_t>(mips.size()); ++level)
+	{
+		image.levels.push_back(utils::CompressImage(mips[level].data(),
+			std::max(imageWidth >> level, 1u),
+			std::max(imageHeight >> level, 1u),
+			format,
+			options.threadCount));
+		sourceBytes += mips[level].size();
+		cookedBytes += image.levels.back().size();
+	}
+
+	const std::string cookedPath = utils::GetCookedTexturePath(path);
+	utils::WriteKtx2(cookedPath, image);
+
+	const std::vector<uint8_t> decoded =
+		utils::DecompressImage(image.levels[0].data(), imageWidth, imageHeight, format);
+	const auto cookTime = std::chrono::steady_clock::now() - startTime;
+	// the size of the mip chain uncompressed (as rgba8) and cooked, the psnr of level 0
+	Logger::Info("{} -> {}: {}x{} {}, {} mips, {:.1f} MB -> {:.1f} MB, {:.1f} dB, {:.0f} ms",
+		path,
+		cookedPath,
+		width,
+		height,
+		GetFormatName(format),
+		mips.size(),
+		static_cast<double>(sourceBytes) / (1024.0 * 1024.0),
+		static_cast<double>(cookedBytes) / (1024.0 * 1024.0),
+		GetPsnr(mips[0], decoded, format),
+		std::chrono::duration<double, std::milli>(cookTime).count());
+}
+
+// cooks textures into block compressed KTX2 files with their mip chains, next to the source images
+// (`Texture2D` loads them instead of the source images)
+// --format <bc7|bc1|bc5>  the block format (bc7 by default), the normal maps (`*normal*`, `*_ddn`, `*_n`) are
+//                         always bc5 unless the format is given
+// --linear                the colors aren't srgb (eg: masks), bc5 is always linear
+// --filter <kaiser|box>   the filter of the mips (kaiser by default)
+// --threads <count>       threads compressing the blocks (one per core by default)
+int main(int argc, char** argv)
+{
+	Logger::Init();
+
+	CookOptions options{};
+	std::vector<std::string> paths{};
+	for (int i = 1; i < argc; ++i)
+	{
+		const int remaining = argc - i - 1;
+		if (std::strcmp(argv[i], "--format") == 0 && remaining >= 1)
+		{
+			const std::string format = argv[++i];
+			options.autoFormat = false;
+			if (format == "bc1")
+				options.format = utils::BlockFormat::BC1;
+			else if (format == "bc5")
+				options.format = utils::BlockFormat::BC5;
+			else if (format == "bc7")
+				options.format = utils::BlockFormat::BC7;
+			else
+				Logger::Warn("Unknown format: {}, bc7 is used", format);
+		}
+		else if (std::strcmp(argv[i], "--linear") == 0)
+			options.linear = true;
+		else if (std::strcmp(argv[i], "--filter") == 0 && remaining >= 1)
+		{
+			const std::string filter = argv[++i];
+			if (filter == "box")
+				options.filter = utils::MipFilter::BOX;
+			else if (filter == "kaiser")
+				options.filter = utils::MipFilter::KAISER;
+			else
+				Logger::Warn("Unknown filter: {}, kaiser is used", filter);
+		}
+		else if (std::strcmp(argv[i], "--threads") == 0 && remaining >= 1)
+			options.threadCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (std::strncmp(argv[i], "--", 2) == 0)
+			Logger::Warn("Unknown argument: {}", argv[i]);
+		else
+			paths.emplace_back(argv[i]);
+	}
+
+	if (paths.empty())
+	{
+		Logger::Error("Usage: textureCooker [--format bc7|bc1|bc5] [--linear] [--filter kaiser|box] "
+			"[--threads <count>] <image>...");
+		return 1;
+	}
+
+	int result = 0;
+	for (const auto& path : paths)
+	{
+		try
+		{
+			CookTexture(path, options);
+		}
+		catch (const std::exception&)
+		{
+			// already logged, the other textures are still cooked
+			result = 1;
+		}
+	}
+
+	return result;
+}
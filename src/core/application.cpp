@@ -1,14 +1,17 @@
 #include "core/application.h"
 
 #include <chrono>
+#include <algorithm>
 #include "core/core.h"
 #include "core/input.h"
+#include "core/profiler.h"
 #include "ui/imGuiOverlay.h"
 
 
 Application* Application::s_Instance = nullptr;
 
-Application::Application(const char* title, uint32_t, uint32_t)
+Application::Application(const char* title, const ApplicationOptions& options)
+	: m_Options{ options }
 {
 	Init(title);
 }
@@ -18,17 +21,20 @@ void Application::Init(const char* title)
 	s_Instance = this;
 	Logger::Info("{} application initialized!", title);
 
-	m_Window = std::make_shared<Window>(WindowProps{ title });
-	// set window event callbacks
-	// TODO: create only one function that dispatches all the events
-	m_Window->SetCloseEventCallbackFn(BIND_EVENT_FN(Application::OnCloseEvent));
-	m_Window->SetResizeEventCallbackFn(BIND_EVENT_FN(Application::OnResizeEvent));
-	m_Window->SetMouseEventCallbackFn(BIND_EVENT_FN(Application::OnMouseMoveEvent));
-	m_Window->SetMouseButtonCallbackFn(BIND_EVENT_FN(Application::OnMouseButtonEvent));
-	m_Window->SetMouseScrollCallbackFn(BIND_EVENT_FN(Application::OnMouseScrollEvent));
-	m_Window->SetKeyEventCallbackFn(BIND_EVENT_FN(Application::OnKeyEvent));
-
-	const VulkanConfig config{
+	if (!m_Options.headless)
+	{
+		m_Window = std::make_shared<Window>(WindowProps{ title, m_Options.width, m_Options.height });
+		// set window event callbacks
+		// TODO: create only one function that dispatches all the events
+		m_Window->SetCloseEventCallbackFn(BIND_EVENT_FN(Application::OnCloseEvent));
+		m_Window->SetResizeEventCallbackFn(BIND_EVENT_FN(Application::OnResizeEvent));
+		m_Window->SetMouseEventCallbackFn(BIND_EVENT_FN(Application::OnMouseMoveEvent));
+		m_Window->SetMouseButtonCallbackFn(BIND_EVENT_FN(Application::OnMouseButtonEvent));
+		m_Window->SetMouseScrollCallbackFn(BIND_EVENT_FN(Application::OnMouseScrollEvent));
+		m_Window->SetKeyEventCallbackFn(BIND_EVENT_FN(Application::OnKeyEvent));
+	}
+
+	VulkanConfig config{
 #ifdef NDEBUG // release mode
 		false, // validation layers disabled
 #else
@@ -36,16 +42,38 @@ void Application::Init(const char* title)
 #endif
 		2, // max frames in flight
 		{ "VK_LAYER_KHRONOS_validation" }, // validation layers
-		{ VK_KHR_SWAPCHAIN_EXTENSION_NAME } // device extensions
+		{ VK_KHR_SWAPCHAIN_EXTENSION_NAME }, // device extensions
+		true // reverse-z infinite projection
 	};
+	if (m_Options.headless)
+	{
+		config.headless = true;
+		config.headlessExtent = { m_Options.width, m_Options.height };
+		// nothing is presented
+		config.deviceExtensions.clear();
+	}
 
 	m_Renderer = std::make_unique<Renderer>(title, config, m_Window);
+
+	// headless draws at least one frame
+	m_FrameCount = m_Options.headless ? std::max(m_Options.frameCount, 1u) : m_Options.frameCount;
+	if (m_Options.headless)
+		Logger::Info("Drawing headless ({}x{})", m_Options.width, m_Options.height);
+
+	if (m_Options.benchmark)
+	{
+		m_Benchmark = std::make_unique<Benchmark>(
+			m_Options.frameCount != 0 ? m_Options.frameCount : BENCHMARK_DEFAULT_FRAME_COUNT,
+			m_Options.reportPath,
+			m_Options.cameraPathFile,
+			m_Options.lightCounts);
+	}
 }
 
-Application* Application::Create(const char* title)
+Application* Application::Create(const char* title, const ApplicationOptions& options)
 {
 	if (Application::s_Instance == nullptr)
-		return new Application{ title };
+		return new Application{ title, options };
 
 	return Application::s_Instance;
 }
@@ -54,14 +82,57 @@ void Application::Run()
 {
 	m_LastFrameTime = std::chrono::high_resolution_clock::now();
 
+	uint32_t frame = 0;
 	while (m_IsRunning)
 	{
-		float deltatime = CalcDeltaTime();
+		DrawFrame();
+		PROFILE_FRAME_END();
+
+		++frame;
+		if (m_Benchmark ? m_Benchmark->IsFinished() : (m_FrameCount != 0 && frame == m_FrameCount))
+			m_IsRunning = false;
+	}
+
+	if (m_Benchmark)
+		m_Benchmark->WriteReport(m_Renderer->GetWidth(), m_Renderer->GetHeight());
+	if (m_Options.headless && !m_Options.outputPath.empty())
+		m_Renderer->SaveFrame(m_Options.outputPath);
 
+	// writes a capture that is still running
+	Profiler::EndCapture();
+}
+
+void Application::DrawFrame()
+{
+	PROFILE_SCOPE("Frame");
+	auto frameStartTime = std::chrono::high_resolution_clock::now();
+	float deltatime = CalcDeltaTime();
+
+	if (m_Benchmark)
+	{
+		// the same frames are drawn in every run, only the time they take changes
+		m_Renderer->SetCameraPose(m_Benchmark->GetCameraPose());
+		if (m_Benchmark->GetLightCount() != 0)
+			m_Renderer->SetLightCount(m_Benchmark->GetLightCount());
+		m_Renderer->Draw(BENCHMARK_TIMESTEP, m_LastFPS);
+	}
+	else
+	{
 		m_Renderer->Draw(deltatime, m_LastFPS);
+	}
+
+	if (m_Window)
+	{
 		m_Window->OnUpdate();
 		ProcessInput();
 	}
+
+	if (m_Benchmark)
+	{
+		auto frameTime = std::chrono::high_resolution_clock::now() - frameStartTime;
+		m_Benchmark->OnFrameEnd(std::chrono::duration<float, std::chrono::milliseconds::period>(frameTime).count(),
+			m_Renderer->GetFrameStats());
+	}
 }
 
 float Application::CalcDeltaTime()
@@ -2,26 +2,51 @@
 
 #include <memory>
 #include <chrono>
+#include <string>
+#include <vector>
 #include "core/window.h"
 #include "renderer/renderer.h"
+#include "core/benchmark.h"
 
 
+// set from the command line
+struct ApplicationOptions
+{
+	// renders offscreen without a window, see `VulkanConfig::headless`
+	bool headless = false;
+	uint32_t width = 1280;
+	uint32_t height = 720;
+	// frames drawn before the application closes, 0 = until the window is closed (headless draws at least 1 frame)
+	// the measured frames when benchmarking, 0 = `BENCHMARK_DEFAULT_FRAME_COUNT`
+	uint32_t frameCount = 0;
+	// the last frame is saved as a png when headless, nothing is saved if empty
+	std::string outputPath{};
+
+	// see `Benchmark`
+	bool benchmark = false;
+	std::string reportPath{ "benchmark.json" };
+	std::string cameraPathFile{}; // the default camera path if empty
+	std::vector<uint32_t> lightCounts{}; // benchmarked one after the other, the renderer's lights if empty
+};
+
 class Application
 {
 public:
 	Application(const Application&) = delete;
 	Application& operator=(const Application&) = delete;
 
-	static Application* Create(const char* title);
+	static Application* Create(const char* title, const ApplicationOptions& options = {});
 	void Run();
 
 	static inline Application& GetInstance() { return *s_Instance; }
+	// there is no window in headless mode
 	[[nodiscard]] inline Window& GetWindow() const { return *m_Window; }
 
 private:
-	explicit Application(const char* title, uint32_t width = 1280, uint32_t height = 720);
+	explicit Application(const char* title, const ApplicationOptions& options);
 
 	void Init(const char* title);
+	void DrawFrame();
 	float CalcDeltaTime(); // deltatime in milliseconds
 
 	// TODO: refactor to use OnEvent()
@@ -36,8 +61,11 @@ private:
 private:
 	bool m_IsRunning = true;
 	static Application* s_Instance;
+	const ApplicationOptions m_Options;
 	std::shared_ptr<Window> m_Window;
 	std::unique_ptr<Renderer> m_Renderer;
+	std::unique_ptr<Benchmark> m_Benchmark{};
+	uint32_t m_FrameCount = 0; // 0 = until the window is closed
 
 	uint32_t m_LastFPS = 0;
 	uint32_t m_FrameCounter = 0;
@@ -0,0 +1,215 @@
+#include "core/benchmark.h"
+
+#include <cmath>
+#include <fstream>
+#include <numeric>
+#include <algorithm>
+#include "core/core.h"
+#include "renderer/device.h"
+#include "utils/utils.h"
+
+#if defined(_WIN32)
+	#define NOMINMAX
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+	#include <psapi.h>
+#elif defined(__linux__)
+	#include <unistd.h>
+#endif
+
+
+Benchmark::Benchmark(uint32_t frameCount,
+	const std::string& reportPath,
+	const std::string& cameraPathFile,
+	const std::vector<uint32_t>& lightCounts)
+	: m_FrameCount{ frameCount },
+	  m_ReportPath{ reportPath },
+	  m_CameraPath{ cameraPathFile.empty() ? CameraPath{} : CameraPath{ cameraPathFile } }
+{
+	if (lightCounts.empty())
+		m_Runs.emplace_back();
+	for (uint32_t lightCount : lightCounts)
+	{
+		THROW(lightCount == 0 || lightCount > MAX_LIGHTS,
+			"Benchmark light count {} isn't between 1 and {}!",
+			lightCount,
+			MAX_LIGHTS)
+		m_Runs.push_back({ lightCount });
+	}
+
+	for (auto& run : m_Runs)
+	{
+		run.frameTimes.reserve(frameCount);
+		run.cpuTimes.reserve(frameCount);
+		run.gpuTimes.reserve(frameCount);
+		run.lightingTimes.reserve(frameCount);
+		run.drawCalls.reserve(frameCount);
+		run.triangles.reserve(frameCount);
+	}
+
+	Logger::Info("Benchmark: {} frames after {} warmup frames, {} run(s)",
+		frameCount,
+		BENCHMARK_WARMUP_FRAMES,
+		m_Runs.size());
+}
+
+CameraPose Benchmark::GetCameraPose() const
+{
+	float time = static_cast<float>(m_Frame) * BENCHMARK_TIMESTEP / 1000.0f;
+	return m_CameraPath.Evaluate(time / BENCHMARK_PATH_DURATION);
+}
+
+void Benchmark::OnFrameEnd(float frameTime, const FrameStats& stats)
+{
+	if (IsFinished())
+		return;
+
+	// the warmup also lets the gpu times of the previous light count go through the profiler
+	if (m_Frame++ >= BENCHMARK_WARMUP_FRAMES)
+	{
+		Run& run = m_Runs[m_Run];
+		run.frameTimes.push_back(frameTime);
+		run.cpuTimes.push_back(stats.cpuTime);
+		run.gpuTimes.push_back(stats.gpuTime);
+		run.lightingTimes.push_back(stats.lightingTime);
+		run.drawCalls.push_back(static_cast<float>(stats.drawCalls));
+		run.triangles.push_back(static_cast<float>(stats.triangles));
+	}
+
+	if (m_Frame == BENCHMARK_WARMUP_FRAMES + m_FrameCount)
+	{
+		++m_Run;
+		m_Frame = 0;
+	}
+}
+
+void Benchmark::WriteReport(uint32_t width, uint32_t height) const
+{
+	std::ofstream file{ m_ReportPath, std::ios::out | std::ios::trunc };
+	THROW(!file.is_open(), "Failed to open {} to write the benchmark report!", m_ReportPath)
+
+	utils::DeviceMemoryStats deviceMemory = utils::GetDeviceMemoryStats();
+	// without light counts the summaries are written at the top level
+	const bool lightSweep = m_Runs.front().lightCount != 0;
+
+	file << "{\n";
+	file << fmt::format("\t\"device\": \"{}\",\n", Device::GetDeviceProperties().deviceName);
+	file << fmt::format("\t\"resolution\": [{}, {}],\n", width, height);
+	file << fmt::format("\t\"frames\": {},\n", m_Runs.front().frameTimes.size());
+	file << fmt::format("\t\"warmupFrames\": {},\n", BENCHMARK_WARMUP_FRAMES);
+	file << fmt::format("\t\"timestepMs\": {:.3f},\n", BENCHMARK_TIMESTEP);
+	if (lightSweep)
+	{
+		file << "\t\"lightCounts\": [\n";
+		for (size_t i = 0; i < m_Runs.size(); ++i)
+		{
+			file << "\t\t{\n";
+			file << fmt::format("\t\t\t\"lights\": {},\n", m_Runs[i].lightCount);
+			file << ToJson(m_Runs[i], "\t\t\t") << "\n";
+			file << (i + 1 < m_Runs.size() ? "\t\t},\n" : "\t\t}\n");
+		}
+		file << "\t],\n";
+	}
+	else
+	{
+		file << ToJson(m_Runs.front(), "\t") << ",\n";
+	}
+	file << "\t\"memory\": {\n";
+	file << fmt::format("\t\t\"deviceBytes\": {},\n", deviceMemory.allocatedBytes);
+	file << fmt::format("\t\t\"devicePeakBytes\": {},\n", deviceMemory.peakBytes);
+	file << fmt::format("\t\t\"deviceAllocations\": {},\n", deviceMemory.allocationCount);
+	file << fmt::format("\t\t\"processResidentBytes\": {}\n", GetProcessMemory());
+	file << "\t}\n";
+	file << "}\n";
+
+	if (!lightSweep)
+	{
+		Summary frameTime = Summarize(m_Runs.front().frameTimes);
+		Logger::Info("Benchmark report written to {} (frame time p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms)",
+			m_ReportPath,
+			frameTime.p50,
+			frameTime.p95,
+			frameTime.p99);
+		return;
+	}
+
+	Logger::Info("Benchmark report written to {}", m_ReportPath);
+	for (const auto& run : m_Runs)
+	{
+		Summary frameTime = Summarize(run.frameTimes);
+		Summary lightingTime = Summarize(run.lightingTimes);
+		Logger::Info("{} lights: frame time p50 {:.3f} ms, lighting pass p50 {:.3f} ms, p95 {:.3f} ms, p99 {:.3f} ms",
+			run.lightCount,
+			frameTime.p50,
+			lightingTime.p50,
+			lightingTime.p95,
+			lightingTime.p99);
+	}
+}
+
+Benchmark::Summary Benchmark::Summarize(std::vector<float> samples)
+{
+	Summary summary{};
+	if (samples.empty())
+		return summary;
+
+	std::sort(samples.begin(), samples.end());
+	// nearest rank
+	auto percentile = [&samples](float p) {
+		size_t rank = static_cast<size_t>(std::ceil(p / 100.0f * static_cast<float>(samples.size())));
+		return samples[std::clamp<size_t>(rank, 1, samples.size()) - 1];
+	};
+
+	summary.avg = std::accumulate(samples.begin(), samples.end(), 0.0f) / static_cast<float>(samples.size());
+	summary.min = samples.front();
+	summary.max = samples.back();
+	summary.p50 = percentile(50.0f);
+	summary.p95 = percentile(95.0f);
+	summary.p99 = percentile(99.0f);
+	return summary;
+}
+
+std::string Benchmark::ToJson(const Summary& summary)
+{
+	return fmt::format(
+		"{{ \"avg\": {:.3f}, \"min\": {:.3f}, \"max\": {:.3f}, \"p50\": {:.3f}, \"p95\": {:.3f}, \"p99\": {:.3f} }}",
+		summary.avg,
+		summary.min,
+		summary.max,
+		summary.p50,
+		summary.p95,
+		summary.p99);
+}
+
+std::string Benchmark::ToJson(const Run& run, const std::string& indent)
+{
+	std::string json{};
+	json += fmt::format("{}\"frameTimeMs\": {},\n", indent, ToJson(Summarize(run.frameTimes)));
+	json += fmt::format("{}\"cpuTimeMs\": {},\n", indent, ToJson(Summarize(run.cpuTimes)));
+	json += fmt::format("{}\"gpuTimeMs\": {},\n", indent, ToJson(Summarize(run.gpuTimes)));
+	json += fmt::format("{}\"lightingTimeMs\": {},\n", indent, ToJson(Summarize(run.lightingTimes)));
+	json += fmt::format("{}\"drawCalls\": {},\n", indent, ToJson(Summarize(run.drawCalls)));
+	json += fmt::format("{}\"triangles\": {}", indent, ToJson(Summarize(run.triangles)));
+	return json;
+}
+
+// resident memory of the process in bytes, 0 if it isn't known on the platform
+uint64_t Benchmark::GetProcessMemory()
+{
+#if defined(_WIN32)
+	PROCESS_MEMORY_COUNTERS counters{};
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.WorkingSetSize;
+	return 0;
+#elif defined(__linux__)
+	// the second value is the resident set size in pages
+	std::ifstream statm{ "/proc/self/statm" };
+	uint64_t size = 0;
+	uint64_t resident = 0;
+	if (!(statm >> size >> resident))
+		return 0;
+	return resident * static_cast<uint64_t>(sysconf(_SC_PAGESIZE));
+#else
+	return 0;
+#endif
+}
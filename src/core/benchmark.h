@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include "renderer/renderer.h"
+#include "renderer/cameraPath.h"
+
+
+constexpr uint32_t BENCHMARK_DEFAULT_FRAME_COUNT = 600;
+constexpr float BENCHMARK_TIMESTEP = 1000.0f / 60.0f; // ms of animation time per frame
+constexpr uint32_t BENCHMARK_WARMUP_FRAMES = 30; // drawn before measuring (first uploads, pipeline caches)
+constexpr float BENCHMARK_PATH_DURATION = 10.0f; // s per loop of the camera path
+
+// deterministic benchmark run
+// every frame advances the animations by the same timestep and the camera follows a camera path,
+// so every run draws the same frames whatever the frame rate is
+// the frames after the warmup are measured and written as a json report
+//
+// with light counts, each count is a run of its own (warmup and measured frames, the camera path starts again), the
+// report then has the times of every count, eg: to compare the cost of the lighting pass with the number of lights
+class Benchmark
+{
+public:
+	// `cameraPathFile` can be empty, the default path is then used
+	// `lightCounts` can be empty, the lights of the renderer are then kept
+	Benchmark(uint32_t frameCount,
+		const std::string& reportPath,
+		const std::string& cameraPathFile,
+		const std::vector<uint32_t>& lightCounts);
+
+	inline bool IsFinished() const { return m_Run >= m_Runs.size(); }
+	// pose of the camera in the next frame
+	CameraPose GetCameraPose() const;
+	// light count of the next frame, 0 = the lights of the renderer are kept
+	inline uint32_t GetLightCount() const { return IsFinished() ? 0 : m_Runs[m_Run].lightCount; }
+	// `frameTime` is the wall clock time of the frame in ms
+	void OnFrameEnd(float frameTime, const FrameStats& stats);
+	void WriteReport(uint32_t width, uint32_t height) const;
+
+private:
+	struct Summary
+	{
+		float avg = 0.0f;
+		float min = 0.0f;
+		float max = 0.0f;
+		float p50 = 0.0f;
+		float p95 = 0.0f;
+		float p99 = 0.0f;
+	};
+
+	// the measured frames of a light count
+	struct Run
+	{
+		uint32_t lightCount = 0; // 0 = the lights of the renderer
+		std::vector<float> frameTimes{};
+		std::vector<float> cpuTimes{};
+		std::vector<float> gpuTimes{};
+		std::vector<float> lightingTimes{};
+		std::vector<float> drawCalls{};
+		std::vector<float> triangles{};
+	};
+
+	static Summary Summarize(std::vector<float> samples);
+	static std::string ToJson(const Summary& summary);
+	// the summaries of the run, one member per line, without a comma after the last one
+	static std::string ToJson(const Run& run, const std::string& indent);
+	static uint64_t GetProcessMemory();
+
+private:
+	const uint32_t m_FrameCount;
+	const std::string m_ReportPath;
+	CameraPath m_CameraPath;
+
+	std::vector<Run> m_Runs{};
+	size_t m_Run = 0;
+	uint32_t m_Frame = 0; // of the current run, the warmup included
+};
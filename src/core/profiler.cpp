@@ -0,0 +1,140 @@
+#include "core/profiler.h"
+
+#include <fstream>
+#include "core/core.h"
+
+
+const std::chrono::steady_clock::time_point Profiler::s_StartTime = std::chrono::steady_clock::now();
+std::atomic<bool> Profiler::s_Capturing{ false };
+uint32_t Profiler::s_CaptureFrameCount = 0;
+uint32_t Profiler::s_CapturedFrames = 0;
+std::string Profiler::s_CapturePath{};
+
+std::mutex Profiler::s_BuffersMutex{};
+std::vector<std::unique_ptr<Profiler::ThreadBuffer>> Profiler::s_Buffers{};
+
+void Profiler::BeginCapture(uint32_t frameCount, const std::string& path)
+{
+	if (IsCapturing())
+	{
+		Logger::Warn("A profiler capture is already running");
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock{ s_BuffersMutex };
+		for (auto& buffer : s_Buffers)
+		{
+			buffer->count.store(0, std::memory_order_relaxed);
+			buffer->dropped.store(0, std::memory_order_relaxed);
+		}
+	}
+
+	s_CaptureFrameCount = frameCount;
+	s_CapturedFrames = 0;
+	s_CapturePath = path;
+	s_Capturing.store(true, std::memory_order_release);
+	Logger::Info("Profiler capture started");
+}
+
+void Profiler::EndCapture()
+{
+	if (!IsCapturing())
+		return;
+
+	s_Capturing.store(false, std::memory_order_release);
+	WriteTrace();
+}
+
+void Profiler::OnFrameEnd()
+{
+	if (!IsCapturing())
+		return;
+
+	++s_CapturedFrames;
+	if (s_CaptureFrameCount != 0 && s_CapturedFrames >= s_CaptureFrameCount)
+		EndCapture();
+}
+
+void Profiler::RecordScope(const char* name, uint64_t startNs, uint64_t endNs)
+{
+	ThreadBuffer* buffer = GetThreadBuffer();
+	uint32_t index = buffer->count.load(std::memory_order_relaxed);
+	if (index == PROFILER_EVENTS_PER_THREAD)
+	{
+		buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+
+	buffer->events[index] = { name, startNs, endNs - startNs };
+	// publishes the event to the thread that writes the capture
+	buffer->count.store(index + 1, std::memory_order_release);
+}
+
+Profiler::ThreadBuffer* Profiler::GetThreadBuffer()
+{
+	thread_local ThreadBuffer* threadBuffer = nullptr;
+	if (threadBuffer != nullptr)
+		return threadBuffer;
+
+	auto buffer = std::make_unique<ThreadBuffer>();
+	buffer->events = std::make_unique<Event[]>(PROFILER_EVENTS_PER_THREAD);
+
+	std::lock_guard<std::mutex> lock{ s_BuffersMutex };
+	buffer->threadIndex = static_cast<uint32_t>(s_Buffers.size());
+	threadBuffer = buffer.get();
+	s_Buffers.push_back(std::move(buffer));
+	return threadBuffer;
+}
+
+void Profiler::WriteTrace()
+{
+	std::ofstream file{ s_CapturePath, std::ios::out | std::ios::trunc };
+	if (!file.is_open())
+	{
+		Logger::Error("Failed to open {} to write the profiler capture", s_CapturePath);
+		return;
+	}
+
+	std::lock_guard<std::mutex> lock{ s_BuffersMutex };
+
+	// complete events ("ph": "X"), the timestamps and durations are in us
+	file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+	bool first = true;
+	uint32_t eventCount = 0;
+	uint32_t droppedCount = 0;
+	for (const auto& buffer : s_Buffers)
+	{
+		uint32_t count = buffer->count.load(std::memory_order_acquire);
+		eventCount += count;
+		droppedCount += buffer->dropped.load(std::memory_order_relaxed);
+
+		file << (first ? "" : ",") << fmt::format(
+			"\n{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+			buffer->threadIndex,
+			buffer->threadIndex == 0 ? "Main thread" : fmt::format("Thread {}", buffer->threadIndex));
+		first = false;
+
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			const Event& event = buffer->events[i];
+			// the names are identifiers or literals, only quotes and backslashes have to be escaped
+			std::string name{ event.name };
+			for (size_t pos = name.find_first_of("\"\\"); pos != std::string::npos;
+				 pos = name.find_first_of("\"\\", pos + 2))
+				name.insert(pos, 1, '\\');
+
+			file << fmt::format(",\n{{\"name\":\"{}\",\"ph\":\"X\",\"pid\":0,\"tid\":{},\"ts\":{:.3f},\"dur\":{:.3f}}}",
+				name,
+				buffer->threadIndex,
+				static_cast<double>(event.startNs) / 1000.0,
+				static_cast<double>(event.durationNs) / 1000.0);
+		}
+	}
+	file << "\n]}\n";
+
+	Logger::Info(
+		"Profiler capture of {} frames written to {} ({} scopes)", s_CapturedFrames, s_CapturePath, eventCount);
+	if (droppedCount > 0)
+		Logger::Warn("{} profiler scopes were dropped, the event buffers are full", droppedCount);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+#include <chrono>
+
+
+constexpr uint32_t PROFILER_EVENTS_PER_THREAD = 1 << 16; // per capture, the events after this are dropped
+
+// cpu scope profiler, the scopes are only recorded while a capture is running
+// a capture is written as a chrome trace (json), it can be opened in chrome://tracing or in perfetto (ui.perfetto.dev)
+//
+// every thread records into its own fixed size buffer, only the owning thread writes to it so recording a scope
+// is lock-free, the mutex is only taken when a thread records its first scope and when a capture starts or ends
+// captures have to be started and ended between frames, on the main thread
+//
+// the `PROFILE_*` macros expand to nothing when `ENABLE_PROFILER` is not defined
+class Profiler
+{
+public:
+	// records the next `frameCount` frames and writes them to `path`, 0 records until `EndCapture()` is called
+	static void BeginCapture(uint32_t frameCount, const std::string& path = "trace.json");
+	static void EndCapture();
+	// counts the captured frames, ends the capture after the requested number of frames
+	static void OnFrameEnd();
+
+	// `name` has to outlive the capture, eg: a string literal
+	static void RecordScope(const char* name, uint64_t startNs, uint64_t endNs);
+
+	static inline bool IsCapturing() { return s_Capturing.load(std::memory_order_relaxed); }
+	// ns since the start of the application
+	static inline uint64_t Now()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now() - s_StartTime).count());
+	}
+
+private:
+	struct Event
+	{
+		const char* name;
+		uint64_t startNs;
+		uint64_t durationNs;
+	};
+
+	struct ThreadBuffer
+	{
+		uint32_t threadIndex = 0;
+		std::unique_ptr<Event[]> events{};
+		// only written by the owning thread, read by the thread that writes the capture
+		std::atomic<uint32_t> count{ 0 };
+		std::atomic<uint32_t> dropped{ 0 };
+	};
+
+	static ThreadBuffer* GetThreadBuffer();
+	static void WriteTrace();
+
+private:
+	static const std::chrono::steady_clock::time_point s_StartTime;
+	static std::atomic<bool> s_Capturing;
+	static uint32_t s_CaptureFrameCount;
+	static uint32_t s_CapturedFrames;
+	static std::string s_CapturePath;
+
+	static std::mutex s_BuffersMutex;
+	static std::vector<std::unique_ptr<ThreadBuffer>> s_Buffers;
+};
+
+// measures the time from its construction to the end of the scope
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* name)
+		: m_Name{ name },
+		  m_StartNs{ Profiler::IsCapturing() ? Profiler::Now() : 0 }
+	{}
+
+	~ProfileScope()
+	{
+		// scopes that were open when the capture started are not recorded
+		if (m_StartNs != 0 && Profiler::IsCapturing())
+			Profiler::RecordScope(m_Name, m_StartNs, Profiler::Now());
+	}
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* m_Name;
+	uint64_t m_StartNs;
+};
+
+#ifdef ENABLE_PROFILER
+	#define PROFILE_CONCAT_IMPL(a, b) a##b
+	#define PROFILE_CONCAT(a, b)      PROFILE_CONCAT_IMPL(a, b)
+	#define PROFILE_SCOPE(name)       ProfileScope PROFILE_CONCAT(profileScope, __LINE__){ name }
+	#define PROFILE_FUNCTION()        PROFILE_SCOPE(__func__)
+	#define PROFILE_FRAME_END()       Profiler::OnFrameEnd()
+#else
+	#define PROFILE_SCOPE(name)
+	#define PROFILE_FUNCTION()
+	#define PROFILE_FRAME_END()
+#endif
@@ -1,6 +1,7 @@
 #include "core/window.h"
 
 #include "core/core.h"
+#include "core/profiler.h"
 
 
 Window::Window(const WindowProps& props)
@@ -69,6 +70,7 @@ void Window::Init(const WindowProps& props)
 
 void Window::OnUpdate()
 {
+	PROFILE_FUNCTION();
 	glfwPollEvents();
 }
 
@@ -57,9 +57,17 @@ const std::vector<Vertex> vertexData{
 const auto [indices, vertices] = utils::GetModelData(vertexData);
 
 
-Cube::Cube(VkRenderPass renderPass, const uint32_t maxFramesInFlight, const uint64_t numInstances)
+Cube::Cube(VkRenderPass renderPass,
+	VkRenderPass gBufferRenderPass,
+	const std::vector<const DescriptorSet*>& sharedDescriptorSets,
+	BindlessTextures* bindlessTextures,
+	Materials* materials,
+	const uint32_t maxFramesInFlight,
+	const uint64_t numInstances)
+	: m_SharedDescriptorSets{ sharedDescriptorSets }
 {
 	m_VertexBuffer = std::make_unique<VertexBuffer>(vertices);
+	m_PositionBuffer = std::make_unique<VertexBuffer>(utils::GetPositions(vertices));
 	m_IndexBuffer = std::make_unique<IndexBuffer>(indices);
 
 	std::array<const char*, 2> texturePaths{
@@ -87,11 +95,14 @@ Cube::Cube(VkRenderPass renderPass, const uint32_t maxFramesInFlight, const uint
 	m_Textures.reserve(texturePaths.size());
 	for (const auto& texturePath : texturePaths)
 		m_Textures.emplace_back(texturePath);
+	Material material{};
+	material.diffuseTexture = bindlessTextures->Add(m_Textures[0]);
+	material.specularTexture = bindlessTextures->Add(m_Textures[1]);
+	m_Material = materials->Add(material);
 
 	std::vector<VkDescriptorBufferInfo> uniformBufferInfos = UniformBuffer::GetBufferInfos(m_UniformBuffers);
 	std::vector<VkDescriptorBufferInfo> dynamicUniformBufferInfos =
 		UniformBuffer::GetBufferInfos(m_DynamicUniformBuffers);
-	std::vector<VkDescriptorImageInfo> textureImageInfos = Texture2D::GetImageInfos(m_Textures);
 
 	m_DescriptorSet = std::make_unique<DescriptorSet>(maxFramesInFlight);
 	m_DescriptorSet->SetupLayout({
@@ -109,37 +120,37 @@ Cube::Cube(VkRenderPass renderPass, const uint32_t maxFramesInFlight, const uint
 			1,
 			dynamicUniformBufferInfos.data(),
 			nullptr), //
-		DescriptorSet::CreateLayout( //
-			DescriptorType::SAMPLED_IMAGE,
-			ShaderType::FRAGMENT,
-			2,
-			static_cast<uint32_t>(m_Textures.size()),
-			nullptr,
-			textureImageInfos.data()), //
-		DescriptorSet::CreateLayout( //
-			DescriptorType::SAMPLER,
-			ShaderType::FRAGMENT,
-			3,
-			1,
-			nullptr,
-			&textureImageInfos[0]), // we only need the sampler
-	});
+	},
+		DescriptorSet::GetSetLayouts(m_SharedDescriptorSets));
 	m_DescriptorSet->Create();
-	m_Pipeline = std::make_unique<Pipeline>("assets/shaders/phongLighting.vert.spv",
-		"assets/shaders/phongLighting.frag.spv",
-		m_DescriptorSet->GetPipelineLayout(),
-		renderPass);
+	m_Pipelines = CreateLitPipelines(m_DescriptorSet->GetPipelineLayout(), renderPass, gBufferRenderPass);
 }
 
 void Cube::Draw(VkCommandBuffer commandBuffer,
 	const uint64_t currentFrameIndex,
 	const uint32_t dynamicOffsetCount,
-	const uint32_t* dynamicOffset)
+	const uint32_t* dynamicOffset,
+	DrawPass drawPass)
 {
-	m_VertexBuffer->Bind(commandBuffer);
+	if (drawPass == DrawPass::DEPTH_PREPASS)
+		m_PositionBuffer->Bind(commandBuffer);
+	else
+		m_VertexBuffer->Bind(commandBuffer);
 	m_IndexBuffer->Bind(commandBuffer);
-	m_Pipeline->Bind(commandBuffer);
+	m_Pipelines[static_cast<size_t>(drawPass)]->Bind(commandBuffer);
 	m_DescriptorSet->Bind(commandBuffer, currentFrameIndex, dynamicOffsetCount, dynamicOffset);
+	DescriptorSet::BindShared(
+		commandBuffer, m_DescriptorSet->GetPipelineLayout(), m_SharedDescriptorSets, currentFrameIndex);
+	VertexDecode{}.Push(commandBuffer, m_DescriptorSet->GetPipelineLayout()); // full precision vertices
+	m_Material.Push(commandBuffer, m_DescriptorSet->GetPipelineLayout());
+	m_IndexBuffer->Draw(commandBuffer);
+}
+
+void Cube::DrawPositions(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const
+{
+	VertexDecode{}.Push(commandBuffer, pipelineLayout);
+	m_PositionBuffer->Bind(commandBuffer);
+	m_IndexBuffer->Bind(commandBuffer);
 	m_IndexBuffer->Draw(commandBuffer);
 }
 
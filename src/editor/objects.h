@@ -6,34 +6,54 @@
 #include "renderer/texture.h"
 #include "renderer/pipeline.h"
 #include "renderer/descriptor.h"
+#include "renderer/materials.h"
+#include "renderer/bindlessTextures.h"
 #include "editor/ubo.h"
 
 
 class Cube
 {
 public:
-	Cube(VkRenderPass renderPass, const uint32_t maxFramesInFlight, const uint64_t numInstances);
+	Cube(VkRenderPass renderPass,
+		VkRenderPass gBufferRenderPass,
+		const std::vector<const DescriptorSet*>& sharedDescriptorSets,
+		BindlessTextures* bindlessTextures,
+		Materials* materials,
+		const uint32_t maxFramesInFlight,
+		const uint64_t numInstances);
 
 	void Draw(VkCommandBuffer commandBuffer,
 		const uint64_t currentFrameIndex,
 		const uint32_t dynamicOffsetCount,
-		const uint32_t* dynamicOffset);
+		const uint32_t* dynamicOffset,
+		DrawPass drawPass = DrawPass::FORWARD);
+	// only binds the position stream and draws, the pipeline is bound by the caller, eg: shadow maps
+	// `pipelineLayout` has the vertex decode push constant range, see `VertexDecode`
+	void DrawPositions(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const;
 
 	void UpdateUniformBuffers(const UniformBufferObject& ubo,
 		const DynamicUniformBufferObject& dUbo,
 		const uint32_t currentFrameIndex);
 
+	// object space bounding box
+	inline glm::vec3 GetBoundsMin() const { return glm::vec3(-0.5f); }
+	inline glm::vec3 GetBoundsMax() const { return glm::vec3(0.5f); }
+
 private:
+	// scene wide data (lighting, shadows), bound as set 1, 2, ...
+	std::vector<const DescriptorSet*> m_SharedDescriptorSets;
 	uint64_t m_DUboAlignmentSize = 0;
 
 	std::unique_ptr<VertexBuffer> m_VertexBuffer;
+	std::unique_ptr<VertexBuffer> m_PositionBuffer;
 	std::unique_ptr<IndexBuffer> m_IndexBuffer;
 	std::vector<Texture2D> m_Textures;
+	MaterialIndex m_Material{}; // in the material buffer
 
 	std::vector<UniformBuffer> m_UniformBuffers{};
 	std::vector<UniformBuffer> m_DynamicUniformBuffers{};
 	std::unique_ptr<DescriptorSet> m_DescriptorSet{};
-	std::unique_ptr<Pipeline> m_Pipeline{};
+	DrawPassPipelines m_Pipelines{};
 };
 
 
@@ -91,4 +91,49 @@ private:
 struct LightCubeUBO
 {
 	glm::mat4 transformationMat;
-};
\ No newline at end of file
+};
+
+struct PointLight
+{
+	// std430 layout, matches `PointLight` in the shaders
+	alignas(16) glm::vec4 position; // xyz = world space position, w = radius
+	alignas(16) glm::vec4 color; // rgb = color, a = intensity
+};
+
+struct ClusterUBO
+{
+	alignas(16) glm::mat4 viewMat;
+	alignas(16) glm::mat4 invProjMat;
+	alignas(16) glm::uvec4 gridSize; // xyz = cluster grid dimensions, w = light count
+	alignas(16) glm::vec4 screenParams; // xy = framebuffer size, z = near plane, w = far plane of the last slice
+};
+
+struct DeferredLightingUBO
+{
+	alignas(16) glm::mat4 invViewProjMat; // to reconstruct the world space position from the depth
+	alignas(16) glm::vec4 viewPos;
+};
+
+// has to match the value in the shaders
+constexpr uint32_t SHADOW_CASCADE_COUNT = 4;
+
+struct ShadowUBO
+{
+	alignas(16) glm::mat4 viewMat; // camera view, to select the cascade
+	alignas(16) glm::mat4 cascadeViewProjMats[SHADOW_CASCADE_COUNT];
+	alignas(16) glm::vec4 cascadeSplits; // far view space depth of each cascade
+	alignas(16) glm::vec4 sunDirection; // xyz = direction the light travels in
+	alignas(16) glm::vec4 sunColor; // rgb = color, a = intensity
+	alignas(16) glm::vec4 pointLightPos; // xyz = world space position of light 0, w = far plane of its cube map
+	alignas(16) glm::vec4 shadowParams; // x = shadows enabled, y = near plane of the cube map, z = normal offset
+};
+
+struct MeshletCullingUBO
+{
+	alignas(16) glm::mat4 modelMat;
+	alignas(16) glm::mat4 modelViewMat; // the occlusion test projects the bounding spheres from view space
+	alignas(16) glm::vec4 frustumPlanes[4]; // world space side planes of the camera, xyz = inward normal, w = distance
+	alignas(16) glm::vec4 cameraPos; // xyz = world space position, w = largest scale of the model matrix
+	alignas(16) glm::vec4 projection; // projection matrix elements, x = [0][0], y = [1][1], z = [2][2], w = [3][2]
+	alignas(16) glm::vec4 depthParams; // x = near plane, y = 1 with reverse-z
+};
@@ -1,11 +1,58 @@
+#include <string>
+#include <cstring>
+#include <sstream>
 #include "core/core.h"
 #include "core/application.h"
 
-int main()
+// --headless               render offscreen, without a window
+// --frames <count>         close after drawing `count` frames
+// --size <width> <height>  size of the window or of the offscreen images
+// --output <path.png>      save the last frame (headless)
+// --benchmark              fixed timestep and camera path, writes a report after the frames
+// --report <path.json>     path of the benchmark report
+// --camera-path <path>     keyframes of the benchmark camera path
+// --lights <count,...>     benchmarks each light count in turn, eg: 1,64,1024,4096
+static ApplicationOptions ParseOptions(int argc, char** argv)
+{
+	ApplicationOptions options{};
+	for (int i = 1; i < argc; ++i)
+	{
+		const int remaining = argc - i - 1;
+		if (std::strcmp(argv[i], "--headless") == 0)
+			options.headless = true;
+		else if (std::strcmp(argv[i], "--frames") == 0 && remaining >= 1)
+			options.frameCount = static_cast<uint32_t>(std::stoul(argv[++i]));
+		else if (std::strcmp(argv[i], "--size") == 0 && remaining >= 2)
+		{
+			options.width = static_cast<uint32_t>(std::stoul(argv[++i]));
+			options.height = static_cast<uint32_t>(std::stoul(argv[++i]));
+		}
+		else if (std::strcmp(argv[i], "--output") == 0 && remaining >= 1)
+			options.outputPath = argv[++i];
+		else if (std::strcmp(argv[i], "--benchmark") == 0)
+			options.benchmark = true;
+		else if (std::strcmp(argv[i], "--report") == 0 && remaining >= 1)
+			options.reportPath = argv[++i];
+		else if (std::strcmp(argv[i], "--camera-path") == 0 && remaining >= 1)
+			options.cameraPathFile = argv[++i];
+		else if (std::strcmp(argv[i], "--lights") == 0 && remaining >= 1)
+		{
+			std::stringstream counts{ argv[++i] };
+			for (std::string count; std::getline(counts, count, ',');)
+				options.lightCounts.push_back(static_cast<uint32_t>(std::stoul(count)));
+		}
+		else
+			Logger::Warn("Unknown argument: {}", argv[i]);
+	}
+
+	return options;
+}
+
+int main(int argc, char** argv)
 {
 	Logger::Init();
 
-	Application* app = Application::Create("Phong Lighting");
+	Application* app = Application::Create("Phong Lighting", ParseOptions(argc, argv));
 	app->Run();
 	delete app;
-}
\ No newline at end of file
+}
@@ -0,0 +1,139 @@
+#include "renderer/bindlessTextures.h"
+
+#include <algorithm>
+#include "core/core.h"
+#include "renderer/device.h"
+#include "renderer/samplerCache.h"
+
+
+BindlessTextures::BindlessTextures(const Materials& materials, const uint32_t maxFramesInFlight)
+{
+	const VkPhysicalDeviceDescriptorIndexingPropertiesEXT& limits = Device::GetDescriptorIndexingProperties();
+	m_Capacity = std::min({ BINDLESS_TEXTURE_CAPACITY,
+		limits.maxDescriptorSetUpdateAfterBindSampledImages,
+		limits.maxPerStageDescriptorUpdateAfterBindSampledImages });
+
+	CreateSampler();
+	m_Textures.reserve(m_Capacity);
+	m_TextureVersions.resize(maxFramesInFlight);
+	for (auto& versions : m_TextureVersions)
+		versions.reserve(m_Capacity);
+	m_TextureFeedback = std::make_unique<TextureFeedback>(m_Capacity, maxFramesInFlight);
+	std::vector<VkDescriptorBufferInfo> textureFeedbackInfos = m_TextureFeedback->GetBufferInfos();
+	std::vector<VkDescriptorBufferInfo> materialInfos = materials.GetBufferInfos();
+
+	// the array is only written when the textures are added
+	m_DescriptorSet = std::make_unique<DescriptorSet>(maxFramesInFlight);
+	m_DescriptorSet->SetupLayout({
+		DescriptorSet::CreateLayout( //
+			DescriptorType::SAMPLED_IMAGE,
+			ShaderType::FRAGMENT,
+			0,
+			m_Capacity,
+			nullptr,
+			nullptr,
+			VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT_EXT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT
+				| VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT_EXT), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::SAMPLER,
+			ShaderType::FRAGMENT,
+			1,
+			1,
+			nullptr,
+			nullptr,
+			0,
+			&m_Sampler), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::FRAGMENT,
+			2,
+			1,
+			textureFeedbackInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::FRAGMENT,
+			3,
+			1,
+			materialInfos.data(),
+			nullptr), //
+	});
+	m_DescriptorSet->Create();
+	Logger::Info("Bindless textures: {} slots", m_Capacity);
+}
+
+uint32_t BindlessTextures::Add(const Texture2D& texture)
+{
+	THROW(GetCount() >= m_Capacity, "The bindless texture array is full ({} textures)!", m_Capacity)
+
+	const uint32_t index = GetCount();
+	m_Textures.push_back(&texture);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_TextureVersions.size()); ++i)
+	{
+		m_TextureVersions[i].push_back(texture.GetVersion());
+		Write(index, i);
+	}
+	return index;
+}
+
+void BindlessTextures::ReadFeedback(const uint32_t currentFrameIndex)
+{
+	m_SampledLevels = m_TextureFeedback->Read(currentFrameIndex);
+}
+
+void BindlessTextures::Update(const uint32_t currentFrameIndex)
+{
+	// the set of this frame isn't used by the gpu anymore (its fence has been waited on), the other frames may still
+	// sample the old images, their sets are rewritten when they are recorded
+	std::vector<uint64_t>& versions = m_TextureVersions[currentFrameIndex];
+	std::vector<uint32_t> residentLevels(m_Textures.size());
+	for (uint32_t i = 0; i < GetCount(); ++i)
+	{
+		if (versions[i] != m_Textures[i]->GetVersion())
+		{
+			Write(i, currentFrameIndex);
+			versions[i] = m_Textures[i]->GetVersion();
+		}
+		residentLevels[i] = m_Textures[i]->GetResidentLevel();
+	}
+
+	// the lods the shaders write are relative to the resident levels of this frame
+	m_TextureFeedback->SetResidentLevels(residentLevels, currentFrameIndex);
+}
+
+void BindlessTextures::RecordFeedbackBarrier(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex)
+{
+	m_TextureFeedback->RecordHostReadBarrier(commandBuffer, currentFrameIndex);
+}
+
+void BindlessTextures::Write(uint32_t index, uint32_t setIndex)
+{
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageView = m_Textures[index]->GetImageInfo().imageView;
+	imageInfo.imageLayout = m_Textures[index]->GetImageInfo().imageLayout;
+	m_DescriptorSet->UpdateImage(0, index, imageInfo, setIndex);
+}
+
+void BindlessTextures::CreateSampler()
+{
+	// the same settings as the samplers of the textures, the cache returns their sampler
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_LINEAR;
+	samplerInfo.minFilter = VK_FILTER_LINEAR;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_REPEAT;
+	samplerInfo.anisotropyEnable = VK_TRUE;
+	samplerInfo.maxAnisotropy = Device::GetDeviceProperties().limits.maxSamplerAnisotropy;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+
+	m_Sampler = SamplerCache::Get(samplerInfo);
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "renderer/descriptor.h"
+#include "renderer/texture.h"
+#include "renderer/textureStreamer.h"
+#include "renderer/materials.h"
+
+
+// slots of the bindless texture array, clamped to the update after bind limits of the device
+constexpr uint32_t BINDLESS_TEXTURE_CAPACITY = 4096;
+
+// the textures of all the lit objects in one partially bound array (binding 0) with one sampler (binding 1), their
+// texture feedback (binding 2, one slot per texture) and the material buffer (binding 3, see `Materials`)
+// it is a shared set of the lit pipelines (set 3), the draws select their material with `MaterialIndex` and the
+// materials their textures, instead of binding a set with their own textures
+// the array is update after bind, the slots that aren't sampled by the pending frames can be written at any time
+class BindlessTextures
+{
+public:
+	BindlessTextures(const Materials& materials, const uint32_t maxFramesInFlight);
+
+	// writes the texture into the next slot, returns its index, the texture has to outlive the array
+	uint32_t Add(const Texture2D& texture);
+	// reads the finest levels the textures were sampled at the last time the frame was drawn, after the fence of the
+	// frame has been waited on
+	void ReadFeedback(const uint32_t currentFrameIndex);
+	// rewrites the slots of the textures whose images have been recreated (eg: by the texture streamer) in the set of
+	// the frame and records the resident levels the frame samples, before the frame is recorded
+	void Update(const uint32_t currentFrameIndex);
+	// after the last pass that samples the textures, see `TextureFeedback::RecordHostReadBarrier()`
+	void RecordFeedbackBarrier(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex);
+
+	// the level of the full chain from the last `ReadFeedback()`, `TextureFeedback::NONE` if it wasn't sampled
+	inline uint32_t GetSampledLevel(uint32_t index) const
+	{
+		return index < m_SampledLevels.size() ? m_SampledLevels[index] : TextureFeedback::NONE;
+	}
+	inline const DescriptorSet* GetDescriptorSet() const { return m_DescriptorSet.get(); }
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(m_Textures.size()); }
+	inline uint32_t GetCapacity() const { return m_Capacity; }
+
+private:
+	void Write(uint32_t index, uint32_t setIndex);
+	void CreateSampler();
+
+private:
+	uint32_t m_Capacity = 0;
+	std::vector<const Texture2D*> m_Textures{}; // per slot
+	std::vector<std::vector<uint64_t>> m_TextureVersions{}; // per frame in flight, of the images written into its set
+	std::vector<uint32_t> m_SampledLevels{};
+	std::unique_ptr<TextureFeedback> m_TextureFeedback{};
+	VkSampler m_Sampler{}; // immutable, baked into the set layout
+	std::unique_ptr<DescriptorSet> m_DescriptorSet{};
+};
@@ -18,8 +18,9 @@ constexpr float g_ZNear = 0.01f;
 constexpr float g_ZFar = 100.0f;
 
 
-Camera::Camera(float aspectRatio)
-	: m_AspectRatio{ aspectRatio },
+Camera::Camera(float aspectRatio, bool reverseZ)
+	: m_ReverseZ{ reverseZ },
+	  m_AspectRatio{ aspectRatio },
 	  m_CameraPos{ g_CameraPos },
 	  m_CameraFront{ g_CameraFront },
 	  m_CameraUp{ g_CameraUp },
@@ -34,7 +35,10 @@ Camera::Camera(float aspectRatio)
 	  m_ViewMatrix{},
 	  m_ProjectionMatrix{},
 	  m_ViewProjectionMatrix{}
-{}
+{
+	// the first frame is drawn before the first update
+	UpdateMatrices();
+}
 
 void Camera::OnUpdate(float deltatime)
 {
@@ -42,11 +46,7 @@ void Camera::OnUpdate(float deltatime)
 	if (io.WantCaptureKeyboard)
 		return;
 
-	m_ViewMatrix = glm::lookAt(m_CameraPos, m_CameraPos + m_CameraFront, m_CameraUp);
-	m_ProjectionMatrix = glm::perspective(m_FOVy, m_AspectRatio, m_ZNear, m_ZFar);
-	// glm was designed for opengl where the y-coord for clip coordinate is flipped
-	m_ProjectionMatrix[1][1] *= -1;
-	m_ViewProjectionMatrix = m_ProjectionMatrix * m_ViewMatrix;
+	UpdateMatrices();
 
 	// movement
 	const float cameraSpeed = 3.0f * (deltatime / 1000.0f);
@@ -88,6 +88,26 @@ void Camera::OnUpdate(float deltatime)
 	}
 }
 
+void Camera::UpdateMatrices()
+{
+	m_ViewMatrix = glm::lookAt(m_CameraPos, m_CameraPos + m_CameraFront, m_CameraUp);
+	if (m_ReverseZ)
+		m_ProjectionMatrix = InfinitePerspectiveReverseZ(m_FOVy, m_AspectRatio, m_ZNear);
+	else
+		m_ProjectionMatrix = glm::perspective(m_FOVy, m_AspectRatio, m_ZNear, m_ZFar);
+	// glm was designed for opengl where the y-coord for clip coordinate is flipped
+	m_ProjectionMatrix[1][1] *= -1;
+	m_ViewProjectionMatrix = m_ProjectionMatrix * m_ViewMatrix;
+}
+
+void Camera::LookAt(const glm::vec3& position, const glm::vec3& target)
+{
+	m_CameraPos = position;
+	m_CameraFront = glm::normalize(target - position);
+	m_Target = target;
+	UpdateMatrices();
+}
+
 void Camera::OnMouseMove(double xpos, double ypos)
 {
 	// initial values: m_Yaw = -90.0f, m_Pitch = 0.0f
@@ -128,3 +148,18 @@ void Camera::OnMouseMove(double xpos, double ypos)
 	direction.z = std::sinf(glm::radians(m_Yaw)) * std::cosf(glm::radians(m_Pitch));
 	m_CameraFront = glm::normalize(direction);
 }
+
+glm::mat4 Camera::InfinitePerspectiveReverseZ(float fovy, float aspectRatio, float zNear)
+{
+	// right handed, depth = zNear / viewDepth
+	// 1 at the near plane and approaches 0 at infinity
+	const float focalLength = 1.0f / std::tanf(fovy / 2.0f);
+
+	glm::mat4 projection{ 0.0f };
+	projection[0][0] = focalLength / aspectRatio;
+	projection[1][1] = focalLength;
+	projection[2][3] = -1.0f; // w = -z
+	projection[3][2] = zNear;
+
+	return projection;
+}
@@ -9,9 +9,14 @@
 class Camera
 {
 public:
-	Camera(float aspectRatio);
+	Camera(float aspectRatio, bool reverseZ = false);
 
+	// updates the matrices, then moves the camera with the keyboard input
 	void OnUpdate(float deltatime);
+	// updates the matrices without processing any input (eg: headless)
+	void UpdateMatrices();
+	// places the camera, the matrices are updated
+	void LookAt(const glm::vec3& position, const glm::vec3& target);
 	void OnMouseMove(double xpos, double ypos);
 
 	inline void SetAspectRatio(float aspectRatio) { m_AspectRatio = aspectRatio; }
@@ -19,9 +24,18 @@ public:
 	inline glm::mat4 GetProjectionMatrix() const { return m_ProjectionMatrix; }
 	inline glm::mat4 GetViewProjectionMatrix() const { return m_ViewProjectionMatrix; }
 	inline glm::vec3 GetCameraPosition() const { return m_CameraPos; }
+	inline float GetFOVy() const { return m_FOVy; }
+	inline float GetAspectRatio() const { return m_AspectRatio; }
+	inline float GetZNear() const { return m_ZNear; }
+	// the reverse-z projection has no far plane, this is then only the range covered by the light clusters
+	inline float GetZFar() const { return m_ZFar; }
+
+private:
+	static glm::mat4 InfinitePerspectiveReverseZ(float fovy, float aspectRatio, float zNear);
 
 private:
 	bool m_FirstMouseMove = true;
+	bool m_ReverseZ;
 	float m_AspectRatio;
 
 	glm::vec3 m_CameraPos;
@@ -0,0 +1,77 @@
+#include "renderer/cameraPath.h"
+
+#include <cmath>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <glm/gtc/constants.hpp>
+#include "core/core.h"
+
+
+constexpr uint32_t DEFAULT_PATH_KEYFRAMES = 8;
+
+CameraPath::CameraPath()
+{
+	// a loop around the models, moving in and out and up and down
+	m_Keyframes.reserve(DEFAULT_PATH_KEYFRAMES);
+	for (uint32_t i = 0; i < DEFAULT_PATH_KEYFRAMES; ++i)
+	{
+		float angle = glm::two_pi<float>() * static_cast<float>(i) / static_cast<float>(DEFAULT_PATH_KEYFRAMES);
+		float radius = (i % 2 == 0) ? 3.0f : 5.0f;
+		float height = (i % 4 < 2) ? 0.5f : 2.0f;
+		m_Keyframes.push_back(
+			{ glm::vec3(radius * std::sin(angle), height, radius * std::cos(angle)), glm::vec3(0.0f) });
+	}
+}
+
+CameraPath::CameraPath(const std::string& filepath)
+{
+	std::ifstream file{ filepath };
+	THROW(!file.is_open(), "Failed to open the camera path: {}", filepath)
+
+	std::string line{};
+	while (std::getline(file, line))
+	{
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		std::istringstream stream{ line };
+		CameraPose pose{};
+		stream >> pose.position.x >> pose.position.y >> pose.position.z >> pose.target.x >> pose.target.y
+			>> pose.target.z;
+		THROW(stream.fail(), "Invalid camera path keyframe: {}", line)
+		m_Keyframes.push_back(pose);
+	}
+
+	THROW(m_Keyframes.size() < 2, "A camera path needs at least 2 keyframes: {}", filepath)
+}
+
+CameraPose CameraPath::Evaluate(float t) const
+{
+	const size_t count = m_Keyframes.size();
+	float position = (t - std::floor(t)) * static_cast<float>(count);
+	size_t segment = std::min(static_cast<size_t>(position), count - 1);
+	float local = position - static_cast<float>(segment);
+
+	// the path is closed, the keyframes wrap around
+	const CameraPose& p0 = m_Keyframes[(segment + count - 1) % count];
+	const CameraPose& p1 = m_Keyframes[segment];
+	const CameraPose& p2 = m_Keyframes[(segment + 1) % count];
+	const CameraPose& p3 = m_Keyframes[(segment + 2) % count];
+
+	return { CatmullRom(p0.position, p1.position, p2.position, p3.position, local),
+		CatmullRom(p0.target, p1.target, p2.target, p3.target, local) };
+}
+
+glm::vec3 CameraPath::CatmullRom(const glm::vec3& p0,
+	const glm::vec3& p1,
+	const glm::vec3& p2,
+	const glm::vec3& p3,
+	float t)
+{
+	float t2 = t * t;
+	float t3 = t2 * t;
+	return 0.5f
+		   * ((2.0f * p1) + (p2 - p0) * t + (2.0f * p0 - 5.0f * p1 + 4.0f * p2 - p3) * t2
+			  + (3.0f * p1 - p0 - 3.0f * p2 + p3) * t3);
+}
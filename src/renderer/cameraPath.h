@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+
+struct CameraPose
+{
+	glm::vec3 position{ 0.0f };
+	glm::vec3 target{ 0.0f };
+};
+
+// closed catmull-rom spline through camera keyframes, the camera flies the same way in every benchmark run
+class CameraPath
+{
+public:
+	// orbits around the scene
+	CameraPath();
+	// one keyframe per line: `px py pz tx ty tz`, empty lines and lines starting with `#` are skipped
+	explicit CameraPath(const std::string& filepath);
+
+	// `t` is the position along the path, [0, 1) is one loop
+	CameraPose Evaluate(float t) const;
+
+private:
+	static glm::vec3
+		CatmullRom(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2, const glm::vec3& p3, float t);
+
+private:
+	std::vector<CameraPose> m_Keyframes{};
+};
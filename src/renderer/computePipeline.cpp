@@ -0,0 +1,37 @@
+#include "renderer/computePipeline.h"
+
+#include "core/core.h"
+#include "renderer/device.h"
+#include "renderer/shader.h"
+
+
+ComputePipeline::ComputePipeline(const char* compShaderPath, VkPipelineLayout pipelineLayout)
+{
+	Init(compShaderPath, pipelineLayout);
+}
+
+ComputePipeline::~ComputePipeline()
+{
+	Cleanup();
+}
+
+void ComputePipeline::Init(const char* compShaderPath, VkPipelineLayout pipelineLayout)
+{
+	Shader computeShader{ compShaderPath, ShaderType::COMPUTE };
+
+	VkComputePipelineCreateInfo computePipelineInfo{};
+	computePipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	computePipelineInfo.stage = computeShader.GetShaderStage();
+	computePipelineInfo.layout = pipelineLayout;
+	computePipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
+	computePipelineInfo.basePipelineIndex = -1;
+
+	THROW(vkCreateComputePipelines(Device::GetDevice(), VK_NULL_HANDLE, 1, &computePipelineInfo, nullptr, &m_Pipeline)
+			  != VK_SUCCESS,
+		"Failed to create compute pipeline!");
+}
+
+void ComputePipeline::Cleanup()
+{
+	vkDestroyPipeline(Device::GetDevice(), m_Pipeline, nullptr);
+}
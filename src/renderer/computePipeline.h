@@ -0,0 +1,32 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+
+class ComputePipeline
+{
+public:
+	ComputePipeline(const char* compShaderPath, VkPipelineLayout pipelineLayout);
+	~ComputePipeline();
+
+	inline void Bind(VkCommandBuffer commandBuffer)
+	{
+		vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+	}
+
+	inline void Dispatch(VkCommandBuffer commandBuffer,
+		uint32_t groupCountX,
+		uint32_t groupCountY,
+		uint32_t groupCountZ)
+	{
+		vkCmdDispatch(commandBuffer, groupCountX, groupCountY, groupCountZ);
+	}
+
+	inline VkPipeline GetPipeline() const { return m_Pipeline; }
+
+private:
+	void Init(const char* compShaderPath, VkPipelineLayout pipelineLayout);
+	void Cleanup();
+
+private:
+	VkPipeline m_Pipeline{};
+};
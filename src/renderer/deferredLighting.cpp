@@ -0,0 +1,86 @@
+#include "renderer/deferredLighting.h"
+
+#include <array>
+#include <glm/glm.hpp>
+#include "renderer/renderStats.h"
+
+
+DeferredLighting::DeferredLighting(VkRenderPass renderPass,
+	const GBuffer* gBuffer,
+	const std::vector<const DescriptorSet*>& sharedDescriptorSets,
+	const uint32_t maxFramesInFlight)
+	: m_GBuffer{ gBuffer },
+	  m_SharedDescriptorSets{ sharedDescriptorSets }
+{
+	VkDeviceSize uboSize = sizeof(DeferredLightingUBO);
+
+	m_UniformBuffers.reserve(maxFramesInFlight);
+	for (uint64_t i = 0; i < maxFramesInFlight; ++i)
+	{
+		m_UniformBuffers.emplace_back(
+			uboSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uboSize);
+	}
+
+	std::vector<VkDescriptorBufferInfo> uniformBufferInfos = UniformBuffer::GetBufferInfos(m_UniformBuffers);
+	// the images are written by `SetGBufferImages()` once the render graph has created them
+	std::array<VkSampler, GBUFFER_ATTACHMENT_COUNT> gBufferSamplers{};
+	gBufferSamplers.fill(m_GBuffer->GetSampler());
+
+	m_DescriptorSet = std::make_unique<DescriptorSet>(maxFramesInFlight);
+	m_DescriptorSet->SetupLayout({
+		DescriptorSet::CreateLayout( //
+			DescriptorType::UNIFORM_BUFFER,
+			ShaderType::FRAGMENT,
+			0,
+			1,
+			uniformBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::COMBINED_IMAGE_SAMPLER,
+			ShaderType::FRAGMENT,
+			1,
+			GBUFFER_ATTACHMENT_COUNT,
+			nullptr,
+			nullptr,
+			0,
+			gBufferSamplers.data()), //
+	},
+		DescriptorSet::GetSetLayouts(m_SharedDescriptorSets));
+	m_DescriptorSet->Create();
+
+	// the depth is always written (not tested), it is the depth of the g-buffer
+	PipelineConfig config{};
+	config.vertexLayout = VertexLayout::NONE;
+	config.cullMode = VK_CULL_MODE_NONE;
+	config.sampleShading = false;
+	config.depthCompareOp = VK_COMPARE_OP_ALWAYS;
+	m_Pipeline = std::make_unique<Pipeline>("assets/shaders/deferredLighting.vert.spv",
+		"assets/shaders/deferredLighting.frag.spv",
+		m_DescriptorSet->GetPipelineLayout(),
+		renderPass,
+		config);
+}
+
+void DeferredLighting::SetGBufferImages(const std::array<VkDescriptorImageInfo, GBUFFER_ATTACHMENT_COUNT>& imageInfos)
+{
+	m_DescriptorSet->UpdateImages(1, imageInfos.data());
+}
+
+void DeferredLighting::Draw(VkCommandBuffer commandBuffer, const uint64_t currentFrameIndex)
+{
+	m_Pipeline->Bind(commandBuffer);
+	m_DescriptorSet->Bind(commandBuffer, currentFrameIndex, 0, nullptr);
+	DescriptorSet::BindShared(
+		commandBuffer, m_DescriptorSet->GetPipelineLayout(), m_SharedDescriptorSets, currentFrameIndex);
+
+	// fullscreen triangle
+	RenderStats::CountDraw(3);
+	vkCmdDraw(commandBuffer, 3, 1, 0, 0);
+}
+
+void DeferredLighting::UpdateUniformBuffers(const Camera& camera, const uint32_t currentFrameIndex)
+{
+	m_Ubo.invViewProjMat = glm::inverse(camera.GetViewProjectionMatrix());
+	m_Ubo.viewPos = glm::vec4(camera.GetCameraPosition(), 1.0f);
+	m_UniformBuffers[currentFrameIndex].Map(&m_Ubo);
+}
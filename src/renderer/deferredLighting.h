@@ -0,0 +1,43 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <vulkan/vulkan.h>
+#include "renderer/uniformBuffer.h"
+#include "renderer/descriptor.h"
+#include "renderer/pipeline.h"
+#include "renderer/camera.h"
+#include "renderer/gBuffer.h"
+#include "editor/ubo.h"
+
+
+// lighting pass of the deferred shading path
+// a fullscreen triangle drawn in the swapchain render pass, that samples the g-buffer
+// and shades every pixel with the sun and the clustered lights (see `LightClusters`, `ShadowMaps`)
+// it also writes the g-buffer depth so that the forward passes after it are depth tested against the scene
+class DeferredLighting
+{
+public:
+	DeferredLighting(VkRenderPass renderPass,
+		const GBuffer* gBuffer,
+		const std::vector<const DescriptorSet*>& sharedDescriptorSets,
+		const uint32_t maxFramesInFlight);
+
+	// the sampled g-buffer images (see `GBuffer::CreateImages()`), has to be called after the render graph has
+	// recreated them, the samplers are immutable
+	void SetGBufferImages(const std::array<VkDescriptorImageInfo, GBUFFER_ATTACHMENT_COUNT>& imageInfos);
+
+	void Draw(VkCommandBuffer commandBuffer, const uint64_t currentFrameIndex);
+	void UpdateUniformBuffers(const Camera& camera, const uint32_t currentFrameIndex);
+
+private:
+	const GBuffer* m_GBuffer;
+	// scene wide data (lighting, shadows), bound as set 1, 2, ...
+	std::vector<const DescriptorSet*> m_SharedDescriptorSets;
+
+	DeferredLightingUBO m_Ubo{};
+	std::vector<UniformBuffer> m_UniformBuffers{};
+	std::unique_ptr<DescriptorSet> m_DescriptorSet{};
+	std::unique_ptr<Pipeline> m_Pipeline{};
+};
@@ -1,14 +1,23 @@
 #include "renderer/descriptor.h"
 
 #include <array>
+#include <cstring>
+#include <algorithm>
 #include "core/core.h"
 #include "renderer/device.h"
+#include "renderer/vertexBuffer.h"
+#include "renderer/bindlessTextures.h"
 
 
 VkDescriptorPool DescriptorPool::s_DescriptorPool{};
+VkDescriptorPool DescriptorPool::s_UpdateAfterBindPool{};
+std::unique_ptr<DescriptorAllocator> DescriptorPool::s_Allocator{};
 
 void DescriptorPool::Init()
 {
+	s_Allocator = std::make_unique<DescriptorAllocator>();
+
+	// imgui frees its sets individually, the renderer allocates from `s_Allocator`
 	VkDescriptorPoolSize poolSizes[] = {
 		{VK_DESCRIPTOR_TYPE_SAMPLER,                 1000},
 		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1000},
@@ -32,10 +41,29 @@ void DescriptorPool::Init()
 
 	THROW(vkCreateDescriptorPool(Device::GetDevice(), &descriptorPoolInfo, nullptr, &s_DescriptorPool) != VK_SUCCESS,
 		"Failed to create descriptor pool!");
+
+	// the bindless texture arrays with their feedback and material buffers, one set per frame in flight
+	VkDescriptorPoolSize updateAfterBindPoolSizes[] = {
+		{VK_DESCRIPTOR_TYPE_SAMPLER,         16},
+		{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,  4 * BINDLESS_TEXTURE_CAPACITY},
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 32}
+	};
+
+	descriptorPoolInfo.flags =
+		VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT | VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT_EXT;
+	descriptorPoolInfo.maxSets = 16;
+	descriptorPoolInfo.poolSizeCount = std::size(updateAfterBindPoolSizes);
+	descriptorPoolInfo.pPoolSizes = updateAfterBindPoolSizes;
+
+	THROW(vkCreateDescriptorPool(Device::GetDevice(), &descriptorPoolInfo, nullptr, &s_UpdateAfterBindPool)
+			  != VK_SUCCESS,
+		"Failed to create update after bind descriptor pool!");
 }
 
 void DescriptorPool::Cleanup()
 {
+	s_Allocator.reset();
+	vkDestroyDescriptorPool(Device::GetDevice(), s_UpdateAfterBindPool, nullptr);
 	vkDestroyDescriptorPool(Device::GetDevice(), s_DescriptorPool, nullptr);
 }
 
@@ -57,11 +85,13 @@ void DescriptorSet::Init(uint32_t descriptorSetCount)
 
 void DescriptorSet::Cleanup()
 {
+	vkDestroyDescriptorUpdateTemplate(Device::GetDevice(), m_UpdateTemplate, nullptr);
 	vkDestroyPipelineLayout(Device::GetDevice(), m_PipelineLayout, nullptr);
 	vkDestroyDescriptorSetLayout(Device::GetDevice(), m_DescriptorSetLayout, nullptr);
 }
 
-void DescriptorSet::SetupLayout(std::initializer_list<DescriptorLayout> layout)
+void DescriptorSet::SetupLayout(std::initializer_list<DescriptorLayout> layout,
+	const std::vector<VkDescriptorSetLayout>& sharedSetLayouts)
 {
 	m_DescriptorLayout.insert(m_DescriptorLayout.end(), layout);
 	m_LayoutBindings.reserve(layout.size());
@@ -72,7 +102,7 @@ void DescriptorSet::SetupLayout(std::initializer_list<DescriptorLayout> layout)
 		layoutBinding.descriptorType = static_cast<VkDescriptorType>(l.descriptorType);
 		layoutBinding.descriptorCount = l.descriptorCount;
 		layoutBinding.stageFlags = static_cast<VkShaderStageFlags>(l.shaderStageFlags);
-		layoutBinding.pImmutableSamplers = nullptr;
+		layoutBinding.pImmutableSamplers = l.pImmutableSamplers;
 
 		m_LayoutBindings.push_back(layoutBinding);
 	}
@@ -82,48 +112,172 @@ void DescriptorSet::SetupLayout(std::initializer_list<DescriptorLayout> layout)
 	descriptorSetLayoutInfo.bindingCount = static_cast<uint32_t>(m_LayoutBindings.size());
 	descriptorSetLayoutInfo.pBindings = m_LayoutBindings.data();
 
+	// only chained if a binding has flags
+	std::vector<VkDescriptorBindingFlagsEXT> bindingFlags{};
+	bindingFlags.reserve(layout.size());
+	for (auto& l : layout)
+	{
+		bindingFlags.push_back(l.bindingFlags);
+		if (l.bindingFlags & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT)
+			m_UpdateAfterBind = true;
+	}
+
+	VkDescriptorSetLayoutBindingFlagsCreateInfoEXT bindingFlagsInfo{};
+	bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO_EXT;
+	bindingFlagsInfo.bindingCount = static_cast<uint32_t>(bindingFlags.size());
+	bindingFlagsInfo.pBindingFlags = bindingFlags.data();
+	if (std::any_of(bindingFlags.begin(), bindingFlags.end(), [](VkDescriptorBindingFlagsEXT flags) {
+			return flags != 0;
+		}))
+		descriptorSetLayoutInfo.pNext = &bindingFlagsInfo;
+	if (m_UpdateAfterBind)
+		descriptorSetLayoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT;
+
 	THROW(vkCreateDescriptorSetLayout(Device::GetDevice(), &descriptorSetLayoutInfo, nullptr, &m_DescriptorSetLayout)
 			  != VK_SUCCESS,
 		"Failed to create descriptor set layout!");
 
-	VkPushConstantRange pushConstantRange{};
-	pushConstantRange.offset = 0;
-	pushConstantRange.size = sizeof(int32_t);
-	pushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	std::array<VkPushConstantRange, 3> pushConstantRanges{};
+	pushConstantRanges[0].offset = 0;
+	pushConstantRanges[0].size = FRAGMENT_PUSH_CONSTANT_SIZE;
+	pushConstantRanges[0].stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	// the vertex decode of the mesh that is drawn, see `VertexDecode`
+	pushConstantRanges[1].offset = VERTEX_DECODE_PUSH_CONSTANT_OFFSET;
+	pushConstantRanges[1].size = sizeof(VertexDecode);
+	pushConstantRanges[1].stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	// the parameters of a compute dispatch, eg: the level of a pass that is dispatched once per level
+	pushConstantRanges[2].offset = 0;
+	pushConstantRanges[2].size = COMPUTE_PUSH_CONSTANT_SIZE;
+	pushConstantRanges[2].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+
+	// set 0 is always the layout owned by this descriptor set
+	std::vector<VkDescriptorSetLayout> setLayouts{ m_DescriptorSetLayout };
+	setLayouts.insert(setLayouts.end(), sharedSetLayouts.begin(), sharedSetLayouts.end());
 
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-	pipelineLayoutInfo.setLayoutCount = 1;
-	pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
-	pipelineLayoutInfo.pushConstantRangeCount = 1;
-	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+	pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+	pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+	pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+	pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
 
 	THROW(vkCreatePipelineLayout(Device::GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS,
 		"Failed to create pipeline layout!");
 }
 
-void DescriptorSet::Create()
+// eg: a partially bound array that is filled later, or samplers that are baked into the layout
+static bool IsWrittenOnCreate(const DescriptorLayout& layout)
 {
-	std::vector<VkDescriptorSetLayout> setLayouts{ m_DescriptorSetCount, m_DescriptorSetLayout };
-
-	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
-	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	descriptorSetAllocateInfo.descriptorPool = DescriptorPool::Get();
-	descriptorSetAllocateInfo.descriptorSetCount = m_DescriptorSetCount;
-	descriptorSetAllocateInfo.pSetLayouts = setLayouts.data();
+	return (layout.pBufferInfos != nullptr || layout.pImageInfos != nullptr)
+		   && !(layout.descriptorType == DescriptorType::SAMPLER && layout.pImmutableSamplers != nullptr);
+}
 
+void DescriptorSet::Create()
+{
 	// we create one descriptor set for each frame with the same layout
 	m_DescriptorSets.resize(m_DescriptorSetCount);
-	THROW(vkAllocateDescriptorSets(Device::GetDevice(), &descriptorSetAllocateInfo, m_DescriptorSets.data())
-			  != VK_SUCCESS,
-		"Failed to allocate descriptor sets!")
+	if (m_UpdateAfterBind)
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts{ m_DescriptorSetCount, m_DescriptorSetLayout };
 
-	for (uint64_t i = 0; i < m_DescriptorSetCount; ++i)
+		VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+		descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+		descriptorSetAllocateInfo.descriptorPool = DescriptorPool::GetUpdateAfterBind();
+		descriptorSetAllocateInfo.descriptorSetCount = m_DescriptorSetCount;
+		descriptorSetAllocateInfo.pSetLayouts = setLayouts.data();
+
+		THROW(vkAllocateDescriptorSets(Device::GetDevice(), &descriptorSetAllocateInfo, m_DescriptorSets.data())
+				  != VK_SUCCESS,
+			"Failed to allocate descriptor sets!")
+	}
+	else
 	{
-		std::vector<VkWriteDescriptorSet> descriptorWrites{};
+		for (auto& descriptorSet : m_DescriptorSets)
+			descriptorSet = DescriptorPool::GetAllocator().Allocate(m_DescriptorSetLayout);
+	}
+
+	CreateUpdateTemplate();
+	if (m_UpdateTemplate == VK_NULL_HANDLE)
+		return;
 
-		descriptorWrites.reserve(m_DescriptorLayout.size());
+	// the buffer infos of the set and the shared image infos, in the order of the template entries
+	std::vector<uint8_t> data(m_UpdateTemplateSize);
+	for (uint64_t i = 0; i < m_DescriptorSetCount; ++i)
+	{
+		size_t offset = 0;
 		for (auto& layout : m_DescriptorLayout)
+		{
+			if (!IsWrittenOnCreate(layout))
+				continue;
+
+			if (layout.pBufferInfos != nullptr)
+			{
+				const size_t size = sizeof(VkDescriptorBufferInfo) * layout.descriptorCount;
+				std::memcpy(data.data() + offset, &layout.pBufferInfos[i], size);
+				offset += size;
+			}
+			else
+			{
+				const size_t size = sizeof(VkDescriptorImageInfo) * layout.descriptorCount;
+				std::memcpy(data.data() + offset, layout.pImageInfos, size);
+				offset += size;
+			}
+		}
+
+		vkUpdateDescriptorSetWithTemplate(Device::GetDevice(), m_DescriptorSets[i], m_UpdateTemplate, data.data());
+	}
+}
+
+void DescriptorSet::CreateUpdateTemplate()
+{
+	if (m_UpdateTemplate != VK_NULL_HANDLE)
+		return;
+
+	std::vector<VkDescriptorUpdateTemplateEntry> entries{};
+	entries.reserve(m_DescriptorLayout.size());
+	m_UpdateTemplateSize = 0;
+	for (auto& layout : m_DescriptorLayout)
+	{
+		if (!IsWrittenOnCreate(layout))
+			continue;
+
+		VkDescriptorUpdateTemplateEntry entry{};
+		entry.dstBinding = layout.shaderBinding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = layout.descriptorCount;
+		entry.descriptorType = static_cast<VkDescriptorType>(layout.descriptorType);
+		entry.offset = m_UpdateTemplateSize;
+		entry.stride = layout.pBufferInfos != nullptr ? sizeof(VkDescriptorBufferInfo) : sizeof(VkDescriptorImageInfo);
+		m_UpdateTemplateSize += entry.stride * entry.descriptorCount;
+
+		entries.push_back(entry);
+	}
+
+	if (entries.empty())
+		return;
+
+	VkDescriptorUpdateTemplateCreateInfo updateTemplateInfo{};
+	updateTemplateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO;
+	updateTemplateInfo.descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size());
+	updateTemplateInfo.pDescriptorUpdateEntries = entries.data();
+	updateTemplateInfo.templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET;
+	updateTemplateInfo.descriptorSetLayout = m_DescriptorSetLayout;
+
+	THROW(vkCreateDescriptorUpdateTemplate(Device::GetDevice(), &updateTemplateInfo, nullptr, &m_UpdateTemplate)
+			  != VK_SUCCESS,
+		"Failed to create descriptor update template!")
+}
+
+void DescriptorSet::UpdateImages(uint32_t shaderBinding, const VkDescriptorImageInfo* pImageInfos)
+{
+	for (auto& layout : m_DescriptorLayout)
+	{
+		if (layout.shaderBinding != shaderBinding)
+			continue;
+
+		std::vector<VkWriteDescriptorSet> descriptorWrites{};
+		descriptorWrites.reserve(m_DescriptorSetCount);
+		for (uint64_t i = 0; i < m_DescriptorSetCount; ++i)
 		{
 			VkWriteDescriptorSet descWrite{};
 			descWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
@@ -132,15 +286,97 @@ void DescriptorSet::Create()
 			descWrite.dstArrayElement = 0;
 			descWrite.descriptorType = static_cast<VkDescriptorType>(layout.descriptorType);
 			descWrite.descriptorCount = layout.descriptorCount;
-			descWrite.pBufferInfo = layout.pBufferInfos == nullptr ? nullptr : &layout.pBufferInfos[i];
-			descWrite.pImageInfo = layout.pImageInfos == nullptr ? nullptr : layout.pImageInfos;
+			descWrite.pImageInfo = pImageInfos;
 
 			descriptorWrites.push_back(descWrite);
 		}
 
 		vkUpdateDescriptorSets(
 			Device::GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+		return;
+	}
+
+	LOG_AND_THROW("Descriptor binding {} does not exist!", shaderBinding);
+}
+
+void DescriptorSet::UpdateImages(uint32_t shaderBinding, const VkDescriptorImageInfo* pImageInfos, uint32_t setIndex)
+{
+	for (auto& layout : m_DescriptorLayout)
+	{
+		if (layout.shaderBinding != shaderBinding)
+			continue;
+
+		VkWriteDescriptorSet descWrite{};
+		descWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descWrite.dstSet = m_DescriptorSets[setIndex];
+		descWrite.dstBinding = layout.shaderBinding;
+		descWrite.dstArrayElement = 0;
+		descWrite.descriptorType = static_cast<VkDescriptorType>(layout.descriptorType);
+		descWrite.descriptorCount = layout.descriptorCount;
+		descWrite.pImageInfo = pImageInfos;
+
+		vkUpdateDescriptorSets(Device::GetDevice(), 1, &descWrite, 0, nullptr);
+		return;
 	}
+
+	LOG_AND_THROW("Descriptor binding {} does not exist!", shaderBinding);
+}
+
+void DescriptorSet::UpdateImage(uint32_t shaderBinding, uint32_t arrayElement, const VkDescriptorImageInfo& imageInfo)
+{
+	for (auto& layout : m_DescriptorLayout)
+	{
+		if (layout.shaderBinding != shaderBinding)
+			continue;
+
+		std::vector<VkWriteDescriptorSet> descriptorWrites{};
+		descriptorWrites.reserve(m_DescriptorSetCount);
+		for (uint64_t i = 0; i < m_DescriptorSetCount; ++i)
+		{
+			VkWriteDescriptorSet descWrite{};
+			descWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+			descWrite.dstSet = m_DescriptorSets[i];
+			descWrite.dstBinding = layout.shaderBinding;
+			descWrite.dstArrayElement = arrayElement;
+			descWrite.descriptorType = static_cast<VkDescriptorType>(layout.descriptorType);
+			descWrite.descriptorCount = 1;
+			descWrite.pImageInfo = &imageInfo;
+
+			descriptorWrites.push_back(descWrite);
+		}
+
+		vkUpdateDescriptorSets(
+			Device::GetDevice(), static_cast<uint32_t>(descriptorWrites.size()), descriptorWrites.data(), 0, nullptr);
+		return;
+	}
+
+	LOG_AND_THROW("Descriptor binding {} does not exist!", shaderBinding);
+}
+
+void DescriptorSet::UpdateImage(uint32_t shaderBinding,
+	uint32_t arrayElement,
+	const VkDescriptorImageInfo& imageInfo,
+	uint32_t setIndex)
+{
+	for (auto& layout : m_DescriptorLayout)
+	{
+		if (layout.shaderBinding != shaderBinding)
+			continue;
+
+		VkWriteDescriptorSet descWrite{};
+		descWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		descWrite.dstSet = m_DescriptorSets[setIndex];
+		descWrite.dstBinding = layout.shaderBinding;
+		descWrite.dstArrayElement = arrayElement;
+		descWrite.descriptorType = static_cast<VkDescriptorType>(layout.descriptorType);
+		descWrite.descriptorCount = 1;
+		descWrite.pImageInfo = &imageInfo;
+
+		vkUpdateDescriptorSets(Device::GetDevice(), 1, &descWrite, 0, nullptr);
+		return;
+	}
+
+	LOG_AND_THROW("Descriptor binding {} does not exist!", shaderBinding);
 }
 
 DescriptorLayout DescriptorSet::CreateLayout(DescriptorType descriptorType,
@@ -148,7 +384,9 @@ DescriptorLayout DescriptorSet::CreateLayout(DescriptorType descriptorType,
 	uint32_t shaderBinding,
 	uint32_t descriptorCount,
 	VkDescriptorBufferInfo* pBufferInfos,
-	VkDescriptorImageInfo* pImageInfos)
+	VkDescriptorImageInfo* pImageInfos,
+	VkDescriptorBindingFlagsEXT bindingFlags,
+	const VkSampler* pImmutableSamplers)
 {
 	DescriptorLayout layout{};
 	layout.shaderBinding = shaderBinding;
@@ -157,6 +395,8 @@ DescriptorLayout DescriptorSet::CreateLayout(DescriptorType descriptorType,
 	layout.shaderStageFlags = shaderStage;
 	layout.pBufferInfos = pBufferInfos;
 	layout.pImageInfos = pImageInfos;
+	layout.bindingFlags = bindingFlags;
+	layout.pImmutableSamplers = pImmutableSamplers;
 
 	return layout;
 }
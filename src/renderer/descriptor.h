@@ -2,10 +2,12 @@
 
 #include <vulkan/vulkan.h>
 #include <vector>
+#include <memory>
 #include <initializer_list>
 #include "renderer/shader.h"
 #include "renderer/uniformBuffer.h"
 #include "renderer/texture.h"
+#include "renderer/descriptorAllocator.h"
 
 
 enum class DescriptorType
@@ -13,12 +15,18 @@ enum class DescriptorType
 	SAMPLER = VK_DESCRIPTOR_TYPE_SAMPLER,
 	COMBINED_IMAGE_SAMPLER = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER,
 	SAMPLED_IMAGE = VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,
+	STORAGE_IMAGE = VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,
 	UNIFORM_BUFFER = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,
 	STORAGE_BUFFER = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,
 	UNIFORM_BUFFER_DYNAMIC = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC,
 	STORAGE_BUFFER_DYNAMIC = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC,
 };
 
+// size of the push constant range of the compute stage, at offset 0 of every pipeline layout
+constexpr uint32_t COMPUTE_PUSH_CONSTANT_SIZE = 16;
+// size of the push constant range of the fragment stage, at offset 0 of every pipeline layout (see `MaterialIndex`)
+constexpr uint32_t FRAGMENT_PUSH_CONSTANT_SIZE = 4;
+
 struct DescriptorLayout
 {
 	DescriptorType descriptorType;
@@ -28,6 +36,11 @@ struct DescriptorLayout
 
 	VkDescriptorBufferInfo* pBufferInfos = nullptr;
 	VkDescriptorImageInfo* pImageInfos = nullptr;
+	// eg: partially bound, the descriptors of a binding without infos are not written by `DescriptorSet::Create()`
+	VkDescriptorBindingFlagsEXT bindingFlags = 0;
+	// `descriptorCount` samplers baked into the set layout (see `SamplerCache`), the samplers of the image infos are
+	// ignored, the sampler bindings with immutable samplers are never written
+	const VkSampler* pImmutableSamplers = nullptr;
 };
 
 class DescriptorPool
@@ -35,10 +48,17 @@ class DescriptorPool
 public:
 	static void Init();
 	static void Cleanup();
+	// for imgui, which frees its sets one by one
 	static inline VkDescriptorPool Get() { return s_DescriptorPool; }
+	// for the sets with update after bind bindings
+	static inline VkDescriptorPool GetUpdateAfterBind() { return s_UpdateAfterBindPool; }
+	// the sets of the renderer, grows with them
+	static inline DescriptorAllocator& GetAllocator() { return *s_Allocator; }
 
 private:
 	static VkDescriptorPool s_DescriptorPool;
+	static VkDescriptorPool s_UpdateAfterBindPool;
+	static std::unique_ptr<DescriptorAllocator> s_Allocator;
 };
 
 class DescriptorSet
@@ -51,17 +71,40 @@ public:
 	void Init(uint32_t descriptorSetCount);
 	void Cleanup();
 
-	void SetupLayout(std::initializer_list<DescriptorLayout> layout);
+	// `sharedSetLayouts` are appended to the pipeline layout as set 1, 2, ...
+	// these sets are owned (and bound) by someone else, eg: scene wide lighting data
+	void SetupLayout(std::initializer_list<DescriptorLayout> layout,
+		const std::vector<VkDescriptorSetLayout>& sharedSetLayouts = {});
+	// allocates the sets and writes the bindings with infos with an update template
 	void Create();
+	// rewrites the image descriptors of a binding in every set, eg: after the images have been recreated
+	// the sets must not be in use by the gpu
+	void UpdateImages(uint32_t shaderBinding, const VkDescriptorImageInfo* pImageInfos);
+	// same for a single set, eg: when every set is used by a pass that writes another image
+	void UpdateImages(uint32_t shaderBinding, const VkDescriptorImageInfo* pImageInfos, uint32_t setIndex);
+	// rewrites one element of an image array in every set, the element must not be used by the pending command
+	// buffers unless the binding is update after bind
+	void UpdateImage(uint32_t shaderBinding, uint32_t arrayElement, const VkDescriptorImageInfo& imageInfo);
+	// same for a single set, eg: the set of the frame that is recorded while the others are pending
+	void UpdateImage(uint32_t shaderBinding,
+		uint32_t arrayElement,
+		const VkDescriptorImageInfo& imageInfo,
+		uint32_t setIndex);
 
 	static DescriptorLayout CreateLayout(DescriptorType descriptorType,
 		ShaderType shaderStage,
 		uint32_t shaderBinding,
 		uint32_t descriptorCount,
 		VkDescriptorBufferInfo* pBufferInfos,
-		VkDescriptorImageInfo* pImageInfos);
+		VkDescriptorImageInfo* pImageInfos,
+		VkDescriptorBindingFlagsEXT bindingFlags = 0,
+		const VkSampler* pImmutableSamplers = nullptr);
 
 	inline VkPipelineLayout GetPipelineLayout() const { return m_PipelineLayout; }
+	inline VkDescriptorSetLayout GetDescriptorSetLayout() const { return m_DescriptorSetLayout; }
+	// writes the bindings that `Create()` writes, its data are the infos of those bindings one after another (in the
+	// order of the layout), null if there are none
+	inline VkDescriptorUpdateTemplate GetUpdateTemplate() const { return m_UpdateTemplate; }
 
 	inline void Bind(VkCommandBuffer commandBuffer,
 		uint64_t currentFrameIdx,
@@ -78,16 +121,85 @@ public:
 			pDynamicOffsets);
 	}
 
+	inline void BindCompute(VkCommandBuffer commandBuffer, uint64_t currentFrameIdx)
+	{
+		vkCmdBindDescriptorSets(commandBuffer,
+			VK_PIPELINE_BIND_POINT_COMPUTE,
+			m_PipelineLayout,
+			0,
+			1,
+			&m_DescriptorSets[currentFrameIdx],
+			0,
+			nullptr);
+	}
+
+	// binds this set as a shared set (`setIndex` > 0) of another pipeline layout
+	inline void BindShared(VkCommandBuffer commandBuffer,
+		VkPipelineLayout pipelineLayout,
+		uint32_t setIndex,
+		uint64_t currentFrameIdx,
+		VkPipelineBindPoint bindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS) const
+	{
+		vkCmdBindDescriptorSets(commandBuffer,
+			bindPoint,
+			pipelineLayout,
+			setIndex,
+			1,
+			&m_DescriptorSets[currentFrameIdx],
+			0,
+			nullptr);
+	}
+
+	// binds `descriptorSets` as the shared sets 1, 2, ... of `pipelineLayout`
+	static void BindShared(VkCommandBuffer commandBuffer,
+		VkPipelineLayout pipelineLayout,
+		const std::vector<const DescriptorSet*>& descriptorSets,
+		uint64_t currentFrameIdx)
+	{
+		for (uint32_t i = 0; i < static_cast<uint32_t>(descriptorSets.size()); ++i)
+			descriptorSets[i]->BindShared(commandBuffer, pipelineLayout, i + 1, currentFrameIdx);
+	}
+
+	// set layouts of the shared sets, in the order they are bound
+	static std::vector<VkDescriptorSetLayout> GetSetLayouts(const std::vector<const DescriptorSet*>& descriptorSets)
+	{
+		std::vector<VkDescriptorSetLayout> setLayouts{};
+		setLayouts.reserve(descriptorSets.size());
+		for (const auto* descriptorSet : descriptorSets)
+			setLayouts.push_back(descriptorSet->GetDescriptorSetLayout());
+
+		return setLayouts;
+	}
+
+	// `pValues` has `FRAGMENT_PUSH_CONSTANT_SIZE` bytes
 	inline void PushConstants(VkCommandBuffer commandBuffer, uint64_t currentFrameIdx, const void* pValues)
 	{
-		vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(int32_t), pValues);
+		vkCmdPushConstants(commandBuffer,
+			m_PipelineLayout,
+			VK_SHADER_STAGE_FRAGMENT_BIT,
+			0,
+			FRAGMENT_PUSH_CONSTANT_SIZE,
+			pValues);
+	}
+
+	// `pValues` has `COMPUTE_PUSH_CONSTANT_SIZE` bytes
+	inline void PushComputeConstants(VkCommandBuffer commandBuffer, const void* pValues) const
+	{
+		vkCmdPushConstants(
+			commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, COMPUTE_PUSH_CONSTANT_SIZE, pValues);
 	}
 
+private:
+	void CreateUpdateTemplate();
+
 private:
 	uint32_t m_DescriptorSetCount = 0;
 	std::vector<DescriptorLayout> m_DescriptorLayout{};
 	std::vector<VkDescriptorSetLayoutBinding> m_LayoutBindings{};
 	VkDescriptorSetLayout m_DescriptorSetLayout{};
 	VkPipelineLayout m_PipelineLayout{};
+	VkDescriptorUpdateTemplate m_UpdateTemplate{};
+	size_t m_UpdateTemplateSize = 0; // of the data of one set
+	bool m_UpdateAfterBind = false; // allocated from the update after bind pool
 	std::vector<VkDescriptorSet> m_DescriptorSets{};
 };
\ No newline at end of file
@@ -0,0 +1,161 @@
+#include "renderer/descriptorAllocator.h"
+
+#include <cstring>
+#include <algorithm>
+#include <functional>
+#include "core/core.h"
+#include "renderer/device.h"
+
+
+// descriptors per set of every pool, enough for the largest sets of the renderer (eg: the g-buffer inputs of the
+// deferred lighting), a set that doesn't fit moves on to the next pool like a full pool
+struct DescriptorRatio
+{
+	VkDescriptorType type;
+	float count;
+};
+
+static constexpr DescriptorRatio DESCRIPTOR_RATIOS[] = {
+	{VK_DESCRIPTOR_TYPE_SAMPLER,                 1.0f},
+	{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f},
+	{ VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE,          2.0f},
+	{ VK_DESCRIPTOR_TYPE_STORAGE_IMAGE,          1.0f},
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER,         2.0f},
+	{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER,         4.0f},
+	{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 1.0f},
+	{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC, 1.0f}
+};
+
+DescriptorAllocator::DescriptorAllocator(uint32_t firstPoolSets)
+	: m_NextPoolSets{ firstPoolSets }
+{
+}
+
+DescriptorAllocator::~DescriptorAllocator()
+{
+	for (auto& pool : m_Pools)
+		vkDestroyDescriptorPool(Device::GetDevice(), pool.pool, nullptr);
+}
+
+VkDescriptorSet DescriptorAllocator::Allocate(VkDescriptorSetLayout layout)
+{
+	VkDescriptorSetAllocateInfo descriptorSetAllocateInfo{};
+	descriptorSetAllocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	descriptorSetAllocateInfo.descriptorSetCount = 1;
+	descriptorSetAllocateInfo.pSetLayouts = &layout;
+
+	VkDescriptorSet descriptorSet{};
+	while (true)
+	{
+		if (m_CurrentPool == m_Pools.size())
+			AddPool();
+
+		Pool& pool = m_Pools[m_CurrentPool];
+		if (pool.setCount == pool.maxSets)
+		{
+			++m_CurrentPool;
+			continue;
+		}
+
+		descriptorSetAllocateInfo.descriptorPool = pool.pool;
+		const VkResult result =
+			vkAllocateDescriptorSets(Device::GetDevice(), &descriptorSetAllocateInfo, &descriptorSet);
+		if (result == VK_SUCCESS)
+		{
+			++pool.setCount;
+			++m_SetCount;
+			return descriptorSet;
+		}
+
+		THROW(result != VK_ERROR_OUT_OF_POOL_MEMORY && result != VK_ERROR_FRAGMENTED_POOL,
+			"Failed to allocate descriptor set!")
+		// the set would not fit into the next pools either
+		THROW(pool.setCount == 0, "The descriptor set layout has more descriptors than a descriptor pool!")
+		++m_CurrentPool;
+	}
+}
+
+void DescriptorAllocator::Reset()
+{
+	for (auto& pool : m_Pools)
+	{
+		if (pool.setCount == 0)
+			continue;
+
+		vkResetDescriptorPool(Device::GetDevice(), pool.pool, 0);
+		pool.setCount = 0;
+	}
+
+	m_CurrentPool = 0;
+	m_SetCount = 0;
+}
+
+void DescriptorAllocator::AddPool()
+{
+	std::vector<VkDescriptorPoolSize> poolSizes{};
+	poolSizes.reserve(std::size(DESCRIPTOR_RATIOS));
+	for (const auto& ratio : DESCRIPTOR_RATIOS)
+		poolSizes.push_back({ ratio.type, static_cast<uint32_t>(ratio.count * static_cast<float>(m_NextPoolSets)) });
+
+	// the sets are only freed by resetting the pool
+	VkDescriptorPoolCreateInfo descriptorPoolInfo{};
+	descriptorPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	descriptorPoolInfo.maxSets = m_NextPoolSets;
+	descriptorPoolInfo.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+	descriptorPoolInfo.pPoolSizes = poolSizes.data();
+
+	VkDescriptorPool pool{};
+	THROW(vkCreateDescriptorPool(Device::GetDevice(), &descriptorPoolInfo, nullptr, &pool) != VK_SUCCESS,
+		"Failed to create descriptor pool!")
+
+	m_Pools.push_back({ pool, m_NextPoolSets, 0 });
+	m_NextPoolSets = std::min(m_NextPoolSets + m_NextPoolSets / 2, DESCRIPTOR_POOL_MAX_SETS);
+}
+
+
+// fnv-1a
+static size_t HashBytes(const void* data, size_t size, size_t seed)
+{
+	const auto bytes = static_cast<const uint8_t*>(data);
+	uint64_t hash = 14695981039346656037ull ^ seed;
+	for (size_t i = 0; i < size; ++i)
+	{
+		hash ^= bytes[i];
+		hash *= 1099511628211ull;
+	}
+
+	return static_cast<size_t>(hash);
+}
+
+DescriptorCache::DescriptorCache(DescriptorAllocator& allocator)
+	: m_Allocator{ allocator }
+{
+}
+
+VkDescriptorSet DescriptorCache::Get(VkDescriptorSetLayout layout,
+	VkDescriptorUpdateTemplate updateTemplate,
+	const void* data,
+	size_t size)
+{
+	const size_t hash = HashBytes(data, size, std::hash<VkDescriptorSetLayout>{}(layout));
+	const auto [first, last] = m_Sets.equal_range(hash);
+	for (auto it = first; it != last; ++it)
+	{
+		const Entry& entry = it->second;
+		if (entry.layout == layout && entry.data.size() == size && std::memcmp(entry.data.data(), data, size) == 0)
+			return entry.descriptorSet;
+	}
+
+	const VkDescriptorSet descriptorSet = m_Allocator.Allocate(layout);
+	vkUpdateDescriptorSetWithTemplate(Device::GetDevice(), descriptorSet, updateTemplate, data);
+
+	const auto bytes = static_cast<const uint8_t*>(data);
+	m_Sets.emplace(hash, Entry{ layout, std::vector<uint8_t>(bytes, bytes + size), descriptorSet });
+	return descriptorSet;
+}
+
+void DescriptorCache::Reset()
+{
+	m_Sets.clear();
+	m_Allocator.Reset();
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+
+constexpr uint32_t DESCRIPTOR_POOL_MIN_SETS = 64; // sets of the first pool of an allocator
+constexpr uint32_t DESCRIPTOR_POOL_MAX_SETS = 4096; // the next pools are 1.5x larger, up to this
+
+// allocates descriptor sets from a chain of pools: a full (or fragmented) pool moves on to the next one, a new pool is
+// appended to the chain when all of them are full, so the allocations never run out
+// the sets are never freed one by one, `Reset()` returns all of them to their pools and keeps the pools, eg: the
+// allocator of a frame in flight is reset after the fence of the frame has been waited on
+class DescriptorAllocator
+{
+public:
+	DescriptorAllocator(uint32_t firstPoolSets = DESCRIPTOR_POOL_MIN_SETS);
+	~DescriptorAllocator();
+
+	DescriptorAllocator(const DescriptorAllocator&) = delete;
+	DescriptorAllocator& operator=(const DescriptorAllocator&) = delete;
+
+	VkDescriptorSet Allocate(VkDescriptorSetLayout layout);
+	// the sets must not be in use by the gpu
+	void Reset();
+
+	inline uint32_t GetPoolCount() const { return static_cast<uint32_t>(m_Pools.size()); }
+	inline uint64_t GetSetCount() const { return m_SetCount; } // allocated since the last reset
+
+private:
+	struct Pool
+	{
+		VkDescriptorPool pool;
+		uint32_t maxSets;
+		uint32_t setCount; // allocated since the last reset
+	};
+
+private:
+	void AddPool();
+
+private:
+	std::vector<Pool> m_Pools{};
+	size_t m_CurrentPool = 0; // the pools before it are full
+	uint32_t m_NextPoolSets = 0;
+	uint64_t m_SetCount = 0;
+};
+
+// descriptor sets keyed by their layout and the resources written into them: a set that is requested again with the
+// same resources is returned instead of being allocated and written again
+// the sets are written with an update template, `data` is the data of the template (eg: the image and buffer infos one
+// after another), it is hashed and compared byte by byte, so the infos have to be zero initialized (`{}`) to clear
+// their padding
+// the sets come from `allocator`, the cache has to be reset with it
+class DescriptorCache
+{
+public:
+	DescriptorCache(DescriptorAllocator& allocator);
+
+	VkDescriptorSet Get(VkDescriptorSetLayout layout,
+		VkDescriptorUpdateTemplate updateTemplate,
+		const void* data,
+		size_t size);
+	// resets the allocator, the sets must not be in use by the gpu
+	void Reset();
+
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(m_Sets.size()); }
+
+private:
+	struct Entry
+	{
+		VkDescriptorSetLayout layout;
+		std::vector<uint8_t> data;
+		VkDescriptorSet descriptorSet;
+	};
+
+private:
+	DescriptorAllocator& m_Allocator;
+	std::unordered_multimap<size_t, Entry> m_Sets{}; // by the hash of the layout and the data
+};
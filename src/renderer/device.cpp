@@ -10,8 +10,11 @@ std::shared_ptr<Device> Device::s_Instance = nullptr;
 Device::Device(const VulkanConfig& config, VkSurfaceKHR windowSurface)
 	: m_Config{ config },
 	  m_WindowSurface{ windowSurface },
+	  m_DeviceExtensions{ config.deviceExtensions },
 	  m_PhysicalDevice{ VK_NULL_HANDLE }
 {
+	// the textures of the lit pipelines are bound as one partially bound array, see `BindlessTextures`
+	m_DeviceExtensions.push_back(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME);
 	PickPhysicalDevice();
 	CreateLogicalDevice();
 }
@@ -50,6 +53,12 @@ void Device::PickPhysicalDevice()
 		{
 			m_PhysicalDevice = device;
 			vkGetPhysicalDeviceProperties(m_PhysicalDevice, &m_PhysicalDeviceProperties);
+			m_DescriptorIndexingProperties.sType =
+				VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES_EXT;
+			VkPhysicalDeviceProperties2 properties{};
+			properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+			properties.pNext = &m_DescriptorIndexingProperties;
+			vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &properties);
 			m_MsaaSamples = GetMaxUsableSampleCount();
 			break;
 		}
@@ -59,8 +68,9 @@ void Device::PickPhysicalDevice()
 
 	Logger::Info(
 		"Physical device info:\n"
-		"    Device name: {}",
-		m_PhysicalDeviceProperties.deviceName);
+		"    Device name: {}{}",
+		m_PhysicalDeviceProperties.deviceName,
+		m_PhysicalDeviceProperties.deviceType == VK_PHYSICAL_DEVICE_TYPE_CPU ? " (software rasterizer)" : "");
 }
 
 void Device::CreateLogicalDevice()
@@ -85,21 +95,40 @@ void Device::CreateLogicalDevice()
 	}
 
 	// specify used device features
+	VkPhysicalDeviceFeatures supportedFeatures;
+	vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+
 	VkPhysicalDeviceFeatures deviceFeatures{};
 	deviceFeatures.samplerAnisotropy = VK_TRUE;
 	deviceFeatures.sampleRateShading = VK_TRUE; // enable sample shading
+	deviceFeatures.fragmentStoresAndAtomics = VK_TRUE; // the lit shaders write the texture feedback
+	// optional, used for the overdraw statistics
+	deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+	// optional, the cooked textures are block compressed (the source images are loaded without it)
+	deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+	m_EnabledFeatures = deviceFeatures;
+
+	// a runtime sized array that is partially bound and can be written while it is bound (the unused descriptors
+	// even while the command buffers that bind it are pending)
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{};
+	descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	descriptorIndexingFeatures.runtimeDescriptorArray = VK_TRUE;
+	descriptorIndexingFeatures.descriptorBindingPartiallyBound = VK_TRUE;
+	descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+	descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
 
 	// create logical device
 	VkDeviceCreateInfo deviceInfo{};
 	deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+	deviceInfo.pNext = &descriptorIndexingFeatures;
 	deviceInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 	deviceInfo.pQueueCreateInfos = queueCreateInfos.data();
 	deviceInfo.pEnabledFeatures = &deviceFeatures;
 
 	// these are similar to create instance but they are device specific this
 	// time
-	deviceInfo.enabledExtensionCount = static_cast<uint32_t>(m_Config.deviceExtensions.size());
-	deviceInfo.ppEnabledExtensionNames = m_Config.deviceExtensions.data();
+	deviceInfo.enabledExtensionCount = static_cast<uint32_t>(m_DeviceExtensions.size());
+	deviceInfo.ppEnabledExtensionNames = m_DeviceExtensions.data();
 
 	if (m_Config.enableValidationLayers)
 	{
@@ -121,14 +150,21 @@ void Device::CreateLogicalDevice()
 
 bool Device::IsDeviceSuitable(VkPhysicalDevice physicalDevice)
 {
+	// the core 1.1 entry points are used (eg: `vkGetPhysicalDeviceFeatures2()`, descriptor update templates)
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+	if (properties.apiVersion < VK_API_VERSION_1_1)
+		return false;
+
 	QueueFamilyIndices indicies = FindQueueFamilies(physicalDevice, m_WindowSurface);
 
 	// checking for extension availability like swapchain extension availability
 	bool extensionsSupported = CheckDeviceExtensionSupport(physicalDevice);
 
 	// checking if swapchain is supported by window surface
-	bool swapchainAdequate = false;
-	if (extensionsSupported)
+	// there is no surface in headless mode, any device that can render is used (including cpu devices)
+	bool swapchainAdequate = m_WindowSurface == VK_NULL_HANDLE;
+	if (extensionsSupported && !swapchainAdequate)
 	{
 		SwapchainSupportDetails swapchainSupport = QuerySwapchainSupport(physicalDevice, m_WindowSurface);
 		swapchainAdequate = !swapchainSupport.formats.empty() && !swapchainSupport.presentModes.empty();
@@ -137,7 +173,8 @@ bool Device::IsDeviceSuitable(VkPhysicalDevice physicalDevice)
 	VkPhysicalDeviceFeatures supportedFeatures;
 	vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
 
-	return indicies.IsComplete() && extensionsSupported && swapchainAdequate && supportedFeatures.samplerAnisotropy;
+	return indicies.IsComplete() && extensionsSupported && swapchainAdequate && supportedFeatures.samplerAnisotropy
+		   && supportedFeatures.fragmentStoresAndAtomics && CheckDescriptorIndexingSupport(physicalDevice);
 }
 
 bool Device::CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice)
@@ -147,7 +184,7 @@ bool Device::CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice)
 	std::vector<VkExtensionProperties> availableExtensions{ extensionCount };
 	vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.data());
 
-	std::set<std::string> requiredExtensions{ m_Config.deviceExtensions.begin(), m_Config.deviceExtensions.end() };
+	std::set<std::string> requiredExtensions{ m_DeviceExtensions.begin(), m_DeviceExtensions.end() };
 
 	for (const auto& extension : availableExtensions)
 		requiredExtensions.erase(extension.extensionName);
@@ -155,6 +192,22 @@ bool Device::CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice)
 	return requiredExtensions.empty();
 }
 
+bool Device::CheckDescriptorIndexingSupport(VkPhysicalDevice physicalDevice)
+{
+	// only queried for the devices that have the extension (`extensionsSupported` is checked first)
+	VkPhysicalDeviceDescriptorIndexingFeaturesEXT descriptorIndexingFeatures{};
+	descriptorIndexingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES_EXT;
+	VkPhysicalDeviceFeatures2 features{};
+	features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	features.pNext = &descriptorIndexingFeatures;
+	vkGetPhysicalDeviceFeatures2(physicalDevice, &features);
+
+	return descriptorIndexingFeatures.runtimeDescriptorArray
+		   && descriptorIndexingFeatures.descriptorBindingPartiallyBound
+		   && descriptorIndexingFeatures.descriptorBindingSampledImageUpdateAfterBind
+		   && descriptorIndexingFeatures.descriptorBindingUpdateUnusedWhilePending;
+}
+
 VkSampleCountFlagBits Device::GetMaxUsableSampleCount()
 {
 	VkSampleCountFlags counts = m_PhysicalDeviceProperties.limits.framebufferColorSampleCounts
@@ -249,6 +302,15 @@ QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice physicalDevice, Vk
 		if (queueFamilies[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)
 			indices.graphicsFamily = i;
 
+		// nothing is presented without a surface (headless), the graphics queue is used in its place
+		if (windowSurface == VK_NULL_HANDLE)
+		{
+			indices.presentFamily = indices.graphicsFamily;
+			if (indices.IsComplete())
+				break;
+			continue;
+		}
+
 		// check for queue family compatible for presentation
 		// the graphics queue and the presentation queue might end up being the
 		// same but we treat them as separate queues
@@ -265,6 +327,26 @@ QueueFamilyIndices Device::FindQueueFamilies(VkPhysicalDevice physicalDevice, Vk
 	return indices;
 }
 
+VkCompareOp Device::GetDepthCompareOp(VkCompareOp compareOp)
+{
+	if (!IsReverseZ())
+		return compareOp;
+
+	switch (compareOp)
+	{
+	case VK_COMPARE_OP_LESS:
+		return VK_COMPARE_OP_GREATER;
+	case VK_COMPARE_OP_LESS_OR_EQUAL:
+		return VK_COMPARE_OP_GREATER_OR_EQUAL;
+	case VK_COMPARE_OP_GREATER:
+		return VK_COMPARE_OP_LESS;
+	case VK_COMPARE_OP_GREATER_OR_EQUAL:
+		return VK_COMPARE_OP_LESS_OR_EQUAL;
+	default: // NEVER, EQUAL, NOT_EQUAL, ALWAYS don't depend on the direction
+		return compareOp;
+	}
+}
+
 VkFormat Device::FindSupportedFormat(const std::vector<VkFormat>& canditateFormats,
 	VkImageTiling tiling,
 	VkFormatFeatureFlags features)
@@ -25,6 +25,7 @@ struct SwapchainSupportDetails
 class Device
 {
 public:
+	// `windowSurface` is `VK_NULL_HANDLE` in headless mode, the present queue is then the graphics queue
 	Device(const VulkanConfig& config, VkSurfaceKHR windowSurface);
 	Device(const Device&) = delete;
 	Device& operator=(const Device&) = delete;
@@ -41,6 +42,18 @@ public:
 	static inline VkQueue GetPresentQueue() { return s_Instance->m_PresentQueue; }
 	static inline QueueFamilyIndices GetQueueFamilyIndices() { return s_Instance->m_QueueFamilyIndices; }
 	static inline VkSampleCountFlagBits GetMSAASamplesCount() { return s_Instance->m_MsaaSamples; }
+	static inline const VkPhysicalDeviceFeatures& GetEnabledFeatures() { return s_Instance->m_EnabledFeatures; }
+	// limits of the descriptors that are updated after they are bound, see `BindlessTextures`
+	static inline const VkPhysicalDeviceDescriptorIndexingPropertiesEXT& GetDescriptorIndexingProperties()
+	{
+		return s_Instance->m_DescriptorIndexingProperties;
+	}
+
+	// depth convention of all the depth buffers, see `VulkanConfig::reverseZ`
+	static inline bool IsReverseZ() { return s_Instance->m_Config.reverseZ; }
+	static inline float GetDepthClearValue() { return IsReverseZ() ? 0.0f : 1.0f; }
+	// `compareOp` is given for the standard depth range (closer = smaller) and is flipped for reverse-z
+	static VkCompareOp GetDepthCompareOp(VkCompareOp compareOp);
 
 	// waits for the device to finish operations
 	static inline void WaitIdle() { vkDeviceWaitIdle(s_Instance->m_DeviceVk); }
@@ -60,6 +73,8 @@ private:
 
 	bool IsDeviceSuitable(VkPhysicalDevice physicalDevice);
 	bool CheckDeviceExtensionSupport(VkPhysicalDevice physicalDevice);
+	// the descriptor indexing features used by the bindless textures
+	static bool CheckDescriptorIndexingSupport(VkPhysicalDevice physicalDevice);
 
 	VkSampleCountFlagBits GetMaxUsableSampleCount();
 
@@ -67,6 +82,8 @@ private:
 	const VulkanConfig m_Config;
 	VkInstance m_VulkanInstance;
 	VkSurfaceKHR m_WindowSurface;
+	// the extensions of the config and the ones the renderer always needs
+	std::vector<const char*> m_DeviceExtensions;
 
 	static std::shared_ptr<Device> s_Instance;
 
@@ -76,6 +93,8 @@ private:
 	VkDevice m_DeviceVk;
 
 	VkPhysicalDeviceProperties m_PhysicalDeviceProperties;
+	VkPhysicalDeviceFeatures m_EnabledFeatures{};
+	VkPhysicalDeviceDescriptorIndexingPropertiesEXT m_DescriptorIndexingProperties{};
 
 	VkQueue m_GraphicsQueue;
 	VkQueue m_PresentQueue;
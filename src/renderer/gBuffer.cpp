@@ -0,0 +1,133 @@
+#include "renderer/gBuffer.h"
+
+#include "core/core.h"
+#include "renderer/device.h"
+#include "renderer/samplerCache.h"
+
+
+GBuffer::GBuffer()
+{
+	m_Formats[0] = VK_FORMAT_R16G16B16A16_SFLOAT; // normal
+	m_Formats[1] = VK_FORMAT_R8G8B8A8_SRGB; // albedo, in srgb to keep the precision of the dark colors
+	m_Formats[2] = VK_FORMAT_R8G8B8A8_UNORM; // specular
+	m_Formats[3] = FindDepthFormat();
+
+	CreateRenderPass();
+	CreateSampler();
+}
+
+GBuffer::~GBuffer()
+{
+	vkDestroyRenderPass(Device::GetDevice(), m_RenderPass, nullptr);
+}
+
+std::array<RenderGraphResource, GBUFFER_ATTACHMENT_COUNT> GBuffer::CreateImages(RenderGraph& renderGraph,
+	uint32_t width,
+	uint32_t height) const
+{
+	static constexpr const char* names[GBUFFER_ATTACHMENT_COUNT]{
+		"G-buffer normal", "G-buffer albedo", "G-buffer specular", "G-buffer depth"
+	};
+
+	std::array<RenderGraphResource, GBUFFER_ATTACHMENT_COUNT> images{};
+	for (size_t i = 0; i < images.size(); ++i)
+		images[i] = renderGraph.CreateImage(names[i], { m_Formats[i], width, height });
+
+	return images;
+}
+
+std::vector<VkClearValue> GBuffer::GetClearValues() const
+{
+	// alpha of the albedo stays 0 where nothing is drawn
+	std::vector<VkClearValue> clearValues(GBUFFER_ATTACHMENT_COUNT);
+	clearValues[0].color = { 0.0f, 0.0f, 0.0f, 0.0f };
+	clearValues[1].color = { 0.0f, 0.0f, 0.0f, 0.0f };
+	clearValues[2].color = { 0.0f, 0.0f, 0.0f, 0.0f };
+	clearValues[3].depthStencil = { Device::GetDepthClearValue(), 0 };
+
+	return clearValues;
+}
+
+void GBuffer::CreateRenderPass()
+{
+	// the attachments stay in their attachment layouts, the render graph transitions them for the lighting pass that
+	// samples them
+	std::array<VkAttachmentDescription, GBUFFER_ATTACHMENT_COUNT> attachments{};
+	for (size_t i = 0; i < attachments.size(); ++i)
+	{
+		const VkImageLayout layout = i == GBUFFER_COLOR_ATTACHMENT_COUNT
+										 ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL
+										 : VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+		attachments[i].format = m_Formats[i];
+		attachments[i].samples = VK_SAMPLE_COUNT_1_BIT;
+		attachments[i].loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		attachments[i].storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+		attachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		attachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		attachments[i].initialLayout = layout;
+		attachments[i].finalLayout = layout;
+	}
+
+	// attachment refrences
+	std::array<VkAttachmentReference, GBUFFER_COLOR_ATTACHMENT_COUNT> colorRefs{};
+	for (uint32_t i = 0; i < GBUFFER_COLOR_ATTACHMENT_COUNT; ++i)
+	{
+		colorRefs[i].attachment = i;
+		colorRefs[i].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	}
+
+	VkAttachmentReference depthRef{};
+	depthRef.attachment = GBUFFER_COLOR_ATTACHMENT_COUNT;
+	depthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	// subpass
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = static_cast<uint32_t>(colorRefs.size());
+	subpass.pColorAttachments = colorRefs.data();
+	subpass.pDepthStencilAttachment = &depthRef;
+
+	// render pass
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	renderPassInfo.pAttachments = attachments.data();
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+
+	THROW(vkCreateRenderPass(Device::GetDevice(), &renderPassInfo, nullptr, &m_RenderPass) != VK_SUCCESS,
+		"Failed to create g-buffer render pass!");
+}
+
+void GBuffer::CreateSampler()
+{
+	// the g-buffer is read one texel per pixel
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.0f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = 0.0f;
+
+	m_Sampler = SamplerCache::Get(samplerInfo);
+}
+
+VkFormat GBuffer::FindDepthFormat()
+{
+	// unlike the swapchain's depth buffer, this one is also sampled
+	return Device::FindSupportedFormat(
+		{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "renderer/renderGraph.h"
+
+
+// normal, albedo, specular and depth
+constexpr uint32_t GBUFFER_COLOR_ATTACHMENT_COUNT = 3;
+constexpr uint32_t GBUFFER_ATTACHMENT_COUNT = GBUFFER_COLOR_ATTACHMENT_COUNT + 1;
+
+// geometry buffer of the deferred shading path
+// the geometry is drawn into it in its own render pass, before the swapchain render pass
+// the attachments are then sampled by the lighting pass (see `DeferredLighting`)
+// the world space position is not stored, it is reconstructed from the depth
+// the attachments are transient images of the render graph, they are only allocated while the deferred path is drawn
+// and can share their memory with the other transient images (see `RenderGraph`)
+class GBuffer
+{
+public:
+	GBuffer();
+	~GBuffer();
+
+	// declares the attachments in the order: normal, albedo, specular, depth
+	std::array<RenderGraphResource, GBUFFER_ATTACHMENT_COUNT> CreateImages(RenderGraph& renderGraph,
+		uint32_t width,
+		uint32_t height) const;
+
+	// the attachments stay in their attachment layouts, the render graph transitions them
+	inline VkRenderPass GetRenderPass() const { return m_RenderPass; }
+	std::vector<VkClearValue> GetClearValues() const;
+	inline VkSampler GetSampler() const { return m_Sampler; }
+
+private:
+	void CreateRenderPass();
+	void CreateSampler();
+
+	static VkFormat FindDepthFormat();
+
+private:
+	std::array<VkFormat, GBUFFER_ATTACHMENT_COUNT> m_Formats{};
+	VkSampler m_Sampler{}; // owned by the `SamplerCache`
+	VkRenderPass m_RenderPass{};
+};
@@ -0,0 +1,259 @@
+#include "renderer/gpuProfiler.h"
+
+#include <cstring>
+#include <algorithm>
+#include "imgui/imgui.h"
+#include "core/core.h"
+#include "renderer/device.h"
+
+
+GpuProfiler::GpuProfiler(const uint32_t maxFramesInFlight)
+	: m_Records(maxFramesInFlight)
+{
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(Device::GetPhysicalDevice(), &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(Device::GetPhysicalDevice(), &queueFamilyCount, queueFamilies.data());
+
+	uint32_t validBits = queueFamilies[Device::GetQueueFamilyIndices().graphicsFamily.value()].timestampValidBits;
+	if (validBits == 0)
+	{
+		Logger::Warn("Timestamp queries are not supported by the graphics queue, the gpu profiler is disabled");
+		return;
+	}
+
+	m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+	m_TimestampPeriod = Device::GetDeviceProperties().limits.timestampPeriod;
+
+	for (auto& records : m_Records)
+		records.reserve(GPU_PROFILER_MAX_SCOPES);
+
+	// a begin and an end query for every scope, for each frame in flight
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = GPU_PROFILER_MAX_SCOPES * 2 * maxFramesInFlight;
+
+	THROW(vkCreateQueryPool(Device::GetDevice(), &queryPoolInfo, nullptr, &m_QueryPool) != VK_SUCCESS,
+		"Failed to create query pool!")
+}
+
+GpuProfiler::~GpuProfiler()
+{
+	vkDestroyQueryPool(Device::GetDevice(), m_QueryPool, nullptr);
+}
+
+void GpuProfiler::BeginFrame(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex)
+{
+	if (!IsSupported())
+		return;
+
+	if (!m_ScopeStack.empty())
+	{
+		Logger::Warn("{} gpu profiler scopes have not been ended", m_ScopeStack.size());
+		m_ScopeStack.clear();
+	}
+
+	m_CurrentFrameIndex = currentFrameIndex;
+	ReadResults(currentFrameIndex);
+	m_Records[currentFrameIndex].clear();
+
+	vkCmdResetQueryPool(
+		commandBuffer, m_QueryPool, currentFrameIndex * GPU_PROFILER_MAX_SCOPES * 2, GPU_PROFILER_MAX_SCOPES * 2);
+}
+
+void GpuProfiler::BeginScope(VkCommandBuffer commandBuffer, const char* name)
+{
+	if (!IsSupported())
+		return;
+
+	auto& records = m_Records[m_CurrentFrameIndex];
+	if (records.size() == GPU_PROFILER_MAX_SCOPES)
+	{
+		m_ScopeStack.push_back(-1);
+		return;
+	}
+
+	// the parent is the innermost open scope that is measured
+	int32_t parent = -1;
+	for (auto it = m_ScopeStack.rbegin(); it != m_ScopeStack.rend(); ++it)
+	{
+		if (*it >= 0)
+		{
+			parent = *it;
+			break;
+		}
+	}
+
+	int32_t index = static_cast<int32_t>(records.size());
+	records.push_back({ name, parent });
+	m_ScopeStack.push_back(index);
+
+	uint32_t query = (m_CurrentFrameIndex * GPU_PROFILER_MAX_SCOPES + static_cast<uint32_t>(index)) * 2;
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, query);
+}
+
+void GpuProfiler::EndScope(VkCommandBuffer commandBuffer)
+{
+	if (!IsSupported())
+		return;
+
+	THROW(m_ScopeStack.empty(), "GpuProfiler::EndScope() called without a matching BeginScope()!")
+
+	int32_t index = m_ScopeStack.back();
+	m_ScopeStack.pop_back();
+	if (index < 0)
+		return;
+
+	uint32_t query = (m_CurrentFrameIndex * GPU_PROFILER_MAX_SCOPES + static_cast<uint32_t>(index)) * 2 + 1;
+	vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, query);
+}
+
+void GpuProfiler::ReadResults(const uint32_t frameIndex)
+{
+	const auto& records = m_Records[frameIndex];
+	if (records.empty())
+		return;
+
+	// every query is followed by its availability
+	std::vector<uint64_t> results(records.size() * 2 * 2);
+	VkResult status = vkGetQueryPoolResults(Device::GetDevice(),
+		m_QueryPool,
+		frameIndex * GPU_PROFILER_MAX_SCOPES * 2,
+		static_cast<uint32_t>(records.size() * 2),
+		results.size() * sizeof(uint64_t),
+		results.data(),
+		sizeof(uint64_t) * 2,
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+	if (status != VK_SUCCESS && status != VK_NOT_READY)
+		return;
+
+	for (auto& stats : m_Stats)
+	{
+		stats.recordedLastFrame = false;
+		stats.lastFrameTime = 0.0f;
+	}
+	m_FrameTime = 0.0f;
+
+	// the stats of each record, a parent is always recorded before its children
+	std::vector<uint32_t> recordStats(records.size());
+	for (size_t i = 0; i < records.size(); ++i)
+	{
+		int32_t parentStats = records[i].parent < 0 ? -1 : static_cast<int32_t>(recordStats[records[i].parent]);
+		recordStats[i] = FindOrAddStats(parentStats, records[i].name);
+
+		const uint64_t* begin = &results[i * 4];
+		const uint64_t* end = &results[i * 4 + 2];
+		if (begin[1] == 0 || end[1] == 0) // not available
+			continue;
+
+		uint64_t ticks = ((end[0] & m_TimestampMask) - (begin[0] & m_TimestampMask)) & m_TimestampMask;
+		float time = static_cast<float>(ticks) * m_TimestampPeriod / 1000000.0f;
+		if (records[i].parent < 0)
+			m_FrameTime += time;
+
+		ScopeStats& stats = m_Stats[recordStats[i]];
+		stats.history[stats.nextSample] = time;
+		stats.nextSample = (stats.nextSample + 1) % GPU_PROFILER_HISTORY;
+		stats.sampleCount = std::min(stats.sampleCount + 1, GPU_PROFILER_HISTORY);
+		stats.recordedLastFrame = true;
+		stats.lastFrameTime += time;
+	}
+}
+
+float GpuProfiler::GetScopeTime(const char* name) const
+{
+	for (uint32_t index : m_RootStats)
+	{
+		if (std::strcmp(m_Stats[index].name, name) == 0)
+			return m_Stats[index].lastFrameTime;
+	}
+
+	return 0.0f;
+}
+
+uint32_t GpuProfiler::FindOrAddStats(int32_t parent, const char* name)
+{
+	std::vector<uint32_t>& siblings = parent < 0 ? m_RootStats : m_Stats[parent].children;
+	for (uint32_t index : siblings)
+	{
+		if (std::strcmp(m_Stats[index].name, name) == 0)
+			return index;
+	}
+
+	uint32_t index = static_cast<uint32_t>(m_Stats.size());
+	m_Stats.push_back({ name });
+	// `siblings` may have been invalidated by the push_back
+	(parent < 0 ? m_RootStats : m_Stats[parent].children).push_back(index);
+	return index;
+}
+
+void GpuProfiler::OnUIRender() const
+{
+	if (!IsSupported())
+	{
+		ImGui::Text("GPU timestamps are not supported");
+		return;
+	}
+
+	ImGuiTableFlags tableFlags = ImGuiTableFlags_BordersInnerV | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingFixedFit;
+	if (!ImGui::BeginTable("##gpu_profiler", 4, tableFlags))
+		return;
+
+	ImGui::TableSetupColumn("GPU scope");
+	ImGui::TableSetupColumn("avg ms");
+	ImGui::TableSetupColumn("min ms");
+	ImGui::TableSetupColumn("max ms");
+	ImGui::TableHeadersRow();
+
+	for (uint32_t index : m_RootStats)
+		DrawStats(index);
+
+	ImGui::EndTable();
+}
+
+void GpuProfiler::DrawStats(uint32_t statsIndex) const
+{
+	const ScopeStats& stats = m_Stats[statsIndex];
+
+	float minTime = 0.0f;
+	float maxTime = 0.0f;
+	float avgTime = 0.0f;
+	if (stats.sampleCount > 0)
+	{
+		minTime = stats.history[0];
+		for (uint32_t i = 0; i < stats.sampleCount; ++i)
+		{
+			minTime = std::min(minTime, stats.history[i]);
+			maxTime = std::max(maxTime, stats.history[i]);
+			avgTime += stats.history[i];
+		}
+		avgTime /= static_cast<float>(stats.sampleCount);
+	}
+
+	ImGui::TableNextRow();
+	ImGui::TableNextColumn();
+	ImGuiTreeNodeFlags nodeFlags = ImGuiTreeNodeFlags_DefaultOpen | ImGuiTreeNodeFlags_SpanFullWidth;
+	if (stats.children.empty())
+		nodeFlags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+
+	// scopes that weren't recorded in the last frame are dimmed
+	if (!stats.recordedLastFrame)
+		ImGui::PushStyleColor(ImGuiCol_Text, ImGui::GetStyleColorVec4(ImGuiCol_TextDisabled));
+	bool open = ImGui::TreeNodeEx(stats.name, nodeFlags);
+	ImGui::TableNextColumn();
+	ImGui::Text("%.3f", avgTime);
+	ImGui::TableNextColumn();
+	ImGui::Text("%.3f", minTime);
+	ImGui::TableNextColumn();
+	ImGui::Text("%.3f", maxTime);
+	if (!stats.recordedLastFrame)
+		ImGui::PopStyleColor();
+
+	if (open && !stats.children.empty())
+	{
+		for (uint32_t child : stats.children)
+			DrawStats(child);
+		ImGui::TreePop();
+	}
+}
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+
+constexpr uint32_t GPU_PROFILER_MAX_SCOPES = 64; // per frame, the scopes after this are not measured
+constexpr uint32_t GPU_PROFILER_HISTORY = 128; // frames the min/avg/max are computed over
+
+// gpu time of the passes and draw groups of a frame, measured with timestamp queries
+// the scopes can be nested, the results are shown as a tree in the profiler window
+//
+// the queries of a frame are read when the frame index is used again, after its fence has been waited on,
+// so the results lag `maxFramesInFlight` frames behind but reading them never stalls
+// nothing is recorded if the graphics queue doesn't support timestamps
+class GpuProfiler
+{
+public:
+	GpuProfiler(const uint32_t maxFramesInFlight);
+	~GpuProfiler();
+
+	// reads the results of the frame's previous use and resets its queries, has to be recorded outside of a render
+	// pass, before any scope of the frame
+	void BeginFrame(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex);
+	// `name` has to outlive the profiler, eg: a string literal
+	// scopes with the same name under the same parent are accumulated into the same statistics
+	void BeginScope(VkCommandBuffer commandBuffer, const char* name);
+	void EndScope(VkCommandBuffer commandBuffer);
+
+	// tree of the scopes with their rolling min/avg/max, in ms
+	void OnUIRender() const;
+
+	inline bool IsSupported() const { return m_QueryPool != VK_NULL_HANDLE; }
+	// sum of the top level scopes of the last frame that was read, in ms
+	inline float GetFrameTime() const { return m_FrameTime; }
+	// sum of the top level scopes called `name` in the last frame that was read, in ms (0 if it wasn't recorded)
+	float GetScopeTime(const char* name) const;
+
+private:
+	void ReadResults(const uint32_t frameIndex);
+	uint32_t FindOrAddStats(int32_t parent, const char* name);
+	void DrawStats(uint32_t statsIndex) const;
+
+private:
+	// a scope recorded in a frame, its begin and end queries are `2 * index` and `2 * index + 1` of the frame
+	struct ScopeRecord
+	{
+		const char* name;
+		int32_t parent; // index of the parent record, -1 for the top level
+	};
+
+	struct ScopeStats
+	{
+		const char* name;
+		std::vector<uint32_t> children{};
+		std::array<float, GPU_PROFILER_HISTORY> history{}; // ring buffer of the times in ms
+		uint32_t sampleCount = 0;
+		uint32_t nextSample = 0;
+		bool recordedLastFrame = false; // eg: a cached shadow map isn't rendered every frame
+		float lastFrameTime = 0.0f; // sum of the records of the last frame, in ms
+	};
+
+	VkQueryPool m_QueryPool{};
+	float m_TimestampPeriod = 1.0f; // ns per tick
+	uint64_t m_TimestampMask = ~0ull; // the valid bits of the timestamps
+
+	uint32_t m_CurrentFrameIndex = 0;
+	float m_FrameTime = 0.0f;
+	std::vector<std::vector<ScopeRecord>> m_Records{}; // per frame in flight
+	std::vector<int32_t> m_ScopeStack{}; // open scopes of the current frame, -1 if the scope isn't measured
+
+	std::vector<ScopeStats> m_Stats{};
+	std::vector<uint32_t> m_RootStats{};
+};
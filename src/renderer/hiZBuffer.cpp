@@ -0,0 +1,292 @@
+#include "renderer/hiZBuffer.h"
+
+#include <algorithm>
+#include <glm/glm.hpp>
+#include "core/core.h"
+#include "renderer/device.h"
+#include "renderer/samplerCache.h"
+#include "utils/utils.h"
+
+
+// the largest power of two that is at most `value`
+static uint32_t PreviousPowerOfTwo(uint32_t value)
+{
+	uint32_t power = 1;
+	while (power <= value / 2)
+		power *= 2;
+
+	return power;
+}
+
+
+HiZBuffer::HiZBuffer(uint32_t width, uint32_t height, const uint32_t maxFramesInFlight)
+{
+	CreateSampler();
+	CreatePyramid(width, height);
+
+	// every set is written by `UpdateDescriptors()` and `SetDepthImageView()`, the sets of the levels past the last one
+	// are never bound
+	VkDescriptorImageInfo levelImageInfo{ m_Sampler, m_LevelViews[0], VK_IMAGE_LAYOUT_GENERAL };
+	VkDescriptorImageInfo pyramidImageInfo{ m_Sampler, m_ImageView, VK_IMAGE_LAYOUT_GENERAL };
+
+	m_BuildDescriptorSet = std::make_unique<DescriptorSet>(HIZ_MAX_LEVELS);
+	m_BuildDescriptorSet->SetupLayout({
+		DescriptorSet::CreateLayout( //
+			DescriptorType::COMBINED_IMAGE_SAMPLER,
+			ShaderType::COMPUTE,
+			0,
+			1,
+			nullptr,
+			nullptr,
+			0,
+			&m_Sampler), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::COMBINED_IMAGE_SAMPLER,
+			ShaderType::COMPUTE,
+			1,
+			1,
+			nullptr,
+			&levelImageInfo,
+			0,
+			&m_Sampler), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_IMAGE,
+			ShaderType::COMPUTE,
+			2,
+			1,
+			nullptr,
+			&levelImageInfo), //
+	});
+	m_BuildDescriptorSet->Create();
+
+	// the depth buffer is only read with `texelFetch()`, the multisampled one needs another sampler type
+	const char* shaderPath = Device::GetMSAASamplesCount() == VK_SAMPLE_COUNT_1_BIT
+		? "assets/shaders/hiZBuffer.comp.spv"
+		: "assets/shaders/hiZBufferMS.comp.spv";
+	m_BuildPipeline = std::make_unique<ComputePipeline>(shaderPath, m_BuildDescriptorSet->GetPipelineLayout());
+
+	m_DescriptorSet = std::make_unique<DescriptorSet>(maxFramesInFlight);
+	m_DescriptorSet->SetupLayout({
+		DescriptorSet::CreateLayout( //
+			DescriptorType::COMBINED_IMAGE_SAMPLER,
+			ShaderType::COMPUTE,
+			0,
+			1,
+			nullptr,
+			&pyramidImageInfo,
+			0,
+			&m_Sampler), //
+	});
+	m_DescriptorSet->Create();
+
+	UpdateDescriptors();
+}
+
+HiZBuffer::~HiZBuffer()
+{
+	Cleanup();
+}
+
+void HiZBuffer::Recreate(uint32_t width, uint32_t height)
+{
+	Device::WaitIdle();
+	Cleanup();
+
+	CreatePyramid(width, height);
+	UpdateDescriptors();
+}
+
+void HiZBuffer::SetDepthImageView(VkImageView depthImageView)
+{
+	// the sets of all the levels have the depth buffer, only level 0 reads it
+	VkDescriptorImageInfo depthImageInfo{ m_Sampler, depthImageView, VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL };
+	for (uint32_t level = 0; level < m_LevelCount; ++level)
+		m_BuildDescriptorSet->UpdateImages(0, &depthImageInfo, level);
+}
+
+void HiZBuffer::Build(VkCommandBuffer commandBuffer)
+{
+	// the previous contents are discarded, the culling passes of the previous frame have read them
+	VkImageMemoryBarrier imageBarrier{};
+	imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	imageBarrier.srcAccessMask = 0;
+	imageBarrier.dstAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	imageBarrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	imageBarrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	imageBarrier.image = m_Image;
+	imageBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	imageBarrier.subresourceRange.baseMipLevel = 0;
+	imageBarrier.subresourceRange.levelCount = m_LevelCount;
+	imageBarrier.subresourceRange.baseArrayLayer = 0;
+	imageBarrier.subresourceRange.layerCount = 1;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		1,
+		&imageBarrier);
+
+	// every level reads the previous one, the culling passes read the last one
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	m_BuildPipeline->Bind(commandBuffer);
+	for (uint32_t level = 0; level < m_LevelCount; ++level)
+	{
+		// x = level, y = 1 with reverse-z (the farthest depth is the smallest), z = samples of the depth buffer
+		const glm::uvec4 pushConstants{ level,
+			Device::IsReverseZ() ? 1u : 0u,
+			static_cast<uint32_t>(Device::GetMSAASamplesCount()),
+			0 };
+		m_BuildDescriptorSet->BindCompute(commandBuffer, level);
+		m_BuildDescriptorSet->PushComputeConstants(commandBuffer, &pushConstants);
+
+		const uint32_t width = std::max(m_Width >> level, 1u);
+		const uint32_t height = std::max(m_Height >> level, 1u);
+		m_BuildPipeline->Dispatch(commandBuffer,
+			(width + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+			(height + HIZ_GROUP_SIZE - 1) / HIZ_GROUP_SIZE,
+			1);
+
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1,
+			&barrier,
+			0,
+			nullptr,
+			0,
+			nullptr);
+	}
+}
+
+void HiZBuffer::CreatePyramid(uint32_t width, uint32_t height)
+{
+	// powers of two, so that every texel of a level covers exactly 2x2 texels of the previous one
+	const uint32_t maxSize = 1u << (HIZ_MAX_LEVELS - 1);
+	m_Width = std::min(PreviousPowerOfTwo(width), maxSize);
+	m_Height = std::min(PreviousPowerOfTwo(height), maxSize);
+	m_LevelCount = 1;
+	while ((std::max(m_Width, m_Height) >> m_LevelCount) > 0)
+		++m_LevelCount;
+
+	utils::CreateImage(m_Width,
+		m_Height,
+		m_LevelCount,
+		VK_SAMPLE_COUNT_1_BIT,
+		VK_FORMAT_R32_SFLOAT,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_Image,
+		m_ImageMemory);
+
+	m_ImageView = utils::CreateImageView(m_Image, VK_FORMAT_R32_SFLOAT, VK_IMAGE_ASPECT_COLOR_BIT, m_LevelCount);
+	for (uint32_t level = 0; level < m_LevelCount; ++level)
+	{
+		VkImageViewCreateInfo imageViewInfo{};
+		imageViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+		imageViewInfo.image = m_Image;
+		imageViewInfo.format = VK_FORMAT_R32_SFLOAT;
+		imageViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+		imageViewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		imageViewInfo.subresourceRange.baseMipLevel = level;
+		imageViewInfo.subresourceRange.levelCount = 1;
+		imageViewInfo.subresourceRange.baseArrayLayer = 0;
+		imageViewInfo.subresourceRange.layerCount = 1;
+
+		THROW(vkCreateImageView(Device::GetDevice(), &imageViewInfo, nullptr, &m_LevelViews[level]) != VK_SUCCESS,
+			"Failed to create hi-z level image view!")
+	}
+
+	// the pyramid stays in the general layout, the culling passes may be recorded before it is built the first time
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = 0;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barrier.newLayout = VK_IMAGE_LAYOUT_GENERAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = m_Image;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = 0;
+	barrier.subresourceRange.levelCount = m_LevelCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = 1;
+
+	VkCommandBuffer commandBuffer = utils::BeginSingleTimeCommands();
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		0,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		1,
+		&barrier);
+	utils::EndSingleTimeCommands(commandBuffer);
+}
+
+void HiZBuffer::UpdateDescriptors()
+{
+	VkDescriptorImageInfo pyramidImageInfo{ m_Sampler, m_ImageView, VK_IMAGE_LAYOUT_GENERAL };
+
+	// level 0 reads the depth buffer, its previous level is never read
+	for (uint32_t level = 0; level < m_LevelCount; ++level)
+	{
+		VkDescriptorImageInfo previousImageInfo{ m_Sampler,
+			m_LevelViews[level == 0 ? 0 : level - 1],
+			VK_IMAGE_LAYOUT_GENERAL };
+		VkDescriptorImageInfo levelImageInfo{ m_Sampler, m_LevelViews[level], VK_IMAGE_LAYOUT_GENERAL };
+
+		m_BuildDescriptorSet->UpdateImages(1, &previousImageInfo, level);
+		m_BuildDescriptorSet->UpdateImages(2, &levelImageInfo, level);
+	}
+
+	m_DescriptorSet->UpdateImages(0, &pyramidImageInfo);
+}
+
+void HiZBuffer::Cleanup()
+{
+	for (uint32_t level = 0; level < m_LevelCount; ++level)
+		vkDestroyImageView(Device::GetDevice(), m_LevelViews[level], nullptr);
+	vkDestroyImageView(Device::GetDevice(), m_ImageView, nullptr);
+	vkDestroyImage(Device::GetDevice(), m_Image, nullptr);
+	utils::FreeMemory(m_ImageMemory);
+}
+
+void HiZBuffer::CreateSampler()
+{
+	// the pyramid and the depth buffer are only read with `texelFetch()`
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = VK_FILTER_NEAREST;
+	samplerInfo.minFilter = VK_FILTER_NEAREST;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.0f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_FALSE;
+	samplerInfo.compareOp = VK_COMPARE_OP_ALWAYS;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
+
+	m_Sampler = SamplerCache::Get(samplerInfo);
+}
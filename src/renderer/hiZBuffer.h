@@ -0,0 +1,61 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <vulkan/vulkan.h>
+#include "renderer/descriptor.h"
+#include "renderer/computePipeline.h"
+
+
+// these have to match the values in `hiZBuffer.comp`
+constexpr uint32_t HIZ_MAX_LEVELS = 16;
+constexpr uint32_t HIZ_GROUP_SIZE = 8; // 8x8 texels per workgroup
+
+// hierarchical depth (hi-z) pyramid of the depth buffer of the swapchain, for the occlusion culling
+// level 0 is the largest power of two that fits into the depth buffer, every texel holds the farthest depth of the
+// pixels it covers (and of all their samples with msaa), every next level halves the size and keeps the farthest
+// depth of 2x2 texels, so a texel of any level is never nearer than the depth buffer under it
+// built by one compute dispatch per level
+//
+// the pyramid is sampled by the culling passes through a shared descriptor set
+// binding 0: pyramid (`sampler2D`, nearest, every level, r32f)
+class HiZBuffer
+{
+public:
+	HiZBuffer(uint32_t width, uint32_t height, const uint32_t maxFramesInFlight);
+	~HiZBuffer();
+
+	// has to be called when the swapchain is recreated, followed by `SetDepthImageView()`
+	void Recreate(uint32_t width, uint32_t height);
+	// the depth buffer is a transient image of the render graph, has to be called after it has been recreated
+	void SetDepthImageView(VkImageView depthImageView);
+	// records the downsample passes, has to be called outside of a render pass
+	// the depth buffer has been written and is in `VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL` (a
+	// `RenderGraphAccess::SAMPLED_COMPUTE` read)
+	void Build(VkCommandBuffer commandBuffer);
+
+	inline const DescriptorSet* GetDescriptorSet() const { return m_DescriptorSet.get(); }
+
+private:
+	void CreatePyramid(uint32_t width, uint32_t height);
+	void UpdateDescriptors();
+	void Cleanup();
+
+	void CreateSampler();
+
+private:
+	uint32_t m_Width = 0; // of level 0
+	uint32_t m_Height = 0;
+	uint32_t m_LevelCount = 0;
+
+	VkImage m_Image{};
+	VkDeviceMemory m_ImageMemory{};
+	VkImageView m_ImageView{}; // every level
+	std::array<VkImageView, HIZ_MAX_LEVELS> m_LevelViews{};
+	VkSampler m_Sampler{}; // owned by the `SamplerCache`
+
+	// one set per level, binding 0 = depth buffer, 1 = previous level, 2 = level that is written
+	std::unique_ptr<DescriptorSet> m_BuildDescriptorSet{};
+	std::unique_ptr<ComputePipeline> m_BuildPipeline{};
+	std::unique_ptr<DescriptorSet> m_DescriptorSet{};
+};
@@ -1,5 +1,7 @@
 #include "renderer/indexBuffer.h"
 
+#include <cstdint>
+#include <algorithm>
 #include "utils/utils.h"
 #include "renderer/device.h"
 
@@ -17,7 +19,17 @@ IndexBuffer::~IndexBuffer()
 
 void IndexBuffer::Init(const std::vector<uint32_t>& indices)
 {
-	VkDeviceSize size = sizeof(indices[0]) * static_cast<uint64_t>(indices.size());
+	// primitive restart is not used, so 0xffff is a regular index
+	std::vector<uint16_t> shortIndices{};
+	const void* src = indices.data();
+	VkDeviceSize size = sizeof(uint32_t) * static_cast<uint64_t>(indices.size());
+	if (std::all_of(indices.begin(), indices.end(), [](uint32_t index) { return index <= UINT16_MAX; }))
+	{
+		m_IndexType = VK_INDEX_TYPE_UINT16;
+		shortIndices.assign(indices.begin(), indices.end());
+		src = shortIndices.data();
+		size = sizeof(uint16_t) * static_cast<uint64_t>(shortIndices.size());
+	}
 
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMem;
@@ -29,7 +41,7 @@ void IndexBuffer::Init(const std::vector<uint32_t>& indices)
 
 	void* data;
 	vkMapMemory(Device::GetDevice(), stagingBufferMem, 0, size, 0, &data);
-	memcpy(data, indices.data(), static_cast<size_t>(size));
+	memcpy(data, src, static_cast<size_t>(size));
 	vkUnmapMemory(Device::GetDevice(), stagingBufferMem);
 
 	// create the actual index buffer
@@ -41,12 +53,12 @@ void IndexBuffer::Init(const std::vector<uint32_t>& indices)
 
 	utils::CopyBuffer(stagingBuffer, m_IndexBuffer, size);
 
-	vkFreeMemory(Device::GetDevice(), stagingBufferMem, nullptr);
+	utils::FreeMemory(stagingBufferMem);
 	vkDestroyBuffer(Device::GetDevice(), stagingBuffer, nullptr);
 }
 
 void IndexBuffer::Cleanup()
 {
-	vkFreeMemory(Device::GetDevice(), m_IndexBufferMemory, nullptr);
+	utils::FreeMemory(m_IndexBufferMemory);
 	vkDestroyBuffer(Device::GetDevice(), m_IndexBuffer, nullptr);
 }
\ No newline at end of file
@@ -2,8 +2,11 @@
 
 #include <vector>
 #include <vulkan/vulkan.h>
+#include "renderer/renderStats.h"
 
 
+// the indices are stored as `uint16_t` when every index fits, which halves the index memory and fetches
+// the index type is carried by the buffer, see `GetIndexType()`
 class IndexBuffer
 {
 public:
@@ -11,10 +14,21 @@ public:
 	~IndexBuffer();
 
 	inline VkBuffer GetBuffer() const { return m_IndexBuffer; }
-	inline void Draw(VkCommandBuffer commandBuffer) { vkCmdDrawIndexed(commandBuffer, m_IndexSize, 1, 0, 0, 0); }
+	inline VkIndexType GetIndexType() const { return m_IndexType; }
+	inline void Draw(VkCommandBuffer commandBuffer)
+	{
+		RenderStats::CountDraw(m_IndexSize);
+		vkCmdDrawIndexed(commandBuffer, m_IndexSize, 1, 0, 0, 0);
+	}
+	// draws a range of the indices, eg: a lod of a mesh
+	inline void Draw(VkCommandBuffer commandBuffer, uint32_t indexCount, uint32_t firstIndex)
+	{
+		RenderStats::CountDraw(indexCount);
+		vkCmdDrawIndexed(commandBuffer, indexCount, 1, firstIndex, 0, 0);
+	}
 	inline void Bind(VkCommandBuffer commandBuffer)
 	{
-		vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+		vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer, 0, m_IndexType);
 	}
 
 private:
@@ -23,6 +37,7 @@ private:
 
 private:
 	uint32_t m_IndexSize;
+	VkIndexType m_IndexType = VK_INDEX_TYPE_UINT32;
 	VkBuffer m_IndexBuffer;
 	VkDeviceMemory m_IndexBufferMemory;
 };
\ No newline at end of file
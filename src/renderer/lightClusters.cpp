@@ -0,0 +1,227 @@
+#include "renderer/lightClusters.h"
+
+#include <cmath>
+#include <algorithm>
+#include <glm/gtc/matrix_inverse.hpp>
+#include "core/core.h"
+
+
+// any depth in (0, 1) lies on the view ray of the pixel,
+// this works for both standard and reverse/infinite depth projections
+static glm::vec3 ScreenToView(const glm::vec2& screenPos, const ClusterUBO& ubo)
+{
+	glm::vec2 ndc = screenPos / glm::vec2(ubo.screenParams.x, ubo.screenParams.y) * 2.0f - 1.0f;
+	glm::vec4 view = ubo.invProjMat * glm::vec4(ndc, 0.5f, 1.0f);
+	return glm::vec3(view) / view.w;
+}
+
+// point on the view ray through `point` at the given (positive) view space depth
+static inline glm::vec3 RayAtDepth(const glm::vec3& point, float depth)
+{
+	return point * (depth / -point.z);
+}
+
+static inline float SliceDepth(uint32_t slice, float zNear, float zFar)
+{
+	return zNear * std::pow(zFar / zNear, static_cast<float>(slice) / static_cast<float>(CLUSTER_GRID_Z));
+}
+
+static inline uint32_t DepthSlice(float depth, float zNear, float zFar)
+{
+	float slice = std::log(depth / zNear) / std::log(zFar / zNear) * static_cast<float>(CLUSTER_GRID_Z);
+	return static_cast<uint32_t>(std::clamp(slice, 0.0f, static_cast<float>(CLUSTER_GRID_Z - 1)));
+}
+
+
+LightClusters::LightClusters(const uint32_t maxFramesInFlight)
+	: m_ClusterMin(CLUSTER_COUNT),
+	  m_ClusterMax(CLUSTER_COUNT),
+	  m_LightCounts(CLUSTER_COUNT)
+{
+	VkDeviceSize uboSize = sizeof(ClusterUBO);
+	VkDeviceSize lightBufferSize = sizeof(PointLight) * MAX_LIGHTS;
+	VkDeviceSize lightCountBufferSize = sizeof(uint32_t) * CLUSTER_COUNT;
+	VkDeviceSize lightIndexBufferSize = sizeof(uint32_t) * CLUSTER_COUNT * MAX_LIGHTS_PER_CLUSTER;
+
+	m_UniformBuffers.reserve(maxFramesInFlight);
+	m_LightBuffers.reserve(maxFramesInFlight);
+	m_LightCountBuffers.reserve(maxFramesInFlight);
+	m_LightIndexBuffers.reserve(maxFramesInFlight);
+
+	// the cluster buffers are host visible so that they can also be filled by the cpu fallback
+	for (uint64_t i = 0; i < maxFramesInFlight; ++i)
+	{
+		m_UniformBuffers.emplace_back(
+			uboSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uboSize);
+		m_LightBuffers.emplace_back(
+			lightBufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_LightCountBuffers.emplace_back(
+			lightCountBufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_LightIndexBuffers.emplace_back(
+			lightIndexBufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+	}
+
+	std::vector<VkDescriptorBufferInfo> uniformBufferInfos = UniformBuffer::GetBufferInfos(m_UniformBuffers);
+	std::vector<VkDescriptorBufferInfo> lightBufferInfos = StorageBuffer::GetBufferInfos(m_LightBuffers);
+	std::vector<VkDescriptorBufferInfo> lightCountBufferInfos = StorageBuffer::GetBufferInfos(m_LightCountBuffers);
+	std::vector<VkDescriptorBufferInfo> lightIndexBufferInfos = StorageBuffer::GetBufferInfos(m_LightIndexBuffers);
+
+	m_DescriptorSet = std::make_unique<DescriptorSet>(maxFramesInFlight);
+	m_DescriptorSet->SetupLayout({
+		DescriptorSet::CreateLayout( //
+			DescriptorType::UNIFORM_BUFFER,
+			ShaderType::COMPUTE | ShaderType::FRAGMENT,
+			0,
+			1,
+			uniformBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE | ShaderType::FRAGMENT,
+			1,
+			1,
+			lightBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE | ShaderType::FRAGMENT,
+			2,
+			1,
+			lightCountBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE | ShaderType::FRAGMENT,
+			3,
+			1,
+			lightIndexBufferInfos.data(),
+			nullptr), //
+	});
+	m_DescriptorSet->Create();
+
+	// the pipeline layout of the descriptor set is reused for the culling pass
+	m_CullingPipeline = std::make_unique<ComputePipeline>(
+		"assets/shaders/clusterCulling.comp.spv", m_DescriptorSet->GetPipelineLayout());
+}
+
+void LightClusters::Update(const std::vector<PointLight>& lights,
+	const Camera& camera,
+	uint32_t width,
+	uint32_t height,
+	const uint32_t currentFrameIndex)
+{
+	const uint32_t lightCount = std::min(static_cast<uint32_t>(lights.size()), MAX_LIGHTS);
+
+	m_ClusterUbo.viewMat = camera.GetViewMatrix();
+	m_ClusterUbo.invProjMat = glm::inverse(camera.GetProjectionMatrix());
+	m_ClusterUbo.gridSize = glm::uvec4(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, lightCount);
+	m_ClusterUbo.screenParams =
+		glm::vec4(static_cast<float>(width), static_cast<float>(height), camera.GetZNear(), camera.GetZFar());
+
+	m_UniformBuffers[currentFrameIndex].Map(&m_ClusterUbo);
+	if (lightCount > 0)
+		m_LightBuffers[currentFrameIndex].Map(lights.data(), sizeof(PointLight) * lightCount);
+
+	if (!m_UseGpuCulling)
+		AssignLightsCpu(lights, currentFrameIndex);
+}
+
+void LightClusters::Cull(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex)
+{
+	if (!m_UseGpuCulling)
+		return;
+
+	m_CullingPipeline->Bind(commandBuffer);
+	m_DescriptorSet->BindCompute(commandBuffer, currentFrameIndex);
+	// one invocation per cluster
+	m_CullingPipeline->Dispatch(
+		commandBuffer, (CLUSTER_COUNT + CLUSTER_CULLING_GROUP_SIZE - 1) / CLUSTER_CULLING_GROUP_SIZE, 1, 1);
+
+	// the fragment shaders have to wait for the light lists to be written
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0,
+		1,
+		&barrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
+}
+
+void LightClusters::AssignLightsCpu(const std::vector<PointLight>& lights, const uint32_t currentFrameIndex)
+{
+	const uint32_t lightCount = m_ClusterUbo.gridSize.w;
+	const float zNear = m_ClusterUbo.screenParams.z;
+	const float zFar = m_ClusterUbo.screenParams.w;
+	const glm::vec2 tileSize = glm::vec2(m_ClusterUbo.screenParams.x / static_cast<float>(CLUSTER_GRID_X),
+		m_ClusterUbo.screenParams.y / static_cast<float>(CLUSTER_GRID_Y));
+
+	// view space bounds of the clusters, same as `clusterCulling.comp`
+	for (uint32_t y = 0; y < CLUSTER_GRID_Y; ++y)
+	{
+		for (uint32_t x = 0; x < CLUSTER_GRID_X; ++x)
+		{
+			glm::vec3 tileMin = ScreenToView(glm::vec2(x, y) * tileSize, m_ClusterUbo);
+			glm::vec3 tileMax = ScreenToView(glm::vec2(x + 1, y + 1) * tileSize, m_ClusterUbo);
+
+			for (uint32_t z = 0; z < CLUSTER_GRID_Z; ++z)
+			{
+				float sliceNear = SliceDepth(z, zNear, zFar);
+				float sliceFar = SliceDepth(z + 1, zNear, zFar);
+
+				glm::vec3 minNear = RayAtDepth(tileMin, sliceNear);
+				glm::vec3 minFar = RayAtDepth(tileMin, sliceFar);
+				glm::vec3 maxNear = RayAtDepth(tileMax, sliceNear);
+				glm::vec3 maxFar = RayAtDepth(tileMax, sliceFar);
+
+				uint32_t clusterIdx = x + y * CLUSTER_GRID_X + z * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+				m_ClusterMin[clusterIdx] = glm::min(glm::min(minNear, minFar), glm::min(maxNear, maxFar));
+				m_ClusterMax[clusterIdx] = glm::max(glm::max(minNear, minFar), glm::max(maxNear, maxFar));
+			}
+		}
+	}
+
+	// counts are accumulated in host memory, reading back from the mapped (uncached) buffer is slow
+	std::fill(m_LightCounts.begin(), m_LightCounts.end(), 0);
+	auto lightIndices = static_cast<uint32_t*>(m_LightIndexBuffers[currentFrameIndex].GetMappedData());
+
+	for (uint32_t i = 0; i < lightCount; ++i)
+	{
+		glm::vec3 center = glm::vec3(m_ClusterUbo.viewMat * glm::vec4(glm::vec3(lights[i].position), 1.0f));
+		float radius = lights[i].position.w;
+		float depth = -center.z;
+
+		if (depth + radius < zNear || depth - radius > zFar)
+			continue;
+
+		// only the slices the light's sphere overlaps have to be tested
+		uint32_t firstSlice = DepthSlice(std::max(depth - radius, zNear), zNear, zFar);
+		uint32_t lastSlice = DepthSlice(std::min(depth + radius, zFar), zNear, zFar);
+
+		for (uint32_t z = firstSlice; z <= lastSlice; ++z)
+		{
+			for (uint32_t xy = 0; xy < CLUSTER_GRID_X * CLUSTER_GRID_Y; ++xy)
+			{
+				uint32_t clusterIdx = xy + z * CLUSTER_GRID_X * CLUSTER_GRID_Y;
+
+				// sphere-aabb intersection
+				glm::vec3 closest = glm::clamp(center, m_ClusterMin[clusterIdx], m_ClusterMax[clusterIdx]);
+				glm::vec3 dist = closest - center;
+				if (glm::dot(dist, dist) > radius * radius || m_LightCounts[clusterIdx] >= MAX_LIGHTS_PER_CLUSTER)
+					continue;
+
+				lightIndices[clusterIdx * MAX_LIGHTS_PER_CLUSTER + m_LightCounts[clusterIdx]] = i;
+				++m_LightCounts[clusterIdx];
+			}
+		}
+	}
+
+	m_LightCountBuffers[currentFrameIndex].Map(m_LightCounts.data(), sizeof(uint32_t) * CLUSTER_COUNT);
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include "renderer/uniformBuffer.h"
+#include "renderer/storageBuffer.h"
+#include "renderer/descriptor.h"
+#include "renderer/computePipeline.h"
+#include "renderer/camera.h"
+#include "editor/ubo.h"
+
+
+// these have to match the values in the shaders
+constexpr uint32_t CLUSTER_GRID_X = 16;
+constexpr uint32_t CLUSTER_GRID_Y = 9;
+constexpr uint32_t CLUSTER_GRID_Z = 24;
+constexpr uint32_t CLUSTER_COUNT = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+constexpr uint32_t MAX_LIGHTS = 4096;
+constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 256;
+constexpr uint32_t CLUSTER_CULLING_GROUP_SIZE = 64;
+
+// clustered shading, used by both the forward and the deferred path
+// the view frustum is divided into a 3D grid of clusters (froxels), exponentially spaced along the depth,
+// and every point light is assigned to the clusters its sphere of influence overlaps
+// the fragment shader then only loops over the lights of the cluster it lies in
+//
+// the scene wide lighting data is exposed as a shared descriptor set (set 1) of the lit pipelines
+// binding 0: `ClusterUBO`
+// binding 1: lights
+// binding 2: light count of each cluster
+// binding 3: light indices of each cluster (`MAX_LIGHTS_PER_CLUSTER` slots per cluster)
+class LightClusters
+{
+public:
+	LightClusters(const uint32_t maxFramesInFlight);
+
+	// uploads the lights and the cluster parameters for the frame
+	// also assigns the lights to the clusters if gpu culling is disabled
+	void Update(const std::vector<PointLight>& lights,
+		const Camera& camera,
+		uint32_t width,
+		uint32_t height,
+		const uint32_t currentFrameIndex);
+	// records the culling compute pass, has to be called outside of a render pass
+	void Cull(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex);
+
+	inline void SetGpuCulling(bool enable) { m_UseGpuCulling = enable; }
+	inline bool IsGpuCulling() const { return m_UseGpuCulling; }
+	inline const DescriptorSet* GetDescriptorSet() const { return m_DescriptorSet.get(); }
+
+private:
+	void AssignLightsCpu(const std::vector<PointLight>& lights, const uint32_t currentFrameIndex);
+
+private:
+	bool m_UseGpuCulling = true;
+	ClusterUBO m_ClusterUbo{};
+
+	// used by the cpu fallback
+	std::vector<glm::vec3> m_ClusterMin{};
+	std::vector<glm::vec3> m_ClusterMax{};
+	std::vector<uint32_t> m_LightCounts{};
+
+	std::vector<UniformBuffer> m_UniformBuffers{};
+	std::vector<StorageBuffer> m_LightBuffers{};
+	std::vector<StorageBuffer> m_LightCountBuffers{};
+	std::vector<StorageBuffer> m_LightIndexBuffers{};
+
+	std::unique_ptr<DescriptorSet> m_DescriptorSet{};
+	std::unique_ptr<ComputePipeline> m_CullingPipeline{};
+};
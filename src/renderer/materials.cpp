@@ -0,0 +1,34 @@
+#include "renderer/materials.h"
+
+#include <algorithm>
+#include "core/core.h"
+
+
+Materials::Materials(const uint32_t maxFramesInFlight)
+	: m_UploadedCounts(maxFramesInFlight, 0)
+{
+	m_Materials.reserve(MAX_MATERIALS);
+	m_Buffers.reserve(maxFramesInFlight);
+	for (uint32_t i = 0; i < maxFramesInFlight; ++i)
+		m_Buffers.emplace_back(sizeof(Material) * MAX_MATERIALS,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+}
+
+MaterialIndex Materials::Add(const Material& material)
+{
+	THROW(m_Materials.size() >= MAX_MATERIALS, "The material buffer is full ({} materials)!", MAX_MATERIALS)
+
+	m_Materials.push_back(material);
+	return { static_cast<uint32_t>(m_Materials.size() - 1) };
+}
+
+void Materials::Update(const uint32_t currentFrameIndex)
+{
+	const uint32_t uploadedCount = m_UploadedCounts[currentFrameIndex];
+	if (uploadedCount == GetCount())
+		return;
+
+	auto materials = static_cast<Material*>(m_Buffers[currentFrameIndex].GetMappedData());
+	std::copy(m_Materials.begin() + uploadedCount, m_Materials.end(), materials + uploadedCount);
+	m_UploadedCounts[currentFrameIndex] = GetCount();
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "renderer/descriptor.h"
+#include "renderer/storageBuffer.h"
+
+
+constexpr uint32_t MAX_MATERIALS = 1024;
+constexpr float DEFAULT_SHININESS = 128.0f;
+// the g-buffer stores the shininess in a unorm channel divided by this, has to match `materials.glsl`
+constexpr float MAX_SHININESS = 256.0f;
+
+// std430, has to match `materials.glsl`
+struct Material
+{
+	uint32_t diffuseTexture = 0; // in the bindless texture array
+	uint32_t specularTexture = 0;
+	float shininess = DEFAULT_SHININESS; // blinn-phong exponent, 1 to `MAX_SHININESS`
+	float specularStrength = 1.0f; // scales the specular texture
+};
+static_assert(sizeof(Material) == 16);
+
+// the material of a draw, an index into the material buffer
+// pushed to the fragment shaders of the lit pipelines (fragment stage, offset 0, see `FRAGMENT_PUSH_CONSTANT_SIZE`)
+struct MaterialIndex
+{
+	uint32_t index = 0;
+
+	inline void Push(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const
+	{
+		vkCmdPushConstants(
+			commandBuffer, pipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(MaterialIndex), this);
+	}
+};
+static_assert(sizeof(MaterialIndex) == FRAGMENT_PUSH_CONSTANT_SIZE);
+
+// the materials of all the lit objects in one storage buffer, bound in the set of the bindless textures (binding 3)
+// the buffers are host visible and per frame in flight, the materials are copied to the buffer of a frame after its
+// fence has been waited on
+class Materials
+{
+public:
+	Materials(const uint32_t maxFramesInFlight);
+
+	// returns the index of the material, the draws push it (see `MaterialIndex`)
+	MaterialIndex Add(const Material& material);
+	// copies the materials that were added since the frame was last updated, before the frame is recorded
+	void Update(const uint32_t currentFrameIndex);
+
+	inline std::vector<VkDescriptorBufferInfo> GetBufferInfos() const
+	{
+		return StorageBuffer::GetBufferInfos(m_Buffers);
+	}
+	inline uint32_t GetCount() const { return static_cast<uint32_t>(m_Materials.size()); }
+
+private:
+	std::vector<Material> m_Materials{};
+	std::vector<StorageBuffer> m_Buffers{};
+	std::vector<uint32_t> m_UploadedCounts{}; // per frame, the materials in its buffer
+};
@@ -0,0 +1,253 @@
+#include "renderer/meshletCulling.h"
+
+#include <cmath>
+#include <numeric>
+#include <algorithm>
+#include "renderer/device.h"
+#include "renderer/renderStats.h"
+
+
+MeshletCulling::MeshletCulling(const std::vector<utils::Meshlet>& meshlets,
+	const std::vector<uint32_t>& indices,
+	const std::vector<uint32_t>& regionSizes,
+	const DescriptorSet* hiZDescriptorSet,
+	const uint32_t maxFramesInFlight)
+	: m_MeshCount{ static_cast<uint32_t>(regionSizes.size()) },
+	  m_RegionOffsets(regionSizes.size(), 0),
+	  m_HiZDescriptorSet{ hiZDescriptorSet },
+	  m_FrameTriangles(maxFramesInFlight, 0),
+	  m_DrawnIndexCounts(regionSizes.size() * CULLING_PHASE_COUNT, 0)
+{
+	std::exclusive_scan(regionSizes.begin(), regionSizes.end(), m_RegionOffsets.begin(), 0u);
+	const uint32_t culledIndexCount = std::accumulate(regionSizes.begin(), regionSizes.end(), 0u);
+
+	// the meshlets and their indices don't change, the buffers written by the culling pass are per frame
+	m_MeshletBuffer = std::make_unique<StorageBuffer>(
+		meshlets.data(), sizeof(utils::Meshlet) * static_cast<uint64_t>(meshlets.size()));
+	m_IndexBuffer = std::make_unique<StorageBuffer>(
+		indices.data(), sizeof(uint32_t) * static_cast<uint64_t>(indices.size()));
+	// nothing was visible before the first frame, its early phase draws nothing
+	const std::vector<uint32_t> visibility(std::max(meshlets.size(), static_cast<size_t>(1)), 0);
+	m_VisibilityBuffer = std::make_unique<StorageBuffer>(
+		visibility.data(), sizeof(uint32_t) * static_cast<uint64_t>(visibility.size()));
+
+	VkDeviceSize uboSize = sizeof(MeshletCullingUBO);
+	VkDeviceSize jobBufferSize = JOB_SIZE * static_cast<uint64_t>(m_MeshCount);
+	VkDeviceSize drawBufferSize =
+		sizeof(VkDrawIndexedIndirectCommand) * static_cast<uint64_t>(m_MeshCount) * CULLING_PHASE_COUNT;
+	VkDeviceSize culledIndexBufferSize = sizeof(uint32_t) * static_cast<uint64_t>(std::max(culledIndexCount, 1u));
+
+	m_UniformBuffers.reserve(maxFramesInFlight);
+	m_JobBuffers.reserve(maxFramesInFlight);
+	m_DrawBuffers.reserve(maxFramesInFlight);
+	m_CulledIndexBuffers.reserve(maxFramesInFlight);
+
+	// the draws are host visible, they are reset by the cpu every frame and read back for the stats
+	for (uint64_t i = 0; i < maxFramesInFlight; ++i)
+	{
+		m_UniformBuffers.emplace_back(
+			uboSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uboSize);
+		m_JobBuffers.emplace_back(
+			jobBufferSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		m_DrawBuffers.emplace_back(drawBufferSize,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT);
+		m_CulledIndexBuffers.emplace_back(
+			culledIndexBufferSize, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT);
+
+		// nothing is drawn before the first culling pass of the frame
+		// the late phase of a mesh draws after the indices of its early phase (its first index is set by the gpu)
+		auto draws = static_cast<VkDrawIndexedIndirectCommand*>(m_DrawBuffers.back().GetMappedData());
+		for (uint32_t draw = 0; draw < m_MeshCount * CULLING_PHASE_COUNT; ++draw)
+			draws[draw] = VkDrawIndexedIndirectCommand{ 0, 1, m_RegionOffsets[draw / CULLING_PHASE_COUNT], 0, 0 };
+	}
+
+	std::vector<VkDescriptorBufferInfo> uniformBufferInfos = UniformBuffer::GetBufferInfos(m_UniformBuffers);
+	std::vector<VkDescriptorBufferInfo> meshletBufferInfos(maxFramesInFlight, m_MeshletBuffer->GetBufferInfo());
+	std::vector<VkDescriptorBufferInfo> indexBufferInfos(maxFramesInFlight, m_IndexBuffer->GetBufferInfo());
+	std::vector<VkDescriptorBufferInfo> jobBufferInfos = StorageBuffer::GetBufferInfos(m_JobBuffers);
+	std::vector<VkDescriptorBufferInfo> drawBufferInfos = StorageBuffer::GetBufferInfos(m_DrawBuffers);
+	std::vector<VkDescriptorBufferInfo> culledIndexBufferInfos = StorageBuffer::GetBufferInfos(m_CulledIndexBuffers);
+	std::vector<VkDescriptorBufferInfo> visibilityBufferInfos(maxFramesInFlight, m_VisibilityBuffer->GetBufferInfo());
+
+	m_DescriptorSet = std::make_unique<DescriptorSet>(maxFramesInFlight);
+	m_DescriptorSet->SetupLayout({
+		DescriptorSet::CreateLayout( //
+			DescriptorType::UNIFORM_BUFFER,
+			ShaderType::COMPUTE,
+			0,
+			1,
+			uniformBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE,
+			1,
+			1,
+			meshletBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE,
+			2,
+			1,
+			indexBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE,
+			3,
+			1,
+			jobBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE,
+			4,
+			1,
+			drawBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE,
+			5,
+			1,
+			culledIndexBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::STORAGE_BUFFER,
+			ShaderType::COMPUTE,
+			6,
+			1,
+			visibilityBufferInfos.data(),
+			nullptr), //
+	},
+		{ m_HiZDescriptorSet->GetDescriptorSetLayout() });
+	m_DescriptorSet->Create();
+
+	m_CullingPipeline = std::make_unique<ComputePipeline>(
+		"assets/shaders/meshletCulling.comp.spv", m_DescriptorSet->GetPipelineLayout());
+}
+
+void MeshletCulling::Update(const glm::mat4& modelMat,
+	const Camera& camera,
+	const std::vector<MeshletRange>& ranges,
+	bool occlusionCulling,
+	const uint32_t currentFrameIndex)
+{
+	// the fence of the frame has been waited on, the draws of its last use are complete
+	auto draws = static_cast<VkDrawIndexedIndirectCommand*>(m_DrawBuffers[currentFrameIndex].GetMappedData());
+	m_Stats.triangles = m_FrameTriangles[currentFrameIndex];
+	m_Stats.drawnTriangles = 0;
+	m_Stats.lateTriangles = 0;
+	for (uint32_t i = 0; i < m_MeshCount * CULLING_PHASE_COUNT; ++i)
+	{
+		m_DrawnIndexCounts[i] = draws[i].indexCount;
+		m_Stats.drawnTriangles += draws[i].indexCount / 3;
+		if (i % CULLING_PHASE_COUNT == static_cast<uint32_t>(CullingPhase::LATE))
+			m_Stats.lateTriangles += draws[i].indexCount / 3;
+		draws[i].indexCount = 0;
+	}
+
+	auto jobs = static_cast<glm::uvec4*>(m_JobBuffers[currentFrameIndex].GetMappedData());
+	m_MaxMeshletCount = 0;
+	m_FrameTriangles[currentFrameIndex] = 0;
+	for (uint32_t mesh = 0; mesh < m_MeshCount; ++mesh)
+	{
+		jobs[mesh] = glm::uvec4(ranges[mesh].firstMeshlet, ranges[mesh].meshletCount, m_RegionOffsets[mesh], 0);
+		m_MaxMeshletCount = std::max(m_MaxMeshletCount, ranges[mesh].meshletCount);
+		m_FrameTriangles[currentFrameIndex] += ranges[mesh].triangleCount;
+	}
+
+	// the largest scale of the model matrix, the meshlet bounds are in object space
+	const float scale = std::sqrt(std::max({ glm::dot(glm::vec3(modelMat[0]), glm::vec3(modelMat[0])),
+		glm::dot(glm::vec3(modelMat[1]), glm::vec3(modelMat[1])),
+		glm::dot(glm::vec3(modelMat[2]), glm::vec3(modelMat[2])) }));
+	const utils::FrustumPlanes planes = utils::GetFrustumPlanes(camera.GetViewProjectionMatrix());
+	const glm::mat4 projMat = camera.GetProjectionMatrix();
+
+	m_OcclusionCulling = occlusionCulling;
+	m_CullingUbo.modelMat = modelMat;
+	m_CullingUbo.modelViewMat = camera.GetViewMatrix() * modelMat;
+	std::copy(planes.begin(), planes.end(), m_CullingUbo.frustumPlanes);
+	m_CullingUbo.cameraPos = glm::vec4(camera.GetCameraPosition(), scale);
+	m_CullingUbo.projection = glm::vec4(projMat[0][0], projMat[1][1], projMat[2][2], projMat[3][2]);
+	m_CullingUbo.depthParams = glm::vec4(camera.GetZNear(), Device::IsReverseZ() ? 1.0f : 0.0f, 0.0f, 0.0f);
+	m_UniformBuffers[currentFrameIndex].Map(&m_CullingUbo);
+}
+
+void MeshletCulling::Cull(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex, CullingPhase phase)
+{
+	if (m_MaxMeshletCount == 0 || (phase == CullingPhase::LATE && !m_OcclusionCulling))
+		return;
+
+	// the visibility is written by the late phase of the previous frame, the late phase reads the early draws
+	VkMemoryBarrier phaseBarrier{};
+	phaseBarrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	phaseBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	phaseBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+
+	if (m_OcclusionCulling)
+	{
+		vkCmdPipelineBarrier(commandBuffer,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			0,
+			1,
+			&phaseBarrier,
+			0,
+			nullptr,
+			0,
+			nullptr);
+	}
+
+	m_CullingPipeline->Bind(commandBuffer);
+	m_DescriptorSet->BindCompute(commandBuffer, currentFrameIndex);
+	m_HiZDescriptorSet->BindShared(commandBuffer,
+		m_DescriptorSet->GetPipelineLayout(),
+		1,
+		currentFrameIndex,
+		VK_PIPELINE_BIND_POINT_COMPUTE);
+	// x = phase, y = 1 with occlusion culling
+	const glm::uvec4 pushConstants{ static_cast<uint32_t>(phase), m_OcclusionCulling ? 1u : 0u, 0, 0 };
+	m_DescriptorSet->PushComputeConstants(commandBuffer, &pushConstants);
+	// one workgroup per meshlet along x (the groups loop over the meshlets past the limit), one row per mesh
+	// the groups past the meshlets of a mesh exit right away
+	const uint32_t groupCount =
+		std::min(m_MaxMeshletCount, Device::GetDeviceProperties().limits.maxComputeWorkGroupCount[0]);
+	m_CullingPipeline->Dispatch(commandBuffer, groupCount, m_MeshCount, 1);
+
+	// the draws read the index counts and the indices written by the culling pass
+	VkMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_INDEX_READ_BIT;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_VERTEX_INPUT_BIT,
+		0,
+		1,
+		&barrier,
+		0,
+		nullptr,
+		0,
+		nullptr);
+}
+
+void MeshletCulling::Draw(VkCommandBuffer commandBuffer,
+	uint32_t meshIndex,
+	const uint32_t currentFrameIndex,
+	CullingPhase phase) const
+{
+	const uint32_t drawIndex = meshIndex * CULLING_PHASE_COUNT + static_cast<uint32_t>(phase);
+	// the index count is only known to the gpu, the stats count the last one that was read back
+	RenderStats::CountDraw(m_DrawnIndexCounts[drawIndex]);
+	vkCmdBindIndexBuffer(
+		commandBuffer, m_CulledIndexBuffers[currentFrameIndex].GetBuffer(), 0, VK_INDEX_TYPE_UINT32);
+	vkCmdDrawIndexedIndirect(commandBuffer,
+		m_DrawBuffers[currentFrameIndex].GetBuffer(),
+		sizeof(VkDrawIndexedIndirectCommand) * static_cast<uint64_t>(drawIndex),
+		1,
+		sizeof(VkDrawIndexedIndirectCommand));
+}
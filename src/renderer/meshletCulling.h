@@ -0,0 +1,117 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include "renderer/uniformBuffer.h"
+#include "renderer/storageBuffer.h"
+#include "renderer/descriptor.h"
+#include "renderer/computePipeline.h"
+#include "renderer/camera.h"
+#include "editor/ubo.h"
+#include "utils/meshlets.h"
+
+
+// has to match the value in `meshletCulling.comp`
+constexpr uint32_t MESHLET_CULLING_GROUP_SIZE = 64;
+
+// the two phases of the occlusion culling, every phase has its own indirect draw per mesh
+// without occlusion culling everything that is visible is drawn by the early phase
+enum class CullingPhase
+{
+	EARLY = 0, // the meshlets that were visible in the previous frame, drawn first
+	LATE = 1, // the meshlets that the hi-z pyramid of the early phase doesn't occlude and weren't drawn by it
+};
+constexpr uint32_t CULLING_PHASE_COUNT = 2;
+
+// the meshlets of a lod of a mesh, a range of the meshlets of the model
+struct MeshletRange
+{
+	uint32_t firstMeshlet = 0;
+	uint32_t meshletCount = 0;
+	uint32_t triangleCount = 0;
+};
+
+// triangles of the meshes that are culled per frame, drawn by `MeshletCulling::Draw()`
+struct MeshletCullingStats
+{
+	uint64_t triangles = 0; // of the meshlets of the selected lods
+	uint64_t drawnTriangles = 0; // of the visible meshlets
+	uint64_t lateTriangles = 0; // of the visible meshlets drawn by the late phase (newly visible)
+};
+
+// culls the meshlets of the meshes of a model against the view frustum and their normal cones, on the gpu
+// without mesh shaders: one workgroup per meshlet tests it and copies the indices of the visible ones into a
+// compacted index buffer, every mesh then draws its region of that buffer with an indirect draw whose index count
+// was counted up by the culling pass (the instance of the model is the only one that is culled)
+//
+// with occlusion culling the meshlets are culled in two phases (two-phase occlusion culling):
+// the early phase draws the meshlets that were visible in the previous frame, the hi-z pyramid is then built from
+// that depth (see `HiZBuffer`) and the late phase tests every meshlet against it, it draws the visible ones that
+// the early phase hasn't drawn and remembers which meshlets are visible for the next frame
+// nothing that is visible is missed, what is disoccluded is drawn by the late phase of the same frame
+//
+// binding 0: `MeshletCullingUBO`
+// binding 1: meshlets of all the meshes and lods (`utils::Meshlet`)
+// binding 2: indices of all the meshes (`utils::Meshlet::firstIndex` indexes into these)
+// binding 3: meshes to cull, x = first meshlet, y = meshlet count, z = first index of the region of the mesh
+// binding 4: draw commands, one per phase of every mesh (`VkDrawIndexedIndirectCommand`)
+// binding 5: culled indices (uint32, also the index buffer of the draws)
+// binding 6: visibility of every meshlet in the last late phase, shared by the frames
+// set 1: hi-z pyramid (`HiZBuffer::GetDescriptorSet()`)
+class MeshletCulling
+{
+public:
+	// `regionSizes` are the largest index counts drawn by every mesh (its full resolution lod)
+	MeshletCulling(const std::vector<utils::Meshlet>& meshlets,
+		const std::vector<uint32_t>& indices,
+		const std::vector<uint32_t>& regionSizes,
+		const DescriptorSet* hiZDescriptorSet,
+		const uint32_t maxFramesInFlight);
+
+	// `ranges` are the meshlets of the selected lod of every mesh
+	// reads back the triangles drawn the last time the buffers of the frame were used, then resets the draws
+	// without `occlusionCulling` the late phase isn't recorded
+	void Update(const glm::mat4& modelMat,
+		const Camera& camera,
+		const std::vector<MeshletRange>& ranges,
+		bool occlusionCulling,
+		const uint32_t currentFrameIndex);
+	// records the culling compute pass of a phase, has to be called outside of a render pass
+	// the late phase has to be recorded after the hi-z pyramid has been built from the depth of the early phase
+	void Cull(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex, CullingPhase phase);
+	// draws the visible meshlets of a mesh culled by a phase, the vertex buffers of the mesh have to be bound
+	void Draw(VkCommandBuffer commandBuffer,
+		uint32_t meshIndex,
+		const uint32_t currentFrameIndex,
+		CullingPhase phase) const;
+
+	// of the frame `maxFramesInFlight` frames ago, the draws are only counted by the gpu
+	inline const MeshletCullingStats& GetStats() const { return m_Stats; }
+
+private:
+	static constexpr uint32_t JOB_SIZE = sizeof(glm::uvec4);
+
+	uint32_t m_MeshCount;
+	std::vector<uint32_t> m_RegionOffsets{}; // first index of the region of every mesh in the culled indices
+	uint32_t m_MaxMeshletCount = 0; // of the meshes this frame, the width of the dispatch
+	bool m_OcclusionCulling = false; // this frame
+	const DescriptorSet* m_HiZDescriptorSet;
+	MeshletCullingUBO m_CullingUbo{};
+	MeshletCullingStats m_Stats{};
+	// triangles of the meshlets submitted by every frame, to compare them with the read back draws
+	std::vector<uint64_t> m_FrameTriangles{};
+	std::vector<uint32_t> m_DrawnIndexCounts{}; // per phase of every mesh, read back, only for the draw call stats
+
+	std::unique_ptr<StorageBuffer> m_MeshletBuffer{};
+	std::unique_ptr<StorageBuffer> m_IndexBuffer{};
+	std::unique_ptr<StorageBuffer> m_VisibilityBuffer{};
+	std::vector<UniformBuffer> m_UniformBuffers{};
+	std::vector<StorageBuffer> m_JobBuffers{};
+	std::vector<StorageBuffer> m_DrawBuffers{};
+	std::vector<StorageBuffer> m_CulledIndexBuffers{};
+
+	std::unique_ptr<DescriptorSet> m_DescriptorSet{};
+	std::unique_ptr<ComputePipeline> m_CullingPipeline{};
+};
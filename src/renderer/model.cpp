@@ -1,38 +1,147 @@
 #include "renderer/model.h"
 
+#include <cmath>
+#include <string>
+#include <numeric>
+#include <algorithm>
 #include "core/core.h"
 #include "glm/glm.hpp"
 #include "renderer/device.h"
+#include "utils/utils.h"
+#include "utils/meshOptimizer.h"
+#include "utils/meshSimplifier.h"
+#include "utils/meshlets.h"
 
 
-Mesh::Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+LodSelection LodSelection::FromCamera(const Camera& camera, uint32_t viewportHeight, float maxPixelError)
+{
+	LodSelection selection{};
+	selection.cameraPos = camera.GetCameraPosition();
+	selection.zNear = camera.GetZNear();
+	selection.pixelsPerUnit = static_cast<float>(viewportHeight) / (2.0f * std::tan(camera.GetFOVy() * 0.5f));
+	selection.maxPixelError = maxPixelError;
+	return selection;
+}
+
+float LodSelection::GetMaxError(const glm::vec3& center, float radius, float scale) const
+{
+	if (pixelsPerUnit * scale <= 0.0f)
+		return 0.0f;
+
+	const float distance = std::max(glm::length(center - cameraPos) - radius * scale, zNear);
+	return maxPixelError * distance / (pixelsPerUnit * scale);
+}
+
+Mesh::Mesh(const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& indices,
+	const std::vector<utils::MeshLod>& lods,
+	const std::vector<MeshletRange>& meshletRanges,
+	uint32_t material,
+	bool compactVertices)
 	: m_Vertices{ vertices },
-	  m_Indices{ indices }
+	  m_Indices{ indices },
+	  m_Lods{ lods },
+	  m_MeshletRanges{ meshletRanges },
+	  m_Material{ material },
+	  m_CompactVertices{ compactVertices }
 {
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (const auto& vertex : m_Vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.pos);
+		boundsMax = glm::max(boundsMax, vertex.pos);
+	}
+	if (!m_Vertices.empty())
+	{
+		m_Center = (boundsMin + boundsMax) * 0.5f;
+		m_Radius = glm::length(boundsMax - boundsMin) * 0.5f;
+	}
+
 	Init();
 }
 
 void Mesh::Init()
 {
-	m_VertexBuffer = std::make_unique<VertexBuffer>(m_Vertices);
+	if (m_CompactVertices)
+	{
+		std::vector<CompactVertex> compactVertices = utils::CompressVertices(m_Vertices, m_VertexDecode);
+		m_VertexBuffer = std::make_unique<VertexBuffer>(compactVertices);
+		m_PositionBuffer = std::make_unique<VertexBuffer>(utils::GetPositions(compactVertices));
+	}
+	else
+	{
+		m_VertexDecode = VertexDecode{};
+		m_VertexBuffer = std::make_unique<VertexBuffer>(m_Vertices);
+		m_PositionBuffer = std::make_unique<VertexBuffer>(utils::GetPositions(m_Vertices));
+	}
 	m_IndexBuffer = std::make_unique<IndexBuffer>(m_Indices);
 }
 
-void Mesh::Draw(VkCommandBuffer commandBuffer) const
+void Mesh::Draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, bool positionsOnly) const
 {
-	m_VertexBuffer->Bind(commandBuffer);
+	BindVertices(commandBuffer, pipelineLayout, positionsOnly);
 	m_IndexBuffer->Bind(commandBuffer);
-	m_IndexBuffer->Draw(commandBuffer);
+	m_IndexBuffer->Draw(commandBuffer, m_Lods[m_Lod].indexCount, m_Lods[m_Lod].firstIndex);
+}
+
+void Mesh::DrawCulled(VkCommandBuffer commandBuffer,
+	VkPipelineLayout pipelineLayout,
+	const MeshletCulling& meshletCulling,
+	uint32_t meshIndex,
+	const uint32_t currentFrameIndex,
+	CullingPhase phase,
+	bool positionsOnly) const
+{
+	BindVertices(commandBuffer, pipelineLayout, positionsOnly);
+	meshletCulling.Draw(commandBuffer, meshIndex, currentFrameIndex, phase);
+}
+
+void Mesh::BindVertices(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, bool positionsOnly) const
+{
+	m_VertexDecode.Push(commandBuffer, pipelineLayout);
+	if (positionsOnly)
+		m_PositionBuffer->Bind(commandBuffer);
+	else
+		m_VertexBuffer->Bind(commandBuffer);
+}
+
+bool Mesh::SelectLod(const glm::mat4& modelMat, const LodSelection& selection)
+{
+	// the largest scale of the model matrix, the errors and the radius are in object space
+	const float scale = std::sqrt(std::max({ glm::dot(glm::vec3(modelMat[0]), glm::vec3(modelMat[0])),
+		glm::dot(glm::vec3(modelMat[1]), glm::vec3(modelMat[1])),
+		glm::dot(glm::vec3(modelMat[2]), glm::vec3(modelMat[2])) }));
+	const glm::vec3 center{ modelMat * glm::vec4(m_Center, 1.0f) };
+	const uint32_t lod = utils::SelectLod(m_Lods, selection.GetMaxError(center, m_Radius, scale));
+
+	const bool changed = lod != m_Lod;
+	m_Lod = lod;
+	return changed;
 }
 
 Model::Model(const char* path,
 	VkRenderPass renderPass,
+	VkRenderPass gBufferRenderPass,
+	const std::vector<const DescriptorSet*>& sharedDescriptorSets,
+	const DescriptorSet* hiZDescriptorSet,
+	BindlessTextures* bindlessTextures,
+	Materials* materials,
+	TextureStreamer* textureStreamer,
 	const uint32_t maxFramesInFlight,
 	const uint64_t numInstances,
-	bool flipUVs)
+	bool flipUVs,
+	bool compactVertices)
 	: m_RenderPass{ renderPass },
+	  m_GBufferRenderPass{ gBufferRenderPass },
+	  m_SharedDescriptorSets{ sharedDescriptorSets },
+	  m_HiZDescriptorSet{ hiZDescriptorSet },
+	  m_BindlessTextures{ bindlessTextures },
+	  m_Materials{ materials },
+	  m_TextureStreamer{ textureStreamer },
 	  m_MaxFramesInFlight{ maxFramesInFlight },
-	  m_NumInstances{ numInstances }
+	  m_NumInstances{ numInstances },
+	  m_CompactVertices{ compactVertices }
 {
 	Logger::Info("Loading model...");
 	LoadModel(path, flipUVs);
@@ -54,8 +163,34 @@ void Model::LoadModel(const std::string& path, bool flipUVs)
 
 	m_Directory = path.substr(0, path.find_last_of('/'));
 	m_Meshes.reserve(static_cast<uint64_t>(scene->mRootNode->mNumMeshes));
+	m_SceneMaterials.assign(scene->mNumMaterials, std::numeric_limits<uint32_t>::max());
 
 	ProcessNode(scene->mRootNode, scene);
+	m_SceneMaterials = {};
+	Logger::Info(
+		" {} meshes, {} materials, {} textures", m_Meshes.size(), m_MeshMaterials.size(), m_LoadedTextures.size());
+
+	std::string lodTriangles = std::to_string(m_LodTriangleCounts[0]);
+	for (uint32_t lod = 1; lod < utils::MAX_MESH_LODS; ++lod)
+		lodTriangles += " -> " + std::to_string(m_LodTriangleCounts[lod]);
+	Logger::Info(" LOD triangles: {}", lodTriangles);
+
+	uint32_t meshletCount = 0;
+	for (const auto& mesh : m_Meshes)
+		meshletCount += mesh.GetMeshletRange().meshletCount;
+	Logger::Info(" {} meshlets, {:.1f} triangles per meshlet",
+		meshletCount,
+		meshletCount == 0 ? 0.0 : static_cast<double>(m_LodTriangleCounts[0]) / static_cast<double>(meshletCount));
+
+	const utils::MeshOptimizationStats& stats = m_OptimizationStats;
+	Logger::Info(" {} triangles, {} -> {} vertices, ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f}",
+		stats.after.triangleCount,
+		stats.inputVertexCount,
+		stats.outputVertexCount,
+		stats.before.GetAcmr(),
+		stats.after.GetAcmr(),
+		stats.before.GetAtvr(),
+		stats.after.GetAtvr());
 }
 
 void Model::SetupRenderingResources()
@@ -80,7 +215,26 @@ void Model::SetupRenderingResources()
 	std::vector<VkDescriptorBufferInfo> uniformBufferInfos = UniformBuffer::GetBufferInfos(m_UniformBuffers);
 	std::vector<VkDescriptorBufferInfo> dynamicUniformBufferInfos =
 		UniformBuffer::GetBufferInfos(m_DynamicUniformBuffers);
-	std::vector<VkDescriptorImageInfo> textureImageInfos = Texture2D::GetImageInfos(m_LoadedTextures);
+	m_TextureIndices.reserve(m_LoadedTextures.size());
+	for (const auto& texture : m_LoadedTextures)
+	{
+		m_TextureIndices.push_back(m_BindlessTextures->Add(*texture));
+		m_TextureStreamer->Register(texture.get());
+	}
+	m_MaterialIndices.reserve(m_MeshMaterials.size());
+	for (Material material : m_MeshMaterials)
+	{
+		material.diffuseTexture = m_TextureIndices[material.diffuseTexture];
+		material.specularTexture = m_TextureIndices[material.specularTexture];
+		m_MaterialIndices.push_back(m_Materials->Add(material));
+	}
+
+	// the meshes that share a material are drawn one after another, the material is only pushed when it changes
+	m_DrawOrder.resize(m_Meshes.size());
+	std::iota(m_DrawOrder.begin(), m_DrawOrder.end(), 0);
+	std::stable_sort(m_DrawOrder.begin(), m_DrawOrder.end(), [this](uint32_t a, uint32_t b) {
+		return m_Meshes[a].GetMaterial() < m_Meshes[b].GetMaterial();
+	});
 
 	m_DescriptorSet = std::make_unique<DescriptorSet>(m_MaxFramesInFlight);
 	m_DescriptorSet->SetupLayout({
@@ -98,38 +252,68 @@ void Model::SetupRenderingResources()
 			1,
 			dynamicUniformBufferInfos.data(),
 			nullptr), //
-		DescriptorSet::CreateLayout( //
-			DescriptorType::SAMPLED_IMAGE,
-			ShaderType::FRAGMENT,
-			2,
-			static_cast<uint32_t>(m_LoadedTextures.size()),
-			nullptr,
-			textureImageInfos.data()), //
-		DescriptorSet::CreateLayout( //
-			DescriptorType::SAMPLER,
-			ShaderType::FRAGMENT,
-			3,
-			1,
-			nullptr,
-			&textureImageInfos[0]), // we only need the sampler
-	});
+	},
+		DescriptorSet::GetSetLayouts(m_SharedDescriptorSets));
 	m_DescriptorSet->Create();
-	m_Pipeline = std::make_unique<Pipeline>("assets/shaders/phongLighting.vert.spv",
-		"assets/shaders/phongLighting.frag.spv",
-		m_DescriptorSet->GetPipelineLayout(),
-		m_RenderPass);
+	m_Pipelines = CreateLitPipelines(
+		m_DescriptorSet->GetPipelineLayout(), m_RenderPass, m_GBufferRenderPass, m_CompactVertices);
+
+	// every mesh gets a region of the culled indices that fits its full resolution lod
+	std::vector<uint32_t> regionSizes{};
+	regionSizes.reserve(m_Meshes.size());
+	for (const auto& mesh : m_Meshes)
+		regionSizes.push_back(mesh.GetMaxIndexCount());
+	m_MeshletCulling = std::make_unique<MeshletCulling>(
+		m_Meshlets, m_MeshletIndices, regionSizes, m_HiZDescriptorSet, m_MaxFramesInFlight);
+	m_Meshlets = {};
+	m_MeshletIndices = {};
+	m_MeshletRanges.resize(m_Meshes.size());
 }
 
 void Model::Draw(VkCommandBuffer commandBuffer,
 	const uint64_t currentFrameIndex,
 	const uint32_t dynamicOffsetCount,
-	const uint32_t* dynamicOffset)
+	const uint32_t* dynamicOffset,
+	DrawPass drawPass,
+	CullingPhase phase)
 {
-	m_Pipeline->Bind(commandBuffer);
+	// only the meshlets that the early phase hasn't drawn are left for the late phase
+	if (phase == CullingPhase::LATE && !m_UseMeshletCulling)
+		return;
+
+	m_Pipelines[static_cast<size_t>(drawPass)]->Bind(commandBuffer);
 	m_DescriptorSet->Bind(commandBuffer, currentFrameIndex, dynamicOffsetCount, dynamicOffset);
+	DescriptorSet::BindShared(
+		commandBuffer, m_DescriptorSet->GetPipelineLayout(), m_SharedDescriptorSets, currentFrameIndex);
+
+	bool positionsOnly = drawPass == DrawPass::DEPTH_PREPASS;
+	uint32_t material = std::numeric_limits<uint32_t>::max();
+	for (uint32_t i : m_DrawOrder)
+	{
+		// the depth prepass doesn't sample the materials
+		if (!positionsOnly && m_Meshes[i].GetMaterial() != material)
+		{
+			material = m_Meshes[i].GetMaterial();
+			m_MaterialIndices[material].Push(commandBuffer, m_DescriptorSet->GetPipelineLayout());
+		}
 
+		if (m_UseMeshletCulling)
+			m_Meshes[i].DrawCulled(commandBuffer,
+				m_DescriptorSet->GetPipelineLayout(),
+				*m_MeshletCulling,
+				i,
+				static_cast<uint32_t>(currentFrameIndex),
+				phase,
+				positionsOnly);
+		else
+			m_Meshes[i].Draw(commandBuffer, m_DescriptorSet->GetPipelineLayout(), positionsOnly);
+	}
+}
+
+void Model::DrawPositions(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const
+{
 	for (const auto& mesh : m_Meshes)
-		mesh.Draw(commandBuffer);
+		mesh.Draw(commandBuffer, pipelineLayout, true);
 }
 
 void Model::UpdateUniformBuffers(const UniformBufferObject& ubo,
@@ -140,6 +324,58 @@ void Model::UpdateUniformBuffers(const UniformBufferObject& ubo,
 	m_DynamicUniformBuffers[currentFrameIndex].Map(dUbo.buffer);
 }
 
+void Model::SelectLods(const glm::mat4& modelMat, const LodSelection& selection)
+{
+	bool changed = false;
+	for (auto& mesh : m_Meshes)
+		changed |= mesh.SelectLod(modelMat, selection);
+
+	if (changed)
+		++m_LodVersion;
+}
+
+void Model::UpdateMeshletCulling(const glm::mat4& modelMat, const Camera& camera, const uint32_t currentFrameIndex)
+{
+	if (!m_UseMeshletCulling)
+		return;
+
+	for (size_t i = 0; i < m_Meshes.size(); ++i)
+		m_MeshletRanges[i] = m_Meshes[i].GetMeshletRange();
+	m_MeshletCulling->Update(modelMat, camera, m_MeshletRanges, m_UseOcclusionCulling, currentFrameIndex);
+}
+
+void Model::CullMeshlets(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex, CullingPhase phase)
+{
+	if (m_UseMeshletCulling)
+		m_MeshletCulling->Cull(commandBuffer, currentFrameIndex, phase);
+}
+
+void Model::RequestTextureLevels(const glm::mat4& modelMat, const LodSelection& selection)
+{
+	// the largest scale of the model matrix, the bounding sphere is in object space
+	const float scale = std::sqrt(std::max({ glm::dot(glm::vec3(modelMat[0]), glm::vec3(modelMat[0])),
+		glm::dot(glm::vec3(modelMat[1]), glm::vec3(modelMat[1])),
+		glm::dot(glm::vec3(modelMat[2]), glm::vec3(modelMat[2])) }));
+	const glm::vec3 center{ modelMat * glm::vec4((m_BoundsMin + m_BoundsMax) * 0.5f, 1.0f) };
+	const float radius = glm::length(m_BoundsMax - m_BoundsMin) * 0.5f * scale;
+	const float distance = std::max(glm::length(center - selection.cameraPos) - radius, selection.zNear);
+	// pixels covered by the diameter of the bounding sphere, the textures are assumed to span the model once
+	const float pixels = 2.0f * radius * selection.pixelsPerUnit / distance;
+
+	for (size_t i = 0; i < m_LoadedTextures.size(); ++i)
+	{
+		const Texture2D& texture = *m_LoadedTextures[i];
+		uint32_t level = m_BindlessTextures->GetSampledLevel(m_TextureIndices[i]);
+		if (level == TextureFeedback::NONE)
+		{
+			const float texels = static_cast<float>(std::max(texture.GetWidth(), texture.GetHeight()));
+			level = pixels <= 0.0f ? texture.GetLevelCount()
+								   : static_cast<uint32_t>(std::max(std::floor(std::log2(texels / pixels)), 0.0f)) + 1;
+		}
+		m_TextureStreamer->Request(&texture, level);
+	}
+}
+
 void Model::ProcessNode(aiNode* node, const aiScene* scene)
 {
 	for (uint32_t i = 0; i < node->mNumMeshes; ++i)
@@ -157,9 +393,43 @@ void Model::ProcessNode(aiNode* node, const aiScene* scene)
 Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 {
 	std::vector<Vertex> vertices{};
-	vertices.reserve(static_cast<uint64_t>(mesh->mNumVertices));
 	std::vector<uint32_t> indices{};
-	std::vector<Texture2D> textures{};
+	ConvertMesh(mesh, vertices, indices, m_BoundsMin, m_BoundsMax);
+	// vertex cache, overdraw and vertex fetch order
+	m_OptimizationStats += utils::OptimizeMesh(vertices, indices);
+	// the simplified lods are appended to the indices, the meshes with fewer lods count their coarsest one
+	std::vector<utils::MeshLod> lods = utils::GenerateLods(vertices, indices);
+	for (uint32_t lod = 0; lod < utils::MAX_MESH_LODS; ++lod)
+		m_LodTriangleCounts[lod] += lods[std::min<size_t>(lod, lods.size() - 1)].indexCount / 3;
+
+	// every lod is reordered into its meshlets, the meshlets of the model point into the indices of all its meshes
+	const uint32_t indexBase = static_cast<uint32_t>(m_MeshletIndices.size());
+	std::vector<MeshletRange> meshletRanges{};
+	meshletRanges.reserve(lods.size());
+	for (const auto& lod : lods)
+	{
+		std::vector<utils::Meshlet> meshlets = utils::BuildMeshlets(vertices, indices, lod.firstIndex, lod.indexCount);
+		meshletRanges.push_back({ static_cast<uint32_t>(m_Meshlets.size()),
+			static_cast<uint32_t>(meshlets.size()),
+			lod.indexCount / 3 });
+		for (auto& meshlet : meshlets)
+			meshlet.firstIndex += indexBase;
+		m_Meshlets.insert(m_Meshlets.end(), meshlets.begin(), meshlets.end());
+	}
+	m_MeshletIndices.insert(m_MeshletIndices.end(), indices.begin(), indices.end());
+
+	const uint32_t material = LoadMaterial(scene, mesh->mMaterialIndex);
+	return Mesh{ vertices, indices, lods, meshletRanges, material, m_CompactVertices };
+}
+
+void Model::ConvertMesh(const aiMesh* mesh,
+	std::vector<Vertex>& vertices,
+	std::vector<uint32_t>& indices,
+	glm::vec3& boundsMin,
+	glm::vec3& boundsMax)
+{
+	vertices.reserve(vertices.size() + static_cast<uint64_t>(mesh->mNumVertices));
+	indices.reserve(indices.size() + static_cast<uint64_t>(mesh->mNumFaces) * 3);
 
 	// process vertices
 	for (uint32_t i = 0; i < mesh->mNumVertices; ++i)
@@ -167,6 +437,8 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 		Vertex vertex{};
 		glm::vec3 position{ mesh->mVertices[i].x, mesh->mVertices[i].y, mesh->mVertices[i].z };
 		vertex.pos = position;
+		boundsMin = glm::min(boundsMin, position);
+		boundsMax = glm::max(boundsMax, position);
 
 		if (mesh->HasNormals())
 		{
@@ -190,56 +462,61 @@ Mesh Model::ProcessMesh(aiMesh* mesh, const aiScene* scene)
 	// process indices
 	for (uint32_t i = 0; i < mesh->mNumFaces; ++i)
 	{
-		aiFace face = mesh->mFaces[i];
+		const aiFace& face = mesh->mFaces[i];
 		for (uint32_t j = 0; j < face.mNumIndices; ++j)
 			indices.push_back(face.mIndices[j]);
 	}
+}
 
-	// process materials
-	if (mesh->mMaterialIndex >= 0)
-	{
-		aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-		LoadTextures(material, aiTextureType_DIFFUSE);
-		LoadTextures(material, aiTextureType_SPECULAR);
-	}
-
-	return Mesh{ vertices, indices };
+uint32_t Model::LoadMaterial(const aiScene* scene, uint32_t sceneMaterial)
+{
+	if (m_SceneMaterials[sceneMaterial] != std::numeric_limits<uint32_t>::max())
+		return m_SceneMaterials[sceneMaterial];
+
+	aiMaterial* material = scene->mMaterials[sceneMaterial];
+	Material meshMaterial{};
+	meshMaterial.diffuseTexture = LoadTexture(material, aiTextureType_DIFFUSE);
+	meshMaterial.specularTexture = LoadTexture(material, aiTextureType_SPECULAR);
+	// the materials without a specular exponent keep the default one
+	float shininess = 0.0f;
+	if (material->Get(AI_MATKEY_SHININESS, shininess) == AI_SUCCESS && shininess > 0.0f)
+		meshMaterial.shininess = std::clamp(shininess, 1.0f, MAX_SHININESS);
+	float specularStrength = 0.0f;
+	if (material->Get(AI_MATKEY_SHININESS_STRENGTH, specularStrength) == AI_SUCCESS)
+		meshMaterial.specularStrength = std::max(specularStrength, 0.0f);
+
+	m_SceneMaterials[sceneMaterial] = static_cast<uint32_t>(m_MeshMaterials.size());
+	m_MeshMaterials.push_back(meshMaterial);
+	return m_SceneMaterials[sceneMaterial];
 }
 
-void Model::LoadTextures(aiMaterial* material, aiTextureType type)
+uint32_t Model::LoadTexture(aiMaterial* material, aiTextureType type)
 {
-	uint32_t textureCount = material->GetTextureCount(type);
-	if (textureCount == 0)
+	// the shaders only sample the first texture of every type
+	std::string texturePath{};
+	if (material->GetTextureCount(type) == 0)
 	{
-		// fallback texture if the texture could not be loaded
-		const char* texPath = "assets/textures/checkerboard.png";
-		Logger::Warn(" Fallback texture loaded: \"{}\"", texPath);
-		m_LoadedTextures.push_back(std::make_shared<Texture2D>(texPath));
-		return;
+		// fallback texture if the material has none
+		texturePath = "assets/textures/checkerboard.png";
 	}
-
-	for (uint32_t i = 0; i < textureCount; ++i)
+	else
 	{
 		aiString filename;
-		bool skip = false;
-
-		material->GetTexture(type, i, &filename);
-		std::string texturePath = m_Directory + '/' + filename.C_Str();
-
-		// check if the texture has already been loaded
-		for (const auto& texture : m_LoadedTextures)
-		{
-			if (texturePath == texture->GetPath())
-			{
-				skip = true;
-				break;
-			}
-		}
+		material->GetTexture(type, 0, &filename);
+		texturePath = m_Directory + '/' + filename.C_Str();
+	}
 
-		if (!skip)
-		{
-			m_LoadedTextures.push_back(std::make_shared<Texture2D>(texturePath.c_str()));
-			Logger::Info("    Loaded texture: \"{}\"", texturePath.c_str());
-		}
+	// check if the texture has already been loaded
+	for (size_t i = 0; i < m_LoadedTextures.size(); ++i)
+	{
+		if (texturePath == m_LoadedTextures[i]->GetPath())
+			return static_cast<uint32_t>(i);
 	}
+
+	m_LoadedTextures.push_back(std::make_shared<Texture2D>(texturePath.c_str(), true));
+	if (material->GetTextureCount(type) == 0)
+		Logger::Warn(" Fallback texture loaded: \"{}\"", texturePath);
+	else
+		Logger::Info("    Loaded texture: \"{}\"", texturePath);
+	return static_cast<uint32_t>(m_LoadedTextures.size() - 1);
 }
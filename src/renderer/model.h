@@ -3,6 +3,8 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <array>
+#include <limits>
 #include <vulkan/vulkan.h>
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
@@ -13,22 +15,88 @@
 #include "renderer/uniformBuffer.h"
 #include "renderer/descriptor.h"
 #include "renderer/pipeline.h"
+#include "renderer/camera.h"
+#include "renderer/meshletCulling.h"
+#include "renderer/textureStreamer.h"
+#include "renderer/bindlessTextures.h"
+#include "renderer/materials.h"
 #include "editor/ubo.h"
+#include "utils/meshOptimizer.h"
+#include "utils/meshSimplifier.h"
+#include "utils/meshlets.h"
+
+
+constexpr float LOD_MAX_PIXEL_ERROR = 1.0f; // default of `LodSelection::maxPixelError`
+
+// the lods are picked per frame by their error projected to the screen, see `Mesh::SelectLod()`
+struct LodSelection
+{
+	glm::vec3 cameraPos{ 0.0f };
+	float zNear = 0.1f;
+	// pixels per world space unit at a distance of 1, viewport height / (2 * tan(fovy / 2))
+	float pixelsPerUnit = 0.0f;
+	float maxPixelError = LOD_MAX_PIXEL_ERROR; // 0 only draws the lods without error (the full resolution)
+
+	static LodSelection FromCamera(const Camera& camera, uint32_t viewportHeight, float maxPixelError);
+	// the object space error that is projected to `maxPixelError` pixels at the nearest point of a bounding sphere
+	// (world space center, object space radius), `scale` is the largest scale of the model matrix
+	float GetMaxError(const glm::vec3& center, float radius, float scale) const;
+};
 
 
 class Mesh
 {
 public:
-	Mesh(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+	// `indices` holds the indices of all the `lods` (see `utils::GenerateLods()`), `meshletRanges` has the meshlets
+	// of every lod, `material` is the index of the material in the model
+	// `compactVertices` quantizes the vertices into `CompactVertex`es when the buffers are created
+	Mesh(const std::vector<Vertex>& vertices,
+		const std::vector<uint32_t>& indices,
+		const std::vector<utils::MeshLod>& lods,
+		const std::vector<MeshletRange>& meshletRanges,
+		uint32_t material,
+		bool compactVertices);
 
 	void Init();
-	void Draw(VkCommandBuffer commandBuffer) const;
+	// depth only passes draw with the position only stream, every pass draws the selected lod
+	// pushes the vertex decode of the mesh, `pipelineLayout` has to have its range (see `VertexDecode`)
+	void Draw(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, bool positionsOnly = false) const;
+	// draws the visible meshlets of the selected lod, culled by `meshletCulling` (`meshIndex` is the mesh in it)
+	void DrawCulled(VkCommandBuffer commandBuffer,
+		VkPipelineLayout pipelineLayout,
+		const MeshletCulling& meshletCulling,
+		uint32_t meshIndex,
+		const uint32_t currentFrameIndex,
+		CullingPhase phase,
+		bool positionsOnly = false) const;
+	// selects the coarsest lod whose error, projected to the screen at the distance of the bounding sphere,
+	// is at most `selection.maxPixelError` pixels, returns true if another lod was selected
+	bool SelectLod(const glm::mat4& modelMat, const LodSelection& selection);
+
+	inline uint32_t GetLod() const { return m_Lod; }
+	inline uint32_t GetMaterial() const { return m_Material; }
+	inline const MeshletRange& GetMeshletRange() const { return m_MeshletRanges[m_Lod]; }
+	// of the full resolution lod, the largest one
+	inline uint32_t GetMaxIndexCount() const { return m_Lods[0].indexCount; }
+
+private:
+	void BindVertices(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout, bool positionsOnly) const;
 
 private:
 	std::vector<Vertex> m_Vertices;
 	std::vector<uint32_t> m_Indices;
+	std::vector<utils::MeshLod> m_Lods;
+	std::vector<MeshletRange> m_MeshletRanges;
+	uint32_t m_Lod = 0;
+	uint32_t m_Material;
+	bool m_CompactVertices;
+	VertexDecode m_VertexDecode{};
+	// object space bounding sphere
+	glm::vec3 m_Center{ 0.0f };
+	float m_Radius = 0.0f;
 
 	std::unique_ptr<VertexBuffer> m_VertexBuffer{};
+	std::unique_ptr<VertexBuffer> m_PositionBuffer{};
 	std::unique_ptr<IndexBuffer> m_IndexBuffer{};
 };
 
@@ -37,17 +105,61 @@ class Model
 public:
 	Model(const char* path,
 		VkRenderPass renderPass,
+		VkRenderPass gBufferRenderPass,
+		const std::vector<const DescriptorSet*>& sharedDescriptorSets,
+		const DescriptorSet* hiZDescriptorSet,
+		BindlessTextures* bindlessTextures,
+		Materials* materials,
+		TextureStreamer* textureStreamer,
 		const uint32_t maxFramesInFlight,
 		const uint64_t numInstances,
-		bool flipUVs = false);
+		bool flipUVs = false,
+		bool compactVertices = true);
 
 	void Draw(VkCommandBuffer commandBuffer,
 		const uint64_t currentFrameIndex,
 		const uint32_t dynamicOffsetCount,
-		const uint32_t* dynamicOffset);
+		const uint32_t* dynamicOffset,
+		DrawPass drawPass = DrawPass::FORWARD,
+		CullingPhase phase = CullingPhase::EARLY);
+	// only binds the position streams and draws, the pipeline is bound by the caller, eg: shadow maps
+	// `pipelineLayout` has the vertex decode push constant range, see `VertexDecode`
+	void DrawPositions(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const;
 	void UpdateUniformBuffers(const UniformBufferObject& ubo,
 		const DynamicUniformBufferObject& dUbo,
 		const uint32_t currentFrameIndex);
+	// selects the lods of the meshes for this frame, `modelMat` is the model matrix of the (only) instance
+	void SelectLods(const glm::mat4& modelMat, const LodSelection& selection);
+	// uploads the meshlets of the selected lods and the camera to cull them against, after `SelectLods()`
+	void UpdateMeshletCulling(const glm::mat4& modelMat, const Camera& camera, const uint32_t currentFrameIndex);
+	// records the meshlet culling pass of a phase, has to be called outside of a render pass
+	// the passes of `Draw()` draw the visible meshlets, the shadow maps (`DrawPositions()`) the whole lods
+	// the late phase is only culled and drawn with occlusion culling, everything else is drawn by the early phase
+	void CullMeshlets(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex, CullingPhase phase);
+	// requests the levels of the textures from the streamer: the finest levels they were sampled at the last time the
+	// frame was drawn (see `BindlessTextures::ReadFeedback()`), or one level coarser than the size of the model on the
+	// screen needs if they weren't sampled (eg: outside of the view)
+	void RequestTextureLevels(const glm::mat4& modelMat, const LodSelection& selection);
+
+	// object space bounding box of all the meshes
+	inline glm::vec3 GetBoundsMin() const { return m_BoundsMin; }
+	inline glm::vec3 GetBoundsMax() const { return m_BoundsMax; }
+	inline bool HasCompactVertices() const { return m_CompactVertices; }
+	// incremented when the lod of a mesh changes, eg: for the cached shadow maps
+	inline uint64_t GetLodVersion() const { return m_LodVersion; }
+	inline void SetMeshletCulling(bool enable) { m_UseMeshletCulling = enable; }
+	// tests the meshlets against the hi-z pyramid, in two phases, see `MeshletCulling`
+	inline void SetOcclusionCulling(bool enable) { m_UseOcclusionCulling = enable; }
+	inline const MeshletCullingStats& GetMeshletCullingStats() const { return m_MeshletCulling->GetStats(); }
+	inline uint32_t GetMaterialCount() const { return static_cast<uint32_t>(m_MeshMaterials.size()); }
+
+	// converts the vertices and the faces of an assimp mesh, grows the bounding box
+	// doesn't touch the gpu, the textures are loaded by `ProcessMesh()`
+	static void ConvertMesh(const aiMesh* mesh,
+		std::vector<Vertex>& vertices,
+		std::vector<uint32_t>& indices,
+		glm::vec3& boundsMin,
+		glm::vec3& boundsMax);
 
 private:
 	void LoadModel(const std::string& path, bool flipUVs);
@@ -55,20 +167,51 @@ private:
 
 	void ProcessNode(aiNode* node, const aiScene* scene);
 	Mesh ProcessMesh(aiMesh* mesh, const aiScene* scene);
-	void LoadTextures(aiMaterial* material, aiTextureType type);
+	// returns the index of the material in the model, the materials shared by meshes are only loaded once
+	uint32_t LoadMaterial(const aiScene* scene, uint32_t sceneMaterial);
+	// returns the index of the first texture of `type` in `m_LoadedTextures` (or of its fallback)
+	uint32_t LoadTexture(aiMaterial* material, aiTextureType type);
 
 private:
 	VkRenderPass m_RenderPass;
+	VkRenderPass m_GBufferRenderPass;
+	// scene wide data (lighting, shadows), bound as set 1, 2, ...
+	std::vector<const DescriptorSet*> m_SharedDescriptorSets;
+	const DescriptorSet* m_HiZDescriptorSet;
+	BindlessTextures* m_BindlessTextures;
+	Materials* m_Materials;
+	TextureStreamer* m_TextureStreamer;
 	const uint32_t m_MaxFramesInFlight;
 	const uint64_t m_NumInstances;
+	const bool m_CompactVertices;
 
 	std::string m_Directory;
 	std::vector<Mesh> m_Meshes;
+	glm::vec3 m_BoundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 m_BoundsMax{ std::numeric_limits<float>::lowest() };
 	std::vector<std::shared_ptr<Texture2D>> m_LoadedTextures{};
+	std::vector<uint32_t> m_TextureIndices{}; // of the textures in the bindless array
+	// the texture indices point into `m_LoadedTextures`, the materials in the material buffer point into the
+	// bindless array
+	std::vector<Material> m_MeshMaterials{};
+	std::vector<MaterialIndex> m_MaterialIndices{}; // of the mesh materials in the material buffer
+	std::vector<uint32_t> m_SceneMaterials{}; // the mesh material of every assimp material, only kept while loading
+	std::vector<uint32_t> m_DrawOrder{}; // of the meshes, sorted by their material
+	utils::MeshOptimizationStats m_OptimizationStats{}; // of all the meshes
+	std::array<uint64_t, utils::MAX_MESH_LODS> m_LodTriangleCounts{}; // of all the meshes, per lod
+	uint64_t m_LodVersion = 0;
+
+	// the meshlets of all the meshes and lods and the indices they point into, only kept until they are uploaded
+	std::vector<utils::Meshlet> m_Meshlets{};
+	std::vector<uint32_t> m_MeshletIndices{};
+	std::vector<MeshletRange> m_MeshletRanges{}; // of the selected lods
+	std::unique_ptr<MeshletCulling> m_MeshletCulling{};
+	bool m_UseMeshletCulling = true;
+	bool m_UseOcclusionCulling = false;
 
 	uint64_t m_DUboAlignmentSize = 0;
 	std::vector<UniformBuffer> m_UniformBuffers{};
 	std::vector<UniformBuffer> m_DynamicUniformBuffers{};
 	std::unique_ptr<DescriptorSet> m_DescriptorSet{};
-	std::unique_ptr<Pipeline> m_Pipeline{};
+	DrawPassPipelines m_Pipelines{};
 };
\ No newline at end of file
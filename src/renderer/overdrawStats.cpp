@@ -0,0 +1,87 @@
+#include "renderer/overdrawStats.h"
+
+#include <array>
+#include "core/core.h"
+#include "renderer/device.h"
+
+
+OverdrawStats::OverdrawStats(const uint32_t maxFramesInFlight)
+	: m_Pending(maxFramesInFlight * OVERDRAW_MAX_PASSES, false)
+{
+	if (!Device::GetEnabledFeatures().pipelineStatisticsQuery)
+	{
+		Logger::Warn("Pipeline statistics queries are not supported, overdraw statistics are disabled");
+		return;
+	}
+
+	// one query for each pass of each frame in flight
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+	queryPoolInfo.queryCount = maxFramesInFlight * OVERDRAW_MAX_PASSES;
+	queryPoolInfo.pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+	THROW(vkCreateQueryPool(Device::GetDevice(), &queryPoolInfo, nullptr, &m_QueryPool) != VK_SUCCESS,
+		"Failed to create query pool!")
+}
+
+OverdrawStats::~OverdrawStats()
+{
+	vkDestroyQueryPool(Device::GetDevice(), m_QueryPool, nullptr);
+}
+
+void OverdrawStats::Reset(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex)
+{
+	if (!IsSupported())
+		return;
+
+	const uint32_t firstQuery = currentFrameIndex * OVERDRAW_MAX_PASSES;
+	uint64_t invocations = 0;
+	bool available = false;
+	for (uint32_t query = firstQuery; query < firstQuery + OVERDRAW_MAX_PASSES; ++query)
+	{
+		if (!m_Pending[query])
+			continue;
+
+		// [0] = fragment shader invocations, [1] = availability
+		std::array<uint64_t, 2> result{};
+		VkResult status = vkGetQueryPoolResults(Device::GetDevice(),
+			m_QueryPool,
+			query,
+			1,
+			sizeof(result),
+			result.data(),
+			sizeof(result),
+			VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+		if (status == VK_SUCCESS && result[1] != 0)
+		{
+			invocations += result[0];
+			available = true;
+		}
+		m_Pending[query] = false;
+	}
+
+	if (available)
+		m_FragmentInvocations = invocations;
+
+	vkCmdResetQueryPool(commandBuffer, m_QueryPool, firstQuery, OVERDRAW_MAX_PASSES);
+}
+
+void OverdrawStats::Begin(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex, uint32_t pass)
+{
+	if (!IsSupported())
+		return;
+
+	vkCmdBeginQuery(commandBuffer, m_QueryPool, currentFrameIndex * OVERDRAW_MAX_PASSES + pass, 0);
+}
+
+void OverdrawStats::End(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex, uint32_t pass)
+{
+	if (!IsSupported())
+		return;
+
+	const uint32_t query = currentFrameIndex * OVERDRAW_MAX_PASSES + pass;
+	vkCmdEndQuery(commandBuffer, m_QueryPool, query);
+	m_Pending[query] = true;
+}
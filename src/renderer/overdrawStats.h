@@ -0,0 +1,39 @@
+#pragma once
+
+#include <vector>
+#include <vulkan/vulkan.h>
+
+
+// a query can't span render passes, a frame can draw the scene in this many render passes
+constexpr uint32_t OVERDRAW_MAX_PASSES = 2;
+
+// counts the fragment shader invocations of the scene draws with a pipeline statistics query
+// overdraw = invocations / pixels, 1.0 means that every pixel has been shaded exactly once
+// (with sample shading a pixel can be shaded more than once even without any overdraw)
+// needs the `pipelineStatisticsQuery` device feature, nothing is recorded without it
+class OverdrawStats
+{
+public:
+	OverdrawStats(const uint32_t maxFramesInFlight);
+	~OverdrawStats();
+
+	// reads the results of the frame's previous use, so the frame's fence has to be waited on before
+	// and resets the queries, has to be recorded outside of a render pass
+	void Reset(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex);
+	// `pass` < `OVERDRAW_MAX_PASSES`, the invocations of every pass of the frame are summed
+	void Begin(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex, uint32_t pass = 0);
+	void End(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex, uint32_t pass = 0);
+
+	inline bool IsSupported() const { return m_QueryPool != VK_NULL_HANDLE; }
+	inline uint64_t GetFragmentInvocations() const { return m_FragmentInvocations; }
+	inline float GetOverdraw(uint32_t width, uint32_t height) const
+	{
+		return static_cast<float>(m_FragmentInvocations) / static_cast<float>(width * height);
+	}
+
+private:
+	VkQueryPool m_QueryPool{};
+	// queries that have been written and not read yet
+	std::vector<bool> m_Pending{};
+	uint64_t m_FragmentInvocations = 0;
+};
@@ -1,18 +1,66 @@
 #include "renderer/pipeline.h"
 
 #include <array>
+#include <vector>
+#include <memory>
 #include "core/core.h"
 #include "renderer/device.h"
 #include "renderer/shader.h"
 #include "renderer/vertexBuffer.h"
+#include "renderer/gBuffer.h"
 
 
+struct VertexInputDescription
+{
+	std::vector<VkVertexInputBindingDescription> bindings{};
+	std::vector<VkVertexInputAttributeDescription> attributes{};
+};
+
+static VertexInputDescription GetVertexInputDescription(VertexLayout vertexLayout)
+{
+	VertexInputDescription description{};
+	switch (vertexLayout)
+	{
+	case VertexLayout::NONE:
+		break;
+
+	case VertexLayout::POSITION:
+		description.bindings = { Vertex::GetPositionBindingDescription() };
+		description.attributes = { Vertex::GetPositionAttributeDescription() };
+		break;
+
+	case VertexLayout::VERTEX:
+	{
+		auto attributes = Vertex::GetAttributeDescription();
+		description.bindings = { Vertex::GetBindingDescription() };
+		description.attributes.assign(attributes.begin(), attributes.end());
+		break;
+	}
+
+	case VertexLayout::COMPACT_POSITION:
+		description.bindings = { CompactVertex::GetPositionBindingDescription() };
+		description.attributes = { CompactVertex::GetPositionAttributeDescription() };
+		break;
+
+	case VertexLayout::COMPACT:
+	{
+		auto attributes = CompactVertex::GetAttributeDescription();
+		description.bindings = { CompactVertex::GetBindingDescription() };
+		description.attributes.assign(attributes.begin(), attributes.end());
+		break;
+	}
+	}
+
+	return description;
+}
+
 Pipeline::Pipeline(const char* vertShaderPath,
 	const char* fragShaderPath,
 	VkPipelineLayout pipelineLayout,
-	VkRenderPass renderPass)
+	VkRenderPass renderPass,
+	const PipelineConfig& config)
 {
-	Init(vertShaderPath, fragShaderPath, pipelineLayout, renderPass);
+	Init(vertShaderPath, fragShaderPath, pipelineLayout, renderPass, config);
 }
 
 Pipeline::~Pipeline()
@@ -23,25 +71,30 @@ Pipeline::~Pipeline()
 void Pipeline::Init(const char* vertShaderPath,
 	const char* fragShaderPath,
 	VkPipelineLayout pipelineLayout,
-	VkRenderPass renderPass)
+	VkRenderPass renderPass,
+	const PipelineConfig& config)
 {
 	// shader stages
 	Shader vertexShader{ vertShaderPath, ShaderType::VERTEX };
-	Shader fragmentShader{ fragShaderPath, ShaderType::FRAGMENT };
-	std::array<VkPipelineShaderStageCreateInfo, 2> shaderStages{ vertexShader.GetShaderStage(),
-		fragmentShader.GetShaderStage() };
+	std::vector<VkPipelineShaderStageCreateInfo> shaderStages{ vertexShader.GetShaderStage() };
+	// depth only pipelines have no fragment shader
+	std::unique_ptr<Shader> fragmentShader{};
+	if (fragShaderPath != nullptr)
+	{
+		fragmentShader = std::make_unique<Shader>(fragShaderPath, ShaderType::FRAGMENT);
+		shaderStages.push_back(fragmentShader->GetShaderStage());
+	}
 
 	// fixed functions
 	// vertex input
-	auto vertexBindingDesc = Vertex::GetBindingDescription();
-	auto vertexAttrDesc = Vertex::GetAttributeDescription();
+	VertexInputDescription vertexInput = GetVertexInputDescription(config.vertexLayout);
 
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-	vertexInputInfo.vertexBindingDescriptionCount = 1;
-	vertexInputInfo.pVertexBindingDescriptions = &vertexBindingDesc;
-	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexAttrDesc.size());
-	vertexInputInfo.pVertexAttributeDescriptions = vertexAttrDesc.data();
+	vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(vertexInput.bindings.size());
+	vertexInputInfo.pVertexBindingDescriptions = vertexInput.bindings.data();
+	vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(vertexInput.attributes.size());
+	vertexInputInfo.pVertexAttributeDescriptions = vertexInput.attributes.data();
 
 	// input assembly
 	VkPipelineInputAssemblyStateCreateInfo inputAssemblyInfo{};
@@ -62,21 +115,21 @@ void Pipeline::Init(const char* vertShaderPath,
 	rasterizationStateInfo.rasterizerDiscardEnable = VK_FALSE;
 	rasterizationStateInfo.polygonMode = VK_POLYGON_MODE_FILL;
 	rasterizationStateInfo.lineWidth = 1.0f;
-	rasterizationStateInfo.cullMode = VK_CULL_MODE_BACK_BIT;
+	rasterizationStateInfo.cullMode = config.cullMode;
 	// we specify counter clockwise because in the projection matrix we flipped the y-coord
 	rasterizationStateInfo.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
 	// the depth value can be altered by adding a constant value based on fragment slope
-	rasterizationStateInfo.depthBiasEnable = VK_FALSE;
-	rasterizationStateInfo.depthBiasConstantFactor = 0.0f;
+	rasterizationStateInfo.depthBiasEnable =
+		config.depthBiasConstant != 0.0f || config.depthBiasSlope != 0.0f ? VK_TRUE : VK_FALSE;
+	rasterizationStateInfo.depthBiasConstantFactor = config.depthBiasConstant;
 	rasterizationStateInfo.depthBiasClamp = 0.0f;
-	rasterizationStateInfo.depthBiasSlopeFactor = 0.0f;
+	rasterizationStateInfo.depthBiasSlopeFactor = config.depthBiasSlope;
 
 	// multisampling
 	VkPipelineMultisampleStateCreateInfo multisampleStateInfo{};
 	multisampleStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO;
-	multisampleStateInfo.sampleShadingEnable = VK_FALSE;
-	multisampleStateInfo.rasterizationSamples = Device::GetMSAASamplesCount();
-	multisampleStateInfo.sampleShadingEnable = VK_TRUE;
+	multisampleStateInfo.rasterizationSamples = config.msaa ? Device::GetMSAASamplesCount() : VK_SAMPLE_COUNT_1_BIT;
+	multisampleStateInfo.sampleShadingEnable = config.msaa && config.sampleShading ? VK_TRUE : VK_FALSE;
 	multisampleStateInfo.minSampleShading = 0.2f; // min fraction for sample shading; closer to 1 is smoother
 	multisampleStateInfo.pSampleMask = nullptr;
 	multisampleStateInfo.alphaToCoverageEnable = VK_FALSE;
@@ -86,8 +139,9 @@ void Pipeline::Init(const char* vertShaderPath,
 	VkPipelineDepthStencilStateCreateInfo depthStencilStateInfo{};
 	depthStencilStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO;
 	depthStencilStateInfo.depthTestEnable = VK_TRUE;
-	depthStencilStateInfo.depthWriteEnable = VK_TRUE;
-	depthStencilStateInfo.depthCompareOp = VK_COMPARE_OP_LESS;
+	depthStencilStateInfo.depthWriteEnable = config.depthWrite ? VK_TRUE : VK_FALSE;
+	depthStencilStateInfo.depthCompareOp =
+		config.cameraDepth ? Device::GetDepthCompareOp(config.depthCompareOp) : config.depthCompareOp;
 	depthStencilStateInfo.depthBoundsTestEnable = VK_FALSE;
 	depthStencilStateInfo.minDepthBounds = 0.0f;
 	depthStencilStateInfo.maxDepthBounds = 1.0f;
@@ -98,17 +152,20 @@ void Pipeline::Init(const char* vertShaderPath,
 	// color blending
 	// configuration per color attachment
 	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-	colorBlendAttachment.colorWriteMask =
+	VkColorComponentFlags colorWriteMask =
 		VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+	colorBlendAttachment.colorWriteMask = config.colorWrite ? colorWriteMask : 0;
 	colorBlendAttachment.blendEnable = VK_FALSE;
+	std::vector<VkPipelineColorBlendAttachmentState> colorBlendAttachments(config.colorAttachmentCount,
+		colorBlendAttachment);
 
 	// configuration for global color blending settings
 	VkPipelineColorBlendStateCreateInfo colorBlendStateInfo{};
 	colorBlendStateInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
 	colorBlendStateInfo.logicOpEnable = VK_FALSE;
 	colorBlendStateInfo.logicOp = VK_LOGIC_OP_COPY;
-	colorBlendStateInfo.attachmentCount = 1;
-	colorBlendStateInfo.pAttachments = &colorBlendAttachment;
+	colorBlendStateInfo.attachmentCount = static_cast<uint32_t>(colorBlendAttachments.size());
+	colorBlendStateInfo.pAttachments = colorBlendAttachments.data();
 	colorBlendStateInfo.blendConstants[0] = 0.0f;
 	colorBlendStateInfo.blendConstants[1] = 0.0f;
 	colorBlendStateInfo.blendConstants[2] = 0.0f;
@@ -150,4 +207,55 @@ void Pipeline::Init(const char* vertShaderPath,
 void Pipeline::Cleanup()
 {
 	vkDestroyPipeline(Device::GetDevice(), m_Pipeline, nullptr);
-}
\ No newline at end of file
+}
+
+DrawPassPipelines CreateLitPipelines(VkPipelineLayout pipelineLayout,
+	VkRenderPass renderPass,
+	VkRenderPass gBufferRenderPass,
+	bool compactVertices)
+{
+	DrawPassPipelines pipelines{};
+	const VertexLayout vertexLayout = compactVertices ? VertexLayout::COMPACT : VertexLayout::VERTEX;
+
+	PipelineConfig forwardConfig{};
+	forwardConfig.vertexLayout = vertexLayout;
+	pipelines[static_cast<size_t>(DrawPass::FORWARD)] =
+		std::make_unique<Pipeline>("assets/shaders/phongLighting.vert.spv",
+			"assets/shaders/phongLighting.frag.spv",
+			pipelineLayout,
+			renderPass,
+			forwardConfig);
+
+	// only the positions are read, and nothing but the depth is written
+	PipelineConfig depthPrepassConfig{};
+	depthPrepassConfig.vertexLayout = compactVertices ? VertexLayout::COMPACT_POSITION : VertexLayout::POSITION;
+	depthPrepassConfig.sampleShading = false;
+	depthPrepassConfig.colorWrite = false;
+	pipelines[static_cast<size_t>(DrawPass::DEPTH_PREPASS)] = std::make_unique<Pipeline>(
+		"assets/shaders/depthPrepass.vert.spv", nullptr, pipelineLayout, renderPass, depthPrepassConfig);
+
+	// the depth buffer is already complete, only the visible fragments pass
+	PipelineConfig forwardEqualConfig{};
+	forwardEqualConfig.vertexLayout = vertexLayout;
+	forwardEqualConfig.depthWrite = false;
+	forwardEqualConfig.depthCompareOp = VK_COMPARE_OP_EQUAL;
+	pipelines[static_cast<size_t>(DrawPass::FORWARD_EQUAL)] =
+		std::make_unique<Pipeline>("assets/shaders/phongLighting.vert.spv",
+			"assets/shaders/phongLighting.frag.spv",
+			pipelineLayout,
+			renderPass,
+			forwardEqualConfig);
+
+	PipelineConfig gBufferConfig{};
+	gBufferConfig.vertexLayout = vertexLayout;
+	gBufferConfig.msaa = false;
+	gBufferConfig.colorAttachmentCount = GBUFFER_COLOR_ATTACHMENT_COUNT;
+	pipelines[static_cast<size_t>(DrawPass::GBUFFER)] =
+		std::make_unique<Pipeline>("assets/shaders/phongLighting.vert.spv",
+			"assets/shaders/gBuffer.frag.spv",
+			pipelineLayout,
+			gBufferRenderPass,
+			gBufferConfig);
+
+	return pipelines;
+}
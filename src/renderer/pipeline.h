@@ -1,14 +1,55 @@
 #pragma once
 
+#include <array>
+#include <memory>
 #include <vulkan/vulkan.h>
 
+
+// pass that an object is drawn in, selects the pipeline of the object
+enum class DrawPass
+{
+	FORWARD,
+	DEPTH_PREPASS, // depth only
+	FORWARD_EQUAL, // forward shading after the depth pre-pass
+	GBUFFER,
+};
+constexpr size_t DRAW_PASS_COUNT = 4;
+
+enum class VertexLayout
+{
+	NONE, // fullscreen passes generate their vertices in the vertex shader
+	POSITION, // position only stream, see `Vertex::GetPositionBindingDescription()`
+	VERTEX,
+	COMPACT_POSITION, // see `CompactVertex::GetPositionBindingDescription()`
+	COMPACT, // see `CompactVertex`
+};
+
+// fixed function state that differs between the pipelines
+// the defaults are the forward shading pipeline
+struct PipelineConfig
+{
+	VertexLayout vertexLayout = VertexLayout::VERTEX;
+	VkCullModeFlags cullMode = VK_CULL_MODE_BACK_BIT;
+	bool msaa = true; // use the msaa sample count of the device
+	bool sampleShading = true;
+	bool depthWrite = true;
+	VkCompareOp depthCompareOp = VK_COMPARE_OP_LESS; // flipped for reverse-z, see `Device::GetDepthCompareOp()`
+	bool cameraDepth = true; // false for passes with their own (standard) depth range, eg: shadow maps
+	float depthBiasConstant = 0.0f; // depth bias is enabled if either factor is non-zero
+	float depthBiasSlope = 0.0f;
+	uint32_t colorAttachmentCount = 1;
+	bool colorWrite = true;
+};
+
 class Pipeline
 {
 public:
+	// `fragShaderPath` can be null for depth only pipelines
 	Pipeline(const char* vertShaderPath,
 		const char* fragShaderPath,
 		VkPipelineLayout pipelineLayout,
-		VkRenderPass renderPass);
+		VkRenderPass renderPass,
+		const PipelineConfig& config = {});
 	~Pipeline();
 
 	inline void Bind(VkCommandBuffer commandBuffer)
@@ -22,9 +63,18 @@ private:
 	void Init(const char* vertShaderPath,
 		const char* fragShaderPath,
 		VkPipelineLayout pipelineLayout,
-		VkRenderPass renderPass);
+		VkRenderPass renderPass,
+		const PipelineConfig& config);
 	void Cleanup();
 
 private:
 	VkPipeline m_Pipeline{};
-};
\ No newline at end of file
+};
+
+// the pipelines of a lit object (phong shaded, with the scene lighting as set 1), one for each `DrawPass`
+// `compactVertices` selects the `COMPACT` layouts instead of the full precision ones
+using DrawPassPipelines = std::array<std::unique_ptr<Pipeline>, DRAW_PASS_COUNT>;
+DrawPassPipelines CreateLitPipelines(VkPipelineLayout pipelineLayout,
+	VkRenderPass renderPass,
+	VkRenderPass gBufferRenderPass,
+	bool compactVertices = false);
@@ -0,0 +1,746 @@
+#include "renderer/renderGraph.h"
+
+#include <algorithm>
+#include <optional>
+#include "imgui/imgui.h"
+#include "core/core.h"
+#include "core/profiler.h"
+#include "renderer/device.h"
+#include "utils/utils.h"
+
+
+constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+
+// the synchronization scope of an access
+struct AccessInfo
+{
+	VkPipelineStageFlags stages;
+	VkAccessFlags readAccess;
+	VkAccessFlags writeAccess;
+	VkImageLayout layout;
+	VkImageUsageFlags usage;
+};
+
+static bool IsDepthFormat(VkFormat format)
+{
+	return format == VK_FORMAT_D16_UNORM || format == VK_FORMAT_X8_D24_UNORM_PACK32 || format == VK_FORMAT_D32_SFLOAT
+		   || format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT
+		   || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+static bool HasStencil(VkFormat format)
+{
+	return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT
+		   || format == VK_FORMAT_D32_SFLOAT_S8_UINT;
+}
+
+// of the barriers, the views only have the depth aspect (they are sampled)
+static VkImageAspectFlags GetAspect(VkFormat format)
+{
+	if (!IsDepthFormat(format))
+		return VK_IMAGE_ASPECT_COLOR_BIT;
+
+	return HasStencil(format) ? VK_IMAGE_ASPECT_DEPTH_BIT | VK_IMAGE_ASPECT_STENCIL_BIT : VK_IMAGE_ASPECT_DEPTH_BIT;
+}
+
+static AccessInfo GetAccessInfo(RenderGraphAccess access, VkFormat format)
+{
+	// the sampled depth stays in a depth layout (eg: the depth of the hi-z buffer)
+	const VkImageLayout sampledLayout = IsDepthFormat(format) ? VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL
+															  : VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	switch (access)
+	{
+	case RenderGraphAccess::COLOR_ATTACHMENT:
+		return { VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_READ_BIT,
+			VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT };
+	case RenderGraphAccess::DEPTH_ATTACHMENT:
+		return { VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+			VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+			VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT };
+	case RenderGraphAccess::SAMPLED_FRAGMENT:
+		return { VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			0,
+			sampledLayout,
+			VK_IMAGE_USAGE_SAMPLED_BIT };
+	case RenderGraphAccess::SAMPLED_COMPUTE:
+		return { VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT,
+			VK_ACCESS_SHADER_READ_BIT,
+			0,
+			sampledLayout,
+			VK_IMAGE_USAGE_SAMPLED_BIT };
+	case RenderGraphAccess::TRANSFER_SRC:
+		return { VK_PIPELINE_STAGE_TRANSFER_BIT,
+			VK_ACCESS_TRANSFER_READ_BIT,
+			0,
+			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			VK_IMAGE_USAGE_TRANSFER_SRC_BIT };
+	case RenderGraphAccess::PRESENT:
+		// the semaphore of the present makes the writes available
+		return { VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, 0 };
+	}
+
+	LOG_AND_THROW("Unknown render graph access!")
+}
+
+static bool IsAttachment(RenderGraphAccess access)
+{
+	return access == RenderGraphAccess::COLOR_ATTACHMENT || access == RenderGraphAccess::DEPTH_ATTACHMENT;
+}
+
+
+bool RenderGraphImageDesc::operator==(const RenderGraphImageDesc& other) const
+{
+	return format == other.format && width == other.width && height == other.height && samples == other.samples;
+}
+
+RenderGraphPass::RenderGraphPass(const std::string& name)
+	: m_Name{ name }
+{
+}
+
+void RenderGraphPass::SetRenderPass(VkRenderPass renderPass, const std::vector<VkClearValue>& clearValues)
+{
+	m_RenderPass = renderPass;
+	m_ClearValues = clearValues;
+}
+
+void RenderGraphPass::Read(RenderGraphResource resource, RenderGraphAccess access)
+{
+	AddUse(resource, access, true, false);
+}
+
+void RenderGraphPass::Write(RenderGraphResource resource, RenderGraphAccess access)
+{
+	AddUse(resource, access, false, true);
+}
+
+void RenderGraphPass::ReadWrite(RenderGraphResource resource, RenderGraphAccess access)
+{
+	AddUse(resource, access, true, true);
+}
+
+void RenderGraphPass::SetSideEffects()
+{
+	m_SideEffects = true;
+}
+
+void RenderGraphPass::SetExecute(const std::function<void(VkCommandBuffer)>& execute)
+{
+	m_Execute = execute;
+}
+
+bool RenderGraphPass::Use::operator==(const Use& other) const
+{
+	return resource == other.resource && access == other.access && read == other.read && write == other.write;
+}
+
+void RenderGraphPass::AddUse(RenderGraphResource resource, RenderGraphAccess access, bool read, bool write)
+{
+	// an image can only be in one layout during a pass
+	for (const auto& use : m_Uses)
+		THROW(use.resource == resource, "Render graph pass '{}' uses an image twice!", m_Name)
+
+	m_Uses.push_back({ resource, access, read, write });
+}
+
+
+bool RenderGraph::Resource::operator==(const Resource& other) const
+{
+	return name == other.name && desc == other.desc && imported == other.imported && waitStages == other.waitStages
+		   && finalAccess == other.finalAccess;
+}
+
+RenderGraph::~RenderGraph()
+{
+	DestroyFramebuffers();
+	DestroyTransientImages();
+}
+
+void RenderGraph::Reset()
+{
+	m_Resources.clear();
+	m_Passes.clear();
+}
+
+RenderGraphResource RenderGraph::CreateImage(const std::string& name, const RenderGraphImageDesc& desc)
+{
+	m_Resources.push_back({ name, desc, false, 0, RenderGraphAccess::PRESENT, VK_NULL_HANDLE, VK_NULL_HANDLE });
+	return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+}
+
+RenderGraphResource RenderGraph::ImportImage(const std::string& name,
+	VkImage image,
+	VkImageView imageView,
+	const RenderGraphImageDesc& desc,
+	VkPipelineStageFlags waitStages,
+	RenderGraphAccess finalAccess)
+{
+	m_Resources.push_back({ name, desc, true, waitStages, finalAccess, image, imageView });
+	return static_cast<RenderGraphResource>(m_Resources.size() - 1);
+}
+
+RenderGraphPass& RenderGraph::AddPass(const std::string& name)
+{
+	return m_Passes.emplace_back(name);
+}
+
+bool RenderGraph::Compile()
+{
+	bool unchanged = m_Compiled && m_Resources == m_CompiledResources && m_Passes.size() == m_CompiledPassNames.size();
+	for (size_t i = 0; unchanged && i < m_Passes.size(); ++i)
+	{
+		const RenderGraphPass& pass = m_Passes[i];
+		unchanged = pass.m_Name == m_CompiledPassNames[i] && pass.m_Uses == m_CompiledUses[i]
+					&& pass.m_RenderPass == m_CompiledRenderPasses[i] && pass.m_SideEffects == m_CompiledSideEffects[i];
+	}
+	if (unchanged)
+		return false;
+
+	PROFILE_FUNCTION();
+	// the transient images may be in use by the pending frames
+	Device::WaitIdle();
+	DestroyFramebuffers();
+	DestroyTransientImages();
+
+	m_CompiledResources = m_Resources;
+	m_CompiledPassNames.clear();
+	m_CompiledUses.clear();
+	m_CompiledRenderPasses.clear();
+	m_CompiledSideEffects.clear();
+	for (const auto& pass : m_Passes)
+	{
+		m_CompiledPassNames.push_back(pass.m_Name);
+		m_CompiledUses.push_back(pass.m_Uses);
+		m_CompiledRenderPasses.push_back(pass.m_RenderPass);
+		m_CompiledSideEffects.push_back(pass.m_SideEffects);
+	}
+
+	m_CulledPasses.assign(m_Passes.size(), false);
+	Cull(m_CulledPasses);
+
+	m_CompiledPasses.clear();
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_Passes.size()); ++i)
+	{
+		if (!m_CulledPasses[i])
+			m_CompiledPasses.push_back({ i });
+	}
+
+	// the lifetimes of the transient images, in the compiled passes
+	m_TransientImages.assign(m_Resources.size(), {});
+	std::vector<bool> usedImages(m_Resources.size(), false);
+	for (uint32_t i = 0; i < static_cast<uint32_t>(m_CompiledPasses.size()); ++i)
+	{
+		const RenderGraphPass& pass = m_Passes[m_CompiledPasses[i].pass];
+		for (const auto& use : pass.m_Uses)
+		{
+			THROW(use.resource >= m_Resources.size(), "Render graph pass '{}' uses an unknown image!", pass.m_Name)
+			if (m_Resources[use.resource].imported)
+				continue;
+
+			TransientImage& image = m_TransientImages[use.resource];
+			if (!usedImages[use.resource])
+			{
+				// the contents of the transient images don't survive the frame
+				THROW(use.read,
+					"Render graph pass '{}' reads '{}' before it is written!",
+					pass.m_Name,
+					m_Resources[use.resource].name)
+				usedImages[use.resource] = true;
+				image.firstPass = i;
+			}
+
+			image.lastPass = i;
+		}
+	}
+
+	CreateTransientImages(usedImages);
+	AliasMemory();
+	PlaceBarriers();
+
+	m_Stats = {};
+	m_Stats.passCount = static_cast<uint32_t>(m_Passes.size());
+	m_Stats.culledPassCount = static_cast<uint32_t>(m_Passes.size() - m_CompiledPasses.size());
+	m_Stats.barrierCount = static_cast<uint32_t>(m_FinalBarriers.size());
+	for (const auto& compiledPass : m_CompiledPasses)
+		m_Stats.barrierCount += static_cast<uint32_t>(compiledPass.barriers.size());
+	for (const auto& image : m_TransientImages)
+	{
+		if (image.image == VK_NULL_HANDLE)
+			continue;
+
+		++m_Stats.transientImageCount;
+		m_Stats.unaliasedBytes += image.memoryRequirements.size;
+	}
+	for (const auto& block : m_MemoryBlocks)
+		m_Stats.transientBytes += block.size;
+
+	m_Compiled = true;
+	Logger::Info("Render graph: {} passes ({} culled), {} barriers, {} transient images in {:.2f} MB ({:.2f} MB saved "
+				 "by aliasing)",
+		m_Stats.passCount,
+		m_Stats.culledPassCount,
+		m_Stats.barrierCount,
+		m_Stats.transientImageCount,
+		static_cast<double>(m_Stats.transientBytes) / BYTES_PER_MB,
+		static_cast<double>(m_Stats.unaliasedBytes - m_Stats.transientBytes) / BYTES_PER_MB);
+	return true;
+}
+
+void RenderGraph::Execute(VkCommandBuffer commandBuffer)
+{
+	THROW(!m_Compiled, "The render graph has to be compiled before it is executed!")
+
+	for (const auto& compiledPass : m_CompiledPasses)
+	{
+		const RenderGraphPass& pass = m_Passes[compiledPass.pass];
+		RecordBarriers(commandBuffer, compiledPass.barriers);
+
+		if (pass.m_RenderPass == VK_NULL_HANDLE)
+		{
+			if (pass.m_Execute)
+				pass.m_Execute(commandBuffer);
+			continue;
+		}
+
+		VkExtent2D extent{};
+		const VkFramebuffer framebuffer = GetFramebuffer(pass, extent);
+
+		VkViewport viewport{};
+		viewport.x = 0.0f;
+		viewport.y = 0.0f;
+		viewport.width = static_cast<float>(extent.width);
+		viewport.height = static_cast<float>(extent.height);
+		viewport.minDepth = 0.0f;
+		viewport.maxDepth = 1.0f;
+		vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+		VkRect2D scissor{};
+		scissor.offset = { 0, 0 };
+		scissor.extent = extent;
+		vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+		VkRenderPassBeginInfo renderPassBeginInfo{};
+		renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+		renderPassBeginInfo.renderPass = pass.m_RenderPass;
+		renderPassBeginInfo.framebuffer = framebuffer;
+		renderPassBeginInfo.renderArea.offset = { 0, 0 };
+		renderPassBeginInfo.renderArea.extent = extent;
+		renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(pass.m_ClearValues.size());
+		renderPassBeginInfo.pClearValues = pass.m_ClearValues.data();
+
+		vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+		if (pass.m_Execute)
+			pass.m_Execute(commandBuffer);
+		vkCmdEndRenderPass(commandBuffer);
+	}
+
+	RecordBarriers(commandBuffer, m_FinalBarriers);
+}
+
+void RenderGraph::Invalidate()
+{
+	Device::WaitIdle();
+	DestroyFramebuffers();
+	DestroyTransientImages();
+	m_Compiled = false;
+}
+
+VkImageView RenderGraph::GetImageView(RenderGraphResource resource) const
+{
+	if (m_Resources[resource].imported)
+		return m_Resources[resource].imageView;
+
+	return resource < m_TransientImages.size() ? m_TransientImages[resource].imageView : VK_NULL_HANDLE;
+}
+
+VkDescriptorImageInfo RenderGraph::GetSampledImageInfo(RenderGraphResource resource) const
+{
+	VkDescriptorImageInfo imageInfo{};
+	imageInfo.imageView = GetImageView(resource);
+	const VkFormat format = m_Resources[resource].desc.format;
+	imageInfo.imageLayout = GetAccessInfo(RenderGraphAccess::SAMPLED_FRAGMENT, format).layout;
+	return imageInfo;
+}
+
+void RenderGraph::OnUIRender()
+{
+	ImGui::SeparatorText("Render graph:");
+	ImGui::Text("%u passes (%u culled), %u barriers per frame",
+		m_Stats.passCount,
+		m_Stats.culledPassCount,
+		m_Stats.barrierCount);
+	ImGui::Text("Transient images: %u in %.2f MB, %.2f MB without aliasing (%.2f MB saved)",
+		m_Stats.transientImageCount,
+		static_cast<double>(m_Stats.transientBytes) / BYTES_PER_MB,
+		static_cast<double>(m_Stats.unaliasedBytes) / BYTES_PER_MB,
+		static_cast<double>(m_Stats.unaliasedBytes - m_Stats.transientBytes) / BYTES_PER_MB);
+
+	if (!ImGui::TreeNode("Render graph passes"))
+		return;
+
+	for (size_t i = 0; i < m_CompiledPassNames.size(); ++i)
+	{
+		if (m_CulledPasses[i])
+			ImGui::TextDisabled("%s (culled)", m_CompiledPassNames[i].c_str());
+		else
+			ImGui::Text("%s", m_CompiledPassNames[i].c_str());
+	}
+
+	ImGui::TreePop();
+}
+
+void RenderGraph::Cull(std::vector<bool>& culled) const
+{
+	// the images whose current contents are still read, walking back from the end of the frame, the imported images
+	// are read after the last pass
+	std::vector<bool> needed(m_Resources.size(), false);
+	for (size_t i = 0; i < m_Resources.size(); ++i)
+		needed[i] = m_Resources[i].imported;
+
+	for (size_t i = m_Passes.size(); i-- > 0;)
+	{
+		const RenderGraphPass& pass = m_Passes[i];
+		bool used = pass.m_SideEffects;
+		for (const auto& use : pass.m_Uses)
+			used = used || (use.write && use.resource < needed.size() && needed[use.resource]);
+
+		culled[i] = !used;
+		if (!used)
+			continue;
+
+		// a write that doesn't read replaces the contents, the passes before it don't have to produce them
+		for (const auto& use : pass.m_Uses)
+		{
+			if (use.resource < needed.size() && use.write && !use.read)
+				needed[use.resource] = false;
+		}
+		for (const auto& use : pass.m_Uses)
+		{
+			if (use.resource < needed.size() && use.read)
+				needed[use.resource] = true;
+		}
+	}
+}
+
+void RenderGraph::CreateTransientImages(const std::vector<bool>& usedImages)
+{
+	// the usage of every access of the compiled passes
+	std::vector<VkImageUsageFlags> usages(m_Resources.size(), 0);
+	for (const auto& compiledPass : m_CompiledPasses)
+	{
+		for (const auto& use : m_Passes[compiledPass.pass].m_Uses)
+			usages[use.resource] |= GetAccessInfo(use.access, m_Resources[use.resource].desc.format).usage;
+	}
+
+	for (size_t i = 0; i < m_Resources.size(); ++i)
+	{
+		if (!usedImages[i])
+			continue;
+
+		const RenderGraphImageDesc& desc = m_Resources[i].desc;
+		VkImageCreateInfo imageInfo{};
+		imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+		imageInfo.imageType = VK_IMAGE_TYPE_2D;
+		imageInfo.extent.width = desc.width;
+		imageInfo.extent.height = desc.height;
+		imageInfo.extent.depth = 1;
+		imageInfo.mipLevels = 1;
+		imageInfo.arrayLayers = 1;
+		imageInfo.format = desc.format;
+		imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+		imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+		imageInfo.usage = usages[i];
+		imageInfo.samples = desc.samples;
+		imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+		TransientImage& image = m_TransientImages[i];
+		THROW(vkCreateImage(Device::GetDevice(), &imageInfo, nullptr, &image.image) != VK_SUCCESS,
+			"Failed to create render graph image '{}'!",
+			m_Resources[i].name)
+		vkGetImageMemoryRequirements(Device::GetDevice(), image.image, &image.memoryRequirements);
+	}
+}
+
+void RenderGraph::AliasMemory()
+{
+	// the largest images first, an image is placed into the first block of its memory types where none of the images
+	// are used by its passes, every image of a block is bound at its start (the offset is aligned for all of them)
+	std::vector<RenderGraphResource> images{};
+	for (RenderGraphResource i = 0; i < static_cast<RenderGraphResource>(m_TransientImages.size()); ++i)
+	{
+		if (m_TransientImages[i].image != VK_NULL_HANDLE)
+			images.push_back(i);
+	}
+	std::stable_sort(images.begin(), images.end(), [this](RenderGraphResource a, RenderGraphResource b) {
+		return m_TransientImages[a].memoryRequirements.size > m_TransientImages[b].memoryRequirements.size;
+	});
+
+	for (const RenderGraphResource resource : images)
+	{
+		TransientImage& image = m_TransientImages[resource];
+		const auto overlaps = [this, &image](RenderGraphResource other) {
+			const TransientImage& otherImage = m_TransientImages[other];
+			return image.firstPass <= otherImage.lastPass && otherImage.firstPass <= image.lastPass;
+		};
+
+		uint32_t blockIndex = 0;
+		for (; blockIndex < m_MemoryBlocks.size(); ++blockIndex)
+		{
+			const MemoryBlock& block = m_MemoryBlocks[blockIndex];
+			if ((block.memoryTypeBits & image.memoryRequirements.memoryTypeBits) != 0
+				&& std::none_of(block.images.begin(), block.images.end(), overlaps))
+				break;
+		}
+		if (blockIndex == m_MemoryBlocks.size())
+			m_MemoryBlocks.push_back({ VK_NULL_HANDLE, 0, image.memoryRequirements.memoryTypeBits });
+
+		MemoryBlock& block = m_MemoryBlocks[blockIndex];
+		block.size = std::max(block.size, image.memoryRequirements.size);
+		block.memoryTypeBits &= image.memoryRequirements.memoryTypeBits;
+		block.images.push_back(resource);
+		image.block = blockIndex;
+	}
+
+	for (auto& block : m_MemoryBlocks)
+	{
+		block.memory = utils::AllocateMemory(block.size, block.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+		for (const RenderGraphResource resource : block.images)
+		{
+			TransientImage& image = m_TransientImages[resource];
+			const VkFormat format = m_Resources[resource].desc.format;
+			vkBindImageMemory(Device::GetDevice(), image.image, block.memory, 0);
+			image.imageView = utils::CreateImageView(
+				image.image, format, IsDepthFormat(format) ? VK_IMAGE_ASPECT_DEPTH_BIT : VK_IMAGE_ASPECT_COLOR_BIT, 1);
+		}
+	}
+}
+
+void RenderGraph::PlaceBarriers()
+{
+	// the accesses to the memory of an image since its last write (or layout transition), per memory block for the
+	// transient images (the aliased images share them) and per resource for the imported ones
+	struct Hazard
+	{
+		VkPipelineStageFlags writeStages = 0;
+		VkAccessFlags writeAccess = 0;
+		VkPipelineStageFlags readStages = 0;
+		// the write is visible to these
+		VkPipelineStageFlags visibleStages = 0;
+		VkAccessFlags visibleAccess = 0;
+	};
+
+	const size_t blockCount = m_MemoryBlocks.size();
+	const auto getHazard = [this, blockCount](std::vector<Hazard>& hazards, RenderGraphResource resource) -> Hazard& {
+		return m_Resources[resource].imported ? hazards[blockCount + resource]
+											  : hazards[m_TransientImages[resource].block];
+	};
+
+	// the barriers of a frame that starts with `hazards` (the accesses of the previous frame), the contents of every
+	// image are discarded at its first access
+	const auto placeBarriers = [&](std::vector<Hazard>& hazards, bool record) {
+		for (size_t i = 0; i < m_Resources.size(); ++i)
+		{
+			if (m_Resources[i].imported)
+				hazards[blockCount + i] = { m_Resources[i].waitStages };
+		}
+
+		std::vector<VkImageLayout> layouts(m_Resources.size(), VK_IMAGE_LAYOUT_UNDEFINED);
+		const auto access = [&](RenderGraphResource resource, const AccessInfo& info, bool read, bool write) {
+			Hazard& hazard = getHazard(hazards, resource);
+			const VkAccessFlags dstAccess = (read ? info.readAccess : 0) | (write ? info.writeAccess : 0);
+			Barrier barrier{ resource, layouts[resource], info.layout, 0, 0, info.stages, dstAccess };
+
+			bool needed = false;
+			if (write || layouts[resource] != info.layout)
+			{
+				// the layout transition is a write too, it waits for the reads and writes before it
+				barrier.srcStages = hazard.writeStages | hazard.readStages;
+				barrier.srcAccess = hazard.writeAccess;
+				needed = layouts[resource] != info.layout || barrier.srcStages != 0;
+				if (write)
+					hazard = { info.stages, info.writeAccess };
+				else
+					hazard = { info.stages, 0, info.stages, info.stages, dstAccess };
+			}
+			else
+			{
+				// a read of a write that isn't visible to it yet
+				barrier.srcStages = hazard.writeStages;
+				barrier.srcAccess = hazard.writeAccess;
+				needed = hazard.writeStages != 0
+						 && ((hazard.visibleStages & info.stages) != info.stages
+							 || (hazard.visibleAccess & dstAccess) != dstAccess);
+				hazard.readStages |= info.stages;
+				if (needed)
+				{
+					hazard.visibleStages |= info.stages;
+					hazard.visibleAccess |= dstAccess;
+				}
+			}
+
+			layouts[resource] = info.layout;
+			if (!needed)
+				return std::optional<Barrier>{};
+
+			if (barrier.srcStages == 0)
+				barrier.srcStages = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+			return std::optional<Barrier>{ barrier };
+		};
+
+		for (auto& compiledPass : m_CompiledPasses)
+		{
+			if (record)
+				compiledPass.barriers.clear();
+
+			for (const auto& use : m_Passes[compiledPass.pass].m_Uses)
+			{
+				const AccessInfo info = GetAccessInfo(use.access, m_Resources[use.resource].desc.format);
+				const std::optional<Barrier> barrier = access(use.resource, info, use.read, use.write);
+				if (record && barrier)
+					compiledPass.barriers.push_back(*barrier);
+			}
+		}
+
+		// the imported images are read by their final access after the last pass, eg: presented
+		if (record)
+			m_FinalBarriers.clear();
+		for (RenderGraphResource i = 0; i < static_cast<RenderGraphResource>(m_Resources.size()); ++i)
+		{
+			const Resource& resource = m_Resources[i];
+			if (!resource.imported)
+				continue;
+
+			const AccessInfo info = GetAccessInfo(resource.finalAccess, resource.desc.format);
+			const std::optional<Barrier> barrier = access(i, info, true, false);
+			if (record && barrier)
+				m_FinalBarriers.push_back(*barrier);
+		}
+	};
+
+	// the first frame starts without accesses, the next ones with the accesses of the previous frame (eg: the last
+	// pass that used a memory block before the first one that writes it again)
+	std::vector<Hazard> hazards(blockCount + m_Resources.size());
+	placeBarriers(hazards, false);
+	placeBarriers(hazards, true);
+}
+
+void RenderGraph::DestroyTransientImages()
+{
+	for (auto& image : m_TransientImages)
+	{
+		if (image.imageView != VK_NULL_HANDLE)
+			vkDestroyImageView(Device::GetDevice(), image.imageView, nullptr);
+		if (image.image != VK_NULL_HANDLE)
+			vkDestroyImage(Device::GetDevice(), image.image, nullptr);
+	}
+	for (const auto& block : m_MemoryBlocks)
+	{
+		if (block.memory != VK_NULL_HANDLE)
+			utils::FreeMemory(block.memory);
+	}
+
+	m_TransientImages.clear();
+	m_MemoryBlocks.clear();
+}
+
+void RenderGraph::DestroyFramebuffers()
+{
+	for (const auto& framebuffer : m_Framebuffers)
+		vkDestroyFramebuffer(Device::GetDevice(), framebuffer.framebuffer, nullptr);
+
+	m_Framebuffers.clear();
+}
+
+VkImage RenderGraph::GetImage(RenderGraphResource resource) const
+{
+	return m_Resources[resource].imported ? m_Resources[resource].image : m_TransientImages[resource].image;
+}
+
+VkFramebuffer RenderGraph::GetFramebuffer(const RenderGraphPass& pass, VkExtent2D& extent)
+{
+	std::vector<VkImageView> attachments{};
+	for (const auto& use : pass.m_Uses)
+	{
+		if (!IsAttachment(use.access))
+			continue;
+
+		if (attachments.empty())
+			extent = { m_Resources[use.resource].desc.width, m_Resources[use.resource].desc.height };
+		attachments.push_back(GetImageView(use.resource));
+	}
+	THROW(attachments.empty(), "Render graph pass '{}' has a render pass without attachments!", pass.m_Name)
+
+	// one per swapchain image for the passes that write it
+	for (const auto& framebuffer : m_Framebuffers)
+	{
+		if (framebuffer.renderPass == pass.m_RenderPass && framebuffer.attachments == attachments)
+			return framebuffer.framebuffer;
+	}
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = pass.m_RenderPass;
+	framebufferInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
+	framebufferInfo.pAttachments = attachments.data();
+	framebufferInfo.width = extent.width;
+	framebufferInfo.height = extent.height;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer framebuffer{};
+	THROW(vkCreateFramebuffer(Device::GetDevice(), &framebufferInfo, nullptr, &framebuffer) != VK_SUCCESS,
+		"Failed to create framebuffer of render graph pass '{}'!",
+		pass.m_Name)
+
+	m_Framebuffers.push_back({ pass.m_RenderPass, attachments, framebuffer });
+	return framebuffer;
+}
+
+void RenderGraph::RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers) const
+{
+	if (barriers.empty())
+		return;
+
+	std::vector<VkImageMemoryBarrier> imageBarriers{};
+	imageBarriers.reserve(barriers.size());
+	VkPipelineStageFlags srcStages = 0;
+	VkPipelineStageFlags dstStages = 0;
+	for (const auto& barrier : barriers)
+	{
+		VkImageMemoryBarrier imageBarrier{};
+		imageBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		imageBarrier.srcAccessMask = barrier.srcAccess;
+		imageBarrier.dstAccessMask = barrier.dstAccess;
+		imageBarrier.oldLayout = barrier.oldLayout;
+		imageBarrier.newLayout = barrier.newLayout;
+		imageBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		imageBarrier.image = GetImage(barrier.resource);
+		imageBarrier.subresourceRange.aspectMask = GetAspect(m_Resources[barrier.resource].desc.format);
+		imageBarrier.subresourceRange.baseMipLevel = 0;
+		imageBarrier.subresourceRange.levelCount = 1;
+		imageBarrier.subresourceRange.baseArrayLayer = 0;
+		imageBarrier.subresourceRange.layerCount = 1;
+		imageBarriers.push_back(imageBarrier);
+
+		srcStages |= barrier.srcStages;
+		dstStages |= barrier.dstStages;
+	}
+
+	vkCmdPipelineBarrier(commandBuffer,
+		srcStages,
+		dstStages,
+		0,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		static_cast<uint32_t>(imageBarriers.size()),
+		imageBarriers.data());
+}
@@ -0,0 +1,235 @@
+#pragma once
+
+#include <deque>
+#include <string>
+#include <vector>
+#include <functional>
+#include <vulkan/vulkan.h>
+
+
+// an image of the render graph, only valid for the frame it was declared in
+using RenderGraphResource = uint32_t;
+
+// how a pass uses an image, the stages, accesses and layouts of the barriers are derived from it
+enum class RenderGraphAccess
+{
+	COLOR_ATTACHMENT, // also the resolve attachments
+	DEPTH_ATTACHMENT,
+	SAMPLED_FRAGMENT,
+	SAMPLED_COMPUTE,
+	// only the final accesses of the imported images
+	TRANSFER_SRC,
+	PRESENT,
+};
+
+struct RenderGraphImageDesc
+{
+	VkFormat format;
+	uint32_t width;
+	uint32_t height;
+	VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+
+	bool operator==(const RenderGraphImageDesc& other) const;
+};
+
+// of the compiled graph
+struct RenderGraphStats
+{
+	uint32_t passCount = 0; // declared
+	uint32_t culledPassCount = 0;
+	uint32_t barrierCount = 0; // image barriers recorded per frame
+	uint32_t transientImageCount = 0; // of the passes that weren't culled
+	VkDeviceSize transientBytes = 0; // allocated for the transient images
+	VkDeviceSize unaliasedBytes = 0; // if every transient image had its own memory
+};
+
+// a pass of the render graph: the images it reads and writes, the render pass it is recorded in (if any) and the
+// commands it records
+class RenderGraphPass
+{
+public:
+	explicit RenderGraphPass(const std::string& name);
+
+	// the graph begins the render pass around the commands of the pass, the attachments of its framebuffer are the
+	// images of the attachment accesses, in the order they are declared
+	// the attachments have to stay in their attachment layout (the initial and final layouts of the render pass), the
+	// graph places the barriers before the render pass
+	void SetRenderPass(VkRenderPass renderPass, const std::vector<VkClearValue>& clearValues);
+	// the contents of the image are used
+	void Read(RenderGraphResource resource, RenderGraphAccess access);
+	// the contents of the image are replaced, eg: cleared, the passes that wrote it before are culled if nothing else
+	// reads their results
+	void Write(RenderGraphResource resource, RenderGraphAccess access);
+	// the contents of the image are used and modified, eg: an attachment that is loaded
+	void ReadWrite(RenderGraphResource resource, RenderGraphAccess access);
+	// the pass writes something outside of the graph (eg: a buffer), it is never culled
+	void SetSideEffects();
+	void SetExecute(const std::function<void(VkCommandBuffer)>& execute);
+
+	inline const std::string& GetName() const { return m_Name; }
+
+private:
+	friend class RenderGraph;
+
+	struct Use
+	{
+		RenderGraphResource resource;
+		RenderGraphAccess access;
+		bool read;
+		bool write;
+
+		bool operator==(const Use& other) const;
+	};
+
+private:
+	void AddUse(RenderGraphResource resource, RenderGraphAccess access, bool read, bool write);
+
+private:
+	std::string m_Name;
+	std::vector<Use> m_Uses{}; // one per image, in the order they are declared
+	VkRenderPass m_RenderPass{};
+	std::vector<VkClearValue> m_ClearValues{};
+	bool m_SideEffects = false;
+	std::function<void(VkCommandBuffer)> m_Execute{};
+};
+
+// the passes of a frame and the images they use, declared every frame in the order they are recorded
+// - the passes that nothing reads (directly or through other passes) are culled, the roots are the passes with side
+//   effects and the ones that write the imported images
+// - the barriers between the passes are derived from the declared accesses, a barrier is only placed for a layout
+//   transition, a write after an access or a read of a write that isn't visible to it yet, the barriers before a pass
+//   are recorded with one `vkCmdPipelineBarrier()`
+// - the transient images are owned by the graph, the ones whose passes don't overlap share their memory (aliasing)
+// the graph is only compiled again when the declarations change (eg: a pass is toggled, the size of an image changes),
+// the compiled barriers and images are reused by the next frames
+// the buffers are not in the graph, their passes synchronize them (eg: the culling passes)
+class RenderGraph
+{
+public:
+	RenderGraph() = default;
+	~RenderGraph();
+
+	RenderGraph(const RenderGraph&) = delete;
+	RenderGraph& operator=(const RenderGraph&) = delete;
+
+	// clears the declarations of the previous frame
+	void Reset();
+	RenderGraphResource CreateImage(const std::string& name, const RenderGraphImageDesc& desc);
+	// an image that is owned by someone else (eg: the swapchain image of the frame), its contents are discarded at the
+	// start of the frame, the first access waits for `waitStages` (eg: the stages the submit waits at for the
+	// acquired image) and the image is transitioned for `finalAccess` after the last pass
+	RenderGraphResource ImportImage(const std::string& name,
+		VkImage image,
+		VkImageView imageView,
+		const RenderGraphImageDesc& desc,
+		VkPipelineStageFlags waitStages,
+		RenderGraphAccess finalAccess);
+	// the pass is valid until the next `Reset()`
+	RenderGraphPass& AddPass(const std::string& name);
+
+	// compiles the declarations if they differ from the compiled ones, waits for the gpu if the transient images are
+	// recreated, returns true if they were, their views have to be written again (eg: into descriptor sets)
+	bool Compile();
+	// records the passes that weren't culled with their barriers
+	void Execute(VkCommandBuffer commandBuffer);
+	// frees the transient images and the framebuffers, eg: when the swapchain is recreated, waits for the gpu
+	void Invalidate();
+
+	// the images of the culled passes have no view
+	VkImageView GetImageView(RenderGraphResource resource) const;
+	// the view and the layout of the sampled accesses, without a sampler
+	VkDescriptorImageInfo GetSampledImageInfo(RenderGraphResource resource) const;
+	inline const RenderGraphStats& GetStats() const { return m_Stats; }
+
+	void OnUIRender();
+
+private:
+	struct Resource
+	{
+		std::string name;
+		RenderGraphImageDesc desc;
+		bool imported;
+		VkPipelineStageFlags waitStages;
+		RenderGraphAccess finalAccess;
+		VkImage image; // imported
+		VkImageView imageView;
+
+		// without the imported image, it changes every frame
+		bool operator==(const Resource& other) const;
+	};
+
+	struct TransientImage
+	{
+		VkImage image{};
+		VkImageView imageView{};
+		VkMemoryRequirements memoryRequirements{};
+		uint32_t firstPass = 0; // of the compiled passes
+		uint32_t lastPass = 0;
+		uint32_t block = 0; // of the memory blocks
+	};
+
+	struct MemoryBlock
+	{
+		VkDeviceMemory memory{};
+		VkDeviceSize size = 0;
+		uint32_t memoryTypeBits = 0;
+		std::vector<RenderGraphResource> images{};
+	};
+
+	struct Barrier
+	{
+		RenderGraphResource resource;
+		VkImageLayout oldLayout;
+		VkImageLayout newLayout;
+		VkPipelineStageFlags srcStages;
+		VkAccessFlags srcAccess;
+		VkPipelineStageFlags dstStages;
+		VkAccessFlags dstAccess;
+	};
+
+	struct CompiledPass
+	{
+		uint32_t pass; // of the declared passes
+		std::vector<Barrier> barriers{}; // before the pass
+	};
+
+	struct Framebuffer
+	{
+		VkRenderPass renderPass;
+		std::vector<VkImageView> attachments;
+		VkFramebuffer framebuffer;
+	};
+
+private:
+	void Cull(std::vector<bool>& culled) const;
+	void CreateTransientImages(const std::vector<bool>& usedImages);
+	void AliasMemory();
+	void PlaceBarriers();
+	void DestroyTransientImages();
+	void DestroyFramebuffers();
+
+	VkImage GetImage(RenderGraphResource resource) const;
+	VkFramebuffer GetFramebuffer(const RenderGraphPass& pass, VkExtent2D& extent);
+	void RecordBarriers(VkCommandBuffer commandBuffer, const std::vector<Barrier>& barriers) const;
+
+private:
+	// declared this frame
+	std::vector<Resource> m_Resources{};
+	std::deque<RenderGraphPass> m_Passes{};
+
+	// compiled, the declarations they were compiled from
+	bool m_Compiled = false;
+	std::vector<Resource> m_CompiledResources{};
+	std::vector<std::string> m_CompiledPassNames{};
+	std::vector<std::vector<RenderGraphPass::Use>> m_CompiledUses{};
+	std::vector<VkRenderPass> m_CompiledRenderPasses{};
+	std::vector<bool> m_CompiledSideEffects{};
+
+	std::vector<bool> m_CulledPasses{}; // per declared pass
+	std::vector<CompiledPass> m_CompiledPasses{};
+	std::vector<Barrier> m_FinalBarriers{}; // of the imported images, after the last pass
+	std::vector<TransientImage> m_TransientImages{}; // per resource, empty for the imported ones
+	std::vector<MemoryBlock> m_MemoryBlocks{};
+	std::vector<Framebuffer> m_Framebuffers{};
+	RenderGraphStats m_Stats{};
+};
@@ -0,0 +1,4 @@
+#include "renderer/renderStats.h"
+
+
+RenderStats::Counts RenderStats::s_Counts{};
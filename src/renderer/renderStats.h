@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+
+// counts of the draw commands recorded since the last reset, reset at the start of every frame
+// the ui isn't counted, it is drawn by the imgui backend
+class RenderStats
+{
+public:
+	static inline void Reset() { s_Counts = {}; }
+
+	static inline void CountDraw(uint32_t vertexCount, uint32_t instanceCount = 1)
+	{
+		++s_Counts.drawCalls;
+		s_Counts.triangles += static_cast<uint64_t>(vertexCount / 3) * instanceCount;
+	}
+
+	static inline uint32_t GetDrawCalls() { return s_Counts.drawCalls; }
+	static inline uint64_t GetTriangles() { return s_Counts.triangles; }
+
+private:
+	struct Counts
+	{
+		uint32_t drawCalls = 0;
+		uint64_t triangles = 0; // of triangle lists
+	};
+
+	static Counts s_Counts;
+};
@@ -2,16 +2,25 @@
 
 #include <cmath>
 #include <array>
+#include <random>
+#include <string>
+#include <chrono>
+#include <algorithm>
 #include <glm/glm.hpp>
+#include <glm/gtc/constants.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/matrix_inverse.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include "core/core.h"
+#include "core/profiler.h"
 #include "utils/utils.h"
 #include "ui/imGuiOverlay.h"
+#include "renderer/renderStats.h"
 
 
 constexpr uint64_t NUM_INSTANCES = 3;
+// light counts that can be selected in the ui, used to compare the shading cost
+constexpr std::array<int, 4> LIGHT_COUNT_PRESETS{ 1, 64, 1024, 4096 };
 
 Renderer::Renderer(const char* title, const VulkanConfig& config, const std::shared_ptr<Window>& window)
 	: m_Config{ config },
@@ -28,26 +37,88 @@ Renderer::~Renderer()
 void Renderer::Init(const char* title)
 {
 	m_VulkanContext = VulkanContext::Create(title, m_Config, m_Window);
-	m_Device = Device::Create(m_Config, m_Window->GetWindowSurface());
+	m_Device = Device::Create(m_Config, VulkanContext::GetWindowSurface());
 	m_CommandPool = CommandPool::Create();
 	DescriptorPool::Init();
 
-	m_Swapchain = std::make_unique<Swapchain>(m_Window);
+	if (m_Config.headless)
+		m_Swapchain = std::make_unique<Swapchain>(m_Config.headlessExtent);
+	else
+		m_Swapchain = std::make_unique<Swapchain>(m_Window);
+	m_RenderGraph = std::make_unique<RenderGraph>();
+	m_LightClusters = std::make_unique<LightClusters>(m_Config.maxFramesInFlight);
+	GenerateLights(static_cast<uint32_t>(m_LightCount));
+	m_ShadowMaps = std::make_unique<ShadowMaps>(m_Config.maxFramesInFlight);
+	// scene wide sets of the lit pipelines, set 1 = lights, set 2 = shadows
+	std::vector<const DescriptorSet*> sceneDescriptorSets{ m_LightClusters->GetDescriptorSet(),
+		m_ShadowMaps->GetDescriptorSet() };
+
+	m_GBuffer = std::make_unique<GBuffer>();
+	m_DeferredLighting = std::make_unique<DeferredLighting>(
+		m_Swapchain->GetRenderPass(), m_GBuffer.get(), sceneDescriptorSets, m_Config.maxFramesInFlight);
+	m_OverdrawStats = std::make_unique<OverdrawStats>(m_Config.maxFramesInFlight);
+	m_GpuProfiler = std::make_unique<GpuProfiler>(m_Config.maxFramesInFlight);
+	m_HiZBuffer = std::make_unique<HiZBuffer>(
+		m_Swapchain->GetWidth(), m_Swapchain->GetHeight(), m_Config.maxFramesInFlight);
+	m_Materials = std::make_unique<Materials>(m_Config.maxFramesInFlight);
+	m_BindlessTextures = std::make_unique<BindlessTextures>(*m_Materials, m_Config.maxFramesInFlight);
+	m_TextureStreamer = std::make_unique<TextureStreamer>(m_Config.maxFramesInFlight);
+	// the lit pipelines also sample the bindless textures and the materials, set 3
+	std::vector<const DescriptorSet*> litDescriptorSets{ sceneDescriptorSets };
+	litDescriptorSets.push_back(m_BindlessTextures->GetDescriptorSet());
 
 	m_BackpackModel = std::make_unique<Model>("assets/models/backpack/backpack.obj",
 		m_Swapchain->GetRenderPass(),
+		m_GBuffer->GetRenderPass(),
+		litDescriptorSets,
+		m_HiZBuffer->GetDescriptorSet(),
+		m_BindlessTextures.get(),
+		m_Materials.get(),
+		m_TextureStreamer.get(),
 		m_Config.maxFramesInFlight,
 		NUM_INSTANCES,
 		false);
 	m_CerberusModel = std::make_unique<Model>("assets/models/Cerberus/Cerberus_LP.FBX",
 		m_Swapchain->GetRenderPass(),
+		m_GBuffer->GetRenderPass(),
+		litDescriptorSets,
+		m_HiZBuffer->GetDescriptorSet(),
+		m_BindlessTextures.get(),
+		m_Materials.get(),
+		m_TextureStreamer.get(),
 		m_Config.maxFramesInFlight,
 		NUM_INSTANCES,
 		true);
 
-	m_Cube = std::make_unique<Cube>(m_Swapchain->GetRenderPass(), m_Config.maxFramesInFlight, NUM_INSTANCES);
+	m_Cube = std::make_unique<Cube>(m_Swapchain->GetRenderPass(),
+		m_GBuffer->GetRenderPass(),
+		litDescriptorSets,
+		m_BindlessTextures.get(),
+		m_Materials.get(),
+		m_Config.maxFramesInFlight,
+		NUM_INSTANCES);
 	m_LightCube = std::make_unique<LightCube>(m_Swapchain->GetRenderPass(), m_Config.maxFramesInFlight, NUM_INSTANCES);
 
+	// the model matrices are updated every frame
+	m_ShadowCasters.resize(NUM_INSTANCES);
+	m_ShadowCasters[0].boundsMin = m_BackpackModel->GetBoundsMin();
+	m_ShadowCasters[0].boundsMax = m_BackpackModel->GetBoundsMax();
+	m_ShadowCasters[0].compactVertices = m_BackpackModel->HasCompactVertices();
+	m_ShadowCasters[0].draw = [this](VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) {
+		m_BackpackModel->DrawPositions(commandBuffer, pipelineLayout);
+	};
+	m_ShadowCasters[1].boundsMin = m_CerberusModel->GetBoundsMin();
+	m_ShadowCasters[1].boundsMax = m_CerberusModel->GetBoundsMax();
+	m_ShadowCasters[1].compactVertices = m_CerberusModel->HasCompactVertices();
+	m_ShadowCasters[1].draw = [this](VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) {
+		m_CerberusModel->DrawPositions(commandBuffer, pipelineLayout);
+	};
+	m_ShadowCasters[2].boundsMin = m_Cube->GetBoundsMin();
+	m_ShadowCasters[2].boundsMax = m_Cube->GetBoundsMax();
+	m_ShadowCasters[2].draw = [this](VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) {
+		m_Cube->DrawPositions(commandBuffer, pipelineLayout);
+	};
+
 	VkDeviceSize uboSize = sizeof(UniformBufferObject);
 	VkDeviceSize minAlignment = Device::GetDeviceProperties().limits.minUniformBufferOffsetAlignment;
 	m_DUbo.Init(minAlignment, NUM_INSTANCES);
@@ -57,16 +128,20 @@ void Renderer::Init(const char* title)
 	CreateSyncObjects();
 
 	m_Camera = std::make_unique<Camera>(
-		static_cast<float>(m_Swapchain->GetWidth()) / static_cast<float>(m_Swapchain->GetHeight()));
+		static_cast<float>(m_Swapchain->GetWidth()) / static_cast<float>(m_Swapchain->GetHeight()),
+		m_Config.reverseZ);
 
-	ImGuiOverlay::Init(m_Config.maxFramesInFlight, m_Swapchain->GetRenderPass());
+	// there is no ui (nor input) in headless mode
+	if (!m_Config.headless)
+		ImGuiOverlay::Init(m_Config.maxFramesInFlight, m_Swapchain->GetRenderPass());
 }
 
 void Renderer::Cleanup()
 {
 	Device::WaitIdle();
 
-	ImGuiOverlay::Cleanup();
+	if (!m_Config.headless)
+		ImGuiOverlay::Cleanup();
 
 	for (size_t i = 0; i < m_Config.maxFramesInFlight; ++i)
 	{
@@ -76,38 +151,239 @@ void Renderer::Cleanup()
 	}
 
 	DescriptorPool::Cleanup();
+	SamplerCache::Cleanup();
 }
 
 void Renderer::Draw(float deltatime, uint32_t fpsCount)
 {
+	PROFILE_FUNCTION();
+	auto startTime = std::chrono::steady_clock::now();
+	m_Time += deltatime / 1000.0f;
+
 	BeginScene();
+	BuildRenderGraph(fpsCount);
+	m_RenderGraph->Execute(m_ActiveCommandBuffer);
+	EndScene();
 
-	uint32_t dynamicOffset = 0 * m_DUbo.GetAlignment();
-	m_BackpackModel->Draw(m_ActiveCommandBuffer, m_CurrentFrameIndex, 1, &dynamicOffset);
+	if (m_Config.headless || m_ScriptedCamera)
+		m_Camera->UpdateMatrices();
+	else
+		m_Camera->OnUpdate(deltatime);
+
+	auto frameTime = std::chrono::steady_clock::now() - startTime;
+	m_FrameStats.cpuTime =
+		std::chrono::duration<float, std::chrono::milliseconds::period>(frameTime).count() - m_WaitTime;
+	m_FrameStats.gpuTime = m_GpuProfiler->GetFrameTime();
+	m_FrameStats.lightingTime = m_GpuProfiler->GetScopeTime("Light culling")
+		+ m_GpuProfiler->GetScopeTime(m_DeferredShading ? "Deferred lighting" : "Forward");
+}
 
-	dynamicOffset = 1 * m_DUbo.GetAlignment();
-	m_CerberusModel->Draw(m_ActiveCommandBuffer, m_CurrentFrameIndex, 1, &dynamicOffset);
+void Renderer::BuildRenderGraph(uint32_t fpsCount)
+{
+	PROFILE_FUNCTION();
+	// the passes are declared every frame, the graph is only compiled again when they change (eg: the shading path
+	// is switched, the window is resized)
+	m_RenderGraph->Reset();
+	const uint32_t width = m_Swapchain->GetWidth();
+	const uint32_t height = m_Swapchain->GetHeight();
+	const RenderGraphResource color = m_RenderGraph->CreateImage(
+		"Color", { m_Swapchain->GetImageFormat(), width, height, Device::GetMSAASamplesCount() });
+	const RenderGraphResource depth = m_RenderGraph->CreateImage(
+		"Depth", { Swapchain::FindDepthFormat(), width, height, Device::GetMSAASamplesCount() });
+	// the submit waits for the acquired image at the color attachment output, the offscreen images are read back
+	const RenderGraphResource swapchainImage = m_RenderGraph->ImportImage("Swapchain image",
+		m_Swapchain->GetImage(m_NextFrameIndex),
+		m_Swapchain->GetImageView(m_NextFrameIndex),
+		{ m_Swapchain->GetImageFormat(), width, height },
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		m_Config.headless ? RenderGraphAccess::TRANSFER_SRC : RenderGraphAccess::PRESENT);
+
+	std::array<RenderGraphResource, GBUFFER_ATTACHMENT_COUNT> gBufferImages{};
+	const bool occlusionCulling = IsOcclusionCullingActive();
+	if (m_DeferredShading)
+	{
+		gBufferImages = m_GBuffer->CreateImages(*m_RenderGraph, width, height);
+		RenderGraphPass& gBufferPass = m_RenderGraph->AddPass("G-buffer");
+		gBufferPass.SetRenderPass(m_GBuffer->GetRenderPass(), m_GBuffer->GetClearValues());
+		for (uint32_t i = 0; i < GBUFFER_COLOR_ATTACHMENT_COUNT; ++i)
+			gBufferPass.Write(gBufferImages[i], RenderGraphAccess::COLOR_ATTACHMENT);
+		gBufferPass.Write(gBufferImages[GBUFFER_COLOR_ATTACHMENT_COUNT], RenderGraphAccess::DEPTH_ATTACHMENT);
+		gBufferPass.SetExecute([this](VkCommandBuffer) {
+			m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "G-buffer");
+			m_OverdrawStats->Begin(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+			DrawScene(DrawPass::GBUFFER);
+			m_OverdrawStats->End(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+			m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+		});
+
+		RenderGraphPass& lightingPass = m_RenderGraph->AddPass("Deferred lighting");
+		lightingPass.SetRenderPass(m_Swapchain->GetRenderPass(), m_Swapchain->GetClearValues());
+		lightingPass.Write(color, RenderGraphAccess::COLOR_ATTACHMENT);
+		lightingPass.Write(depth, RenderGraphAccess::DEPTH_ATTACHMENT);
+		lightingPass.Write(swapchainImage, RenderGraphAccess::COLOR_ATTACHMENT);
+		for (const RenderGraphResource gBufferImage : gBufferImages)
+			lightingPass.Read(gBufferImage, RenderGraphAccess::SAMPLED_FRAGMENT);
+		lightingPass.SetExecute([this, fpsCount](VkCommandBuffer) {
+			m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Deferred lighting");
+			m_DeferredLighting->Draw(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+			m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+			DrawOverlays(fpsCount);
+		});
+	}
+	else
+	{
+		RenderGraphPass& forwardPass = m_RenderGraph->AddPass("Forward");
+		forwardPass.SetRenderPass(m_Swapchain->GetRenderPass(), m_Swapchain->GetClearValues());
+		forwardPass.Write(color, RenderGraphAccess::COLOR_ATTACHMENT);
+		forwardPass.Write(depth, RenderGraphAccess::DEPTH_ATTACHMENT);
+		forwardPass.Write(swapchainImage, RenderGraphAccess::COLOR_ATTACHMENT);
+		forwardPass.SetExecute([this, fpsCount, occlusionCulling](VkCommandBuffer) {
+			m_OverdrawStats->Begin(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+			DrawForward(CullingPhase::EARLY);
+			m_OverdrawStats->End(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+			if (!occlusionCulling)
+				DrawOverlays(fpsCount);
+		});
+	}
 
-	dynamicOffset = 2 * m_DUbo.GetAlignment();
-	m_Cube->Draw(m_ActiveCommandBuffer, m_CurrentFrameIndex, 1, &dynamicOffset);
+	if (occlusionCulling)
+	{
+		// what was visible in the last frame has been drawn, the rest is tested against the depth of it
+		// the pyramid and the culled draws are outside of the graph, the pass is never culled
+		RenderGraphPass& hiZPass = m_RenderGraph->AddPass("Hi-Z");
+		hiZPass.Read(depth, RenderGraphAccess::SAMPLED_COMPUTE);
+		hiZPass.SetSideEffects();
+		hiZPass.SetExecute([this](VkCommandBuffer) {
+			m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Hi-Z");
+			m_HiZBuffer->Build(m_ActiveCommandBuffer);
+			m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+			m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Occlusion culling");
+			m_BackpackModel->CullMeshlets(m_ActiveCommandBuffer, m_CurrentFrameIndex, CullingPhase::LATE);
+			m_CerberusModel->CullMeshlets(m_ActiveCommandBuffer, m_CurrentFrameIndex, CullingPhase::LATE);
+			m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+		});
+
+		// the whole image is resolved again
+		RenderGraphPass& latePass = m_RenderGraph->AddPass("Forward late");
+		latePass.SetRenderPass(m_Swapchain->GetLoadRenderPass(), {});
+		latePass.ReadWrite(color, RenderGraphAccess::COLOR_ATTACHMENT);
+		latePass.ReadWrite(depth, RenderGraphAccess::DEPTH_ATTACHMENT);
+		latePass.Write(swapchainImage, RenderGraphAccess::COLOR_ATTACHMENT);
+		latePass.SetExecute([this, fpsCount](VkCommandBuffer) {
+			m_OverdrawStats->Begin(m_ActiveCommandBuffer, m_CurrentFrameIndex, 1);
+			DrawForward(CullingPhase::LATE);
+			m_OverdrawStats->End(m_ActiveCommandBuffer, m_CurrentFrameIndex, 1);
+			DrawOverlays(fpsCount);
+		});
+	}
+
+	// the texture feedback of the lit passes is read by the cpu once the fence of the frame has been signaled
+	RenderGraphPass& feedbackPass = m_RenderGraph->AddPass("Texture feedback");
+	feedbackPass.SetSideEffects();
+	feedbackPass.SetExecute([this](VkCommandBuffer) {
+		m_BindlessTextures->RecordFeedbackBarrier(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+	});
+
+	if (!m_RenderGraph->Compile())
+		return;
+
+	// the transient images have been recreated, none of the sets is bound by the frame yet
+	// the depth is only sampled (and has the sampled usage) with the hi-z pass
+	if (occlusionCulling)
+		m_HiZBuffer->SetDepthImageView(m_RenderGraph->GetImageView(depth));
+	if (m_DeferredShading)
+	{
+		std::array<VkDescriptorImageInfo, GBUFFER_ATTACHMENT_COUNT> gBufferImageInfos{};
+		for (size_t i = 0; i < gBufferImages.size(); ++i)
+			gBufferImageInfos[i] = m_RenderGraph->GetSampledImageInfo(gBufferImages[i]);
+		m_DeferredLighting->SetGBufferImages(gBufferImageInfos);
+	}
+}
 
+void Renderer::DrawOverlays(uint32_t fpsCount)
+{
+	m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Light cube");
 	m_LightCube->Draw(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+	m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
 
-	UpdateUniformBuffers(m_CurrentFrameIndex);
+	// the ui isn't drawn by the counted draw calls
+	m_FrameStats.drawCalls = RenderStats::GetDrawCalls();
+	m_FrameStats.triangles = RenderStats::GetTriangles();
 
-	OnUIRender(fpsCount);
-	EndScene();
+	if (!m_Config.headless)
+	{
+		m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "ImGui");
+		OnUIRender(fpsCount);
+		m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+	}
+}
 
-	m_Camera->OnUpdate(deltatime);
+void Renderer::SetCameraPose(const CameraPose& pose)
+{
+	m_ScriptedCamera = true;
+	m_Camera->LookAt(pose.position, pose.target);
 }
 
-void Renderer::UpdateUniformBuffers(uint32_t currentFrameIndex)
+void Renderer::SetLightCount(uint32_t lightCount)
+{
+	if (static_cast<uint32_t>(m_LightCount) == lightCount)
+		return;
+
+	m_LightCount = static_cast<int>(lightCount);
+	GenerateLights(lightCount);
+}
+
+void Renderer::SaveFrame(const std::string& path)
+{
+	// `m_NextFrameIndex` is the image of the last frame
+	utils::WritePng(path, m_Swapchain->GetWidth(), m_Swapchain->GetHeight(), m_Swapchain->ReadImage(m_NextFrameIndex));
+	Logger::Info("Frame saved to {}", path);
+}
+
+void Renderer::DrawScene(DrawPass drawPass, CullingPhase phase)
 {
-	static auto startTime = std::chrono::high_resolution_clock::now();
-	auto currentTime = std::chrono::high_resolution_clock::now();
-	float time = std::chrono::duration<float, std::chrono::seconds::period>(currentTime - startTime).count();
+	m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Models");
+	uint32_t dynamicOffset = 0 * m_DUbo.GetAlignment();
+	m_BackpackModel->Draw(m_ActiveCommandBuffer, m_CurrentFrameIndex, 1, &dynamicOffset, drawPass, phase);
+
+	dynamicOffset = 1 * m_DUbo.GetAlignment();
+	m_CerberusModel->Draw(m_ActiveCommandBuffer, m_CurrentFrameIndex, 1, &dynamicOffset, drawPass, phase);
+	m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+
+	// the cube isn't culled, it is drawn by the early phase
+	if (phase == CullingPhase::LATE)
+		return;
+
+	m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Cube");
+	dynamicOffset = 2 * m_DUbo.GetAlignment();
+	m_Cube->Draw(m_ActiveCommandBuffer, m_CurrentFrameIndex, 1, &dynamicOffset, drawPass);
+	m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+}
+
+void Renderer::DrawForward(CullingPhase phase)
+{
+	if (m_DepthPrepass)
+	{
+		m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Depth pre-pass");
+		DrawScene(DrawPass::DEPTH_PREPASS, phase);
+		m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+		m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Forward");
+		DrawScene(DrawPass::FORWARD_EQUAL, phase);
+		m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+	}
+	else
+	{
+		m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Forward");
+		DrawScene(DrawPass::FORWARD, phase);
+		m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+	}
+}
 
-	glm::vec3 lightPos{ 1.5 * std::sinf(time), 0.0f, 1.5 * std::cosf(time) };
+void Renderer::UpdateUniformBuffers(uint32_t currentFrameIndex)
+{
+	PROFILE_FUNCTION();
+	AnimateLights(m_Time);
+	glm::vec3 lightPos = glm::vec3(m_Lights[0].position);
 
 	m_Ubo.lightPos = lightPos;
 	m_Ubo.viewPos = m_Camera->GetCameraPosition();
@@ -151,6 +427,37 @@ void Renderer::UpdateUniformBuffers(uint32_t currentFrameIndex)
 	m_CerberusModel->UpdateUniformBuffers(m_Ubo, m_DUbo, currentFrameIndex);
 	m_Cube->UpdateUniformBuffers(m_Ubo, m_DUbo, currentFrameIndex);
 
+	// the lods drawn by every pass of this frame, including the shadow maps
+	const LodSelection lodSelection = LodSelection::FromCamera(*m_Camera, m_Swapchain->GetHeight(), m_LodPixelError);
+	m_BackpackModel->SelectLods(*m_DUbo.GetModelMatPtr(0), lodSelection);
+	m_CerberusModel->SelectLods(*m_DUbo.GetModelMatPtr(1), lodSelection);
+	// the texture levels are streamed before anything of the frame uses the textures (the copies are submitted first)
+	m_BindlessTextures->ReadFeedback(currentFrameIndex);
+	m_BackpackModel->RequestTextureLevels(*m_DUbo.GetModelMatPtr(0), lodSelection);
+	m_CerberusModel->RequestTextureLevels(*m_DUbo.GetModelMatPtr(1), lodSelection);
+	m_TextureStreamer->Update();
+	m_BindlessTextures->Update(currentFrameIndex);
+	m_Materials->Update(currentFrameIndex);
+	// the meshlets of the selected lods that are outside of the view or face away from the camera are not drawn
+	m_BackpackModel->SetMeshletCulling(m_MeshletCulling);
+	m_CerberusModel->SetMeshletCulling(m_MeshletCulling);
+	m_BackpackModel->SetOcclusionCulling(IsOcclusionCullingActive());
+	m_CerberusModel->SetOcclusionCulling(IsOcclusionCullingActive());
+	m_BackpackModel->UpdateMeshletCulling(*m_DUbo.GetModelMatPtr(0), *m_Camera, currentFrameIndex);
+	m_CerberusModel->UpdateMeshletCulling(*m_DUbo.GetModelMatPtr(1), *m_Camera, currentFrameIndex);
+
+	m_LightClusters->Update(
+		m_Lights, *m_Camera, m_Swapchain->GetWidth(), m_Swapchain->GetHeight(), currentFrameIndex);
+
+	for (uint32_t j = 0; j < NUM_INSTANCES; ++j)
+		m_ShadowCasters[j].modelMat = *m_DUbo.GetModelMatPtr(j);
+	m_ShadowCasters[0].geometryVersion = m_BackpackModel->GetLodVersion();
+	m_ShadowCasters[1].geometryVersion = m_CerberusModel->GetLodVersion();
+	m_ShadowMaps->SetEnabled(m_Shadows);
+	m_ShadowMaps->SetSun(GetSunDirection(), glm::vec3(1.0f), m_SunIntensity);
+	m_ShadowMaps->Update(*m_Camera, m_ShadowCasters, m_Lights[0], currentFrameIndex);
+	m_DeferredLighting->UpdateUniformBuffers(*m_Camera, currentFrameIndex);
+
 	// light cube
 	m_LightCubeUbo.transformationMat = m_Camera->GetViewProjectionMatrix();
 	m_LightCubeUbo.transformationMat = glm::translate(m_LightCubeUbo.transformationMat, lightPos);
@@ -158,12 +465,91 @@ void Renderer::UpdateUniformBuffers(uint32_t currentFrameIndex)
 	m_LightCube->UpdateUniformBuffers(m_LightCubeUbo, currentFrameIndex);
 }
 
+glm::vec3 Renderer::GetSunDirection() const
+{
+	// direction towards the sun, the light travels in the opposite direction
+	float azimuth = glm::radians(m_SunAzimuth);
+	float elevation = glm::radians(m_SunElevation);
+	glm::vec3 toSun{ std::cosf(elevation) * std::sinf(azimuth),
+		std::sinf(elevation),
+		std::cosf(elevation) * std::cosf(azimuth) };
+
+	return -toSun;
+}
+
 void Renderer::OnUIRender(uint32_t fpsCount)
 {
+	PROFILE_FUNCTION();
 	ImGuiOverlay::Begin();
 
 	ImGui::Begin("Profiler");
 	ImGui::Text("%.2f ms/frame (%d fps)", (1000.0f / fpsCount), fpsCount);
+	ImGui::Text("%d lights", m_LightCount);
+	// toggled here so that the frame times of both paths can be compared
+	ImGui::Checkbox("Deferred shading", &m_DeferredShading);
+	ImGui::Checkbox("Depth pre-pass (forward)", &m_DepthPrepass);
+	ImGui::Text("Depth: %s", m_Config.reverseZ ? "reverse-z, infinite far plane" : "standard");
+	if (m_OverdrawStats->IsSupported())
+	{
+		// fragment shader invocations of the scene (without the light cube and the ui) per pixel
+		ImGui::Text("Overdraw: %.2f shaded fragments/pixel",
+			m_OverdrawStats->GetOverdraw(m_Swapchain->GetWidth(), m_Swapchain->GetHeight()));
+	}
+	ImGui::Text("%u draw calls, %llu triangles",
+		m_FrameStats.drawCalls,
+		static_cast<unsigned long long>(m_FrameStats.triangles));
+	// the coarsest lod of a mesh whose error is within this many pixels is drawn
+	ImGui::Text("LOD error (pixels)");
+	ImGui::SliderFloat("##lod_pixel_error", &m_LodPixelError, 0.0f, 8.0f);
+	ImGui::Checkbox("Meshlet culling", &m_MeshletCulling);
+	if (m_MeshletCulling)
+	{
+		// read back from the gpu, a few frames late
+		const MeshletCullingStats& backpackStats = m_BackpackModel->GetMeshletCullingStats();
+		const MeshletCullingStats& cerberusStats = m_CerberusModel->GetMeshletCullingStats();
+		const uint64_t triangles = backpackStats.triangles + cerberusStats.triangles;
+		const uint64_t drawnTriangles = backpackStats.drawnTriangles + cerberusStats.drawnTriangles;
+		const uint64_t culledTriangles = triangles - std::min(drawnTriangles, triangles);
+		ImGui::Text("%.1f%% of the model triangles culled",
+			triangles == 0 ? 0.0 : 100.0 * static_cast<double>(culledTriangles) / static_cast<double>(triangles));
+		ImGui::Checkbox("Occlusion culling (forward)", &m_OcclusionCulling);
+		if (IsOcclusionCullingActive())
+		{
+			// drawn after the hi-z pyramid, what wasn't visible in the previous frame
+			const uint64_t lateTriangles = backpackStats.lateTriangles + cerberusStats.lateTriangles;
+			ImGui::Text("%.1f%% of the drawn triangles newly visible",
+				drawnTriangles == 0
+					? 0.0
+					: 100.0 * static_cast<double>(lateTriangles) / static_cast<double>(drawnTriangles));
+		}
+	}
+	// a cascade is only re-rendered when it moves or when a caster inside it moves
+	ImGui::Text("Shadow cascades:");
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+	{
+		ImGui::SameLine();
+		ImGui::Text("%s", m_ShadowMaps->WasCascadeRendered(i) ? "rendered" : "cached");
+	}
+	m_GpuProfiler->OnUIRender();
+	ImGui::Text("%u of %u bindless texture slots used, %u materials, %u samplers",
+		m_BindlessTextures->GetCount(),
+		m_BindlessTextures->GetCapacity(),
+		m_Materials->GetCount(),
+		SamplerCache::GetCount());
+	ImGui::Text("%llu descriptor sets in %u pools",
+		static_cast<unsigned long long>(DescriptorPool::GetAllocator().GetSetCount()),
+		DescriptorPool::GetAllocator().GetPoolCount());
+	m_TextureStreamer->OnUIRender();
+	m_RenderGraph->OnUIRender();
+#ifdef ENABLE_PROFILER
+	// cpu scopes of the next frames, written as a chrome trace
+	ImGui::SeparatorText("CPU capture:");
+	ImGui::SliderInt("Frames##capture_frames", &m_CaptureFrameCount, 1, 300);
+	if (Profiler::IsCapturing())
+		ImGui::Text("Capturing...");
+	else if (ImGui::Button("Capture trace"))
+		Profiler::BeginCapture(static_cast<uint32_t>(m_CaptureFrameCount), "trace.json");
+#endif
 	ImGui::End();
 
 	ImGui::Begin("Properties");
@@ -218,6 +604,32 @@ void Renderer::OnUIRender(uint32_t fpsCount)
 	ImGui::SliderFloat("##cube_z_axis", &m_CubeRotateZ, -180.0f, 180.0f);
 	ImGui::Separator();
 
+	ImGui::SeparatorText("Lights:");
+	ImGui::Text("Count:");
+	for (const auto& preset : LIGHT_COUNT_PRESETS)
+	{
+		ImGui::SameLine();
+		if (ImGui::RadioButton(std::to_string(preset).c_str(), &m_LightCount, preset))
+			GenerateLights(static_cast<uint32_t>(m_LightCount));
+	}
+	bool gpuCulling = m_LightClusters->IsGpuCulling();
+	if (ImGui::Checkbox("GPU light culling", &gpuCulling))
+		m_LightClusters->SetGpuCulling(gpuCulling);
+	ImGui::Separator();
+
+	ImGui::SeparatorText("Sun:");
+	ImGui::Text("Azimuth:");
+	ImGui::SameLine();
+	ImGui::SliderFloat("##sun_azimuth", &m_SunAzimuth, -180.0f, 180.0f);
+	ImGui::Text("Elevation:");
+	ImGui::SameLine();
+	ImGui::SliderFloat("##sun_elevation", &m_SunElevation, 5.0f, 90.0f);
+	ImGui::Text("Intensity:");
+	ImGui::SameLine();
+	ImGui::SliderFloat("##sun_intensity", &m_SunIntensity, 0.0f, 2.0f);
+	ImGui::Checkbox("Shadows", &m_Shadows);
+	ImGui::Separator();
+
 	ImGui::End();
 
 	ImGuiOverlay::End(m_ActiveCommandBuffer);
@@ -226,6 +638,9 @@ void Renderer::OnUIRender(uint32_t fpsCount)
 void Renderer::OnResize(int /*unused*/, int /*unused*/)
 {
 	m_Swapchain->RecreateSwapchain();
+	// the attachments and the framebuffers of the next frame are created by the render graph
+	m_RenderGraph->Invalidate();
+	m_HiZBuffer->Recreate(m_Swapchain->GetWidth(), m_Swapchain->GetHeight());
 	m_Camera->SetAspectRatio(
 		static_cast<float>(m_Swapchain->GetWidth()) / static_cast<float>(m_Swapchain->GetHeight()));
 }
@@ -237,13 +652,25 @@ void Renderer::OnMouseMove(double xpos, double ypos)
 
 void Renderer::BeginScene()
 {
-	// wait for previous frame to signal the fence
-	vkWaitForFences(Device::GetDevice(), 1, &m_InFlightFences[m_CurrentFrameIndex], VK_TRUE, UINT64_MAX);
+	PROFILE_FUNCTION();
+	auto waitStartTime = std::chrono::steady_clock::now();
+	{
+		PROFILE_SCOPE("Wait for fence");
+		// wait for previous frame to signal the fence
+		vkWaitForFences(Device::GetDevice(), 1, &m_InFlightFences[m_CurrentFrameIndex], VK_TRUE, UINT64_MAX);
+	}
 
-	VkResult result =
-		m_Swapchain->AcquireNextImageIndex(m_ImageAvailableSemaphores[m_CurrentFrameIndex], // signal this semaphore
+	VkResult result{};
+	{
+		PROFILE_SCOPE("Acquire image");
+		result = m_Swapchain->AcquireNextImageIndex(
+			m_ImageAvailableSemaphores[m_CurrentFrameIndex], // signal this semaphore
 			&m_NextFrameIndex);
+	}
 	THROW(result != VK_SUCCESS, "Failed to acquire swapchain image!")
+	auto waitTime = std::chrono::steady_clock::now() - waitStartTime;
+	m_WaitTime = std::chrono::duration<float, std::chrono::milliseconds::period>(waitTime).count();
+	RenderStats::Reset();
 
 	// resetting the fence has been set after the result has been checked to
 	// avoid a deadlock reset the fence to unsignaled state
@@ -251,31 +678,92 @@ void Renderer::BeginScene()
 
 	m_ActiveCommandBuffer = m_CommandBuffer->GetBufferAt(m_CurrentFrameIndex);
 	m_CommandBuffer->Begin(m_CurrentFrameIndex);
-	m_Swapchain->BeginRenderPass(m_ActiveCommandBuffer, m_NextFrameIndex);
+	// the frame's previous gpu times are available now that its fence has been signaled
+	m_GpuProfiler->BeginFrame(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+
+	// the uniforms and lights of this frame are only written after its fence has been signaled
+	UpdateUniformBuffers(m_CurrentFrameIndex);
+	// the culling passes and the shadow maps have to be recorded outside of the render passes
+	m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Meshlet culling");
+	m_BackpackModel->CullMeshlets(m_ActiveCommandBuffer, m_CurrentFrameIndex, CullingPhase::EARLY);
+	m_CerberusModel->CullMeshlets(m_ActiveCommandBuffer, m_CurrentFrameIndex, CullingPhase::EARLY);
+	m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+	m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Light culling");
+	m_LightClusters->Cull(m_ActiveCommandBuffer, m_CurrentFrameIndex);
+	m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+	m_GpuProfiler->BeginScope(m_ActiveCommandBuffer, "Shadows");
+	m_ShadowMaps->Render(m_ActiveCommandBuffer, m_ShadowCasters, *m_GpuProfiler);
+	m_GpuProfiler->EndScope(m_ActiveCommandBuffer);
+	m_OverdrawStats->Reset(m_ActiveCommandBuffer, m_CurrentFrameIndex);
 }
 
 void Renderer::EndScene()
 {
-	m_Swapchain->EndRenderPass(m_ActiveCommandBuffer);
+	PROFILE_FUNCTION();
 	m_CommandBuffer->End(m_CurrentFrameIndex);
 
-	std::array<VkPipelineStageFlags, 1> waitStages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
-	m_CommandBuffer->Submit(m_InFlightFences[m_CurrentFrameIndex],
-		&m_ImageAvailableSemaphores[m_CurrentFrameIndex], // wait on this semaphore
-		1,
-		&m_RenderFinishedSemaphores[m_CurrentFrameIndex], // signal this semaphore
-		1,
-		waitStages.data(),
-		m_CurrentFrameIndex);
+	{
+		PROFILE_SCOPE("Submit");
+		std::array<VkPipelineStageFlags, 1> waitStages{ VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT };
+		m_CommandBuffer->Submit(m_InFlightFences[m_CurrentFrameIndex],
+			&m_ImageAvailableSemaphores[m_CurrentFrameIndex], // wait on this semaphore
+			1,
+			&m_RenderFinishedSemaphores[m_CurrentFrameIndex], // signal this semaphore
+			1,
+			waitStages.data(),
+			m_CurrentFrameIndex);
+	}
 
-	m_Swapchain->Present(&m_RenderFinishedSemaphores[m_CurrentFrameIndex], // wait on this semaphore
-		1,
-		&m_NextFrameIndex);
+	{
+		PROFILE_SCOPE("Present");
+		m_Swapchain->Present(&m_RenderFinishedSemaphores[m_CurrentFrameIndex], // wait on this semaphore
+			1,
+			&m_NextFrameIndex);
+	}
 
 	// update current frame index
 	m_CurrentFrameIndex = (m_CurrentFrameIndex + 1) % m_Config.maxFramesInFlight;
 }
 
+void Renderer::GenerateLights(uint32_t lightCount)
+{
+	m_Lights.resize(lightCount);
+	m_LightOrbits.resize(lightCount);
+
+	// same seed so that every run (and every light count) uses the same lights
+	std::mt19937 rng{ 42 };
+	std::uniform_real_distribution<float> dist{ 0.0f, 1.0f };
+
+	// the orbiting light that is shown by the light cube
+	m_Lights[0].position = glm::vec4(0.0f, 0.0f, 0.0f, 10.0f);
+	m_Lights[0].color = glm::vec4(1.0f);
+	m_LightOrbits[0] = glm::vec4(1.5f, 0.0f, 0.0f, 1.0f);
+
+	for (uint32_t i = 1; i < lightCount; ++i)
+	{
+		float radius = 0.5f + 0.5f * dist(rng);
+		m_Lights[i].position = glm::vec4(0.0f, 0.0f, 0.0f, radius);
+		m_Lights[i].color = glm::vec4(dist(rng), dist(rng), dist(rng), 1.0f);
+		m_LightOrbits[i] = glm::vec4(0.5f + 4.5f * dist(rng),
+			-1.5f + 3.0f * dist(rng),
+			glm::two_pi<float>() * dist(rng),
+			(dist(rng) - 0.5f) * 2.0f);
+	}
+}
+
+void Renderer::AnimateLights(float time)
+{
+	// every light orbits around the y-axis
+	for (size_t i = 0; i < m_Lights.size(); ++i)
+	{
+		const glm::vec4& orbit = m_LightOrbits[i];
+		float angle = orbit.z + orbit.w * time;
+		m_Lights[i].position.x = orbit.x * std::sinf(angle);
+		m_Lights[i].position.y = orbit.y;
+		m_Lights[i].position.z = orbit.x * std::cosf(angle);
+	}
+}
+
 void Renderer::CreateSyncObjects()
 {
 	m_ImageAvailableSemaphores.resize(m_Config.maxFramesInFlight);
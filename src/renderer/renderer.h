@@ -1,6 +1,7 @@
 #pragma once
 
 #include <memory>
+#include <string>
 #include <vector>
 
 #include <vulkan/vulkan.h>
@@ -11,6 +12,7 @@
 #include "renderer/commandPool.h"
 #include "renderer/commandBuffer.h"
 #include "renderer/swapchain.h"
+#include "renderer/renderGraph.h"
 #include "renderer/vertexBuffer.h"
 #include "renderer/indexBuffer.h"
 #include "renderer/descriptor.h"
@@ -19,20 +21,55 @@
 #include "renderer/pipeline.h"
 #include "renderer/camera.h"
 #include "renderer/model.h"
+#include "renderer/lightClusters.h"
+#include "renderer/gBuffer.h"
+#include "renderer/deferredLighting.h"
+#include "renderer/overdrawStats.h"
+#include "renderer/shadowMaps.h"
+#include "renderer/gpuProfiler.h"
+#include "renderer/hiZBuffer.h"
+#include "renderer/textureStreamer.h"
+#include "renderer/bindlessTextures.h"
+#include "renderer/materials.h"
+#include "renderer/samplerCache.h"
+#include "renderer/cameraPath.h"
 #include "editor/ubo.h"
 #include "editor/objects.h"
 
 
+// measurements of the last drawn frame
+struct FrameStats
+{
+	float cpuTime = 0.0f; // ms spent recording and submitting the frame, without waiting for the fence and the image
+	float gpuTime = 0.0f; // ms, lags a few frames behind, see `GpuProfiler`
+	// ms of the light culling and of the lit pass (forward or deferred lighting), lags like `gpuTime`
+	float lightingTime = 0.0f;
+	uint32_t drawCalls = 0;
+	uint64_t triangles = 0;
+};
+
 class Renderer
 {
 public:
+	// `window` is null in headless mode
 	Renderer(const char* title, const VulkanConfig& config, const std::shared_ptr<Window>& window);
 	~Renderer();
 
+	// `deltatime` in ms, the animations are driven by the sum of the deltatimes (not by the wall clock)
 	void Draw(float deltatime, uint32_t fpsCount);
+	// the camera follows the given poses and ignores the input from then on (eg: benchmark camera path)
+	void SetCameraPose(const CameraPose& pose);
+	// `lightCount` >= 1, the lights are generated again if it changes (eg: the light counts of a benchmark)
+	void SetLightCount(uint32_t lightCount);
+	// headless only, writes the last drawn frame to a png
+	void SaveFrame(const std::string& path);
 	void OnResize(int width, int height);
 	void OnMouseMove(double xpos, double ypos);
 
+	inline const FrameStats& GetFrameStats() const { return m_FrameStats; }
+	inline uint32_t GetWidth() const { return m_Swapchain->GetWidth(); }
+	inline uint32_t GetHeight() const { return m_Swapchain->GetHeight(); }
+
 	void BeginScene();
 	void EndScene();
 
@@ -41,7 +78,22 @@ private:
 	void Cleanup();
 
 	void CreateSyncObjects();
+	void GenerateLights(uint32_t lightCount);
+	void AnimateLights(float time);
 	void UpdateUniformBuffers(uint32_t currentFrameIndex);
+	glm::vec3 GetSunDirection() const;
+	// the late phase only draws the models, the meshlets that were disoccluded this frame
+	void DrawScene(DrawPass drawPass, CullingPhase phase = CullingPhase::EARLY);
+	// the forward passes of the scene (with the depth pre-pass if it is enabled)
+	void DrawForward(CullingPhase phase);
+	// declares the passes of the frame after `BeginScene()` (the swapchain image has been acquired) and compiles them
+	void BuildRenderGraph(uint32_t fpsCount);
+	// the light cube, the frame stats and the ui, at the end of the last pass of the swapchain render pass
+	void DrawOverlays(uint32_t fpsCount);
+	inline bool IsOcclusionCullingActive() const
+	{
+		return m_OcclusionCulling && m_MeshletCulling && !m_DeferredShading;
+	}
 	void OnUIRender(uint32_t fpsCount);
 
 private:
@@ -53,16 +105,57 @@ private:
 	std::shared_ptr<CommandPool> m_CommandPool{};
 
 	std::unique_ptr<Swapchain> m_Swapchain{};
+	// the passes of the frame after the culling and the shadows, owns the attachments of the swapchain render pass and
+	// of the g-buffer
+	std::unique_ptr<RenderGraph> m_RenderGraph{};
+	std::unique_ptr<LightClusters> m_LightClusters{};
+	std::unique_ptr<ShadowMaps> m_ShadowMaps{};
+	std::unique_ptr<GBuffer> m_GBuffer{};
+	std::unique_ptr<DeferredLighting> m_DeferredLighting{};
+	std::unique_ptr<OverdrawStats> m_OverdrawStats{};
+	std::unique_ptr<GpuProfiler> m_GpuProfiler{};
+	std::unique_ptr<HiZBuffer> m_HiZBuffer{};
+	// the textures of the models and the cube, the streamed ones are destroyed before the streamer
+	std::unique_ptr<Materials> m_Materials{};
+	std::unique_ptr<BindlessTextures> m_BindlessTextures{};
+	std::unique_ptr<TextureStreamer> m_TextureStreamer{};
 
 	std::unique_ptr<Model> m_BackpackModel{};
 	std::unique_ptr<Model> m_CerberusModel{};
 	std::unique_ptr<Cube> m_Cube{};
 	std::unique_ptr<LightCube> m_LightCube{};
+	// the backpack, cerberus and the cube, in the order of their dynamic uniform buffer offsets
+	std::vector<ShadowCaster> m_ShadowCasters{};
 
 	UniformBufferObject m_Ubo{};
 	DynamicUniformBufferObject m_DUbo{};
 	LightCubeUBO m_LightCubeUbo{};
 
+	// the models are either shaded while they are drawn (forward)
+	// or drawn into the g-buffer and shaded in a fullscreen pass (deferred)
+	bool m_DeferredShading = false;
+	// forward path only, the depth is laid down first so that only the visible fragments are shaded
+	bool m_DepthPrepass = false;
+	// error of the model lods on the screen in pixels, 0 draws the full resolution meshes
+	float m_LodPixelError = LOD_MAX_PIXEL_ERROR;
+	// the meshlets of the models are culled against the view frustum and their normal cones on the gpu
+	bool m_MeshletCulling = true;
+	// forward path only, the meshlets are also culled against the hi-z pyramid of the depth drawn so far
+	bool m_OcclusionCulling = true;
+
+	// light 0 is the orbiting light shown by the light cube
+	int m_LightCount = 1;
+	std::vector<PointLight> m_Lights{};
+	std::vector<glm::vec4> m_LightOrbits{}; // x = orbit radius, y = height, z = phase, w = angular speed
+
+	// directional light, in degrees
+	float m_SunAzimuth{ 30.0f };
+	float m_SunElevation{ 55.0f };
+	float m_SunIntensity{ 0.5f };
+	bool m_Shadows = true;
+
+	int m_CaptureFrameCount = 60; // frames of a cpu profiler capture
+
 	// uniform values to be displayed in the ui
 	glm::vec3 m_BackpackPos{ -1.0f, 0.0f, 0.0f };
 	float m_BackpackRotateX{ 0.0f };
@@ -87,6 +180,11 @@ private:
 	std::vector<VkFence> m_InFlightFences{};
 
 	std::unique_ptr<Camera> m_Camera{};
+	bool m_ScriptedCamera = false;
+
+	float m_Time = 0.0f; // s, animation time
+	FrameStats m_FrameStats{};
+	float m_WaitTime = 0.0f; // ms spent waiting for the fence and the swapchain image in the current frame
 
 	VkCommandBuffer m_ActiveCommandBuffer{};
 	uint32_t m_CurrentFrameIndex = 0;
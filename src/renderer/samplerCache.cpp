@@ -0,0 +1,83 @@
+#include "renderer/samplerCache.h"
+
+#include <cstring>
+#include <functional>
+#include "core/core.h"
+#include "renderer/device.h"
+
+
+std::unordered_map<SamplerCache::Key, VkSampler, SamplerCache::KeyHash> SamplerCache::s_Samplers{};
+
+// the floats are compared by their bits, the same settings always have the same bits
+template<typename T>
+static uint32_t ToBits(T value)
+{
+	static_assert(sizeof(T) == sizeof(uint32_t));
+	uint32_t bits = 0;
+	std::memcpy(&bits, &value, sizeof(bits));
+	return bits;
+}
+
+static void HashCombine(size_t& seed, uint32_t value)
+{
+	seed ^= std::hash<uint32_t>{}(value) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+bool SamplerCache::Key::operator==(const Key& other) const
+{
+	const VkSamplerCreateInfo& a = info;
+	const VkSamplerCreateInfo& b = other.info;
+	return a.flags == b.flags && a.magFilter == b.magFilter && a.minFilter == b.minFilter
+		   && a.mipmapMode == b.mipmapMode && a.addressModeU == b.addressModeU && a.addressModeV == b.addressModeV
+		   && a.addressModeW == b.addressModeW && ToBits(a.mipLodBias) == ToBits(b.mipLodBias)
+		   && a.anisotropyEnable == b.anisotropyEnable && ToBits(a.maxAnisotropy) == ToBits(b.maxAnisotropy)
+		   && a.compareEnable == b.compareEnable && a.compareOp == b.compareOp && ToBits(a.minLod) == ToBits(b.minLod)
+		   && ToBits(a.maxLod) == ToBits(b.maxLod) && a.borderColor == b.borderColor
+		   && a.unnormalizedCoordinates == b.unnormalizedCoordinates;
+}
+
+size_t SamplerCache::KeyHash::operator()(const Key& key) const
+{
+	const VkSamplerCreateInfo& info = key.info;
+	size_t seed = 0;
+	HashCombine(seed, info.flags);
+	HashCombine(seed, info.magFilter);
+	HashCombine(seed, info.minFilter);
+	HashCombine(seed, info.mipmapMode);
+	HashCombine(seed, info.addressModeU);
+	HashCombine(seed, info.addressModeV);
+	HashCombine(seed, info.addressModeW);
+	HashCombine(seed, ToBits(info.mipLodBias));
+	HashCombine(seed, info.anisotropyEnable);
+	HashCombine(seed, ToBits(info.maxAnisotropy));
+	HashCombine(seed, info.compareEnable);
+	HashCombine(seed, info.compareOp);
+	HashCombine(seed, ToBits(info.minLod));
+	HashCombine(seed, ToBits(info.maxLod));
+	HashCombine(seed, info.borderColor);
+	HashCombine(seed, info.unnormalizedCoordinates);
+	return seed;
+}
+
+void SamplerCache::Cleanup()
+{
+	for (const auto& [key, sampler] : s_Samplers)
+		vkDestroySampler(Device::GetDevice(), sampler, nullptr);
+	s_Samplers.clear();
+}
+
+VkSampler SamplerCache::Get(const VkSamplerCreateInfo& samplerInfo)
+{
+	THROW(samplerInfo.pNext != nullptr, "The sampler cache doesn't support sampler create infos with a pNext chain!")
+
+	Key key{ samplerInfo };
+	auto it = s_Samplers.find(key);
+	if (it != s_Samplers.end())
+		return it->second;
+
+	VkSampler sampler{};
+	THROW(vkCreateSampler(Device::GetDevice(), &samplerInfo, nullptr, &sampler) != VK_SUCCESS,
+		"Failed to create sampler!")
+	s_Samplers.emplace(key, sampler);
+	return sampler;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <unordered_map>
+#include <vulkan/vulkan.h>
+
+
+// the samplers of the renderer, one per distinct `VkSamplerCreateInfo`: the objects that create samplers with the same
+// settings share them, which bounds their count (see `maxSamplerAllocationCount`) and makes repeated creations a
+// hash lookup
+// the samplers are owned by the cache, they are destroyed by `Cleanup()` (after everything that uses them)
+class SamplerCache
+{
+public:
+	static void Cleanup();
+	// creates the sampler the first time its settings are seen, the create info can't have a `pNext` chain
+	static VkSampler Get(const VkSamplerCreateInfo& samplerInfo);
+
+	static inline uint32_t GetCount() { return static_cast<uint32_t>(s_Samplers.size()); }
+
+private:
+	// the settings of a sampler without `sType` and `pNext`
+	struct Key
+	{
+		VkSamplerCreateInfo info;
+
+		bool operator==(const Key& other) const;
+	};
+
+	struct KeyHash
+	{
+		size_t operator()(const Key& key) const;
+	};
+
+private:
+	static std::unordered_map<Key, VkSampler, KeyHash> s_Samplers;
+};
@@ -11,6 +11,12 @@ enum class ShaderType
 	COMPUTE = VK_SHADER_STAGE_COMPUTE_BIT
 };
 
+// used to make a descriptor visible to more than one shader stage
+inline ShaderType operator|(ShaderType lhs, ShaderType rhs)
+{
+	return static_cast<ShaderType>(static_cast<uint32_t>(lhs) | static_cast<uint32_t>(rhs));
+}
+
 class Shader
 {
 public:
@@ -0,0 +1,651 @@
+#include "renderer/shadowMaps.h"
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+#include <glm/gtc/matrix_transform.hpp>
+#include "core/core.h"
+#include "renderer/device.h"
+#include "renderer/samplerCache.h"
+#include "utils/utils.h"
+
+
+// cascades cover the view frustum up to this distance, there are no sun shadows beyond it
+constexpr float SHADOW_DISTANCE = 25.0f;
+// the first split starts here even if the camera's near plane is closer, otherwise the first cascade gets tiny
+constexpr float SHADOW_MIN_DEPTH = 0.1f;
+// blend between logarithmic (1.0) and uniform (0.0) split distances
+constexpr float SHADOW_SPLIT_LAMBDA = 0.75f;
+// a cascade covers its slice with this margin, so that it doesn't have to move (and be re-rendered) every frame
+constexpr float CASCADE_CACHE_MARGIN = 1.25f;
+// the cascades extend towards the light by this distance to include the casters outside of the slice
+constexpr float SHADOW_CASTER_DISTANCE = 20.0f;
+constexpr float POINT_SHADOW_NEAR = 0.05f;
+// the receivers are offset along their normal by this many texels to avoid shadow acne
+constexpr float SHADOW_NORMAL_OFFSET = 1.5f;
+constexpr float SHADOW_DEPTH_BIAS_CONSTANT = 1.25f;
+constexpr float SHADOW_DEPTH_BIAS_SLOPE = 1.75f;
+
+// gpu profiler scope of each cascade
+constexpr std::array<const char*, SHADOW_CASCADE_COUNT> CASCADE_SCOPE_NAMES{
+	"Cascade 0",
+	"Cascade 1",
+	"Cascade 2",
+	"Cascade 3",
+};
+static_assert(SHADOW_CASCADE_COUNT == 4, "a scope name is needed for every cascade");
+
+// bounding box of the transformed box
+static void TransformBounds(const glm::mat4& mat,
+	const glm::vec3& boundsMin,
+	const glm::vec3& boundsMax,
+	glm::vec3& outMin,
+	glm::vec3& outMax)
+{
+	outMin = glm::vec3(std::numeric_limits<float>::max());
+	outMax = glm::vec3(std::numeric_limits<float>::lowest());
+	for (uint32_t i = 0; i < 8; ++i)
+	{
+		glm::vec3 corner{ i & 1 ? boundsMax.x : boundsMin.x,
+			i & 2 ? boundsMax.y : boundsMin.y,
+			i & 4 ? boundsMax.z : boundsMin.z };
+		glm::vec3 transformed = glm::vec3(mat * glm::vec4(corner, 1.0f));
+		outMin = glm::min(outMin, transformed);
+		outMax = glm::max(outMax, transformed);
+	}
+}
+
+
+ShadowMaps::ShadowMaps(const uint32_t maxFramesInFlight)
+{
+	m_DepthFormat = Device::FindSupportedFormat({ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D16_UNORM },
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
+
+	// the compare sampler filters the results of the 4 nearest texels if the format supports linear filtering
+	VkFormatProperties formatProperties{};
+	vkGetPhysicalDeviceFormatProperties(Device::GetPhysicalDevice(), m_DepthFormat, &formatProperties);
+	if (!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT))
+		m_Filter = VK_FILTER_NEAREST;
+
+	CreateRenderPass();
+	CreateImages();
+	CreateFramebuffers();
+	CreateSampler();
+	CreatePipeline();
+
+	VkDeviceSize uboSize = sizeof(ShadowUBO);
+	m_UniformBuffers.reserve(maxFramesInFlight);
+	for (uint64_t i = 0; i < maxFramesInFlight; ++i)
+	{
+		m_UniformBuffers.emplace_back(
+			uboSize, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT, uboSize);
+	}
+
+	std::vector<VkDescriptorBufferInfo> uniformBufferInfos = UniformBuffer::GetBufferInfos(m_UniformBuffers);
+	VkDescriptorImageInfo cascadeImageInfo{ m_Sampler, m_CascadeArrayView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+	VkDescriptorImageInfo cubeImageInfo{ m_Sampler, m_CubeView, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+
+	m_DescriptorSet = std::make_unique<DescriptorSet>(maxFramesInFlight);
+	m_DescriptorSet->SetupLayout({
+		DescriptorSet::CreateLayout( //
+			DescriptorType::UNIFORM_BUFFER,
+			ShaderType::FRAGMENT,
+			0,
+			1,
+			uniformBufferInfos.data(),
+			nullptr), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::COMBINED_IMAGE_SAMPLER,
+			ShaderType::FRAGMENT,
+			1,
+			1,
+			nullptr,
+			&cascadeImageInfo,
+			0,
+			&m_Sampler), //
+		DescriptorSet::CreateLayout( //
+			DescriptorType::COMBINED_IMAGE_SAMPLER,
+			ShaderType::FRAGMENT,
+			2,
+			1,
+			nullptr,
+			&cubeImageInfo,
+			0,
+			&m_Sampler), //
+	});
+	m_DescriptorSet->Create();
+
+	SetSun(glm::vec3(-0.5f, -1.0f, -0.3f), glm::vec3(1.0f), 0.5f);
+}
+
+ShadowMaps::~ShadowMaps()
+{
+	VkDevice device = Device::GetDevice();
+
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+	{
+		vkDestroyFramebuffer(device, m_CascadeFramebuffers[i], nullptr);
+		vkDestroyImageView(device, m_CascadeLayerViews[i], nullptr);
+	}
+	vkDestroyImageView(device, m_CascadeArrayView, nullptr);
+	vkDestroyImage(device, m_CascadeImage, nullptr);
+	utils::FreeMemory(m_CascadeMemory);
+
+	for (uint32_t i = 0; i < CUBE_FACE_COUNT; ++i)
+	{
+		vkDestroyFramebuffer(device, m_CubeFramebuffers[i], nullptr);
+		vkDestroyImageView(device, m_CubeFaceViews[i], nullptr);
+	}
+	vkDestroyImageView(device, m_CubeView, nullptr);
+	vkDestroyImage(device, m_CubeImage, nullptr);
+	utils::FreeMemory(m_CubeMemory);
+
+	m_Pipeline.reset();
+	m_CompactPipeline.reset();
+	vkDestroyPipelineLayout(device, m_PipelineLayout, nullptr);
+	vkDestroyRenderPass(device, m_RenderPass, nullptr);
+}
+
+void ShadowMaps::SetSun(const glm::vec3& direction, const glm::vec3& color, float intensity)
+{
+	m_Ubo.sunColor = glm::vec4(color, intensity);
+
+	glm::vec3 sunDirection = glm::normalize(direction);
+	if (sunDirection == m_SunDirection)
+		return;
+
+	// the cascades are fitted in the light's view space, all of them have to be refitted
+	m_SunDirection = sunDirection;
+	glm::vec3 up = std::abs(m_SunDirection.y) > 0.99f ? glm::vec3(0.0f, 0.0f, 1.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+	m_LightViewMat = glm::lookAt(glm::vec3(0.0f), m_SunDirection, up);
+	for (auto& cascade : m_Cascades)
+		cascade.valid = false;
+}
+
+void ShadowMaps::SetEnabled(bool enable)
+{
+	// the shadow maps are not updated while disabled
+	if (enable && !m_Enabled)
+	{
+		for (auto& cascade : m_Cascades)
+			cascade.dirty = true;
+		m_PointShadowDirty = true;
+	}
+
+	m_Enabled = enable;
+}
+
+void ShadowMaps::Update(const Camera& camera,
+	const std::vector<ShadowCaster>& casters,
+	const PointLight& pointLight,
+	const uint32_t currentFrameIndex)
+{
+	UpdateCascades(camera);
+
+	glm::vec3 pointLightPos = glm::vec3(pointLight.position);
+	float pointLightRadius = pointLight.position.w;
+	if (pointLightPos != m_PointLightPos || pointLightRadius != m_PointLightRadius)
+	{
+		m_PointLightPos = pointLightPos;
+		m_PointLightRadius = pointLightRadius;
+		m_PointShadowDirty = true;
+
+		// the faces have to match the cube map face orientations, +x, -x, +y, -y, +z, -z
+		// the y is not flipped, the face images are addressed top to bottom like the framebuffer
+		const std::array<glm::vec3, CUBE_FACE_COUNT> faceDirections{
+			glm::vec3(1.0f, 0.0f, 0.0f),
+			glm::vec3(-1.0f, 0.0f, 0.0f),
+			glm::vec3(0.0f, 1.0f, 0.0f),
+			glm::vec3(0.0f, -1.0f, 0.0f),
+			glm::vec3(0.0f, 0.0f, 1.0f),
+			glm::vec3(0.0f, 0.0f, -1.0f),
+		};
+		const std::array<glm::vec3, CUBE_FACE_COUNT> faceUps{
+			glm::vec3(0.0f, -1.0f, 0.0f),
+			glm::vec3(0.0f, -1.0f, 0.0f),
+			glm::vec3(0.0f, 0.0f, 1.0f),
+			glm::vec3(0.0f, 0.0f, -1.0f),
+			glm::vec3(0.0f, -1.0f, 0.0f),
+			glm::vec3(0.0f, -1.0f, 0.0f),
+		};
+
+		// zero to one depth explicitly, `GLM_FORCE_DEPTH_ZERO_TO_ONE` is only defined in core.cpp and `PointShadow()`
+		// compares against a [0, 1] reference
+		glm::mat4 projMat = glm::perspectiveRH_ZO(glm::radians(90.0f), 1.0f, POINT_SHADOW_NEAR, m_PointLightRadius);
+		for (uint32_t i = 0; i < CUBE_FACE_COUNT; ++i)
+		{
+			m_CubeFaceViewProjMats[i] =
+				projMat * glm::lookAt(m_PointLightPos, m_PointLightPos + faceDirections[i], faceUps[i]);
+		}
+	}
+
+	UpdateCasterBounds(casters);
+
+	m_Ubo.viewMat = camera.GetViewMatrix();
+	m_Ubo.sunDirection = glm::vec4(m_SunDirection, 0.0f);
+	m_Ubo.pointLightPos = glm::vec4(m_PointLightPos, m_PointLightRadius);
+	m_Ubo.shadowParams = glm::vec4(m_Enabled ? 1.0f : 0.0f, POINT_SHADOW_NEAR, SHADOW_NORMAL_OFFSET, 0.0f);
+	m_UniformBuffers[currentFrameIndex].Map(&m_Ubo);
+}
+
+void ShadowMaps::UpdateCascades(const Camera& camera)
+{
+	float zNear = std::max(camera.GetZNear(), SHADOW_MIN_DEPTH);
+	float zFar = SHADOW_DISTANCE;
+	glm::mat4 invViewMat = glm::inverse(camera.GetViewMatrix());
+	float tanHalfFovy = std::tanf(camera.GetFOVy() * 0.5f);
+	float aspectRatio = camera.GetAspectRatio();
+
+	float sliceNear = zNear;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+	{
+		float p = static_cast<float>(i + 1) / static_cast<float>(SHADOW_CASCADE_COUNT);
+		float logSplit = zNear * std::pow(zFar / zNear, p);
+		float uniformSplit = zNear + (zFar - zNear) * p;
+		float sliceFar = SHADOW_SPLIT_LAMBDA * logSplit + (1.0f - SHADOW_SPLIT_LAMBDA) * uniformSplit;
+		m_Ubo.cascadeSplits[i] = sliceFar;
+
+		// world space corners of the slice
+		std::array<glm::vec3, 8> corners{};
+		glm::vec3 center{ 0.0f };
+		for (uint32_t j = 0; j < 8; ++j)
+		{
+			float depth = j & 4 ? sliceFar : sliceNear;
+			float x = (j & 1 ? 1.0f : -1.0f) * depth * tanHalfFovy * aspectRatio;
+			float y = (j & 2 ? 1.0f : -1.0f) * depth * tanHalfFovy;
+			corners[j] = glm::vec3(invViewMat * glm::vec4(x, y, -depth, 1.0f));
+			center += corners[j];
+		}
+		center /= 8.0f;
+
+		// the bounding sphere of the slice keeps its size when the camera rotates
+		float radius = 0.0f;
+		for (const auto& corner : corners)
+			radius = std::max(radius, glm::length(corner - center));
+		radius = std::ceil(radius * 16.0f) / 16.0f;
+
+		// the cascade is only moved when the slice is no longer inside of it
+		Cascade& cascade = m_Cascades[i];
+		glm::vec3 lightSpaceCenter = glm::vec3(m_LightViewMat * glm::vec4(center, 1.0f));
+		glm::vec3 extent = glm::abs(lightSpaceCenter - cascade.center) + radius;
+		bool contained = cascade.valid && extent.x <= cascade.halfExtent && extent.y <= cascade.halfExtent
+						 && extent.z <= cascade.halfExtent;
+
+		if (!contained)
+		{
+			cascade.halfExtent = radius * CASCADE_CACHE_MARGIN;
+			// snapped to the texels so that the shadow edges don't shift when the cascade moves
+			float texelSize = 2.0f * cascade.halfExtent / static_cast<float>(SHADOW_CASCADE_RESOLUTION);
+			cascade.center = lightSpaceCenter;
+			cascade.center.x = std::floor(cascade.center.x / texelSize) * texelSize;
+			cascade.center.y = std::floor(cascade.center.y / texelSize) * texelSize;
+
+			// the light looks down -z, the casters between the light and the slice are towards +z
+			// zero to one depth, with [-1, 1] the near half of the caster range would be clipped
+			const glm::vec3& c = cascade.center;
+			float h = cascade.halfExtent;
+			glm::mat4 projMat =
+				glm::orthoRH_ZO(c.x - h, c.x + h, c.y - h, c.y + h, -(c.z + h + SHADOW_CASTER_DISTANCE), -(c.z - h));
+			cascade.viewProjMat = projMat * m_LightViewMat;
+			cascade.valid = true;
+			cascade.dirty = true;
+		}
+
+		m_Ubo.cascadeViewProjMats[i] = cascade.viewProjMat;
+		sliceNear = sliceFar;
+	}
+}
+
+void ShadowMaps::UpdateCasterBounds(const std::vector<ShadowCaster>& casters)
+{
+	// eg: the first update
+	if (casters.size() != m_CasterMin.size())
+	{
+		m_CasterMin.resize(casters.size());
+		m_CasterMax.resize(casters.size());
+		m_CasterGeometryVersions.resize(casters.size());
+		for (size_t i = 0; i < casters.size(); ++i)
+		{
+			TransformBounds(
+				casters[i].modelMat, casters[i].boundsMin, casters[i].boundsMax, m_CasterMin[i], m_CasterMax[i]);
+			m_CasterGeometryVersions[i] = casters[i].geometryVersion;
+		}
+
+		for (auto& cascade : m_Cascades)
+			cascade.dirty = true;
+		m_PointShadowDirty = true;
+		return;
+	}
+
+	for (size_t i = 0; i < casters.size(); ++i)
+	{
+		glm::vec3 worldMin{};
+		glm::vec3 worldMax{};
+		TransformBounds(casters[i].modelMat, casters[i].boundsMin, casters[i].boundsMax, worldMin, worldMax);
+		if (worldMin == m_CasterMin[i] && worldMax == m_CasterMax[i]
+			&& casters[i].geometryVersion == m_CasterGeometryVersions[i])
+			continue;
+
+		// the shadow maps the caster has left and the ones it has entered
+		for (uint32_t j = 0; j < SHADOW_CASCADE_COUNT; ++j)
+		{
+			if (IsInCascade(j, m_CasterMin[i], m_CasterMax[i]) || IsInCascade(j, worldMin, worldMax))
+				m_Cascades[j].dirty = true;
+		}
+		if (IsInPointLightRange(m_CasterMin[i], m_CasterMax[i]) || IsInPointLightRange(worldMin, worldMax))
+			m_PointShadowDirty = true;
+
+		m_CasterMin[i] = worldMin;
+		m_CasterMax[i] = worldMax;
+		m_CasterGeometryVersions[i] = casters[i].geometryVersion;
+	}
+}
+
+bool ShadowMaps::IsInCascade(uint32_t cascade, const glm::vec3& worldMin, const glm::vec3& worldMax) const
+{
+	glm::vec3 lightSpaceMin{};
+	glm::vec3 lightSpaceMax{};
+	TransformBounds(m_LightViewMat, worldMin, worldMax, lightSpaceMin, lightSpaceMax);
+
+	const glm::vec3& c = m_Cascades[cascade].center;
+	float h = m_Cascades[cascade].halfExtent;
+	glm::vec3 boxMin = c - h;
+	glm::vec3 boxMax = c + glm::vec3(h, h, h + SHADOW_CASTER_DISTANCE);
+
+	return lightSpaceMin.x <= boxMax.x && lightSpaceMax.x >= boxMin.x && lightSpaceMin.y <= boxMax.y
+		   && lightSpaceMax.y >= boxMin.y && lightSpaceMin.z <= boxMax.z && lightSpaceMax.z >= boxMin.z;
+}
+
+bool ShadowMaps::IsInPointLightRange(const glm::vec3& worldMin, const glm::vec3& worldMax) const
+{
+	glm::vec3 closestPoint = glm::clamp(m_PointLightPos, worldMin, worldMax);
+	glm::vec3 offset = closestPoint - m_PointLightPos;
+	return glm::dot(offset, offset) <= m_PointLightRadius * m_PointLightRadius;
+}
+
+void ShadowMaps::Render(VkCommandBuffer commandBuffer,
+	const std::vector<ShadowCaster>& casters,
+	GpuProfiler& profiler)
+{
+	m_CascadeRendered.fill(false);
+	if (!m_Enabled)
+		return;
+
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+	{
+		Cascade& cascade = m_Cascades[i];
+		if (!cascade.dirty)
+			continue;
+
+		profiler.BeginScope(commandBuffer, CASCADE_SCOPE_NAMES[i]);
+		BeginRenderPass(commandBuffer, m_CascadeFramebuffers[i], SHADOW_CASCADE_RESOLUTION);
+		for (size_t j = 0; j < casters.size(); ++j)
+		{
+			// per cascade caster culling
+			if (IsInCascade(i, m_CasterMin[j], m_CasterMax[j]))
+				DrawCaster(commandBuffer, casters[j], cascade.viewProjMat);
+		}
+		vkCmdEndRenderPass(commandBuffer);
+		profiler.EndScope(commandBuffer);
+
+		cascade.dirty = false;
+		m_CascadeRendered[i] = true;
+	}
+
+	if (!m_PointShadowDirty)
+		return;
+
+	profiler.BeginScope(commandBuffer, "Point light");
+	for (uint32_t i = 0; i < CUBE_FACE_COUNT; ++i)
+	{
+		BeginRenderPass(commandBuffer, m_CubeFramebuffers[i], POINT_SHADOW_RESOLUTION);
+		for (size_t j = 0; j < casters.size(); ++j)
+		{
+			if (IsInPointLightRange(m_CasterMin[j], m_CasterMax[j]))
+				DrawCaster(commandBuffer, casters[j], m_CubeFaceViewProjMats[i]);
+		}
+		vkCmdEndRenderPass(commandBuffer);
+	}
+	profiler.EndScope(commandBuffer);
+
+	m_PointShadowDirty = false;
+}
+
+void ShadowMaps::BeginRenderPass(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, uint32_t resolution)
+{
+	// the shadow maps use standard depth
+	VkClearValue clearValue{};
+	clearValue.depthStencil = { 1.0f, 0 };
+
+	VkViewport viewport{};
+	viewport.x = 0.0f;
+	viewport.y = 0.0f;
+	viewport.width = static_cast<float>(resolution);
+	viewport.height = static_cast<float>(resolution);
+	viewport.minDepth = 0.0f;
+	viewport.maxDepth = 1.0f;
+	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+
+	VkRect2D scissor{};
+	scissor.offset = { 0, 0 };
+	scissor.extent = { resolution, resolution };
+	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+	VkRenderPassBeginInfo renderPassBeginInfo{};
+	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassBeginInfo.renderPass = m_RenderPass;
+	renderPassBeginInfo.framebuffer = framebuffer;
+	renderPassBeginInfo.renderArea.offset = { 0, 0 };
+	renderPassBeginInfo.renderArea.extent = { resolution, resolution };
+	renderPassBeginInfo.clearValueCount = 1;
+	renderPassBeginInfo.pClearValues = &clearValue;
+	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+}
+
+void ShadowMaps::DrawCaster(VkCommandBuffer commandBuffer, const ShadowCaster& caster, const glm::mat4& viewProjMat)
+{
+	// the casters differ in their vertex layout
+	(caster.compactVertices ? m_CompactPipeline : m_Pipeline)->Bind(commandBuffer);
+	glm::mat4 mvp = viewProjMat * caster.modelMat;
+	vkCmdPushConstants(commandBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &mvp);
+	caster.draw(commandBuffer, m_PipelineLayout);
+}
+
+void ShadowMaps::CreateRenderPass()
+{
+	VkAttachmentDescription depthAttachment{};
+	depthAttachment.format = m_DepthFormat;
+	depthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	// a shadow map is always fully redrawn
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkAttachmentReference depthRef{};
+	depthRef.attachment = 0;
+	depthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = 0;
+	subpass.pDepthStencilAttachment = &depthRef;
+
+	// the previous frame's lighting has to finish reading before the shadow map is written
+	// and the lighting has to wait for the shadow map to be written
+	std::array<VkSubpassDependency, 2> subpassDependencies{};
+	subpassDependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+	subpassDependencies[0].dstSubpass = 0;
+	subpassDependencies[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	subpassDependencies[0].dstStageMask =
+		VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	subpassDependencies[0].srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	subpassDependencies[0].dstAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	subpassDependencies[1].srcSubpass = 0;
+	subpassDependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+	subpassDependencies[1].srcStageMask = VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	subpassDependencies[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+	subpassDependencies[1].srcAccessMask = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+	subpassDependencies[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = 1;
+	renderPassInfo.pAttachments = &depthAttachment;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = static_cast<uint32_t>(subpassDependencies.size());
+	renderPassInfo.pDependencies = subpassDependencies.data();
+
+	THROW(vkCreateRenderPass(Device::GetDevice(), &renderPassInfo, nullptr, &m_RenderPass) != VK_SUCCESS,
+		"Failed to create shadow map render pass!");
+}
+
+void ShadowMaps::CreateImages()
+{
+	uint32_t miplevels = 1;
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+
+	// cascades, one layer each
+	utils::CreateImage(SHADOW_CASCADE_RESOLUTION,
+		SHADOW_CASCADE_RESOLUTION,
+		miplevels,
+		VK_SAMPLE_COUNT_1_BIT,
+		m_DepthFormat,
+		VK_IMAGE_TILING_OPTIMAL,
+		usage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_CascadeImage,
+		m_CascadeMemory,
+		SHADOW_CASCADE_COUNT);
+
+	m_CascadeArrayView = utils::CreateImageView(m_CascadeImage,
+		m_DepthFormat,
+		VK_IMAGE_ASPECT_DEPTH_BIT,
+		miplevels,
+		VK_IMAGE_VIEW_TYPE_2D_ARRAY,
+		0,
+		SHADOW_CASCADE_COUNT);
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+	{
+		m_CascadeLayerViews[i] = utils::CreateImageView(
+			m_CascadeImage, m_DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, miplevels, VK_IMAGE_VIEW_TYPE_2D, i, 1);
+	}
+
+	// point light cube map
+	utils::CreateImage(POINT_SHADOW_RESOLUTION,
+		POINT_SHADOW_RESOLUTION,
+		miplevels,
+		VK_SAMPLE_COUNT_1_BIT,
+		m_DepthFormat,
+		VK_IMAGE_TILING_OPTIMAL,
+		usage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_CubeImage,
+		m_CubeMemory,
+		CUBE_FACE_COUNT,
+		VK_IMAGE_CREATE_CUBE_COMPATIBLE_BIT);
+
+	m_CubeView = utils::CreateImageView(m_CubeImage,
+		m_DepthFormat,
+		VK_IMAGE_ASPECT_DEPTH_BIT,
+		miplevels,
+		VK_IMAGE_VIEW_TYPE_CUBE,
+		0,
+		CUBE_FACE_COUNT);
+	for (uint32_t i = 0; i < CUBE_FACE_COUNT; ++i)
+	{
+		m_CubeFaceViews[i] = utils::CreateImageView(
+			m_CubeImage, m_DepthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, miplevels, VK_IMAGE_VIEW_TYPE_2D, i, 1);
+	}
+}
+
+void ShadowMaps::CreateFramebuffers()
+{
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = m_RenderPass;
+	framebufferInfo.attachmentCount = 1;
+	framebufferInfo.layers = 1;
+
+	framebufferInfo.width = SHADOW_CASCADE_RESOLUTION;
+	framebufferInfo.height = SHADOW_CASCADE_RESOLUTION;
+	for (uint32_t i = 0; i < SHADOW_CASCADE_COUNT; ++i)
+	{
+		framebufferInfo.pAttachments = &m_CascadeLayerViews[i];
+		THROW(vkCreateFramebuffer(Device::GetDevice(), &framebufferInfo, nullptr, &m_CascadeFramebuffers[i])
+				  != VK_SUCCESS,
+			"Failed to create shadow cascade framebuffer!")
+	}
+
+	framebufferInfo.width = POINT_SHADOW_RESOLUTION;
+	framebufferInfo.height = POINT_SHADOW_RESOLUTION;
+	for (uint32_t i = 0; i < CUBE_FACE_COUNT; ++i)
+	{
+		framebufferInfo.pAttachments = &m_CubeFaceViews[i];
+		THROW(vkCreateFramebuffer(Device::GetDevice(), &framebufferInfo, nullptr, &m_CubeFramebuffers[i]) != VK_SUCCESS,
+			"Failed to create point shadow framebuffer!")
+	}
+}
+
+void ShadowMaps::CreateSampler()
+{
+	// depth compare sampler, returns 1.0 where the fragment is lit
+	VkSamplerCreateInfo samplerInfo{};
+	samplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	samplerInfo.magFilter = m_Filter;
+	samplerInfo.minFilter = m_Filter;
+	samplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+	samplerInfo.anisotropyEnable = VK_FALSE;
+	samplerInfo.maxAnisotropy = 1.0f;
+	samplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	samplerInfo.unnormalizedCoordinates = VK_FALSE;
+	samplerInfo.compareEnable = VK_TRUE;
+	samplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	samplerInfo.mipLodBias = 0.0f;
+	samplerInfo.minLod = 0.0f;
+	samplerInfo.maxLod = 0.0f;
+
+	m_Sampler = SamplerCache::Get(samplerInfo);
+}
+
+void ShadowMaps::CreatePipeline()
+{
+	// the caster's light space transform is pushed per draw, followed by the vertex decode of each mesh
+	static_assert(VERTEX_DECODE_PUSH_CONSTANT_OFFSET == sizeof(glm::mat4));
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = sizeof(glm::mat4) + sizeof(VertexDecode);
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 0;
+	pipelineLayoutInfo.pushConstantRangeCount = 1;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	THROW(vkCreatePipelineLayout(Device::GetDevice(), &pipelineLayoutInfo, nullptr, &m_PipelineLayout) != VK_SUCCESS,
+		"Failed to create shadow map pipeline layout!");
+
+	PipelineConfig config{};
+	config.vertexLayout = VertexLayout::POSITION;
+	// the cube map faces are not y-flipped, so the winding differs between the passes
+	config.cullMode = VK_CULL_MODE_NONE;
+	config.msaa = false;
+	config.cameraDepth = false;
+	config.colorAttachmentCount = 0;
+	config.depthBiasConstant = SHADOW_DEPTH_BIAS_CONSTANT;
+	config.depthBiasSlope = SHADOW_DEPTH_BIAS_SLOPE;
+	m_Pipeline = std::make_unique<Pipeline>(
+		"assets/shaders/shadow.vert.spv", nullptr, m_PipelineLayout, m_RenderPass, config);
+	config.vertexLayout = VertexLayout::COMPACT_POSITION;
+	m_CompactPipeline = std::make_unique<Pipeline>(
+		"assets/shaders/shadow.vert.spv", nullptr, m_PipelineLayout, m_RenderPass, config);
+}
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <memory>
+#include <functional>
+#include <vulkan/vulkan.h>
+#include <glm/glm.hpp>
+#include "renderer/uniformBuffer.h"
+#include "renderer/descriptor.h"
+#include "renderer/pipeline.h"
+#include "renderer/camera.h"
+#include "renderer/gpuProfiler.h"
+#include "editor/ubo.h"
+
+
+constexpr uint32_t SHADOW_CASCADE_RESOLUTION = 2048;
+constexpr uint32_t POINT_SHADOW_RESOLUTION = 1024;
+constexpr uint32_t CUBE_FACE_COUNT = 6;
+
+// an object that is drawn into the shadow maps
+struct ShadowCaster
+{
+	glm::mat4 modelMat{ 1.0f };
+	// object space bounding box
+	glm::vec3 boundsMin{ 0.0f };
+	glm::vec3 boundsMax{ 0.0f };
+	// position only stream of `CompactVertex`es, drawn with the compact shadow pipeline
+	bool compactVertices = false;
+	// changes when the caster draws other geometry, eg: another lod, the cached shadow maps are then rendered again
+	uint64_t geometryVersion = 0;
+	// binds the position only stream, pushes the vertex decode (see `VertexDecode`) and draws
+	// the shadow pipeline is already bound
+	std::function<void(VkCommandBuffer, VkPipelineLayout)> draw{};
+};
+
+// shadows of the sun (directional light) and of the orbiting point light (light 0)
+// the sun uses cascaded shadow maps, the view frustum up to the shadow distance is split into
+// `SHADOW_CASCADE_COUNT` slices, each covered by an orthographic projection (a layer of a depth array image)
+// the point light uses a depth cube map
+//
+// the cascades are cached, a cascade's projection covers its slice with some margin and is only moved
+// when the slice leaves it, so a cascade is only re-rendered when it is moved or when a caster inside it moves
+// the casters are culled per cascade (and against the point light's radius)
+// the shadow maps use standard depth, independent of the camera's reverse-z
+//
+// the shadow data is exposed as a shared descriptor set (set 2) of the lit pipelines
+// binding 0: `ShadowUBO`
+// binding 1: cascades (sampler2DArrayShadow)
+// binding 2: point light cube map (samplerCubeShadow)
+class ShadowMaps
+{
+public:
+	ShadowMaps(const uint32_t maxFramesInFlight);
+	~ShadowMaps();
+
+	// fits the cascades and finds the shadow maps that have to be re-rendered, uploads the shadow data for the frame
+	void Update(const Camera& camera,
+		const std::vector<ShadowCaster>& casters,
+		const PointLight& pointLight,
+		const uint32_t currentFrameIndex);
+	// records the shadow passes that are out of date, has to be called outside of a render pass
+	// every rendered shadow map gets its own gpu profiler scope
+	void Render(VkCommandBuffer commandBuffer, const std::vector<ShadowCaster>& casters, GpuProfiler& profiler);
+
+	// `direction` is the direction the light travels in
+	void SetSun(const glm::vec3& direction, const glm::vec3& color, float intensity);
+	void SetEnabled(bool enable);
+
+	inline bool IsEnabled() const { return m_Enabled; }
+	inline const DescriptorSet* GetDescriptorSet() const { return m_DescriptorSet.get(); }
+	// whether the cascade was re-rendered in the last `Render()`, it is cached otherwise
+	inline bool WasCascadeRendered(uint32_t cascade) const { return m_CascadeRendered[cascade]; }
+
+private:
+	void CreateRenderPass();
+	void CreateImages();
+	void CreateFramebuffers();
+	void CreateSampler();
+	void CreatePipeline();
+
+	void UpdateCascades(const Camera& camera);
+	void UpdateCasterBounds(const std::vector<ShadowCaster>& casters);
+	bool IsInCascade(uint32_t cascade, const glm::vec3& worldMin, const glm::vec3& worldMax) const;
+	bool IsInPointLightRange(const glm::vec3& worldMin, const glm::vec3& worldMax) const;
+
+	void BeginRenderPass(VkCommandBuffer commandBuffer, VkFramebuffer framebuffer, uint32_t resolution);
+	void DrawCaster(VkCommandBuffer commandBuffer, const ShadowCaster& caster, const glm::mat4& viewProjMat);
+
+private:
+	struct Cascade
+	{
+		// light space box (light view space), centered on `center` with the half extent `halfExtent`
+		glm::vec3 center{ 0.0f };
+		float halfExtent = 0.0f;
+		glm::mat4 viewProjMat{ 1.0f };
+		bool valid = false; // false until the cascade has been fitted
+		bool dirty = true;
+	};
+
+	bool m_Enabled = true;
+	glm::vec3 m_SunDirection{ 0.0f }; // set by `SetSun()`
+	glm::mat4 m_LightViewMat{ 1.0f };
+	std::array<Cascade, SHADOW_CASCADE_COUNT> m_Cascades{};
+	std::array<bool, SHADOW_CASCADE_COUNT> m_CascadeRendered{};
+
+	glm::vec3 m_PointLightPos{ 0.0f };
+	float m_PointLightRadius = 0.0f;
+	bool m_PointShadowDirty = true;
+	std::array<glm::mat4, CUBE_FACE_COUNT> m_CubeFaceViewProjMats{};
+
+	// world space bounds of the casters in the last update, to find the casters that moved
+	std::vector<glm::vec3> m_CasterMin{};
+	std::vector<glm::vec3> m_CasterMax{};
+	std::vector<uint64_t> m_CasterGeometryVersions{};
+
+	ShadowUBO m_Ubo{};
+	std::vector<UniformBuffer> m_UniformBuffers{};
+	std::unique_ptr<DescriptorSet> m_DescriptorSet{};
+
+	VkFormat m_DepthFormat{};
+	VkFilter m_Filter = VK_FILTER_LINEAR;
+	VkRenderPass m_RenderPass{};
+	VkPipelineLayout m_PipelineLayout{};
+	std::unique_ptr<Pipeline> m_Pipeline{};
+	std::unique_ptr<Pipeline> m_CompactPipeline{};
+	VkSampler m_Sampler{}; // owned by the `SamplerCache`
+
+	VkImage m_CascadeImage{};
+	VkDeviceMemory m_CascadeMemory{};
+	VkImageView m_CascadeArrayView{}; // sampled
+	std::array<VkImageView, SHADOW_CASCADE_COUNT> m_CascadeLayerViews{}; // rendered to
+	std::array<VkFramebuffer, SHADOW_CASCADE_COUNT> m_CascadeFramebuffers{};
+
+	VkImage m_CubeImage{};
+	VkDeviceMemory m_CubeMemory{};
+	VkImageView m_CubeView{}; // sampled
+	std::array<VkImageView, CUBE_FACE_COUNT> m_CubeFaceViews{}; // rendered to
+	std::array<VkFramebuffer, CUBE_FACE_COUNT> m_CubeFramebuffers{};
+};
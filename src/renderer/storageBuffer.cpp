@@ -0,0 +1,74 @@
+#include "renderer/storageBuffer.h"
+
+#include "renderer/device.h"
+#include "utils/utils.h"
+
+
+StorageBuffer::StorageBuffer(VkDeviceSize size, VkMemoryPropertyFlags properties, VkBufferUsageFlags usage)
+	: m_BufferSize{ size }
+{
+	utils::CreateBuffer(m_BufferSize,
+		VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | usage,
+		properties,
+		m_StorageBuffer,
+		m_StorageBufferMemory);
+
+	// device local buffers are only written by the gpu
+	if (properties & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT)
+		vkMapMemory(Device::GetDevice(), m_StorageBufferMemory, 0, m_BufferSize, 0, &m_StorageBufferMapped);
+
+	m_BufferInfo.buffer = m_StorageBuffer;
+	m_BufferInfo.offset = 0;
+	m_BufferInfo.range = m_BufferSize;
+}
+
+StorageBuffer::StorageBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage)
+	: m_BufferSize{ size }
+{
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMem;
+	utils::CreateBuffer(m_BufferSize,
+		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer,
+		stagingBufferMem);
+
+	void* mapped;
+	vkMapMemory(Device::GetDevice(), stagingBufferMem, 0, m_BufferSize, 0, &mapped);
+	memcpy(mapped, data, static_cast<size_t>(m_BufferSize));
+	vkUnmapMemory(Device::GetDevice(), stagingBufferMem);
+
+	utils::CreateBuffer(m_BufferSize,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | usage,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_StorageBuffer,
+		m_StorageBufferMemory);
+	utils::CopyBuffer(stagingBuffer, m_StorageBuffer, m_BufferSize);
+
+	utils::FreeMemory(stagingBufferMem);
+	vkDestroyBuffer(Device::GetDevice(), stagingBuffer, nullptr);
+
+	m_BufferInfo.buffer = m_StorageBuffer;
+	m_BufferInfo.offset = 0;
+	m_BufferInfo.range = m_BufferSize;
+}
+
+StorageBuffer::~StorageBuffer()
+{
+	if (m_StorageBufferMapped != nullptr)
+		vkUnmapMemory(Device::GetDevice(), m_StorageBufferMemory);
+
+	utils::FreeMemory(m_StorageBufferMemory);
+	vkDestroyBuffer(Device::GetDevice(), m_StorageBuffer, nullptr);
+}
+
+std::vector<VkDescriptorBufferInfo> StorageBuffer::GetBufferInfos(const std::vector<StorageBuffer>& storageBuffers)
+{
+	std::vector<VkDescriptorBufferInfo> bufferInfos{};
+	bufferInfos.reserve(storageBuffers.size());
+
+	for (const auto& storageBuffer : storageBuffers)
+		bufferInfos.push_back(storageBuffer.m_BufferInfo);
+
+	return bufferInfos;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstring>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+
+class StorageBuffer
+{
+public:
+	// `usage` is added to the storage buffer usage, eg: for buffers that are also read as index or indirect buffers
+	StorageBuffer(VkDeviceSize size, VkMemoryPropertyFlags properties, VkBufferUsageFlags usage = 0);
+	// device local buffer with `data` uploaded through a staging buffer, for data that is only read by the gpu
+	StorageBuffer(const void* data, VkDeviceSize size, VkBufferUsageFlags usage = 0);
+	~StorageBuffer();
+
+	inline VkBuffer GetBuffer() const { return m_StorageBuffer; }
+	inline VkDescriptorBufferInfo& GetBufferInfo() { return m_BufferInfo; }
+	// only valid for host visible buffers
+	inline void* GetMappedData() const { return m_StorageBufferMapped; }
+	inline void Map(const void* src, VkDeviceSize size) { memcpy(m_StorageBufferMapped, src, size); }
+
+	static std::vector<VkDescriptorBufferInfo> GetBufferInfos(const std::vector<StorageBuffer>& storageBuffers);
+
+private:
+	VkDeviceSize m_BufferSize;
+	VkDescriptorBufferInfo m_BufferInfo{};
+	VkBuffer m_StorageBuffer{};
+	VkDeviceMemory m_StorageBufferMemory{};
+	void* m_StorageBufferMapped = nullptr;
+};
@@ -1,5 +1,6 @@
 #include "renderer/swapchain.h"
 
+#include <array>
 #include <algorithm>
 #include "core/core.h"
 #include "renderer/vulkanContext.h"
@@ -13,12 +14,20 @@ Swapchain::Swapchain(const std::shared_ptr<Window>& window)
 	Init();
 }
 
+Swapchain::Swapchain(VkExtent2D extent)
+	: m_Window{ nullptr },
+	  m_SwapchainExtent{ extent }
+{
+	Init();
+}
+
 Swapchain::~Swapchain()
 {
 	Cleanup();
 	// Cleanup() is also called when recreating swapchain
 	// but we don't recreate render pass
 	vkDestroyRenderPass(Device::GetDevice(), m_RenderPass, nullptr);
+	vkDestroyRenderPass(Device::GetDevice(), m_LoadRenderPass, nullptr);
 }
 
 void Swapchain::Init()
@@ -26,35 +35,34 @@ void Swapchain::Init()
 	CreateSwapchain();
 	CreateSwapchainImageViews();
 
-	CreateRenderPass();
-	CreateColorResource();
-	CreateDepthResource();
-	CreateFramebuffers();
+	CreateRenderPass(false, m_RenderPass);
+	CreateRenderPass(true, m_LoadRenderPass);
 }
 
 void Swapchain::Cleanup()
 {
-	vkDestroyImageView(Device::GetDevice(), m_DepthImageView, nullptr);
-	vkDestroyImage(Device::GetDevice(), m_DepthImage, nullptr);
-	vkFreeMemory(Device::GetDevice(), m_DepthImageMemory, nullptr);
-
-	vkDestroyImageView(Device::GetDevice(), m_ColorImageView, nullptr);
-	vkDestroyImage(Device::GetDevice(), m_ColorImage, nullptr);
-	vkFreeMemory(Device::GetDevice(), m_ColorImageMemory, nullptr);
-
-	for (const auto& framebuffer : m_SwapchainFramebuffers)
-		vkDestroyFramebuffer(Device::GetDevice(), framebuffer, nullptr);
-
 	for (const auto& imageView : m_SwapchainImageViews)
 		vkDestroyImageView(Device::GetDevice(), imageView, nullptr);
 
+	if (IsHeadless())
+	{
+		for (size_t i = 0; i < m_SwapchainImages.size(); ++i)
+		{
+			vkDestroyImage(Device::GetDevice(), m_SwapchainImages[i], nullptr);
+			utils::FreeMemory(m_OffscreenImageMemory[i]);
+		}
+		m_SwapchainImages.clear();
+		m_OffscreenImageMemory.clear();
+		return;
+	}
+
 	// swapchain images are destroyed with `vkDestroySwapchainKHR()`
 	vkDestroySwapchainKHR(Device::GetDevice(), m_Swapchain, nullptr);
 }
 
 void Swapchain::RecreateSwapchain()
 {
-	while (m_Window->IsMinimized())
+	while (!IsHeadless() && m_Window->IsMinimized())
 	{
 		m_Window->WaitEvents();
 	}
@@ -64,13 +72,23 @@ void Swapchain::RecreateSwapchain()
 
 	CreateSwapchain();
 	CreateSwapchainImageViews();
-	CreateColorResource();
-	CreateDepthResource();
-	CreateFramebuffers();
 }
 
 VkResult Swapchain::AcquireNextImageIndex(VkSemaphore imageAvailableSemaphore, uint32_t* pImageIndex)
 {
+	if (IsHeadless())
+	{
+		*pImageIndex = m_NextOffscreenImage;
+		m_NextOffscreenImage = (m_NextOffscreenImage + 1) % HEADLESS_IMAGE_COUNT;
+
+		// the frame's submit waits on the semaphore, so it is signaled by an empty submit
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.signalSemaphoreCount = 1;
+		submitInfo.pSignalSemaphores = &imageAvailableSemaphore;
+		return vkQueueSubmit(Device::GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+	}
+
 	// acquire image from the swapchain
 	// signals the semaphore
 	return vkAcquireNextImageKHR(
@@ -79,6 +97,19 @@ VkResult Swapchain::AcquireNextImageIndex(VkSemaphore imageAvailableSemaphore, u
 
 void Swapchain::Present(const VkSemaphore* pWaitSemaphores, uint32_t waitSemaphoreCount, const uint32_t* pImageIndices)
 {
+	if (IsHeadless())
+	{
+		// nothing is presented, the semaphores are waited on so that they are unsignaled for the next use
+		std::vector<VkPipelineStageFlags> waitStages(waitSemaphoreCount, VK_PIPELINE_STAGE_ALL_COMMANDS_BIT);
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.waitSemaphoreCount = waitSemaphoreCount;
+		submitInfo.pWaitSemaphores = pWaitSemaphores;
+		submitInfo.pWaitDstStageMask = waitStages.data();
+		vkQueueSubmit(Device::GetGraphicsQueue(), 1, &submitInfo, VK_NULL_HANDLE);
+		return;
+	}
+
 	std::array<VkSwapchainKHR, 1> swapchains{ m_Swapchain };
 	VkPresentInfoKHR presentInfo{};
 	presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
@@ -92,61 +123,25 @@ void Swapchain::Present(const VkSemaphore* pWaitSemaphores, uint32_t waitSemapho
 	vkQueuePresentKHR(Device::GetPresentQueue(), &presentInfo);
 }
 
-void Swapchain::BeginRenderPass(VkCommandBuffer commandBuffer, uint32_t imageIndex)
-{
-	auto clearValues = ClearAttachmentValues();
-	SetViewport(commandBuffer);
-	SetScissor(commandBuffer);
-
-	VkRenderPassBeginInfo renderPassBeginInfo{};
-	renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassBeginInfo.renderPass = m_RenderPass;
-	renderPassBeginInfo.framebuffer = m_SwapchainFramebuffers[imageIndex];
-	renderPassBeginInfo.renderArea.offset = { 0, 0 };
-	renderPassBeginInfo.renderArea.extent = m_SwapchainExtent;
-	renderPassBeginInfo.clearValueCount = static_cast<uint32_t>(clearValues.size());
-	renderPassBeginInfo.pClearValues = clearValues.data();
-	vkCmdBeginRenderPass(commandBuffer, &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-}
-
-void Swapchain::EndRenderPass(VkCommandBuffer commandBuffer)
-{
-	vkCmdEndRenderPass(commandBuffer);
-}
-
-std::array<VkClearValue, 3> Swapchain::ClearAttachmentValues()
+std::vector<VkClearValue> Swapchain::GetClearValues() const
 {
 	// clear values for each attachment
-	std::array<VkClearValue, 3> clearValues;
+	std::vector<VkClearValue> clearValues(3);
 	clearValues[0].color = { 0.0f, 0.0f, 0.0f, 1.0f };
-	clearValues[1].depthStencil = { 1.0f, 0 };
+	clearValues[1].depthStencil = { Device::GetDepthClearValue(), 0 };
 	clearValues[2].color = clearValues[0].color;
 
 	return clearValues;
 }
 
-void Swapchain::SetScissor(VkCommandBuffer commandBuffer)
-{
-	VkRect2D scissor{};
-	scissor.offset = { 0, 0 };
-	scissor.extent = m_SwapchainExtent;
-	vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-}
-
-void Swapchain::SetViewport(VkCommandBuffer commandBuffer)
-{
-	VkViewport viewport{};
-	viewport.x = 0.0f;
-	viewport.y = 0.0f;
-	viewport.width = static_cast<float>(m_SwapchainExtent.width);
-	viewport.height = static_cast<float>(m_SwapchainExtent.height);
-	viewport.minDepth = 0.0f;
-	viewport.maxDepth = 1.0f;
-	vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-}
-
 void Swapchain::CreateSwapchain()
 {
+	if (IsHeadless())
+	{
+		CreateOffscreenImages();
+		return;
+	}
+
 	SwapchainSupportDetails swapchainSupport =
 		Device::QuerySwapchainSupport(Device::GetPhysicalDevice(), VulkanContext::GetWindowSurface());
 	VkSurfaceFormatKHR surfaceFormat = ChooseSurfaceFormat(swapchainSupport.formats);
@@ -197,6 +192,99 @@ void Swapchain::CreateSwapchain()
 	m_SwapchainExtent = extent;
 }
 
+void Swapchain::CreateOffscreenImages()
+{
+	// the same format as the window's swapchain, so that the pipelines are the same in both modes
+	m_SwapchainImageFormat = VK_FORMAT_B8G8R8A8_UNORM;
+	m_SwapchainImages.resize(HEADLESS_IMAGE_COUNT);
+	m_OffscreenImageMemory.resize(HEADLESS_IMAGE_COUNT);
+
+	for (uint32_t i = 0; i < HEADLESS_IMAGE_COUNT; ++i)
+	{
+		utils::CreateImage(m_SwapchainExtent.width,
+			m_SwapchainExtent.height,
+			1,
+			VK_SAMPLE_COUNT_1_BIT,
+			m_SwapchainImageFormat,
+			VK_IMAGE_TILING_OPTIMAL,
+			VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+			VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+			m_SwapchainImages[i],
+			m_OffscreenImageMemory[i]);
+	}
+}
+
+std::vector<uint8_t> Swapchain::ReadImage(uint32_t imageIndex)
+{
+	THROW(!IsHeadless(), "Only the offscreen images of a headless swapchain can be read!")
+
+	Device::WaitIdle();
+
+	VkDeviceSize size = static_cast<VkDeviceSize>(m_SwapchainExtent.width) * m_SwapchainExtent.height * 4;
+	VkBuffer stagingBuffer{};
+	VkDeviceMemory stagingBufferMemory{};
+	utils::CreateBuffer(size,
+		VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+		stagingBuffer,
+		stagingBufferMemory);
+
+	VkCommandBuffer commandBuffer = utils::BeginSingleTimeCommands();
+
+	// the render graph leaves the image in the transfer source layout, only the writes have to be made visible
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = m_SwapchainImages[imageIndex];
+	barrier.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		1,
+		&barrier);
+
+	VkBufferImageCopy region{};
+	region.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+	region.imageExtent = { m_SwapchainExtent.width, m_SwapchainExtent.height, 1 };
+	vkCmdCopyImageToBuffer(commandBuffer,
+		m_SwapchainImages[imageIndex],
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		stagingBuffer,
+		1,
+		&region);
+
+	utils::EndSingleTimeCommands(commandBuffer);
+
+	std::vector<uint8_t> pixels(size);
+	void* data = nullptr;
+	vkMapMemory(Device::GetDevice(), stagingBufferMemory, 0, size, 0, &data);
+	const uint8_t* bgra = static_cast<const uint8_t*>(data);
+	// bgra to rgba
+	for (VkDeviceSize i = 0; i < size; i += 4)
+	{
+		pixels[i + 0] = bgra[i + 2];
+		pixels[i + 1] = bgra[i + 1];
+		pixels[i + 2] = bgra[i + 0];
+		pixels[i + 3] = bgra[i + 3];
+	}
+	vkUnmapMemory(Device::GetDevice(), stagingBufferMemory);
+
+	vkDestroyBuffer(Device::GetDevice(), stagingBuffer, nullptr);
+	utils::FreeMemory(stagingBufferMemory);
+
+	return pixels;
+}
+
 void Swapchain::CreateSwapchainImageViews()
 {
 	m_SwapchainImageViews.resize(m_SwapchainImages.size());
@@ -208,41 +296,43 @@ void Swapchain::CreateSwapchainImageViews()
 	}
 }
 
-void Swapchain::CreateRenderPass()
+void Swapchain::CreateRenderPass(bool loadAttachments, VkRenderPass& renderPass)
 {
+	// the attachments stay in their attachment layouts, the render graph places the barriers and layout transitions
+	// around the render pass from the accesses of its passes (eg: the depth sampled by the hi-z pyramid in between)
 	// color attachment description
 	VkAttachmentDescription colorAttachment{};
 	colorAttachment.format = m_SwapchainImageFormat;
 	colorAttachment.samples = Device::GetMSAASamplesCount();
-	colorAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorAttachment.loadOp = loadAttachments ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
 	colorAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	colorAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	colorAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 	colorAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 	// depth attachment description
-	VkFormat depthFormat = FindDepthFormat();
 	VkAttachmentDescription depthAttachment{};
-	depthAttachment.format = depthFormat;
+	depthAttachment.format = FindDepthFormat();
 	depthAttachment.samples = Device::GetMSAASamplesCount();
-	depthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	depthAttachment.loadOp = loadAttachments ? VK_ATTACHMENT_LOAD_OP_LOAD : VK_ATTACHMENT_LOAD_OP_CLEAR;
 	depthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	depthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	depthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	depthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 	depthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
 
 	// color resolve attachment description (Multisample)
+	// the whole image is resolved again at the end of a render pass that continues the frame
 	VkAttachmentDescription colorResolveAttachment{};
 	colorResolveAttachment.format = m_SwapchainImageFormat;
 	colorResolveAttachment.samples = VK_SAMPLE_COUNT_1_BIT; // sample count after MSAA
-	colorResolveAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	colorResolveAttachment.loadOp = loadAttachments ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_CLEAR;
 	colorResolveAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
 	colorResolveAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
 	colorResolveAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	colorResolveAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	colorResolveAttachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+	colorResolveAttachment.initialLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	colorResolveAttachment.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
 
 	// attachment refrences
 	VkAttachmentReference colorRef{};
@@ -265,95 +355,21 @@ void Swapchain::CreateRenderPass()
 	subpass.pResolveAttachments = &colorResolveRef;
 	subpass.pDepthStencilAttachment = &depthRef;
 
-	// subpass dependency
-	VkSubpassDependency subpassDependency{};
-	subpassDependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	subpassDependency.dstSubpass = 0;
-	subpassDependency.srcStageMask =
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	subpassDependency.dstStageMask =
-		VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT;
-	subpassDependency.srcAccessMask = 0;
-	subpassDependency.dstAccessMask =
-		VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
-
 	std::array<VkAttachmentDescription, 3> attachments{ colorAttachment, depthAttachment, colorResolveAttachment };
 
 	// render pass
+	// no subpass dependencies, the barriers of the render graph are recorded outside of the render pass
 	VkRenderPassCreateInfo renderPassInfo{};
 	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
 	renderPassInfo.attachmentCount = static_cast<uint32_t>(attachments.size());
 	renderPassInfo.pAttachments = attachments.data();
 	renderPassInfo.subpassCount = 1;
 	renderPassInfo.pSubpasses = &subpass;
-	renderPassInfo.dependencyCount = 1;
-	renderPassInfo.pDependencies = &subpassDependency;
 
-	THROW(vkCreateRenderPass(Device::GetDevice(), &renderPassInfo, nullptr, &m_RenderPass) != VK_SUCCESS,
+	THROW(vkCreateRenderPass(Device::GetDevice(), &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS,
 		"Failed to create render pass!");
 }
 
-void Swapchain::CreateColorResource()
-{
-	VkFormat colorFormat = m_SwapchainImageFormat;
-	uint32_t miplevels = 1;
-
-	utils::CreateImage(m_SwapchainExtent.width,
-		m_SwapchainExtent.height,
-		miplevels,
-		Device::GetMSAASamplesCount(),
-		colorFormat,
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_ColorImage,
-		m_ColorImageMemory);
-
-	m_ColorImageView = utils::CreateImageView(m_ColorImage, colorFormat, VK_IMAGE_ASPECT_COLOR_BIT, miplevels);
-}
-
-void Swapchain::CreateDepthResource()
-{
-	VkFormat depthFormat = FindDepthFormat();
-	uint32_t miplevels = 1;
-
-	utils::CreateImage(m_SwapchainExtent.width,
-		m_SwapchainExtent.height,
-		miplevels,
-		Device::GetMSAASamplesCount(),
-		depthFormat,
-		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-		m_DepthImage,
-		m_DepthImageMemory);
-
-	m_DepthImageView = utils::CreateImageView(m_DepthImage, depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, miplevels);
-}
-
-void Swapchain::CreateFramebuffers()
-{
-	m_SwapchainFramebuffers.resize(m_SwapchainImages.size());
-
-	for (size_t i = 0; i < m_SwapchainImages.size(); ++i)
-	{
-		std::array<VkImageView, 3> fbAttachments{ m_ColorImageView, m_DepthImageView, m_SwapchainImageViews[i] };
-
-		VkFramebufferCreateInfo framebufferInfo{};
-		framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-		framebufferInfo.renderPass = m_RenderPass;
-		framebufferInfo.attachmentCount = static_cast<uint32_t>(fbAttachments.size());
-		framebufferInfo.pAttachments = fbAttachments.data();
-		framebufferInfo.width = m_SwapchainExtent.width;
-		framebufferInfo.height = m_SwapchainExtent.height;
-		framebufferInfo.layers = 1;
-
-		THROW(vkCreateFramebuffer(Device::GetDevice(), &framebufferInfo, nullptr, &m_SwapchainFramebuffers[i])
-				  != VK_SUCCESS,
-			"Failed to create framebuffer!")
-	}
-}
-
 VkSurfaceFormatKHR Swapchain::ChooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats)
 {
 	for (const auto& format : availableFormats)
@@ -402,5 +418,5 @@ VkFormat Swapchain::FindDepthFormat()
 	return Device::FindSupportedFormat(
 		{ VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT },
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+		VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT);
 }
@@ -6,10 +6,17 @@
 #include "core/window.h"
 
 
+constexpr uint32_t HEADLESS_IMAGE_COUNT = 2;
+
+// the window's swapchain, or offscreen images when there is no window (headless)
+// in headless mode the images are "acquired" in turn and "presenting" only waits on the semaphores,
+// the rendered images can be read back with `ReadImage()`
 class Swapchain
 {
 public:
-	Swapchain(const std::shared_ptr<Window>& window);
+	explicit Swapchain(const std::shared_ptr<Window>& window);
+	// headless
+	explicit Swapchain(VkExtent2D extent);
 	~Swapchain();
 
 	void Cleanup();
@@ -17,33 +24,40 @@ public:
 	VkResult AcquireNextImageIndex(VkSemaphore imageAvailableSemaphore, uint32_t* nextImageIndex);
 	void Present(const VkSemaphore* pWaitSemaphores, uint32_t waitSemaphoreCount, const uint32_t* pImageIndices);
 
-	void BeginRenderPass(VkCommandBuffer commandBuffer, uint32_t imageIndex);
-	void EndRenderPass(VkCommandBuffer commandBuffer);
+	// headless only, waits for the device to be idle and returns the pixels of the image as tightly packed rgba8
+	std::vector<uint8_t> ReadImage(uint32_t imageIndex);
 
 	inline VkSwapchainKHR GetHandle() const { return m_Swapchain; }
+	// the attachments are the multisampled color, the depth and the swapchain image (resolved into), they stay in
+	// their attachment layouts, the render graph transitions them (see `RenderGraph`)
 	inline VkRenderPass GetRenderPass() const { return m_RenderPass; }
+	// compatible with `GetRenderPass()`, loads the attachments instead of clearing them
+	inline VkRenderPass GetLoadRenderPass() const { return m_LoadRenderPass; }
+	// of the attachments of `GetRenderPass()`
+	std::vector<VkClearValue> GetClearValues() const;
+	// change when the swapchain is recreated
+	inline VkImage GetImage(uint32_t imageIndex) const { return m_SwapchainImages[imageIndex]; }
+	inline VkImageView GetImageView(uint32_t imageIndex) const { return m_SwapchainImageViews[imageIndex]; }
+	inline VkFormat GetImageFormat() const { return m_SwapchainImageFormat; }
 	inline uint32_t GetWidth() const { return m_SwapchainExtent.width; }
 	inline uint32_t GetHeight() const { return m_SwapchainExtent.height; }
+	inline bool IsHeadless() const { return m_Window == nullptr; }
+
+	// also sampled by the hi-z pyramid
+	static VkFormat FindDepthFormat();
 
 private:
 	void Init();
 
 	void CreateSwapchain();
 	void CreateSwapchainImageViews();
+	void CreateOffscreenImages();
 
-	void CreateRenderPass();
-	void CreateColorResource();
-	void CreateDepthResource();
-	void CreateFramebuffers();
-
-	std::array<VkClearValue, 3> ClearAttachmentValues();
-	void SetViewport(VkCommandBuffer commandBuffer);
-	void SetScissor(VkCommandBuffer commandBuffer);
+	void CreateRenderPass(bool loadAttachments, VkRenderPass& renderPass);
 
 	static VkPresentModeKHR ChoosePresentMode(const std::vector<VkPresentModeKHR>& availablePresentModes);
 	static VkSurfaceFormatKHR ChooseSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats);
 	VkExtent2D ChooseExtent(const VkSurfaceCapabilitiesKHR& capabilities);
-	static VkFormat FindDepthFormat();
 
 private:
 	std::shared_ptr<Window> m_Window;
@@ -54,14 +68,10 @@ private:
 	VkFormat m_SwapchainImageFormat{};
 	VkExtent2D m_SwapchainExtent{};
 	std::vector<VkImageView> m_SwapchainImageViews{};
+	// headless
+	std::vector<VkDeviceMemory> m_OffscreenImageMemory{};
+	uint32_t m_NextOffscreenImage = 0;
 	// render pass
 	VkRenderPass m_RenderPass{};
-	// framebuffer
-	VkImage m_ColorImage{};
-	VkDeviceMemory m_ColorImageMemory{};
-	VkImageView m_ColorImageView{};
-	VkImage m_DepthImage{};
-	VkDeviceMemory m_DepthImageMemory{};
-	VkImageView m_DepthImageView{};
-	std::vector<VkFramebuffer> m_SwapchainFramebuffers{};
+	VkRenderPass m_LoadRenderPass{}; // compatible with `m_RenderPass`, loads the attachments instead of clearing them
 };
\ No newline at end of file
@@ -1,16 +1,25 @@
 #include "renderer/texture.h"
 
+#include <array>
+#include <filesystem>
 #include "stb_image/stb_image.h"
 #include "core/core.h"
 #include "utils/utils.h"
+#include "utils/mipmaps.h"
 #include "renderer/device.h"
 #include "renderer/commandPool.h"
+#include "renderer/samplerCache.h"
 
 
-Texture2D::Texture2D(const char* texturePath)
+Texture2D::Texture2D(const char* texturePath, bool streamed)
 	: m_Path{ texturePath }
 {
-	CreateTextureImage(texturePath);
+	// the cooked texture, else the mip chain cached by a previous run (eg: the cooked one isn't supported)
+	const std::string cookedPath = utils::GetCookedTexturePath(texturePath);
+	const std::string mipCachePath = utils::GetMipCachePath(texturePath);
+	if (!LoadCookedTexture(texturePath, cookedPath, streamed)
+		&& !LoadCookedTexture(texturePath, mipCachePath, streamed))
+		CreateTextureImage(texturePath, mipCachePath, streamed);
 	CreateTextureImageView();
 	CreateTextureSampler();
 
@@ -21,12 +30,154 @@ Texture2D::Texture2D(const char* texturePath)
 
 Texture2D::~Texture2D()
 {
-	vkDestroySampler(Device::GetDevice(), m_TextureSampler, nullptr);
 	vkDestroyImageView(Device::GetDevice(), m_TextureImageView, nullptr);
-	vkFreeMemory(Device::GetDevice(), m_TextureImageMemory, nullptr);
+	utils::FreeMemory(m_TextureImageMemory);
 	vkDestroyImage(Device::GetDevice(), m_TextureImage, nullptr);
 }
 
+void Texture2D::RetiredImage::Release()
+{
+	vkDestroyImageView(Device::GetDevice(), imageView, nullptr);
+	utils::FreeMemory(imageMemory);
+	vkDestroyImage(Device::GetDevice(), image, nullptr);
+	if (stagingBuffer != VK_NULL_HANDLE)
+	{
+		utils::FreeMemory(stagingBufferMemory);
+		vkDestroyBuffer(Device::GetDevice(), stagingBuffer, nullptr);
+	}
+}
+
+Texture2D::RetiredImage Texture2D::SetResidentLevel(uint32_t level, VkCommandBuffer commandBuffer)
+{
+	level = std::min(level, GetTailLevel());
+	RetiredImage retired{};
+	if (!IsStreamed() || level == m_ResidentLevel)
+		return retired;
+
+	retired.image = m_TextureImage;
+	retired.imageMemory = m_TextureImageMemory;
+	retired.imageView = m_TextureImageView;
+	const uint32_t oldLevel = m_ResidentLevel;
+	const uint32_t oldMiplevels = m_Miplevels;
+
+	m_Miplevels = m_LevelCount - level;
+	utils::CreateImage(std::max(m_Width >> level, 1u),
+		std::max(m_Height >> level, 1u),
+		m_Miplevels,
+		VK_SAMPLE_COUNT_1_BIT,
+		m_Format,
+		VK_IMAGE_TILING_OPTIMAL,
+		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+		m_TextureImage,
+		m_TextureImageMemory);
+
+	// the frames submitted before the copies still sample the old image, the barrier waits for them
+	std::array<VkImageMemoryBarrier, 2> barriers{};
+	for (auto& barrier : barriers)
+	{
+		barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+		barrier.srcAccessMask = 0;
+		barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		barrier.subresourceRange.baseMipLevel = 0;
+		barrier.subresourceRange.baseArrayLayer = 0;
+		barrier.subresourceRange.layerCount = 1;
+	}
+	barriers[0].oldLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barriers[0].newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+	barriers[0].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+	barriers[0].image = retired.image;
+	barriers[0].subresourceRange.levelCount = oldMiplevels;
+	barriers[1].oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	barriers[1].newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barriers[1].dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barriers[1].image = m_TextureImage;
+	barriers[1].subresourceRange.levelCount = m_Miplevels;
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		0,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		static_cast<uint32_t>(barriers.size()),
+		barriers.data());
+
+	// the levels that stay resident (all of them for an eviction)
+	std::vector<VkImageCopy> copies{};
+	for (uint32_t i = std::max(level, oldLevel); i < m_LevelCount; ++i)
+	{
+		VkImageCopy copy{};
+		copy.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i - oldLevel, 0, 1 };
+		copy.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, i - level, 0, 1 };
+		copy.extent = { std::max(m_Width >> i, 1u), std::max(m_Height >> i, 1u), 1 };
+		copies.push_back(copy);
+	}
+	vkCmdCopyImage(commandBuffer,
+		retired.image,
+		VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+		m_TextureImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(copies.size()),
+		copies.data());
+
+	// the new levels are the first mips of the new image
+	if (level < oldLevel)
+	{
+		std::vector<VkBufferImageCopy> regions{};
+		StageLevels(ReadLevels(level, oldLevel), retired.stagingBuffer, retired.stagingBufferMemory, regions);
+		vkCmdCopyBufferToImage(commandBuffer,
+			retired.stagingBuffer,
+			m_TextureImage,
+			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			static_cast<uint32_t>(regions.size()),
+			regions.data());
+	}
+
+	VkImageMemoryBarrier barrier = barriers[1];
+	barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+	barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_TRANSFER_BIT,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		0,
+		0,
+		nullptr,
+		0,
+		nullptr,
+		1,
+		&barrier);
+
+	CreateTextureImageView();
+	m_ResidentLevel = level;
+	m_ImageInfo.imageView = m_TextureImageView;
+	++m_Version;
+	return retired;
+}
+
+uint32_t Texture2D::GetTailLevel() const
+{
+	uint32_t level = 0;
+	while (level + 1 < m_LevelCount && std::max(m_Width >> level, m_Height >> level) > TEXTURE_STREAMING_TAIL_SIZE)
+		++level;
+
+	return level;
+}
+
+uint64_t Texture2D::GetChainSize(uint32_t level) const
+{
+	uint64_t size = 0;
+	for (uint32_t i = level; i < static_cast<uint32_t>(m_Header.levelSizes.size()); ++i)
+		size += m_Header.levelSizes[i];
+
+	return size;
+}
+
 std::vector<VkDescriptorImageInfo> Texture2D::GetImageInfos(const std::vector<Texture2D>& textures)
 {
 	std::vector<VkDescriptorImageInfo> imageInfos{};
@@ -50,41 +201,154 @@ std::vector<VkDescriptorImageInfo> Texture2D::GetImageInfos(const std::vector<st
 }
 
 
-void Texture2D::CreateTextureImage(const char* texturePath)
+bool Texture2D::LoadCookedTexture(const std::string& texturePath, const std::string& cookedPath, bool streamed)
+{
+	if (!std::filesystem::exists(cookedPath))
+		return false;
+	if (std::filesystem::exists(texturePath)
+		&& std::filesystem::last_write_time(texturePath) > std::filesystem::last_write_time(cookedPath))
+	{
+		Logger::Info(" \"{}\" is older than its source image", cookedPath);
+		return false;
+	}
+
+	const utils::Ktx2Header header = utils::ReadKtx2Header(cookedPath);
+	VkFormatProperties formatProperties;
+	vkGetPhysicalDeviceFormatProperties(Device::GetPhysicalDevice(), header.format, &formatProperties);
+	const bool blockCompressed =
+		header.format != VK_FORMAT_R8G8B8A8_SRGB && header.format != VK_FORMAT_R8G8B8A8_UNORM;
+	if ((blockCompressed && !Device::GetEnabledFeatures().textureCompressionBC)
+		|| !(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT))
+	{
+		Logger::Warn(" The format of \"{}\" is not supported, its source image is loaded", cookedPath);
+		return false;
+	}
+
+	m_Width = header.width;
+	m_Height = header.height;
+	m_LevelCount = static_cast<uint32_t>(header.levelSizes.size());
+	m_Header = header;
+	if (streamed)
+	{
+		// the finer levels are read when they are made resident
+		m_CookedPath = cookedPath;
+		m_ResidentLevel = GetTailLevel();
+		UploadTextureImage(ReadLevels(m_ResidentLevel, m_LevelCount));
+	}
+	else
+	{
+		UploadTextureImage(utils::ReadKtx2(cookedPath));
+	}
+
+	return true;
+}
+
+void Texture2D::CreateTextureImage(const std::string& texturePath, const std::string& cachePath, bool streamed)
 {
 	int width = 0, height = 0, channels = 0;
-	auto imageData = stbi_load(texturePath, &width, &height, &channels, STBI_rgb_alpha);
+	auto imageData = stbi_load(texturePath.c_str(), &width, &height, &channels, STBI_rgb_alpha);
 	THROW(!imageData, "Failed to load texutre image data!")
 
-	VkDeviceSize size = width * height * 4;
-	m_Miplevels = static_cast<uint32_t>(std::log2(std::max(width, height))) + 1;
+	utils::Ktx2Image image{};
+	image.format = VK_FORMAT_R8G8B8A8_SRGB;
+	image.width = static_cast<uint32_t>(width);
+	image.height = static_cast<uint32_t>(height);
+	image.levels = utils::GenerateMipChain(imageData, image.width, image.height, utils::MipColorSpace::SRGB);
+	stbi_image_free(imageData);
+
+	// the next run loads the cache instead (until the source image changes), streamed textures read their levels
+	// from it
+	try
+	{
+		utils::WriteKtx2(cachePath, image);
+		if (streamed && LoadCookedTexture(texturePath, cachePath, true))
+			return;
+	}
+	catch (const std::exception&)
+	{
+		Logger::Warn(" The mips of \"{}\" are not cached, the texture is not streamed", texturePath);
+	}
+
+	m_Width = image.width;
+	m_Height = image.height;
+	m_LevelCount = static_cast<uint32_t>(image.levels.size());
+	UploadTextureImage(image);
+}
+
+utils::Ktx2Image Texture2D::ReadLevels(uint32_t firstLevel, uint32_t endLevel) const
+{
+	utils::Ktx2Image image{};
+	image.format = m_Header.format;
+	image.width = std::max(m_Width >> firstLevel, 1u);
+	image.height = std::max(m_Height >> firstLevel, 1u);
+	image.levels.reserve(endLevel - firstLevel);
+	for (uint32_t level = firstLevel; level < endLevel; ++level)
+		image.levels.push_back(utils::ReadKtx2Level(m_CookedPath, m_Header, level));
+
+	return image;
+}
+
+void Texture2D::StageLevels(const utils::Ktx2Image& image,
+	VkBuffer& stagingBuffer,
+	VkDeviceMemory& stagingBufferMemory,
+	std::vector<VkBufferImageCopy>& regions)
+{
+	const auto levelCount = static_cast<uint32_t>(image.levels.size());
+	regions.reserve(levelCount);
+	VkDeviceSize size = 0;
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		VkBufferImageCopy region{};
+		region.bufferOffset = size;
+		region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		region.imageSubresource.mipLevel = level;
+		region.imageSubresource.baseArrayLayer = 0;
+		region.imageSubresource.layerCount = 1;
+		region.imageExtent = { std::max(image.width >> level, 1u), std::max(image.height >> level, 1u), 1 };
+		regions.push_back(region);
+		size += image.levels[level].size();
+	}
 
-	VkBuffer stagingBuffer;
-	VkDeviceMemory stagingBufferMem;
 	utils::CreateBuffer(size,
 		VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
 		VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
 		stagingBuffer,
-		stagingBufferMem);
+		stagingBufferMemory);
 
 	void* data;
-	vkMapMemory(Device::GetDevice(), stagingBufferMem, 0, size, 0, &data);
-	memcpy(data, imageData, static_cast<size_t>(size));
-	vkUnmapMemory(Device::GetDevice(), stagingBufferMem);
+	vkMapMemory(Device::GetDevice(), stagingBufferMemory, 0, size, 0, &data);
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		std::copy(image.levels[level].begin(),
+			image.levels[level].end(),
+			static_cast<uint8_t*>(data) + regions[level].bufferOffset);
+	}
+	vkUnmapMemory(Device::GetDevice(), stagingBufferMemory);
+}
 
-	stbi_image_free(imageData);
+void Texture2D::UploadTextureImage(const utils::Ktx2Image& image)
+{
+	m_Format = image.format;
+	m_Miplevels = static_cast<uint32_t>(image.levels.size());
+
+	// every level is copied in one go
+	VkBuffer stagingBuffer;
+	VkDeviceMemory stagingBufferMem;
+	std::vector<VkBufferImageCopy> regions{};
+	StageLevels(image, stagingBuffer, stagingBufferMem, regions);
 
-	// we generate mipmaps by blitting the image,
-	// this operation is a transfer operation
-	// so we use this image both as a dst and src
-	utils::CreateImage(static_cast<uint32_t>(width),
-		static_cast<uint32_t>(height),
+	// the mips are uploaded with the image, it is only copied to (and from, the resident levels of a streamed texture
+	// are copied to its next image)
+	VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+	if (IsStreamed())
+		usage |= VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	utils::CreateImage(image.width,
+		image.height,
 		m_Miplevels,
 		VK_SAMPLE_COUNT_1_BIT,
-		VK_FORMAT_R8G8B8A8_SRGB,
+		m_Format,
 		VK_IMAGE_TILING_OPTIMAL,
-		VK_IMAGE_USAGE_TRANSFER_SRC_BIT | // to generate mipmaps
-			VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+		usage,
 		VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
 		m_TextureImage,
 		m_TextureImageMemory);
@@ -92,26 +356,22 @@ void Texture2D::CreateTextureImage(const char* texturePath)
 	// we wait for the queue to be idle after every operation (transition and copy)
 	// this makes the operations synchronous
 	// TODO: make it asynchronous
-
+	utils::TransitionImageLayout(
+		m_TextureImage, m_Format, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, m_Miplevels);
+	utils::CopyBufferToImage(stagingBuffer, m_TextureImage, regions);
 	utils::TransitionImageLayout(m_TextureImage,
-		VK_FORMAT_R8G8B8A8_SRGB,
-		VK_IMAGE_LAYOUT_UNDEFINED,
+		m_Format,
 		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
 		m_Miplevels);
 
-	utils::CopyBufferToImage(
-		stagingBuffer, m_TextureImage, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
-
-	utils::GenerateMipmaps(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, width, height, m_Miplevels);
-
-	vkFreeMemory(Device::GetDevice(), stagingBufferMem, nullptr);
+	utils::FreeMemory(stagingBufferMem);
 	vkDestroyBuffer(Device::GetDevice(), stagingBuffer, nullptr);
 }
 
 void Texture2D::CreateTextureImageView()
 {
-	m_TextureImageView =
-		utils::CreateImageView(m_TextureImage, VK_FORMAT_R8G8B8A8_SRGB, VK_IMAGE_ASPECT_COLOR_BIT, m_Miplevels);
+	m_TextureImageView = utils::CreateImageView(m_TextureImage, m_Format, VK_IMAGE_ASPECT_COLOR_BIT, m_Miplevels);
 }
 
 void Texture2D::CreateTextureSampler()
@@ -132,10 +392,11 @@ void Texture2D::CreateTextureSampler()
 	samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
 	samplerInfo.mipLodBias = 0.0f;
 	samplerInfo.minLod = 0.0f;
-	samplerInfo.maxLod = static_cast<float>(m_Miplevels);
+	// not clamped, the image view limits the levels (the image of a streamed texture gets more of them), so that
+	// every texture shares one sampler
+	samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
 	samplerInfo.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
 	samplerInfo.unnormalizedCoordinates = VK_FALSE;
 
-	THROW(vkCreateSampler(Device::GetDevice(), &samplerInfo, nullptr, &m_TextureSampler) != VK_SUCCESS,
-		"Failed to create texture sampler!")
+	m_TextureSampler = SamplerCache::Get(samplerInfo);
 }
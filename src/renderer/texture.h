@@ -4,31 +4,101 @@
 #include <vector>
 #include <memory>
 #include <vulkan/vulkan.h>
+#include "utils/ktx2.h"
 
 
+// the levels that are at most this many texels on their larger side are always resident (streamed textures)
+constexpr uint32_t TEXTURE_STREAMING_TAIL_SIZE = 64;
+
+// loads the cooked texture next to `texturePath` (the same path with the `.ktx2` extension, see `cooker/main.cpp`)
+// with its block compressed format and mips, or the source image, whose mips are generated on the cpu and cached next
+// to it (as an uncompressed `.mips.ktx2` file, the cooked texture is never overwritten), every level is uploaded in one
+// copy
+//
+// a streamed texture only loads its tail (see `TEXTURE_STREAMING_TAIL_SIZE`) and reads the finer levels from the
+// cooked file when they are made resident (see `TextureStreamer`), the image is recreated with the resident levels,
+// the ones that were already resident are copied from the old image
 class Texture2D
 {
 public:
-	Texture2D(const char* texturePath);
+	// the image that `SetResidentLevel()` replaced and the staging buffer of the levels it read, they are released
+	// once the copies and the frames that sampled the old image are done
+	struct RetiredImage
+	{
+		VkImage image{};
+		VkDeviceMemory imageMemory{};
+		VkImageView imageView{};
+		VkBuffer stagingBuffer{};
+		VkDeviceMemory stagingBufferMemory{};
+
+		void Release();
+	};
+
+public:
+	Texture2D(const char* texturePath, bool streamed = false);
 	~Texture2D();
 
+	// makes the levels from `level` to the last one resident, the copies are recorded into `commandBuffer`: the levels
+	// that stay resident are copied from the old image, only the new ones are read from the cooked file and uploaded
+	// the image and its view are replaced right away (the descriptors have to be rewritten), the old image has to be
+	// kept until the copies and the frames that sample it are done
+	RetiredImage SetResidentLevel(uint32_t level, VkCommandBuffer commandBuffer);
+
 	inline std::string GetPath() const { return m_Path; }
 	inline VkDescriptorImageInfo& GetImageInfo() { return m_ImageInfo; }
+	inline const VkDescriptorImageInfo& GetImageInfo() const { return m_ImageInfo; }
+	inline VkFormat GetFormat() const { return m_Format; }
+	// of level 0, whether it is resident or not
+	inline uint32_t GetWidth() const { return m_Width; }
+	inline uint32_t GetHeight() const { return m_Height; }
+	inline uint32_t GetLevelCount() const { return m_LevelCount; }
+	// the finest resident level, 0 unless the texture is streamed
+	inline uint32_t GetResidentLevel() const { return m_ResidentLevel; }
+	inline bool IsStreamed() const { return !m_CookedPath.empty(); }
+	// the finest level that is always resident
+	uint32_t GetTailLevel() const;
+	// bytes of the texels of a level (streamed textures)
+	inline uint64_t GetLevelSize(uint32_t level) const { return m_Header.levelSizes[level]; }
+	// bytes of the texels of the levels from `level` to the last one
+	uint64_t GetChainSize(uint32_t level) const;
+	// incremented when the image is recreated
+	inline uint64_t GetVersion() const { return m_Version; }
 
 	static std::vector<VkDescriptorImageInfo> GetImageInfos(const std::vector<Texture2D>& textures);
 	static std::vector<VkDescriptorImageInfo> GetImageInfos(const std::vector<std::shared_ptr<Texture2D>>& textures);
 
 private:
-	void CreateTextureImage(const char* texturePath);
+	// false if there is no cooked texture, if it is older than the source image or if the device can't sample its
+	// format
+	bool LoadCookedTexture(const std::string& texturePath, const std::string& cookedPath, bool streamed);
+	void CreateTextureImage(const std::string& texturePath, const std::string& cachePath, bool streamed);
+	// the levels of the cooked file from `firstLevel` to `endLevel` (excluded)
+	utils::Ktx2Image ReadLevels(uint32_t firstLevel, uint32_t endLevel) const;
+	// copies the levels of `image` into a new staging buffer, packed one after another, `regions` receives the copy of
+	// every level to the mip of the same index
+	static void StageLevels(const utils::Ktx2Image& image,
+		VkBuffer& stagingBuffer,
+		VkDeviceMemory& stagingBufferMemory,
+		std::vector<VkBufferImageCopy>& regions);
+	void UploadTextureImage(const utils::Ktx2Image& image);
 	void CreateTextureImageView();
 	void CreateTextureSampler();
 
 private:
 	std::string m_Path;
-	uint32_t m_Miplevels = 0;
+	uint32_t m_Width = 0;
+	uint32_t m_Height = 0;
+	uint32_t m_LevelCount = 0;
+	uint32_t m_Miplevels = 0; // of the image, the resident levels
+	uint32_t m_ResidentLevel = 0;
+	uint64_t m_Version = 0;
+	// streamed textures only
+	std::string m_CookedPath{};
+	utils::Ktx2Header m_Header{};
+	VkFormat m_Format = VK_FORMAT_R8G8B8A8_SRGB;
 	VkDescriptorImageInfo m_ImageInfo{};
 	VkImage m_TextureImage{};
 	VkDeviceMemory m_TextureImageMemory{};
 	VkImageView m_TextureImageView{};
-	VkSampler m_TextureSampler{};
+	VkSampler m_TextureSampler{}; // owned by the `SamplerCache`
 };
\ No newline at end of file
@@ -0,0 +1,284 @@
+#include "renderer/textureStreamer.h"
+
+#include <string>
+#include <algorithm>
+#include <filesystem>
+#include "imgui/imgui.h"
+#include "core/core.h"
+#include "utils/utils.h"
+#include "renderer/device.h"
+#include "renderer/commandPool.h"
+
+
+constexpr double BYTES_PER_MB = 1024.0 * 1024.0;
+
+TextureFeedback::TextureFeedback(const uint32_t count, const uint32_t maxFramesInFlight)
+	: m_ResidentLevels(maxFramesInFlight)
+{
+	m_Buffers.reserve(maxFramesInFlight);
+	for (uint32_t i = 0; i < maxFramesInFlight; ++i)
+	{
+		m_Buffers.emplace_back(sizeof(uint32_t) * count,
+			VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+		std::fill_n(static_cast<uint32_t*>(m_Buffers.back().GetMappedData()), count, NONE);
+	}
+}
+
+std::vector<uint32_t> TextureFeedback::Read(const uint32_t currentFrameIndex)
+{
+	const std::vector<uint32_t>& residentLevels = m_ResidentLevels[currentFrameIndex];
+	auto minLevels = static_cast<uint32_t*>(m_Buffers[currentFrameIndex].GetMappedData());
+	std::vector<uint32_t> levels(residentLevels.size());
+	for (size_t i = 0; i < residentLevels.size(); ++i)
+	{
+		// magnified textures store a level below the bias, they need level 0
+		const uint32_t level = residentLevels[i] + minLevels[i];
+		levels[i] = minLevels[i] == NONE ? NONE : (level < BIAS ? 0 : level - BIAS);
+		minLevels[i] = NONE;
+	}
+
+	return levels;
+}
+
+void TextureFeedback::SetResidentLevels(const std::vector<uint32_t>& residentLevels, const uint32_t currentFrameIndex)
+{
+	m_ResidentLevels[currentFrameIndex] = residentLevels;
+}
+
+void TextureFeedback::RecordHostReadBarrier(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex)
+{
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	barrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = m_Buffers[currentFrameIndex].GetBuffer();
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+
+	vkCmdPipelineBarrier(commandBuffer,
+		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT,
+		0,
+		0,
+		nullptr,
+		1,
+		&barrier,
+		0,
+		nullptr);
+}
+
+TextureStreamer::TextureStreamer(const uint32_t maxFramesInFlight)
+	: m_MaxFramesInFlight{ maxFramesInFlight }
+{
+}
+
+TextureStreamer::~TextureStreamer()
+{
+	ReleaseRetiredImages(true);
+}
+
+void TextureStreamer::Register(Texture2D* texture)
+{
+	if (!texture->IsStreamed())
+		return;
+
+	m_Entries.push_back({ texture,
+		texture->GetTailLevel(),
+		texture->GetResidentLevel(),
+		std::vector<uint64_t>(texture->GetLevelCount(), 0) });
+}
+
+void TextureStreamer::Request(const Texture2D* texture, uint32_t level)
+{
+	for (auto& entry : m_Entries)
+	{
+		if (entry.texture == texture)
+		{
+			entry.requestedLevel = std::min(entry.requestedLevel, level);
+			return;
+		}
+	}
+}
+
+void TextureStreamer::Update()
+{
+	++m_Frame;
+	ReleaseRetiredImages(false);
+	const uint64_t budget = static_cast<uint64_t>(m_BudgetMB) * 1024 * 1024;
+
+	// the resident levels are kept until they are evicted
+	uint64_t targetBytes = 0;
+	for (auto& entry : m_Entries)
+	{
+		if (!m_Enabled)
+			entry.requestedLevel = 0;
+		for (uint32_t level = entry.requestedLevel; level < entry.texture->GetLevelCount(); ++level)
+			entry.lastUsed[level] = m_Frame;
+
+		entry.targetLevel = std::min(entry.requestedLevel, entry.texture->GetResidentLevel());
+		targetBytes += entry.texture->GetChainSize(entry.targetLevel);
+	}
+
+	// the finest level that was used the longest ago is dropped first, the largest one between the levels used in
+	// this frame, the tails are never evicted
+	while (m_Enabled && targetBytes > budget)
+	{
+		Entry* evicted = nullptr;
+		for (auto& entry : m_Entries)
+		{
+			if (entry.targetLevel >= entry.texture->GetTailLevel())
+				continue;
+
+			if (!evicted || entry.lastUsed[entry.targetLevel] < evicted->lastUsed[evicted->targetLevel]
+				|| (entry.lastUsed[entry.targetLevel] == evicted->lastUsed[evicted->targetLevel]
+					&& entry.texture->GetLevelSize(entry.targetLevel)
+						   > evicted->texture->GetLevelSize(evicted->targetLevel)))
+				evicted = &entry;
+		}
+		if (!evicted)
+			break;
+
+		targetBytes -= evicted->texture->GetLevelSize(evicted->targetLevel);
+		++evicted->targetLevel;
+	}
+
+	// the copies of every texture that changes are recorded into one command buffer, the evictions only copy the
+	// levels that stay resident, the loads also upload their new levels (capped per frame)
+	VkCommandBuffer commandBuffer = VK_NULL_HANDLE;
+	std::vector<Texture2D::RetiredImage> retiredImages{};
+	auto setResidentLevel = [&](Entry& entry) {
+		if (commandBuffer == VK_NULL_HANDLE)
+			commandBuffer = utils::BeginSingleTimeCommands();
+		retiredImages.push_back(entry.texture->SetResidentLevel(entry.targetLevel, commandBuffer));
+	};
+
+	for (auto& entry : m_Entries)
+	{
+		const uint32_t residentLevel = entry.texture->GetResidentLevel();
+		if (entry.targetLevel <= residentLevel)
+			continue;
+
+		m_Stats.evictedLevels += entry.targetLevel - residentLevel;
+		setResidentLevel(entry);
+	}
+
+	uint64_t uploadedBytes = 0;
+	for (auto& entry : m_Entries)
+	{
+		const uint32_t residentLevel = entry.texture->GetResidentLevel();
+		if (entry.targetLevel >= residentLevel)
+			continue;
+		const uint64_t bytes =
+			entry.texture->GetChainSize(entry.targetLevel) - entry.texture->GetChainSize(residentLevel);
+		// requested again in the next frames
+		if (uploadedBytes > 0 && uploadedBytes + bytes > TEXTURE_STREAMING_FRAME_UPLOAD)
+			continue;
+
+		m_Stats.streamedLevels += residentLevel - entry.targetLevel;
+		setResidentLevel(entry);
+		uploadedBytes += bytes;
+	}
+
+	// submitted before the frame, the barriers of the copies order them with the frames before and after them
+	if (commandBuffer != VK_NULL_HANDLE)
+	{
+		vkEndCommandBuffer(commandBuffer);
+
+		VkFenceCreateInfo fenceInfo{};
+		fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
+		VkFence fence{};
+		THROW(vkCreateFence(Device::GetDevice(), &fenceInfo, nullptr, &fence) != VK_SUCCESS,
+			"Failed to create the fence of the texture copies!")
+
+		VkSubmitInfo submitInfo{};
+		submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
+		submitInfo.commandBufferCount = 1;
+		submitInfo.pCommandBuffers = &commandBuffer;
+		THROW(vkQueueSubmit(Device::GetGraphicsQueue(), 1, &submitInfo, fence) != VK_SUCCESS,
+			"Failed to submit the texture copies!")
+
+		m_PendingCopies.push_back({ m_Frame, commandBuffer, fence, std::move(retiredImages) });
+	}
+
+	m_Stats.residentBytes = 0;
+	m_Stats.fullBytes = 0;
+	for (auto& entry : m_Entries)
+	{
+		m_Stats.residentBytes += entry.texture->GetChainSize(entry.texture->GetResidentLevel());
+		m_Stats.fullBytes += entry.texture->GetChainSize(0);
+		entry.requestedLevel = entry.texture->GetTailLevel();
+	}
+
+	m_WindowBytes += uploadedBytes;
+	const auto now = std::chrono::steady_clock::now();
+	const double windowTime = std::chrono::duration<double>(now - m_WindowStart).count();
+	if (windowTime >= 1.0)
+	{
+		m_Stats.bytesPerSecond = static_cast<double>(m_WindowBytes) / windowTime;
+		m_WindowBytes = 0;
+		m_WindowStart = now;
+	}
+}
+
+void TextureStreamer::ReleaseRetiredImages(bool wait)
+{
+	// the frames that sampled the old images were submitted at most `m_MaxFramesInFlight` frames before the copies,
+	// the fences of all of them have been waited on `m_MaxFramesInFlight` frames after the copies
+	for (size_t i = 0; i < m_PendingCopies.size();)
+	{
+		PendingCopies& copies = m_PendingCopies[i];
+		if (wait)
+			vkWaitForFences(Device::GetDevice(), 1, &copies.fence, VK_TRUE, UINT64_MAX);
+		else if (m_Frame < copies.frame + m_MaxFramesInFlight
+				 || vkGetFenceStatus(Device::GetDevice(), copies.fence) != VK_SUCCESS)
+		{
+			++i;
+			continue;
+		}
+
+		for (auto& image : copies.retiredImages)
+			image.Release();
+		vkDestroyFence(Device::GetDevice(), copies.fence, nullptr);
+		vkFreeCommandBuffers(Device::GetDevice(), CommandPool::Get(), 1, &copies.commandBuffer);
+		m_PendingCopies.erase(m_PendingCopies.begin() + static_cast<std::ptrdiff_t>(i));
+	}
+}
+
+void TextureStreamer::OnUIRender()
+{
+	ImGui::SeparatorText("Texture streaming:");
+	ImGui::Checkbox("Stream texture mips", &m_Enabled);
+	ImGui::Text("Budget (MB)");
+	ImGui::SliderInt("##texture_streaming_budget", &m_BudgetMB, 4, 1024);
+	ImGui::Text("Resident: %.1f / %.1f MB (%.0f%%)",
+		static_cast<double>(m_Stats.residentBytes) / BYTES_PER_MB,
+		static_cast<double>(m_Stats.fullBytes) / BYTES_PER_MB,
+		m_Stats.fullBytes == 0
+			? 100.0
+			: 100.0 * static_cast<double>(m_Stats.residentBytes) / static_cast<double>(m_Stats.fullBytes));
+	// only the levels read from the cooked files, the resident ones are copied on the gpu
+	ImGui::Text("Uploads: %.2f MB/s, %llu levels streamed, %llu evicted",
+		m_Stats.bytesPerSecond / BYTES_PER_MB,
+		static_cast<unsigned long long>(m_Stats.streamedLevels),
+		static_cast<unsigned long long>(m_Stats.evictedLevels));
+
+	if (!ImGui::TreeNode("Streamed textures"))
+		return;
+
+	for (const auto& entry : m_Entries)
+	{
+		const Texture2D& texture = *entry.texture;
+		const uint32_t residentLevel = texture.GetResidentLevel();
+		const std::string name = std::filesystem::path(texture.GetPath()).filename().string();
+		ImGui::Text("%s: %ux%u (level %u of %u), %.2f MB",
+			name.c_str(),
+			std::max(texture.GetWidth() >> residentLevel, 1u),
+			std::max(texture.GetHeight() >> residentLevel, 1u),
+			residentLevel,
+			texture.GetLevelCount(),
+			static_cast<double>(texture.GetChainSize(residentLevel)) / BYTES_PER_MB);
+	}
+	ImGui::TreePop();
+}
@@ -0,0 +1,114 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <vulkan/vulkan.h>
+#include "renderer/texture.h"
+#include "renderer/storageBuffer.h"
+
+
+constexpr uint64_t TEXTURE_STREAMING_BUDGET = 64ull * 1024 * 1024; // default vram budget of the streamed levels
+// the levels uploaded in a frame, more of them wait for the next frames (at least one texture is uploaded)
+constexpr uint64_t TEXTURE_STREAMING_FRAME_UPLOAD = 16ull * 1024 * 1024;
+
+// the finest mip levels the fragment shaders sampled `count` textures at (see `textureFeedback.glsl`), one slot per
+// texture, eg: per slot of the bindless texture array
+// the buffers are host visible and per frame in flight, they are read after the fence of the frame has been waited on
+class TextureFeedback
+{
+public:
+	TextureFeedback(const uint32_t count, const uint32_t maxFramesInFlight);
+
+	// the finest level of the full chain each texture was sampled at the last time the frame was drawn, `NONE` if it
+	// wasn't sampled, only of the textures that had resident levels set for the frame, resets the buffer of the frame
+	std::vector<uint32_t> Read(const uint32_t currentFrameIndex);
+	// the resident levels of the first textures while the frame is drawn, the sampled lods are relative to them
+	void SetResidentLevels(const std::vector<uint32_t>& residentLevels, const uint32_t currentFrameIndex);
+	// makes the writes of the fragment shaders to the buffer of the frame available to the host (the fence alone
+	// doesn't), after the last pass that samples the textures
+	void RecordHostReadBarrier(VkCommandBuffer commandBuffer, const uint32_t currentFrameIndex);
+
+	inline std::vector<VkDescriptorBufferInfo> GetBufferInfos() const
+	{
+		return StorageBuffer::GetBufferInfos(m_Buffers);
+	}
+
+	static constexpr uint32_t NONE = 0xffffffff;
+	static constexpr uint32_t BIAS = 16; // added to the stored levels, they can be negative (magnification)
+
+private:
+	std::vector<StorageBuffer> m_Buffers{};
+	std::vector<std::vector<uint32_t>> m_ResidentLevels{};
+};
+
+struct TextureStreamingStats
+{
+	uint64_t residentBytes = 0; // of the streamed textures
+	uint64_t fullBytes = 0; // if every level of the streamed textures was resident
+	double bytesPerSecond = 0.0; // uploaded, averaged over a second
+	uint64_t streamedLevels = 0; // made resident since the start
+	uint64_t evictedLevels = 0;
+};
+
+// streams the mip levels of the streamed textures (see `Texture2D`) from their cooked files
+// every frame the textures get the finest level that is requested for them (from the texture feedback or from their
+// size on the screen), under a vram budget: the least recently used levels are evicted first
+// the copies of a frame are submitted with a fence before the frame, nothing waits for them on the cpu, the replaced
+// images are destroyed once the copies and the frames in flight that sampled them are done
+class TextureStreamer
+{
+public:
+	explicit TextureStreamer(const uint32_t maxFramesInFlight);
+	~TextureStreamer();
+
+	TextureStreamer(const TextureStreamer&) = delete;
+	TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+	// the textures have to outlive the streamer, the textures that aren't streamed are ignored
+	void Register(Texture2D* texture);
+	// the finest level `texture` is needed at this frame, the finest request of the frame wins
+	void Request(const Texture2D* texture, uint32_t level);
+	// makes the requested levels resident and evicts levels to stay within the budget, after the fence of the frame
+	// has been waited on and before the frame is recorded, the recreated textures get a new version (see
+	// `Texture2D::GetVersion()`), their descriptors have to be rewritten
+	void Update();
+
+	void OnUIRender();
+
+	inline const TextureStreamingStats& GetStats() const { return m_Stats; }
+
+private:
+	struct Entry
+	{
+		Texture2D* texture;
+		uint32_t requestedLevel; // of this frame, the tail level if it wasn't requested
+		uint32_t targetLevel;
+		std::vector<uint64_t> lastUsed; // per level, the frame it was last requested at
+	};
+
+	// the copies submitted in a frame
+	struct PendingCopies
+	{
+		uint64_t frame;
+		VkCommandBuffer commandBuffer;
+		VkFence fence;
+		std::vector<Texture2D::RetiredImage> retiredImages;
+	};
+
+private:
+	// `wait`: waits for every pending copy, eg: when the streamer is destroyed
+	void ReleaseRetiredImages(bool wait);
+
+private:
+	uint32_t m_MaxFramesInFlight = 0;
+	std::vector<Entry> m_Entries{};
+	std::vector<PendingCopies> m_PendingCopies{};
+	int m_BudgetMB = static_cast<int>(TEXTURE_STREAMING_BUDGET / (1024 * 1024)); // set in the ui
+	// off: every level of the streamed textures is resident, regardless of the budget
+	bool m_Enabled = true;
+	uint64_t m_Frame = 0;
+
+	TextureStreamingStats m_Stats{};
+	uint64_t m_WindowBytes = 0;
+	std::chrono::steady_clock::time_point m_WindowStart = std::chrono::steady_clock::now();
+};
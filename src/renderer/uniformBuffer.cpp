@@ -19,7 +19,7 @@ UniformBuffer::UniformBuffer(VkDeviceSize size, VkMemoryPropertyFlags properties
 UniformBuffer::~UniformBuffer()
 {
 	vkUnmapMemory(Device::GetDevice(), m_UniformBufferMemory);
-	vkFreeMemory(Device::GetDevice(), m_UniformBufferMemory, nullptr);
+	utils::FreeMemory(m_UniformBufferMemory);
 	vkDestroyBuffer(Device::GetDevice(), m_UniformBuffer, nullptr);
 }
 
@@ -7,7 +7,25 @@
 VertexBuffer::VertexBuffer(const std::vector<Vertex>& vertices)
 	: m_VertexSize{ static_cast<uint32_t>(vertices.size()) }
 {
-	Init(vertices);
+	Init(vertices.data(), sizeof(vertices[0]) * static_cast<uint64_t>(vertices.size()));
+}
+
+VertexBuffer::VertexBuffer(const std::vector<glm::vec3>& positions)
+	: m_VertexSize{ static_cast<uint32_t>(positions.size()) }
+{
+	Init(positions.data(), sizeof(positions[0]) * static_cast<uint64_t>(positions.size()));
+}
+
+VertexBuffer::VertexBuffer(const std::vector<CompactVertex>& vertices)
+	: m_VertexSize{ static_cast<uint32_t>(vertices.size()) }
+{
+	Init(vertices.data(), sizeof(vertices[0]) * static_cast<uint64_t>(vertices.size()));
+}
+
+VertexBuffer::VertexBuffer(const std::vector<glm::u16vec4>& positions)
+	: m_VertexSize{ static_cast<uint32_t>(positions.size()) }
+{
+	Init(positions.data(), sizeof(positions[0]) * static_cast<uint64_t>(positions.size()));
 }
 
 VertexBuffer::~VertexBuffer()
@@ -15,10 +33,8 @@ VertexBuffer::~VertexBuffer()
 	Cleanup();
 }
 
-void VertexBuffer::Init(const std::vector<Vertex>& vertices)
+void VertexBuffer::Init(const void* data, VkDeviceSize size)
 {
-	VkDeviceSize size = sizeof(vertices[0]) * static_cast<uint64_t>(vertices.size());
-
 	VkBuffer stagingBuffer;
 	VkDeviceMemory stagingBufferMem;
 	utils::CreateBuffer(size,
@@ -27,9 +43,9 @@ void VertexBuffer::Init(const std::vector<Vertex>& vertices)
 		stagingBuffer,
 		stagingBufferMem);
 
-	void* data;
-	vkMapMemory(Device::GetDevice(), stagingBufferMem, 0, size, 0, &data);
-	memcpy(data, vertices.data(), static_cast<size_t>(size));
+	void* mapped;
+	vkMapMemory(Device::GetDevice(), stagingBufferMem, 0, size, 0, &mapped);
+	memcpy(mapped, data, static_cast<size_t>(size));
 	vkUnmapMemory(Device::GetDevice(), stagingBufferMem);
 
 	// create the actual vertex buffer
@@ -41,12 +57,12 @@ void VertexBuffer::Init(const std::vector<Vertex>& vertices)
 
 	utils::CopyBuffer(stagingBuffer, m_Buffer, size);
 
-	vkFreeMemory(Device::GetDevice(), stagingBufferMem, nullptr);
+	utils::FreeMemory(stagingBufferMem);
 	vkDestroyBuffer(Device::GetDevice(), stagingBuffer, nullptr);
 }
 
 void VertexBuffer::Cleanup()
 {
-	vkFreeMemory(Device::GetDevice(), m_BufferMemory, nullptr);
+	utils::FreeMemory(m_BufferMemory);
 	vkDestroyBuffer(Device::GetDevice(), m_Buffer, nullptr);
 }
\ No newline at end of file
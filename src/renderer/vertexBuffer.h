@@ -6,6 +6,8 @@
 #include <vulkan/vulkan.h>
 #include <glm/glm.hpp>
 #include <glm/gtx/hash.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include "renderer/renderStats.h"
 
 
 struct Vertex
@@ -46,6 +48,29 @@ struct Vertex
 		return attrDesc;
 	}
 
+	// position only stream, used by the depth only passes
+	// a separate tightly packed buffer, so that they fetch less memory
+	static VkVertexInputBindingDescription GetPositionBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDesc{};
+		bindingDesc.binding = 0;
+		bindingDesc.stride = sizeof(glm::vec3);
+		bindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDesc;
+	}
+
+	static VkVertexInputAttributeDescription GetPositionAttributeDescription()
+	{
+		VkVertexInputAttributeDescription attrDesc{};
+		attrDesc.location = 0;
+		attrDesc.binding = 0;
+		attrDesc.format = VK_FORMAT_R32G32B32_SFLOAT;
+		attrDesc.offset = 0;
+
+		return attrDesc;
+	}
+
 	// for hash function
 	bool operator==(const Vertex& other) const
 	{
@@ -53,6 +78,89 @@ struct Vertex
 	}
 };
 
+// 16 bytes instead of the 32 of `Vertex`, see `utils::CompressVertices()`
+// the positions are unorm16 relative to the bounds of the mesh, decoded with `VertexDecode`
+// the normals are octahedral encoded (snorm16 x 2) and the texture coordinates are half floats
+struct CompactVertex
+{
+	glm::u16vec4 pos; // w is padding, 3 component 16 bit formats are rarely supported as vertex input
+	glm::i16vec2 normal;
+	glm::u16vec2 texCoord;
+
+	static VkVertexInputBindingDescription GetBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDesc{};
+		bindingDesc.binding = 0;
+		bindingDesc.stride = sizeof(CompactVertex);
+		bindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDesc;
+	}
+
+	static std::array<VkVertexInputAttributeDescription, 3> GetAttributeDescription()
+	{
+		std::array<VkVertexInputAttributeDescription, 3> attrDesc{};
+		attrDesc[0].location = 0;
+		attrDesc[0].binding = 0;
+		attrDesc[0].format = VK_FORMAT_R16G16B16A16_UNORM;
+		attrDesc[0].offset = offsetof(CompactVertex, pos);
+		attrDesc[1].location = 1;
+		attrDesc[1].binding = 0;
+		attrDesc[1].format = VK_FORMAT_R16G16_SNORM;
+		attrDesc[1].offset = offsetof(CompactVertex, normal);
+		attrDesc[2].location = 2;
+		attrDesc[2].binding = 0;
+		attrDesc[2].format = VK_FORMAT_R16G16_SFLOAT;
+		attrDesc[2].offset = offsetof(CompactVertex, texCoord);
+
+		return attrDesc;
+	}
+
+	// position only stream of the compact vertices (8 bytes per position)
+	static VkVertexInputBindingDescription GetPositionBindingDescription()
+	{
+		VkVertexInputBindingDescription bindingDesc{};
+		bindingDesc.binding = 0;
+		bindingDesc.stride = sizeof(glm::u16vec4);
+		bindingDesc.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+
+		return bindingDesc;
+	}
+
+	static VkVertexInputAttributeDescription GetPositionAttributeDescription()
+	{
+		VkVertexInputAttributeDescription attrDesc{};
+		attrDesc.location = 0;
+		attrDesc.binding = 0;
+		attrDesc.format = VK_FORMAT_R16G16B16A16_UNORM;
+		attrDesc.offset = 0;
+
+		return attrDesc;
+	}
+};
+static_assert(sizeof(CompactVertex) == 16, "CompactVertex has to be tightly packed");
+
+// object space position = offset + stored position * scale
+// pushed to the vertex shaders of the meshes before they are drawn (vertex stage, `VERTEX_DECODE_PUSH_CONSTANT_OFFSET`)
+// the pipeline layouts of the lit objects and of the shadow maps have this range
+// the identity for full precision vertices
+constexpr uint32_t VERTEX_DECODE_PUSH_CONSTANT_OFFSET = 64;
+struct VertexDecode
+{
+	glm::vec4 offset{ 0.0f, 0.0f, 0.0f, 0.0f }; // w: 1 if the normals are octahedral encoded (compact vertices)
+	glm::vec4 scale{ 1.0f, 1.0f, 1.0f, 0.0f };
+
+	inline void Push(VkCommandBuffer commandBuffer, VkPipelineLayout pipelineLayout) const
+	{
+		vkCmdPushConstants(commandBuffer,
+			pipelineLayout,
+			VK_SHADER_STAGE_VERTEX_BIT,
+			VERTEX_DECODE_PUSH_CONSTANT_OFFSET,
+			sizeof(VertexDecode),
+			this);
+	}
+};
+
 // hash function
 namespace std {
 template<>
@@ -71,17 +179,26 @@ class VertexBuffer
 {
 public:
 	VertexBuffer(const std::vector<Vertex>& vertices);
+	// position only stream, see `Vertex::GetPositionBindingDescription()`
+	VertexBuffer(const std::vector<glm::vec3>& positions);
+	VertexBuffer(const std::vector<CompactVertex>& vertices);
+	// position only stream of compact vertices, see `CompactVertex::GetPositionBindingDescription()`
+	VertexBuffer(const std::vector<glm::u16vec4>& positions);
 	~VertexBuffer();
 
 	inline VkBuffer GetBuffer() const { return m_Buffer; }
-	inline void Draw(VkCommandBuffer commandBuffer) { vkCmdDraw(commandBuffer, m_VertexSize, 1, 0, 0); }
+	inline void Draw(VkCommandBuffer commandBuffer)
+	{
+		RenderStats::CountDraw(m_VertexSize);
+		vkCmdDraw(commandBuffer, m_VertexSize, 1, 0, 0);
+	}
 	inline void Bind(VkCommandBuffer commandBuffer)
 	{
 		vkCmdBindVertexBuffers(commandBuffer, 0, 1, &m_Buffer, m_Offsets);
 	}
 
 private:
-	void Init(const std::vector<Vertex>& vertices);
+	void Init(const void* data, VkDeviceSize size);
 	void Cleanup();
 
 private:
@@ -12,12 +12,14 @@ VulkanContext::VulkanContext(const char* title, const VulkanConfig& config, cons
 {
 	CreateInstance(title);
 	SetupDebugMessenger();
-	m_Window->CreateWindowSurface(m_VulkanInstance);
+	if (m_Window)
+		m_Window->CreateWindowSurface(m_VulkanInstance);
 }
 
 VulkanContext::~VulkanContext()
 {
-	m_Window->DestroyWindowSurface(m_VulkanInstance);
+	if (m_Window)
+		m_Window->DestroyWindowSurface(m_VulkanInstance);
 
 	if (m_Config.enableValidationLayers)
 		DestroyDebugUtilsMessengerEXT(m_VulkanInstance, m_DebugMessenger, nullptr);
@@ -48,7 +50,8 @@ void VulkanContext::CreateInstance(const char* title)
 	appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 	appInfo.pEngineName = "No Engine";
 	appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-	appInfo.apiVersion = VK_API_VERSION_1_0; // the highest version the application is designed to use
+	// the highest version the application is designed to use, 1.1 for the features2 queries of the extensions
+	appInfo.apiVersion = VK_API_VERSION_1_1;
 
 	VkInstanceCreateInfo instanceInfo{};
 	instanceInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
@@ -81,9 +84,14 @@ void VulkanContext::CreateInstance(const char* title)
 
 std::vector<const char*> VulkanContext::GetRequiredExtensions()
 {
-	uint32_t extensionCount = 0;
-	const char** extensions = Window::GetRequiredVulkanExtensions(&extensionCount);
-	std::vector<const char*> availableExtensions{ extensions, extensions + extensionCount };
+	std::vector<const char*> availableExtensions{};
+	// the surface extensions are only needed to present to a window
+	if (!m_Config.headless)
+	{
+		uint32_t extensionCount = 0;
+		const char** extensions = Window::GetRequiredVulkanExtensions(&extensionCount);
+		availableExtensions.assign(extensions, extensions + extensionCount);
+	}
 
 	if (m_Config.enableValidationLayers)
 		availableExtensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
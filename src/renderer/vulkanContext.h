@@ -15,21 +15,33 @@ public:
 	std::vector<const char*> validationLayers;
 	std::vector<const char*> deviceExtensions;
 
+	// depth 1 at the near plane and 0 at infinity (infinite far plane)
+	// the floating point depth precision is then spread evenly over the distance
+	bool reverseZ;
+
+	// renders into offscreen images instead of a window's swapchain, no window, surface or present is used
+	// so it runs on machines without a display (eg: with a software rasterizer like lavapipe)
+	bool headless = false;
+	VkExtent2D headlessExtent{ 1280, 720 };
+
 public:
 	VulkanConfig(bool enableValidationLayers,
 		uint32_t maxFramesInFlight,
 		const std::vector<const char*>& validationLayers,
-		const std::vector<const char*>& deviceExtensions)
+		const std::vector<const char*>& deviceExtensions,
+		bool reverseZ)
 		: enableValidationLayers{ enableValidationLayers },
 		  maxFramesInFlight{ maxFramesInFlight },
 		  validationLayers{ validationLayers },
-		  deviceExtensions{ deviceExtensions }
+		  deviceExtensions{ deviceExtensions },
+		  reverseZ{ reverseZ }
 	{}
 };
 
 class VulkanContext
 {
 public:
+	// `window` is null in headless mode
 	VulkanContext(const char* title, const VulkanConfig& config, const std::shared_ptr<Window>& window);
 	VulkanContext(const VulkanContext&) = delete;
 	VulkanContext& operator=(const VulkanContext&) = delete;
@@ -38,7 +50,11 @@ public:
 	static std::shared_ptr<VulkanContext>
 		Create(const char* title, const VulkanConfig& config, const std::shared_ptr<Window>& window);
 	static inline VkInstance GetInstance() { return s_Instance->m_VulkanInstance; }
-	static inline VkSurfaceKHR GetWindowSurface() { return s_Instance->m_Window->GetWindowSurface(); }
+	// `VK_NULL_HANDLE` in headless mode
+	static inline VkSurfaceKHR GetWindowSurface()
+	{
+		return s_Instance->m_Window ? s_Instance->m_Window->GetWindowSurface() : VK_NULL_HANDLE;
+	}
 
 private:
 	void CreateInstance(const char* title);
@@ -0,0 +1,289 @@
+#include "utils/ktx2.h"
+
+#include <array>
+#include <cstring>
+#include <fstream>
+#include <algorithm>
+#include <filesystem>
+#include "core/core.h"
+
+
+namespace utils {
+
+// «KTX 20»\r\n\x1a\n
+constexpr std::array<uint8_t, 12> KTX2_IDENTIFIER{
+	0xab, 0x4b, 0x54, 0x58, 0x20, 0x32, 0x30, 0xbb, 0x0d, 0x0a, 0x1a, 0x0a
+};
+constexpr uint64_t KTX2_HEADER_SIZE = 80; // identifier, header and index
+constexpr uint64_t KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+
+// values of the basic data format descriptor (Khronos Data Format Specification 1.3)
+constexpr uint8_t KHR_DF_MODEL_RGBSDA = 1;
+constexpr uint8_t KHR_DF_MODEL_BC1A = 128;
+constexpr uint8_t KHR_DF_MODEL_BC5 = 131;
+constexpr uint8_t KHR_DF_MODEL_BC7 = 134;
+constexpr uint8_t KHR_DF_PRIMARIES_BT709 = 1;
+constexpr uint8_t KHR_DF_TRANSFER_LINEAR = 1;
+constexpr uint8_t KHR_DF_TRANSFER_SRGB = 2;
+constexpr uint8_t KHR_DF_SAMPLE_DATATYPE_LINEAR = 0x10; // the alpha of an srgb format
+constexpr uint8_t KHR_DF_CHANNEL_ALPHA = 15;
+
+// a channel of a texel block in the data format descriptor
+struct DfdSample
+{
+	uint16_t bitOffset = 0;
+	uint8_t bitLength = 0; // minus 1
+	uint8_t channelType = 0;
+	uint32_t upper = 0;
+};
+
+struct FormatInfo
+{
+	uint32_t blockBytes = 0;
+	uint32_t blockDim = 1; // texels per side of a block
+	uint8_t colorModel = 0;
+	bool srgb = false;
+	std::vector<DfdSample> samples{};
+};
+
+static FormatInfo GetFormatInfo(VkFormat format)
+{
+	switch (format)
+	{
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+	{
+		const bool srgb = format == VK_FORMAT_R8G8B8A8_SRGB;
+		const uint8_t alphaType =
+			srgb ? static_cast<uint8_t>(KHR_DF_CHANNEL_ALPHA | KHR_DF_SAMPLE_DATATYPE_LINEAR) : KHR_DF_CHANNEL_ALPHA;
+		return { 4,
+			1,
+			KHR_DF_MODEL_RGBSDA,
+			srgb,
+			{ { 0, 7, 0, 255 }, { 8, 7, 1, 255 }, { 16, 7, 2, 255 }, { 24, 7, alphaType, 255 } } };
+	}
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		return { 8, 4, KHR_DF_MODEL_BC1A, format == VK_FORMAT_BC1_RGB_SRGB_BLOCK, { { 0, 63, 0, 0xffffffff } } };
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+		return { 16, 4, KHR_DF_MODEL_BC5, false, { { 0, 63, 0, 0xffffffff }, { 64, 63, 1, 0xffffffff } } };
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		return { 16, 4, KHR_DF_MODEL_BC7, format == VK_FORMAT_BC7_SRGB_BLOCK, { { 0, 127, 0, 0xffffffff } } };
+	default:
+		LOG_AND_THROW("Unsupported KTX2 format: {}", static_cast<int>(format));
+	}
+}
+
+static uint64_t GetLevelSize(const FormatInfo& info, uint32_t width, uint32_t height, uint32_t level)
+{
+	const uint64_t levelWidth = std::max(width >> level, 1u);
+	const uint64_t levelHeight = std::max(height >> level, 1u);
+	return ((levelWidth + info.blockDim - 1) / info.blockDim) * ((levelHeight + info.blockDim - 1) / info.blockDim)
+		   * info.blockBytes;
+}
+
+template<typename T>
+static void Append(std::vector<uint8_t>& bytes, T value)
+{
+	// the files are little endian, like the hosts we run on
+	const size_t offset = bytes.size();
+	bytes.resize(offset + sizeof(T));
+	std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+template<typename T>
+static T Read(const std::vector<uint8_t>& bytes, uint64_t offset, const std::string& path)
+{
+	THROW(offset + sizeof(T) > bytes.size(), "Truncated KTX2 file: {}", path)
+
+	T value{};
+	std::memcpy(&value, bytes.data() + offset, sizeof(T));
+	return value;
+}
+
+// the basic data format descriptor block, with its total size in front
+static std::vector<uint8_t> CreateDataFormatDescriptor(const FormatInfo& info)
+{
+	const uint16_t blockSize = static_cast<uint16_t>(24 + 16 * info.samples.size());
+	std::vector<uint8_t> dfd{};
+	Append<uint32_t>(dfd, 4u + blockSize);
+	Append<uint32_t>(dfd, 0); // vendor id and descriptor type (khronos, basic)
+	Append<uint16_t>(dfd, 2); // version number
+	Append<uint16_t>(dfd, blockSize);
+	Append<uint8_t>(dfd, info.colorModel);
+	Append<uint8_t>(dfd, KHR_DF_PRIMARIES_BT709);
+	Append<uint8_t>(dfd, info.srgb ? KHR_DF_TRANSFER_SRGB : KHR_DF_TRANSFER_LINEAR);
+	Append<uint8_t>(dfd, 0); // flags, straight alpha
+	for (uint32_t i = 0; i < 4; ++i)
+		Append<uint8_t>(dfd, static_cast<uint8_t>(i < 2 ? info.blockDim - 1 : 0)); // texel block dimensions
+	for (uint32_t i = 0; i < 8; ++i)
+		Append<uint8_t>(dfd, static_cast<uint8_t>(i == 0 ? info.blockBytes : 0)); // bytes per plane
+
+	for (const auto& sample : info.samples)
+	{
+		Append<uint16_t>(dfd, sample.bitOffset);
+		Append<uint8_t>(dfd, sample.bitLength);
+		Append<uint8_t>(dfd, sample.channelType);
+		Append<uint32_t>(dfd, 0); // sample position
+		Append<uint32_t>(dfd, 0); // lower
+		Append<uint32_t>(dfd, sample.upper);
+	}
+
+	return dfd;
+}
+
+std::string GetCookedTexturePath(const std::string& sourcePath)
+{
+	return std::filesystem::path(sourcePath).replace_extension(".ktx2").string();
+}
+
+std::string GetMipCachePath(const std::string& sourcePath)
+{
+	return std::filesystem::path(sourcePath).replace_extension(".mips.ktx2").string();
+}
+
+void WriteKtx2(const std::string& path, const Ktx2Image& image)
+{
+	const FormatInfo info = GetFormatInfo(image.format);
+	const uint32_t levelCount = static_cast<uint32_t>(image.levels.size());
+	THROW(levelCount == 0, "A KTX2 image needs at least one level: {}", path)
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		THROW(image.levels[level].size() != GetLevelSize(info, image.width, image.height, level),
+			"Level {} doesn't match the size of the image: {}",
+			level,
+			path)
+	}
+
+	const std::vector<uint8_t> dfd = CreateDataFormatDescriptor(info);
+	const uint64_t dfdOffset = KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_ENTRY_SIZE * levelCount;
+
+	// the levels are stored from the smallest to the largest, aligned to the size of a block (and to 4 bytes)
+	const uint64_t alignment = std::max(info.blockBytes, 4u);
+	std::vector<uint64_t> levelOffsets(levelCount, 0);
+	uint64_t offset = dfdOffset + dfd.size();
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		offset = (offset + alignment - 1) / alignment * alignment;
+		levelOffsets[level] = offset;
+		offset += image.levels[level].size();
+	}
+
+	std::vector<uint8_t> bytes(KTX2_IDENTIFIER.begin(), KTX2_IDENTIFIER.end());
+	bytes.reserve(offset);
+	Append<uint32_t>(bytes, static_cast<uint32_t>(image.format));
+	Append<uint32_t>(bytes, 1); // type size, bytes of a component (1 for the block compressed formats)
+	Append<uint32_t>(bytes, image.width);
+	Append<uint32_t>(bytes, image.height);
+	Append<uint32_t>(bytes, 0); // depth
+	Append<uint32_t>(bytes, 0); // array layers
+	Append<uint32_t>(bytes, 1); // faces
+	Append<uint32_t>(bytes, levelCount);
+	Append<uint32_t>(bytes, 0); // supercompression scheme
+	Append<uint32_t>(bytes, static_cast<uint32_t>(dfdOffset));
+	Append<uint32_t>(bytes, static_cast<uint32_t>(dfd.size()));
+	Append<uint32_t>(bytes, 0); // key/value data
+	Append<uint32_t>(bytes, 0);
+	Append<uint64_t>(bytes, 0); // supercompression global data
+	Append<uint64_t>(bytes, 0);
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		Append<uint64_t>(bytes, levelOffsets[level]);
+		Append<uint64_t>(bytes, image.levels[level].size());
+		Append<uint64_t>(bytes, image.levels[level].size()); // uncompressed size, the same without supercompression
+	}
+	bytes.insert(bytes.end(), dfd.begin(), dfd.end());
+	for (uint32_t level = levelCount; level-- > 0;)
+	{
+		bytes.resize(levelOffsets[level], 0);
+		bytes.insert(bytes.end(), image.levels[level].begin(), image.levels[level].end());
+	}
+
+	std::ofstream file{ path, std::ios::binary };
+	THROW(!file.is_open(), "Failed to open {}!", path)
+	file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	THROW(!file, "Failed to write {}!", path)
+}
+
+Ktx2Image ReadKtx2(const std::string& path)
+{
+	const Ktx2Header header = ReadKtx2Header(path);
+	Ktx2Image image{};
+	image.format = header.format;
+	image.width = header.width;
+	image.height = header.height;
+	image.levels.reserve(header.levelSizes.size());
+	for (uint32_t level = 0; level < static_cast<uint32_t>(header.levelSizes.size()); ++level)
+		image.levels.push_back(ReadKtx2Level(path, header, level));
+
+	return image;
+}
+
+Ktx2Header ReadKtx2Header(const std::string& path)
+{
+	std::ifstream file{ path, std::ios::binary };
+	THROW(!file.is_open(), "Failed to open {}!", path)
+	std::vector<uint8_t> bytes(KTX2_HEADER_SIZE);
+	file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+
+	THROW(!file || !std::equal(KTX2_IDENTIFIER.begin(), KTX2_IDENTIFIER.end(), bytes.begin()),
+		"Not a KTX2 file: {}",
+		path)
+
+	Ktx2Header header{};
+	header.format = static_cast<VkFormat>(Read<uint32_t>(bytes, 12, path));
+	header.width = Read<uint32_t>(bytes, 20, path);
+	header.height = Read<uint32_t>(bytes, 24, path);
+	const uint32_t depth = Read<uint32_t>(bytes, 28, path);
+	const uint32_t layerCount = Read<uint32_t>(bytes, 32, path);
+	const uint32_t faceCount = Read<uint32_t>(bytes, 36, path);
+	// 0 asks the loader to generate the mips, only level 0 is stored
+	const uint32_t levelCount = std::max(Read<uint32_t>(bytes, 40, path), 1u);
+	const uint32_t supercompression = Read<uint32_t>(bytes, 44, path);
+	THROW(header.width == 0 || header.height == 0 || depth != 0 || layerCount > 1 || faceCount != 1,
+		"Only 2D KTX2 textures are supported: {}",
+		path)
+	THROW(supercompression != 0, "Supercompressed KTX2 files are not supported: {}", path)
+
+	bytes.resize(KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_ENTRY_SIZE * levelCount);
+	file.read(reinterpret_cast<char*>(bytes.data() + KTX2_HEADER_SIZE),
+		static_cast<std::streamsize>(KTX2_LEVEL_INDEX_ENTRY_SIZE * levelCount));
+	THROW(!file, "Truncated KTX2 file: {}", path)
+	file.seekg(0, std::ios::end);
+	const uint64_t fileSize = static_cast<uint64_t>(file.tellg());
+
+	const FormatInfo info = GetFormatInfo(header.format);
+	header.levelOffsets.reserve(levelCount);
+	header.levelSizes.reserve(levelCount);
+	for (uint32_t level = 0; level < levelCount; ++level)
+	{
+		const uint64_t entry = KTX2_HEADER_SIZE + KTX2_LEVEL_INDEX_ENTRY_SIZE * level;
+		const uint64_t offset = Read<uint64_t>(bytes, entry, path);
+		const uint64_t size = Read<uint64_t>(bytes, entry + 8, path);
+		THROW(size != GetLevelSize(info, header.width, header.height, level) || offset + size > fileSize,
+			"Level {} of the KTX2 file is invalid: {}",
+			level,
+			path)
+
+		header.levelOffsets.push_back(offset);
+		header.levelSizes.push_back(size);
+	}
+
+	return header;
+}
+
+std::vector<uint8_t> ReadKtx2Level(const std::string& path, const Ktx2Header& header, uint32_t level)
+{
+	std::ifstream file{ path, std::ios::binary };
+	THROW(!file.is_open(), "Failed to open {}!", path)
+
+	std::vector<uint8_t> bytes(header.levelSizes[level]);
+	file.seekg(static_cast<std::streamoff>(header.levelOffsets[level]));
+	file.read(reinterpret_cast<char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+	THROW(!file, "Failed to read level {} of {}!", level, path)
+
+	return bytes;
+}
+
+} // namespace utils
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <vulkan/vulkan.h>
+
+
+namespace utils {
+
+// a 2D texture with its mip chain in a KTX 2.0 container (no supercompression, no array layers or faces)
+// written for the block compressed formats of the cooker (bc1, bc5, bc7) and rgba8
+struct Ktx2Image
+{
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t width = 0; // of level 0
+	uint32_t height = 0;
+	std::vector<std::vector<uint8_t>> levels{}; // level 0 is the full resolution
+};
+
+// path of the cooked texture of a source image, the same path with the `.ktx2` extension
+std::string GetCookedTexturePath(const std::string& sourcePath);
+// path of the rgba8 mip chain the renderer caches when there is no usable cooked texture, the `.mips.ktx2` extension
+// so that it never overwrites the output of the cooker
+std::string GetMipCachePath(const std::string& sourcePath);
+
+// where the levels of a KTX2 file are, to read them one at a time (eg: when they are streamed)
+struct Ktx2Header
+{
+	VkFormat format = VK_FORMAT_UNDEFINED;
+	uint32_t width = 0; // of level 0
+	uint32_t height = 0;
+	std::vector<uint64_t> levelOffsets{}; // in the file
+	std::vector<uint64_t> levelSizes{};
+};
+
+void WriteKtx2(const std::string& path, const Ktx2Image& image);
+// these throw if the file isn't a KTX 2.0 file of a layout that `WriteKtx2()` can write
+Ktx2Image ReadKtx2(const std::string& path);
+// only reads the header and the level index
+Ktx2Header ReadKtx2Header(const std::string& path);
+std::vector<uint8_t> ReadKtx2Level(const std::string& path, const Ktx2Header& header, uint32_t level);
+
+} // namespace utils
@@ -0,0 +1,305 @@
+#include "utils/meshOptimizer.h"
+
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include "utils/utils.h"
+
+
+namespace utils {
+
+constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount)
+{
+	VertexCacheStats stats{};
+	stats.triangleCount = indices.size() / 3;
+
+	// a vertex is in the fifo if fewer than `VERTEX_CACHE_SIZE` vertices were transformed after it
+	std::vector<uint64_t> cacheTime(vertexCount, 0);
+	uint64_t time = VERTEX_CACHE_SIZE + 1;
+	std::vector<bool> referenced(vertexCount, false);
+	for (uint32_t index : indices)
+	{
+		if (time - cacheTime[index] > VERTEX_CACHE_SIZE)
+		{
+			cacheTime[index] = time++;
+			++stats.transformCount;
+		}
+
+		if (!referenced[index])
+		{
+			referenced[index] = true;
+			++stats.vertexCount;
+		}
+	}
+
+	return stats;
+}
+
+void OptimizeVertexCache(std::vector<uint32_t>& indices, size_t vertexCount, std::vector<uint32_t>* clusterStarts)
+{
+	const size_t triangleCount = indices.size() / 3;
+	if (clusterStarts != nullptr)
+		clusterStarts->assign(1, 0);
+	if (triangleCount == 0)
+		return;
+
+	// triangles of every vertex, `liveCount` is the number of triangles of the vertex that are not emitted yet
+	std::vector<uint32_t> liveCount(vertexCount, 0);
+	for (uint32_t index : indices)
+		++liveCount[index];
+
+	std::vector<uint32_t> offsets(vertexCount + 1, 0);
+	std::partial_sum(liveCount.begin(), liveCount.end(), offsets.begin() + 1);
+	std::vector<uint32_t> adjacency(indices.size());
+	std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+	for (size_t i = 0; i < indices.size(); ++i)
+		adjacency[cursors[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+	std::vector<uint64_t> cacheTime(vertexCount, 0);
+	uint64_t time = VERTEX_CACHE_SIZE + 1;
+	std::vector<bool> emitted(triangleCount, false);
+	std::vector<uint32_t> deadEnds{}; // recently used vertices, to continue from when the fan runs out of triangles
+	deadEnds.reserve(indices.size());
+	std::vector<uint32_t> candidates{};
+	std::vector<uint32_t> output{};
+	output.reserve(indices.size());
+	uint32_t nextVertex = 0; // the vertices before this have no triangles left
+
+	auto skipDeadEnd = [&]() {
+		while (!deadEnds.empty())
+		{
+			const uint32_t vertex = deadEnds.back();
+			deadEnds.pop_back();
+			if (liveCount[vertex] > 0)
+				return vertex;
+		}
+
+		for (; nextVertex < vertexCount; ++nextVertex)
+		{
+			if (liveCount[nextVertex] > 0)
+				return nextVertex;
+		}
+
+		return NO_VERTEX;
+	};
+
+	uint32_t fanVertex = skipDeadEnd();
+	while (fanVertex != NO_VERTEX)
+	{
+		// emit all the remaining triangles around the fanning vertex
+		candidates.clear();
+		for (uint32_t i = offsets[fanVertex]; i < offsets[fanVertex + 1]; ++i)
+		{
+			const uint32_t triangle = adjacency[i];
+			if (emitted[triangle])
+				continue;
+
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				deadEnds.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveCount[vertex];
+				if (time - cacheTime[vertex] > VERTEX_CACHE_SIZE)
+					cacheTime[vertex] = time++;
+			}
+
+			emitted[triangle] = true;
+		}
+
+		// the next fanning vertex is the oldest candidate that is still in the cache after its triangles are emitted
+		uint32_t bestVertex = NO_VERTEX;
+		int64_t bestPriority = -1;
+		for (uint32_t vertex : candidates)
+		{
+			if (liveCount[vertex] == 0)
+				continue;
+
+			int64_t priority = 0;
+			if (time - cacheTime[vertex] + 2 * liveCount[vertex] <= VERTEX_CACHE_SIZE)
+				priority = static_cast<int64_t>(time - cacheTime[vertex]);
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				bestVertex = vertex;
+			}
+		}
+
+		if (bestVertex == NO_VERTEX)
+		{
+			bestVertex = skipDeadEnd();
+			// the cache is cold again, this is where the next cluster starts
+			const uint32_t clusterStart = static_cast<uint32_t>(output.size() / 3);
+			if (bestVertex != NO_VERTEX && clusterStarts != nullptr && clusterStarts->back() != clusterStart)
+				clusterStarts->push_back(clusterStart);
+		}
+
+		fanVertex = bestVertex;
+	}
+
+	indices = std::move(output);
+}
+
+void OptimizeOverdraw(std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& clusterStarts,
+	float threshold)
+{
+	const uint32_t triangleCount = static_cast<uint32_t>(indices.size() / 3);
+	if (triangleCount == 0 || clusterStarts.empty())
+		return;
+
+	const float inputAcmr = AnalyzeVertexCache(indices, vertices.size()).GetAcmr();
+
+	// split the clusters further, where the acmr of the cluster so far is close enough to the acmr of the whole cluster
+	// a cluster starts with a cold cache
+	std::vector<uint32_t> clusters{};
+	std::vector<uint64_t> cacheTime(vertices.size(), 0);
+	uint64_t time = VERTEX_CACHE_SIZE + 1;
+	auto countMisses = [&](uint32_t triangle) {
+		uint32_t misses = 0;
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			const uint32_t vertex = indices[triangle * 3 + corner];
+			if (time - cacheTime[vertex] > VERTEX_CACHE_SIZE)
+			{
+				cacheTime[vertex] = time++;
+				++misses;
+			}
+		}
+
+		return misses;
+	};
+
+	for (size_t c = 0; c < clusterStarts.size(); ++c)
+	{
+		const uint32_t begin = clusterStarts[c];
+		const uint32_t end = c + 1 < clusterStarts.size() ? clusterStarts[c + 1] : triangleCount;
+
+		time += VERTEX_CACHE_SIZE + 1; // flush
+		uint32_t clusterMisses = 0;
+		for (uint32_t t = begin; t < end; ++t)
+			clusterMisses += countMisses(t);
+		const float splitThreshold = threshold * static_cast<float>(clusterMisses) / static_cast<float>(end - begin);
+
+		time += VERTEX_CACHE_SIZE + 1;
+		clusters.push_back(begin);
+		uint32_t misses = 0;
+		uint32_t start = begin;
+		for (uint32_t t = begin; t < end; ++t)
+		{
+			misses += countMisses(t);
+			if (t + 1 < end && static_cast<float>(misses) <= splitThreshold * static_cast<float>(t + 1 - start))
+			{
+				clusters.push_back(t + 1);
+				time += VERTEX_CACHE_SIZE + 1;
+				misses = 0;
+				start = t + 1;
+			}
+		}
+	}
+
+	// the area weighted centroid of the mesh, and of every cluster with its area weighted normal
+	// the clusters whose normals point away from the center of the mesh are drawn first
+	auto clusterEnd = [&](size_t c) { return c + 1 < clusters.size() ? clusters[c + 1] : triangleCount; };
+	std::vector<glm::vec3> clusterCentroids(clusters.size(), glm::vec3(0.0f));
+	std::vector<glm::vec3> clusterNormals(clusters.size(), glm::vec3(0.0f));
+	glm::vec3 meshCentroid{ 0.0f };
+	float meshArea = 0.0f;
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		float clusterArea = 0.0f;
+		for (uint32_t t = clusters[c]; t < clusterEnd(c); ++t)
+		{
+			const glm::vec3& p0 = vertices[indices[t * 3 + 0]].pos;
+			const glm::vec3& p1 = vertices[indices[t * 3 + 1]].pos;
+			const glm::vec3& p2 = vertices[indices[t * 3 + 2]].pos;
+			const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0); // length is twice the area
+			const float area = glm::length(normal);
+
+			clusterCentroids[c] += (p0 + p1 + p2) * (area / 3.0f);
+			clusterNormals[c] += normal;
+			clusterArea += area;
+		}
+
+		meshCentroid += clusterCentroids[c];
+		meshArea += clusterArea;
+		if (clusterArea > 0.0f)
+			clusterCentroids[c] /= clusterArea;
+	}
+
+	if (meshArea > 0.0f)
+		meshCentroid /= meshArea;
+
+	std::vector<float> sortKeys(clusters.size(), 0.0f);
+	for (size_t c = 0; c < clusters.size(); ++c)
+	{
+		const float normalLength = glm::length(clusterNormals[c]);
+		if (normalLength > 0.0f)
+			sortKeys[c] = glm::dot(clusterCentroids[c] - meshCentroid, clusterNormals[c] / normalLength);
+	}
+
+	std::vector<uint32_t> order(clusters.size());
+	std::iota(order.begin(), order.end(), 0);
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return sortKeys[a] > sortKeys[b]; });
+
+	std::vector<uint32_t> output{};
+	output.reserve(indices.size());
+	for (uint32_t c : order)
+		output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusterEnd(c) * 3);
+
+	// the soft splits bound the acmr of every cluster, not of the whole mesh, keep the input if it got too much worse
+	if (AnalyzeVertexCache(output, vertices.size()).GetAcmr() <= inputAcmr * threshold)
+		indices = std::move(output);
+}
+
+void OptimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<Vertex>& vertices)
+{
+	std::vector<uint32_t> remap(vertices.size(), NO_VERTEX);
+	std::vector<Vertex> output{};
+	output.reserve(vertices.size());
+
+	for (uint32_t& index : indices)
+	{
+		if (remap[index] == NO_VERTEX)
+		{
+			remap[index] = static_cast<uint32_t>(output.size());
+			output.push_back(vertices[index]);
+		}
+
+		index = remap[index];
+	}
+
+	vertices = std::move(output);
+}
+
+MeshOptimizationStats OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	MeshOptimizationStats stats{};
+	stats.inputVertexCount = vertices.size();
+
+	// the importer doesn't join the identical vertices, without welding every corner would be a cache miss
+	std::vector<Vertex> corners{};
+	corners.reserve(indices.size());
+	for (uint32_t index : indices)
+		corners.push_back(vertices[index]);
+
+	auto [weldedIndices, weldedVertices] = GetModelData(corners, 0);
+	indices = std::move(weldedIndices);
+	vertices = std::move(weldedVertices);
+	stats.before = AnalyzeVertexCache(indices, vertices.size());
+
+	std::vector<uint32_t> clusterStarts{};
+	OptimizeVertexCache(indices, vertices.size(), &clusterStarts);
+	OptimizeOverdraw(indices, vertices, clusterStarts);
+	OptimizeVertexFetch(indices, vertices);
+
+	stats.after = AnalyzeVertexCache(indices, vertices.size());
+	stats.outputVertexCount = vertices.size();
+	return stats;
+}
+
+} // namespace utils
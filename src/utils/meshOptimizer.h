@@ -0,0 +1,76 @@
+#pragma once
+
+#include <vector>
+#include "renderer/vertexBuffer.h"
+
+
+namespace utils {
+
+constexpr uint32_t VERTEX_CACHE_SIZE = 16; // entries of the simulated post-transform cache (fifo)
+constexpr float OVERDRAW_ACMR_THRESHOLD = 1.05f; // how much the overdraw ordering may raise the acmr
+
+// post-transform cache efficiency of an index buffer, simulated with a fifo cache of `VERTEX_CACHE_SIZE` entries
+struct VertexCacheStats
+{
+	uint64_t triangleCount = 0;
+	uint64_t vertexCount = 0; // referenced vertices
+	uint64_t transformCount = 0; // cache misses, vertex shader invocations
+
+	// average cache miss ratio, transformed vertices per triangle (0.5 - 3.0, lower is better)
+	inline float GetAcmr() const
+	{
+		return triangleCount == 0 ? 0.0f : static_cast<float>(transformCount) / static_cast<float>(triangleCount);
+	}
+	// average transform to vertex ratio, 1.0 is optimal (every vertex is transformed once)
+	inline float GetAtvr() const
+	{
+		return vertexCount == 0 ? 0.0f : static_cast<float>(transformCount) / static_cast<float>(vertexCount);
+	}
+
+	VertexCacheStats& operator+=(const VertexCacheStats& other)
+	{
+		triangleCount += other.triangleCount;
+		vertexCount += other.vertexCount;
+		transformCount += other.transformCount;
+		return *this;
+	}
+};
+
+struct MeshOptimizationStats
+{
+	uint64_t inputVertexCount = 0;
+	uint64_t outputVertexCount = 0;
+	VertexCacheStats before{}; // after welding, in the imported triangle order
+	VertexCacheStats after{};
+
+	MeshOptimizationStats& operator+=(const MeshOptimizationStats& other)
+	{
+		inputVertexCount += other.inputVertexCount;
+		outputVertexCount += other.outputVertexCount;
+		before += other.before;
+		after += other.after;
+		return *this;
+	}
+};
+
+VertexCacheStats AnalyzeVertexCache(const std::vector<uint32_t>& indices, size_t vertexCount);
+
+// reorders the triangles for the post-transform cache (tipsify, Sander et al. 2007)
+// `clusterStarts` (optional) receives the first triangle of every cluster, a cluster starts where the cache is flushed
+void OptimizeVertexCache(std::vector<uint32_t>& indices,
+	size_t vertexCount,
+	std::vector<uint32_t>* clusterStarts = nullptr);
+// reorders the clusters of an index buffer that is already optimized for the vertex cache, so that the triangles
+// facing outwards, which likely occlude the rest of the mesh, are drawn first (view independent)
+// clusters are split further while the acmr stays within `threshold` of the input's
+void OptimizeOverdraw(std::vector<uint32_t>& indices,
+	const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& clusterStarts,
+	float threshold = OVERDRAW_ACMR_THRESHOLD);
+// reorders the vertices in the order they are first referenced (and drops the unused ones), remaps the indices
+void OptimizeVertexFetch(std::vector<uint32_t>& indices, std::vector<Vertex>& vertices);
+
+// welds the vertices, then runs the three passes above
+MeshOptimizationStats OptimizeMesh(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+} // namespace utils
@@ -0,0 +1,512 @@
+#include "utils/meshSimplifier.h"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include "utils/meshOptimizer.h"
+
+
+namespace utils {
+
+// the attribute penalty of a collapse is the squared distance of the attributes, scaled into the (squared) relative
+// position error, eg: flipping a normal (distance 2) costs as much as moving the vertex by 4% of the extent
+constexpr double SIMPLIFY_NORMAL_WEIGHT = 0.02;
+constexpr double SIMPLIFY_TEXCOORD_WEIGHT = 0.05;
+// a collapse is rejected when it turns a triangle by more than ~75 degrees (cos)
+constexpr double SIMPLIFY_MIN_NORMAL_DOT = 0.25;
+// the collapses of a pass cost at most this times the cost of the collapse that would reach the target
+constexpr double SIMPLIFY_PASS_COST_FACTOR = 1.5;
+constexpr uint32_t NO_VERTEX = std::numeric_limits<uint32_t>::max();
+
+// symmetric 4x4 matrix of the summed (weighted) plane equations, error(p) = (p^T A p + 2 b^T p + c) / weight
+// the error is the weighted mean of the squared distances to the planes
+struct Quadric
+{
+	double a00 = 0.0, a01 = 0.0, a02 = 0.0, a11 = 0.0, a12 = 0.0, a22 = 0.0;
+	double b0 = 0.0, b1 = 0.0, b2 = 0.0;
+	double c = 0.0;
+	double weight = 0.0;
+
+	// squared distance to the plane dot(normal, p) + distance = 0, times `weight`
+	static Quadric FromPlane(const glm::dvec3& normal, double distance, double weight)
+	{
+		Quadric quadric{};
+		quadric.a00 = weight * normal.x * normal.x;
+		quadric.a01 = weight * normal.x * normal.y;
+		quadric.a02 = weight * normal.x * normal.z;
+		quadric.a11 = weight * normal.y * normal.y;
+		quadric.a12 = weight * normal.y * normal.z;
+		quadric.a22 = weight * normal.z * normal.z;
+		quadric.b0 = weight * normal.x * distance;
+		quadric.b1 = weight * normal.y * distance;
+		quadric.b2 = weight * normal.z * distance;
+		quadric.c = weight * distance * distance;
+		quadric.weight = weight;
+		return quadric;
+	}
+
+	Quadric& operator+=(const Quadric& other)
+	{
+		a00 += other.a00;
+		a01 += other.a01;
+		a02 += other.a02;
+		a11 += other.a11;
+		a12 += other.a12;
+		a22 += other.a22;
+		b0 += other.b0;
+		b1 += other.b1;
+		b2 += other.b2;
+		c += other.c;
+		weight += other.weight;
+		return *this;
+	}
+
+	double GetError(const glm::dvec3& p) const
+	{
+		if (weight == 0.0)
+			return 0.0;
+		const double error = a00 * p.x * p.x + a11 * p.y * p.y + a22 * p.z * p.z
+							 + 2.0 * (a01 * p.x * p.y + a02 * p.x * p.z + a12 * p.y * p.z)
+							 + 2.0 * (b0 * p.x + b1 * p.y + b2 * p.z) + c;
+		return std::max(error / weight, 0.0); // rounding
+	}
+};
+
+static double GetAttributeDistance(const Vertex& a, const Vertex& b)
+{
+	const glm::vec3 normal = a.normal - b.normal;
+	const glm::vec2 texCoord = a.texCoord - b.texCoord;
+	return SIMPLIFY_NORMAL_WEIGHT * SIMPLIFY_NORMAL_WEIGHT * glm::dot(normal, normal)
+		   + SIMPLIFY_TEXCOORD_WEIGHT * SIMPLIFY_TEXCOORD_WEIGHT * glm::dot(texCoord, texCoord);
+}
+
+// largest side of the bounding box of the referenced vertices
+static float GetExtent(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices, glm::vec3& boundsMin)
+{
+	boundsMin = glm::vec3(std::numeric_limits<float>::max());
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (uint32_t index : indices)
+	{
+		boundsMin = glm::min(boundsMin, vertices[index].pos);
+		boundsMax = glm::max(boundsMax, vertices[index].pos);
+	}
+
+	if (indices.empty())
+		return 0.0f;
+	const glm::vec3 size = boundsMax - boundsMin;
+	return std::max(size.x, std::max(size.y, size.z));
+}
+
+std::vector<uint32_t> GroupPositions(const std::vector<Vertex>& vertices)
+{
+	std::vector<uint32_t> order(vertices.size());
+	std::iota(order.begin(), order.end(), 0);
+	auto samePosition = [&](uint32_t a, uint32_t b) { return vertices[a].pos == vertices[b].pos; };
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		const glm::vec3& pa = vertices[a].pos;
+		const glm::vec3& pb = vertices[b].pos;
+		if (pa.x != pb.x)
+			return pa.x < pb.x;
+		if (pa.y != pb.y)
+			return pa.y < pb.y;
+		if (pa.z != pb.z)
+			return pa.z < pb.z;
+		return a < b;
+	});
+
+	std::vector<uint32_t> groups(vertices.size());
+	for (size_t i = 0; i < order.size(); ++i)
+	{
+		const bool first = i == 0 || !samePosition(order[i - 1], order[i]);
+		groups[order[i]] = first ? order[i] : groups[order[i - 1]];
+	}
+
+	return groups;
+}
+
+// the state of the simplification of a mesh, `Simplify()` can be called with decreasing targets (eg: lods), the
+// quadrics and the attribute errors of the collapses so far are kept, the errors are relative to the input mesh
+class Simplifier
+{
+public:
+	Simplifier(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices);
+
+	// collapses until `targetIndexCount` or until the next collapse costs more than `maxError`
+	void Simplify(size_t targetIndexCount, float maxError);
+
+	inline const std::vector<uint32_t>& GetIndices() const { return m_Indices; }
+	inline float GetError() const { return static_cast<float>(std::sqrt(m_Cost)); }
+
+private:
+	struct Collapse
+	{
+		uint32_t from;
+		uint32_t to;
+		double cost;
+	};
+
+	inline uint32_t GetGroup(size_t triangle, uint32_t corner) const
+	{
+		return m_Groups[m_Indices[triangle * 3 + corner]];
+	}
+
+	void UpdateAdjacency();
+	void GatherWedges(uint32_t group, std::vector<uint32_t>& wedges) const;
+	double MapWedges(uint32_t from, uint32_t to);
+	bool FlipsTriangle(uint32_t from, uint32_t to) const;
+	size_t CollapsePass(double costLimit, size_t trianglesToRemove);
+
+private:
+	const std::vector<Vertex>& m_Vertices;
+	std::vector<uint32_t> m_Indices;
+	std::vector<uint32_t> m_Groups;
+	std::vector<glm::dvec3> m_Positions; // relative to the extent, the errors don't depend on the scale of the mesh
+	std::vector<bool> m_Locked;
+	std::vector<Quadric> m_Quadrics;
+	std::vector<double> m_AttributeErrors; // accumulated from the vertices collapsed into a vertex
+	double m_Cost = 0.0; // of the most expensive collapse so far
+
+	// the triangles around every group
+	std::vector<uint32_t> m_Offsets;
+	std::vector<uint32_t> m_Adjacency{};
+
+	std::vector<Collapse> m_Collapses{};
+	std::vector<uint32_t> m_Remap;
+	std::vector<bool> m_Touched;
+	std::vector<uint32_t> m_FromWedges{};
+	std::vector<uint32_t> m_ToWedges{};
+	std::vector<uint32_t> m_WedgeTargets{};
+};
+
+Simplifier::Simplifier(const std::vector<Vertex>& vertices, const std::vector<uint32_t>& indices)
+	: m_Vertices{ vertices },
+	  m_Indices{ indices },
+	  m_Groups{ GroupPositions(vertices) },
+	  m_Positions(vertices.size()),
+	  m_Locked(vertices.size(), false),
+	  m_Quadrics(vertices.size()),
+	  m_AttributeErrors(vertices.size(), 0.0),
+	  m_Offsets(vertices.size() + 1),
+	  m_Remap(vertices.size()),
+	  m_Touched(vertices.size())
+{
+	glm::vec3 boundsMin{};
+	const float extent = GetExtent(vertices, indices, boundsMin);
+	const double scale = extent > 0.0f ? 1.0 / static_cast<double>(extent) : 0.0;
+	for (size_t i = 0; i < vertices.size(); ++i)
+		m_Positions[i] = glm::dvec3(vertices[i].pos - boundsMin) * scale;
+
+	// the open borders and the non manifold edges are locked (edges used by one or more than two triangles)
+	const size_t triangleCount = m_Indices.size() / 3;
+	std::vector<uint64_t> edges{};
+	edges.reserve(m_Indices.size());
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			const uint64_t a = GetGroup(t, corner);
+			const uint64_t b = GetGroup(t, (corner + 1) % 3);
+			if (a != b)
+				edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+		}
+	}
+
+	std::sort(edges.begin(), edges.end());
+	for (size_t i = 0; i < edges.size();)
+	{
+		size_t end = i + 1;
+		while (end < edges.size() && edges[end] == edges[i])
+			++end;
+		if (end - i != 2)
+		{
+			m_Locked[edges[i] >> 32] = true;
+			m_Locked[edges[i] & 0xffffffff] = true;
+		}
+		i = end;
+	}
+
+	// the planes of the triangles around every group, weighted by the area
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		const glm::dvec3& p0 = m_Positions[GetGroup(t, 0)];
+		const glm::dvec3& p1 = m_Positions[GetGroup(t, 1)];
+		const glm::dvec3& p2 = m_Positions[GetGroup(t, 2)];
+		glm::dvec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const double length = glm::length(normal); // twice the area
+		if (length == 0.0)
+			continue;
+
+		normal /= length;
+		const Quadric quadric = Quadric::FromPlane(normal, -glm::dot(normal, p0), length * 0.5);
+		for (uint32_t corner = 0; corner < 3; ++corner)
+			m_Quadrics[GetGroup(t, corner)] += quadric;
+	}
+}
+
+void Simplifier::Simplify(size_t targetIndexCount, float maxError)
+{
+	const double maxCost = static_cast<double>(maxError) * static_cast<double>(maxError);
+	while (m_Indices.size() > targetIndexCount)
+	{
+		UpdateAdjacency();
+
+		// every half edge is a collapse of its first vertex into the second, the other direction is the half edge of
+		// the neighbouring triangle, the vertices collapse into their neighbours (no new positions)
+		const size_t triangleCount = m_Indices.size() / 3;
+		m_Collapses.clear();
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				const uint32_t from = GetGroup(t, corner);
+				const uint32_t to = GetGroup(t, (corner + 1) % 3);
+				if (from == to || m_Locked[from])
+					continue;
+
+				Quadric quadric = m_Quadrics[from];
+				quadric += m_Quadrics[to];
+				m_Collapses.push_back({ from, to, quadric.GetError(m_Positions[to]) + MapWedges(from, to) });
+			}
+		}
+
+		if (m_Collapses.empty())
+			break;
+		std::sort(m_Collapses.begin(), m_Collapses.end(), [](const Collapse& a, const Collapse& b) {
+			return a.cost < b.cost;
+		});
+
+		// an interior collapse removes two triangles
+		// the pass limit keeps the expensive collapses for the later passes, unless all the cheap ones are rejected
+		const size_t trianglesToRemove = (m_Indices.size() - targetIndexCount + 2) / 3;
+		const size_t goal = std::min(m_Collapses.size(), (trianglesToRemove + 1) / 2) - 1;
+		const double passCost = std::min(maxCost, m_Collapses[goal].cost * SIMPLIFY_PASS_COST_FACTOR);
+		if (CollapsePass(passCost, trianglesToRemove) == 0
+			&& (passCost >= maxCost || CollapsePass(maxCost, trianglesToRemove) == 0))
+			break;
+
+		// the collapsed triangles have two corners in the same group
+		size_t count = 0;
+		for (size_t t = 0; t < triangleCount; ++t)
+		{
+			const uint32_t a = m_Remap[m_Indices[t * 3 + 0]];
+			const uint32_t b = m_Remap[m_Indices[t * 3 + 1]];
+			const uint32_t c = m_Remap[m_Indices[t * 3 + 2]];
+			if (m_Groups[a] == m_Groups[b] || m_Groups[b] == m_Groups[c] || m_Groups[a] == m_Groups[c])
+				continue;
+
+			m_Indices[count++] = a;
+			m_Indices[count++] = b;
+			m_Indices[count++] = c;
+		}
+		m_Indices.resize(count);
+	}
+}
+
+void Simplifier::UpdateAdjacency()
+{
+	const size_t triangleCount = m_Indices.size() / 3;
+	std::fill(m_Offsets.begin(), m_Offsets.end(), 0);
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		for (uint32_t corner = 0; corner < 3; ++corner)
+			++m_Offsets[GetGroup(t, corner) + 1];
+	}
+
+	std::partial_sum(m_Offsets.begin(), m_Offsets.end(), m_Offsets.begin());
+	m_Adjacency.resize(m_Indices.size());
+	std::vector<uint32_t> cursors(m_Offsets.begin(), m_Offsets.end() - 1);
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		for (uint32_t corner = 0; corner < 3; ++corner)
+			m_Adjacency[cursors[GetGroup(t, corner)]++] = static_cast<uint32_t>(t);
+	}
+}
+
+// the vertices of `group` used by the triangles around it
+void Simplifier::GatherWedges(uint32_t group, std::vector<uint32_t>& wedges) const
+{
+	wedges.clear();
+	for (uint32_t i = m_Offsets[group]; i < m_Offsets[group + 1]; ++i)
+	{
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			const uint32_t vertex = m_Indices[m_Adjacency[i] * 3 + corner];
+			if (m_Groups[vertex] == group && std::find(wedges.begin(), wedges.end(), vertex) == wedges.end())
+				wedges.push_back(vertex);
+		}
+	}
+}
+
+// every vertex of `from` becomes the vertex of `to` it shares a triangle with, or the one with the closest attributes
+// returns the attribute error of the collapse
+double Simplifier::MapWedges(uint32_t from, uint32_t to)
+{
+	GatherWedges(from, m_FromWedges);
+	m_WedgeTargets.clear();
+	double error = 0.0;
+	for (uint32_t wedge : m_FromWedges)
+	{
+		uint32_t target = NO_VERTEX;
+		for (uint32_t i = m_Offsets[from]; i < m_Offsets[from + 1] && target == NO_VERTEX; ++i)
+		{
+			const uint32_t* triangle = &m_Indices[m_Adjacency[i] * 3];
+			if (triangle[0] != wedge && triangle[1] != wedge && triangle[2] != wedge)
+				continue;
+			for (uint32_t corner = 0; corner < 3; ++corner)
+			{
+				if (m_Groups[triangle[corner]] == to)
+					target = triangle[corner];
+			}
+		}
+
+		double distance = std::numeric_limits<double>::max();
+		if (target != NO_VERTEX)
+			distance = GetAttributeDistance(m_Vertices[wedge], m_Vertices[target]);
+		else
+		{
+			// eg: the other side of a seam that `to` isn't on
+			GatherWedges(to, m_ToWedges);
+			for (uint32_t candidate : m_ToWedges)
+			{
+				const double candidateDistance = GetAttributeDistance(m_Vertices[wedge], m_Vertices[candidate]);
+				if (candidateDistance < distance)
+				{
+					distance = candidateDistance;
+					target = candidate;
+				}
+			}
+		}
+
+		m_WedgeTargets.push_back(target);
+		error = std::max(error, m_AttributeErrors[wedge] + distance);
+	}
+
+	return error;
+}
+
+// the triangles around `from` that don't collapse must not turn too much or become degenerate
+bool Simplifier::FlipsTriangle(uint32_t from, uint32_t to) const
+{
+	for (uint32_t i = m_Offsets[from]; i < m_Offsets[from + 1]; ++i)
+	{
+		const uint32_t triangle = m_Adjacency[i];
+		uint32_t groups[3] = { GetGroup(triangle, 0), GetGroup(triangle, 1), GetGroup(triangle, 2) };
+		if (groups[0] == to || groups[1] == to || groups[2] == to)
+			continue;
+
+		const glm::dvec3 before = glm::cross(
+			m_Positions[groups[1]] - m_Positions[groups[0]], m_Positions[groups[2]] - m_Positions[groups[0]]);
+		for (uint32_t& group : groups)
+		{
+			if (group == from)
+				group = to;
+		}
+		const glm::dvec3 after = glm::cross(
+			m_Positions[groups[1]] - m_Positions[groups[0]], m_Positions[groups[2]] - m_Positions[groups[0]]);
+
+		const double beforeLength = glm::length(before);
+		const double minDot = SIMPLIFY_MIN_NORMAL_DOT * beforeLength * glm::length(after);
+		if (beforeLength > 0.0 && glm::dot(before, after) <= minDot)
+			return true;
+	}
+
+	return false;
+}
+
+// one pass, the collapses (sorted by cost) up to `costLimit`, returns the number of collapses
+size_t Simplifier::CollapsePass(double costLimit, size_t trianglesToRemove)
+{
+	std::iota(m_Remap.begin(), m_Remap.end(), 0);
+	std::fill(m_Touched.begin(), m_Touched.end(), false);
+	size_t removedTriangles = 0;
+	size_t collapseCount = 0;
+	for (const auto& collapse : m_Collapses)
+	{
+		if (collapse.cost > costLimit || removedTriangles >= trianglesToRemove)
+			break;
+		if (m_Touched[collapse.from] || m_Touched[collapse.to] || FlipsTriangle(collapse.from, collapse.to))
+			continue;
+
+		MapWedges(collapse.from, collapse.to);
+		for (size_t i = 0; i < m_FromWedges.size(); ++i)
+		{
+			const uint32_t wedge = m_FromWedges[i];
+			const uint32_t target = m_WedgeTargets[i];
+			m_Remap[wedge] = target;
+			m_AttributeErrors[target] = std::max(m_AttributeErrors[target],
+				m_AttributeErrors[wedge] + GetAttributeDistance(m_Vertices[wedge], m_Vertices[target]));
+		}
+		m_Quadrics[collapse.to] += m_Quadrics[collapse.from];
+
+		for (uint32_t i = m_Offsets[collapse.from]; i < m_Offsets[collapse.from + 1]; ++i)
+		{
+			const uint32_t triangle = m_Adjacency[i];
+			if (GetGroup(triangle, 0) == collapse.to || GetGroup(triangle, 1) == collapse.to
+				|| GetGroup(triangle, 2) == collapse.to)
+				++removedTriangles;
+		}
+
+		// the triangles around both are changed, the next collapses of this pass would see stale triangles
+		m_Touched[collapse.from] = true;
+		m_Touched[collapse.to] = true;
+		m_Cost = std::max(m_Cost, collapse.cost);
+		++collapseCount;
+	}
+
+	return collapseCount;
+}
+
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& indices,
+	size_t targetIndexCount,
+	float maxError,
+	float* resultError)
+{
+	Simplifier simplifier{ vertices, indices };
+	simplifier.Simplify(targetIndexCount, maxError);
+	if (resultError != nullptr)
+		*resultError = simplifier.GetError();
+	return simplifier.GetIndices();
+}
+
+std::vector<MeshLod> GenerateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	std::vector<MeshLod> lods{ MeshLod{ 0, static_cast<uint32_t>(indices.size()), 0.0f } };
+	glm::vec3 boundsMin{};
+	const float extent = GetExtent(vertices, indices, boundsMin);
+
+	// every lod continues the simplification of the previous one, the errors are relative to the full resolution
+	Simplifier simplifier{ vertices, indices };
+	for (uint32_t lod = 1; lod < MAX_MESH_LODS; ++lod)
+	{
+		const size_t previousCount = lods.back().indexCount;
+		const size_t targetCount = static_cast<size_t>(static_cast<float>(previousCount) * MESH_LOD_REDUCTION) / 3 * 3;
+		simplifier.Simplify(targetCount, MESH_LOD_MAX_ERROR);
+		std::vector<uint32_t> lodIndices = simplifier.GetIndices();
+		const float reduction = static_cast<float>(lodIndices.size()) / static_cast<float>(previousCount);
+		if (lodIndices.empty() || reduction > MESH_LOD_MIN_REDUCTION)
+			break;
+
+		OptimizeVertexCache(lodIndices, vertices.size());
+		lods.push_back(MeshLod{ static_cast<uint32_t>(indices.size()),
+			static_cast<uint32_t>(lodIndices.size()),
+			simplifier.GetError() * extent });
+		indices.insert(indices.end(), lodIndices.begin(), lodIndices.end());
+	}
+
+	return lods;
+}
+
+uint32_t SelectLod(const std::vector<MeshLod>& lods, float maxError)
+{
+	for (size_t i = lods.size(); i > 1; --i)
+	{
+		if (lods[i - 1].error <= maxError)
+			return static_cast<uint32_t>(i - 1);
+	}
+
+	return 0;
+}
+
+} // namespace utils
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vector>
+#include "renderer/vertexBuffer.h"
+
+
+namespace utils {
+
+constexpr uint32_t MAX_MESH_LODS = 5; // including the full resolution mesh
+constexpr float MESH_LOD_REDUCTION = 0.5f; // triangles of a lod, relative to the previous lod
+// a lod that doesn't get below this fraction of the triangles of the previous lod ends the chain
+constexpr float MESH_LOD_MIN_REDUCTION = 0.85f;
+constexpr float MESH_LOD_MAX_ERROR = 0.05f; // relative to the extent of the mesh, see `SimplifyMesh()`
+
+// a range of the index buffer of a mesh
+struct MeshLod
+{
+	uint32_t firstIndex = 0;
+	uint32_t indexCount = 0;
+	float error = 0.0f; // object space distance to the full resolution mesh (approximated)
+};
+
+// the group of every vertex, the vertices with the same position (eg: both sides of a texture seam) are grouped,
+// a group is identified by its first vertex
+std::vector<uint32_t> GroupPositions(const std::vector<Vertex>& vertices);
+
+// edge collapse simplification with quadric error metrics (Garland and Heckbert 1997)
+// the vertices are collapsed into their neighbours, the vertex buffer is shared with the input, only the indices change
+// the cost of a collapse is the quadric error plus a penalty for the normals and texture coordinates it stretches,
+// the vertices with the same position (attribute seams) are collapsed together, the open borders are locked
+// stops at `targetIndexCount` or when the next collapse costs more than `maxError`
+// the errors are relative to the extent of the mesh (largest side of the bounding box)
+std::vector<uint32_t> SimplifyMesh(const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& indices,
+	size_t targetIndexCount,
+	float maxError = MESH_LOD_MAX_ERROR,
+	float* resultError = nullptr);
+
+// appends up to `MAX_MESH_LODS - 1` simplified lods to `indices` (every lod simplified from the previous one,
+// ordered for the vertex cache), returns the ranges of all the lods, the full resolution mesh is the first one
+std::vector<MeshLod> GenerateLods(const std::vector<Vertex>& vertices, std::vector<uint32_t>& indices);
+
+// the coarsest lod whose error is at most `maxError`, `lods` are ordered from the finest to the coarsest
+uint32_t SelectLod(const std::vector<MeshLod>& lods, float maxError);
+
+} // namespace utils
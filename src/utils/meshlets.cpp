@@ -0,0 +1,261 @@
+#include "utils/meshlets.h"
+
+#include <cmath>
+#include <limits>
+#include <numeric>
+#include <algorithm>
+#include <glm/gtc/constants.hpp>
+#include "utils/meshSimplifier.h"
+
+
+namespace utils {
+
+constexpr uint32_t NO_MESHLET = std::numeric_limits<uint32_t>::max();
+// how much the normals of the triangles weigh against their distance when a meshlet is grown
+constexpr float MESHLET_CONE_WEIGHT = 0.5f;
+// a triangle only joins a meshlet if its normal is within 60 degrees of the average normal of the meshlet, hard
+// surface models otherwise spread their meshlets around the sharp edges and their normal cones can't cull
+constexpr float MESHLET_MIN_NORMAL_DOT = 0.5f;
+
+// bounding sphere of the vertices and normal cone of the triangles of a meshlet
+static void ComputeMeshletBounds(Meshlet& meshlet,
+	const std::vector<Vertex>& vertices,
+	const std::vector<uint32_t>& indices)
+{
+	const uint32_t indexEnd = meshlet.firstIndex + meshlet.triangleCount * 3;
+
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (uint32_t i = meshlet.firstIndex; i < indexEnd; ++i)
+	{
+		boundsMin = glm::min(boundsMin, vertices[indices[i]].pos);
+		boundsMax = glm::max(boundsMax, vertices[indices[i]].pos);
+	}
+
+	const glm::vec3 center = (boundsMin + boundsMax) * 0.5f;
+	float radius = 0.0f;
+	for (uint32_t i = meshlet.firstIndex; i < indexEnd; ++i)
+		radius = std::max(radius, glm::length(vertices[indices[i]].pos - center));
+	meshlet.sphere = glm::vec4(center, radius);
+
+	// the axis is the average of the unit normals, the degenerate triangles don't face anywhere
+	glm::vec3 axis{ 0.0f };
+	for (uint32_t i = meshlet.firstIndex; i < indexEnd; i += 3)
+	{
+		const glm::vec3& p0 = vertices[indices[i + 0]].pos;
+		const glm::vec3 normal = glm::cross(vertices[indices[i + 1]].pos - p0, vertices[indices[i + 2]].pos - p0);
+		const float length = glm::length(normal);
+		if (length > 0.0f)
+			axis += normal / length;
+	}
+
+	const float axisLength = glm::length(axis);
+	if (axisLength <= 0.0f)
+		return;
+
+	axis /= axisLength;
+	float minDot = 1.0f;
+	for (uint32_t i = meshlet.firstIndex; i < indexEnd; i += 3)
+	{
+		const glm::vec3& p0 = vertices[indices[i + 0]].pos;
+		const glm::vec3 normal = glm::cross(vertices[indices[i + 1]].pos - p0, vertices[indices[i + 2]].pos - p0);
+		const float length = glm::length(normal);
+		if (length > 0.0f)
+			minDot = std::min(minDot, glm::dot(normal / length, axis));
+	}
+
+	// a view direction within 90 - (angle between the axis and a normal) degrees of the axis faces away from every
+	// triangle, cos(90 - angle) = sin(angle)
+	const float cutoff = minDot <= MESHLET_MIN_CONE_DOT ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+	meshlet.cone = glm::vec4(axis, cutoff);
+}
+
+std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex>& vertices,
+	std::vector<uint32_t>& indices,
+	uint32_t firstIndex,
+	uint32_t indexCount)
+{
+	const uint32_t triangleCount = indexCount / 3;
+	std::vector<Meshlet> meshlets{};
+	if (triangleCount == 0)
+		return meshlets;
+
+	// triangles of every position, the meshlets grow across the attribute seams
+	const std::vector<uint32_t> groups = GroupPositions(vertices);
+	std::vector<uint32_t> offsets(vertices.size() + 1, 0);
+	for (uint32_t i = 0; i < triangleCount * 3; ++i)
+		++offsets[groups[indices[firstIndex + i]] + 1];
+	std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+	std::vector<uint32_t> adjacency(triangleCount * 3);
+	std::vector<uint32_t> cursors(offsets.begin(), offsets.end() - 1);
+	for (uint32_t i = 0; i < triangleCount * 3; ++i)
+		adjacency[cursors[groups[indices[firstIndex + i]]]++] = i / 3;
+
+	std::vector<glm::vec3> centroids(triangleCount);
+	std::vector<glm::vec3> normals(triangleCount, glm::vec3(0.0f));
+	float area = 0.0f;
+	for (uint32_t t = 0; t < triangleCount; ++t)
+	{
+		const glm::vec3& p0 = vertices[indices[firstIndex + t * 3 + 0]].pos;
+		const glm::vec3& p1 = vertices[indices[firstIndex + t * 3 + 1]].pos;
+		const glm::vec3& p2 = vertices[indices[firstIndex + t * 3 + 2]].pos;
+		const glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+		const float length = glm::length(normal);
+		centroids[t] = (p0 + p1 + p2) / 3.0f;
+		if (length > 0.0f)
+			normals[t] = normal / length;
+		area += length * 0.5f;
+	}
+	// radius of a disc of `MESHLET_MAX_TRIANGLES` average triangles, to weigh the distances against the normals
+	const float expectedRadius =
+		std::max(std::sqrt(area / static_cast<float>(triangleCount) * MESHLET_MAX_TRIANGLES / glm::pi<float>()),
+			std::numeric_limits<float>::min());
+
+	std::vector<bool> emitted(triangleCount, false);
+	// the meshlet a vertex was last added to
+	std::vector<uint32_t> vertexMeshlets(vertices.size(), NO_MESHLET);
+	std::vector<uint32_t> candidates{};
+	std::vector<uint32_t> output{};
+	output.reserve(indexCount);
+	uint32_t nextSeed = 0; // the triangles before this are emitted
+
+	Meshlet meshlet{};
+	meshlet.firstIndex = firstIndex;
+	glm::vec3 centroidSum{ 0.0f };
+	glm::vec3 normalSum{ 0.0f };
+
+	auto newVertexCount = [&](uint32_t triangle) {
+		const uint32_t current = static_cast<uint32_t>(meshlets.size());
+		const uint32_t a = indices[firstIndex + triangle * 3 + 0];
+		const uint32_t b = indices[firstIndex + triangle * 3 + 1];
+		const uint32_t c = indices[firstIndex + triangle * 3 + 2];
+		// the corners of a triangle may repeat a vertex
+		return (vertexMeshlets[a] != current) + (vertexMeshlets[b] != current && b != a)
+			+ (vertexMeshlets[c] != current && c != a && c != b);
+	};
+
+	for (uint32_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		// grow the meshlet with the adjacent triangle that adds the fewest vertices, then the one closest to the
+		// meshlet that bends its normals the least, the triangles facing too far away are skipped
+		uint32_t best = NO_MESHLET;
+		uint32_t bestNewVertices = 4;
+		float bestCost = std::numeric_limits<float>::max();
+		const glm::vec3 center = centroidSum / std::max(static_cast<float>(meshlet.triangleCount), 1.0f);
+		const float normalLength = glm::length(normalSum);
+		const glm::vec3 axis = normalLength > 0.0f ? normalSum / normalLength : glm::vec3(0.0f);
+		size_t live = 0;
+		for (uint32_t triangle : candidates)
+		{
+			if (emitted[triangle])
+				continue;
+
+			candidates[live++] = triangle;
+			if (normalLength > 0.0f && glm::dot(normals[triangle], axis) < MESHLET_MIN_NORMAL_DOT)
+				continue;
+			const uint32_t newVertices = newVertexCount(triangle);
+			const float cost = (1.0f + glm::length(centroids[triangle] - center) / expectedRadius)
+				* std::max(1.0f - glm::dot(normals[triangle], axis) * MESHLET_CONE_WEIGHT, 1e-3f);
+			if (newVertices < bestNewVertices || (newVertices == bestNewVertices && cost < bestCost))
+			{
+				best = triangle;
+				bestNewVertices = newVertices;
+				bestCost = cost;
+			}
+		}
+		candidates.resize(live);
+
+		bool closeMeshlet = meshlet.triangleCount == MESHLET_MAX_TRIANGLES
+			|| (best != NO_MESHLET && meshlet.vertexCount + bestNewVertices > MESHLET_MAX_VERTICES);
+		if (best == NO_MESHLET || closeMeshlet)
+		{
+			// without neighbours (eg: small separate parts) the meshlet continues with the first triangle that is
+			// left in the input order if it is close, otherwise the meshlet is closed and the next one starts there
+			while (emitted[nextSeed])
+				++nextSeed;
+			best = nextSeed;
+			bestNewVertices = newVertexCount(best);
+			closeMeshlet = closeMeshlet || meshlet.vertexCount + bestNewVertices > MESHLET_MAX_VERTICES
+				|| glm::length(centroids[best] - center) > expectedRadius
+				|| (normalLength > 0.0f && glm::dot(normals[best], axis) < MESHLET_MIN_NORMAL_DOT);
+
+			if (closeMeshlet && meshlet.triangleCount > 0)
+			{
+				meshlets.push_back(meshlet);
+				meshlet = Meshlet{};
+				meshlet.firstIndex = firstIndex + static_cast<uint32_t>(output.size());
+				centroidSum = glm::vec3(0.0f);
+				normalSum = glm::vec3(0.0f);
+				candidates.clear();
+			}
+		}
+
+		emitted[best] = true;
+		const uint32_t current = static_cast<uint32_t>(meshlets.size());
+		for (uint32_t corner = 0; corner < 3; ++corner)
+		{
+			const uint32_t vertex = indices[firstIndex + best * 3 + corner];
+			output.push_back(vertex);
+			if (vertexMeshlets[vertex] == current)
+				continue;
+
+			vertexMeshlets[vertex] = current;
+			++meshlet.vertexCount;
+			for (uint32_t i = offsets[groups[vertex]]; i < offsets[groups[vertex] + 1]; ++i)
+			{
+				if (!emitted[adjacency[i]])
+					candidates.push_back(adjacency[i]);
+			}
+		}
+
+		++meshlet.triangleCount;
+		centroidSum += centroids[best];
+		normalSum += normals[best];
+	}
+
+	meshlets.push_back(meshlet);
+	std::copy(output.begin(), output.end(), indices.begin() + firstIndex);
+	for (auto& m : meshlets)
+		ComputeMeshletBounds(m, vertices, indices);
+
+	return meshlets;
+}
+
+FrustumPlanes GetFrustumPlanes(const glm::mat4& viewProjMat)
+{
+	// a clip space point is inside if -w <= x <= w and -w <= y <= w, the rows of the matrix (glm is column major)
+	const glm::vec4 rowX{ viewProjMat[0][0], viewProjMat[1][0], viewProjMat[2][0], viewProjMat[3][0] };
+	const glm::vec4 rowY{ viewProjMat[0][1], viewProjMat[1][1], viewProjMat[2][1], viewProjMat[3][1] };
+	const glm::vec4 rowW{ viewProjMat[0][3], viewProjMat[1][3], viewProjMat[2][3], viewProjMat[3][3] };
+
+	FrustumPlanes planes{ rowW + rowX, rowW - rowX, rowW + rowY, rowW - rowY };
+	for (auto& plane : planes)
+		plane /= glm::length(glm::vec3(plane));
+
+	return planes;
+}
+
+bool IsMeshletVisible(const Meshlet& meshlet,
+	const glm::mat4& modelMat,
+	float scale,
+	const glm::vec3& cameraPos,
+	const FrustumPlanes& planes)
+{
+	const glm::vec3 center{ modelMat * glm::vec4(glm::vec3(meshlet.sphere), 1.0f) };
+	const float radius = meshlet.sphere.w * scale;
+	for (const auto& plane : planes)
+	{
+		if (glm::dot(glm::vec3(plane), center) + plane.w < -radius)
+			return false;
+	}
+
+	if (meshlet.cone.w >= 1.0f)
+		return true;
+
+	// the whole sphere has to be inside the cone of the view directions that face away from every triangle
+	const glm::vec3 axis = glm::normalize(glm::mat3(modelMat) * glm::vec3(meshlet.cone));
+	const glm::vec3 view = center - cameraPos;
+	return glm::dot(view, axis) < meshlet.cone.w * glm::length(view) + radius;
+}
+
+} // namespace utils
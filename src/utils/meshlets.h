@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <glm/glm.hpp>
+#include "renderer/vertexBuffer.h"
+
+
+namespace utils {
+
+// these have to match the values in `meshletCulling.comp`
+constexpr uint32_t MESHLET_MAX_VERTICES = 64;
+constexpr uint32_t MESHLET_MAX_TRIANGLES = 124;
+// a meshlet whose triangle normals spread further than this (dot with the average normal) is never cone culled
+constexpr float MESHLET_MIN_CONE_DOT = 0.1f;
+
+// a cluster of neighbouring triangles, a range of the index buffer of a mesh
+// std430 layout, matches `Meshlet` in `meshletCulling.comp`
+struct Meshlet
+{
+	glm::vec4 sphere{ 0.0f }; // xyz = object space center of the bounding sphere, w = radius
+	// xyz = average normal of the triangles (cone axis), w = sine of the largest angle between a normal and the axis
+	// every triangle faces away from a camera inside the cone around the axis (see `IsMeshletVisible()`),
+	// w = 1 is never culled
+	glm::vec4 cone{ 0.0f, 0.0f, 0.0f, 1.0f };
+	uint32_t firstIndex = 0;
+	uint32_t triangleCount = 0;
+	uint32_t vertexCount = 0; // unique vertices
+	uint32_t padding = 0;
+};
+static_assert(sizeof(Meshlet) == 48, "`Meshlet` has to match the std430 layout of the shader");
+
+// the side planes of the view frustum, xyz = inward normal, w = distance
+// they meet at the camera, so they also cull what is behind it, the near and far planes are skipped
+// (the far plane may be at infinity)
+using FrustumPlanes = std::array<glm::vec4, 4>;
+
+// splits the triangles of `indices[firstIndex, firstIndex + indexCount)` into meshlets and reorders them so that
+// every meshlet is a contiguous range
+// a meshlet is grown greedily with the adjacent triangles that add the fewest vertices, close to the meshlet and
+// facing its way (tight normal cones), until it would exceed `MESHLET_MAX_VERTICES` or `MESHLET_MAX_TRIANGLES`
+// the seeds follow the input order, so the vertex cache / overdraw order is kept at a coarse level
+std::vector<Meshlet> BuildMeshlets(const std::vector<Vertex>& vertices,
+	std::vector<uint32_t>& indices,
+	uint32_t firstIndex,
+	uint32_t indexCount);
+
+// world space planes of a view projection matrix (Gribb and Hartmann 2001)
+FrustumPlanes GetFrustumPlanes(const glm::mat4& viewProjMat);
+
+// the frustum and normal cone tests of `meshletCulling.comp`
+// `scale` is the largest scale of `modelMat`, the cone assumes a uniform scale
+bool IsMeshletVisible(const Meshlet& meshlet,
+	const glm::mat4& modelMat,
+	float scale,
+	const glm::vec3& cameraPos,
+	const FrustumPlanes& planes);
+
+} // namespace utils
@@ -0,0 +1,322 @@
+#include "utils/mipmaps.h"
+
+#include <array>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define MIPMAPS_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace utils {
+
+constexpr float MIPMAPS_PI = 3.14159265358979f;
+constexpr uint32_t LINEAR_TO_SRGB_SIZE = 1 << 14; // entries of the table rounding linear values to 8 bit srgb
+constexpr float KAISER_WIDTH = 3.0f; // lobes of the sinc on each side, in texels of the smaller level
+constexpr float KAISER_ALPHA = 4.0f;
+constexpr int32_t KAISER_TAPS = 12; // texels of the larger level on each axis
+constexpr int32_t KAISER_FIRST_TAP = -5; // of the texel `x` of the smaller level, relative to `x * 2`
+
+// the rgba texels of a level in the space they are filtered in, row by row
+using FilterLevel = std::vector<float>;
+
+// the 4 channels of a texel
+#ifdef MIPMAPS_SSE2
+using Texel = __m128;
+
+static inline Texel MakeTexel(float r, float g, float b, float a) { return _mm_setr_ps(r, g, b, a); }
+static inline Texel LoadTexel(const float* texel) { return _mm_loadu_ps(texel); }
+static inline void StoreTexel(float* texel, Texel value) { _mm_storeu_ps(texel, value); }
+static inline Texel ZeroTexel() { return _mm_setzero_ps(); }
+static inline Texel Add(Texel a, Texel b) { return _mm_add_ps(a, b); }
+static inline Texel Scale(Texel a, float scale) { return _mm_mul_ps(a, _mm_set1_ps(scale)); }
+#else
+using Texel = std::array<float, 4>;
+
+static inline Texel MakeTexel(float r, float g, float b, float a) { return { r, g, b, a }; }
+static inline Texel LoadTexel(const float* texel) { return { texel[0], texel[1], texel[2], texel[3] }; }
+static inline void StoreTexel(float* texel, Texel value) { std::copy(value.begin(), value.end(), texel); }
+static inline Texel ZeroTexel() { return {}; }
+static inline Texel Add(Texel a, Texel b) { return { a[0] + b[0], a[1] + b[1], a[2] + b[2], a[3] + b[3] }; }
+static inline Texel Scale(Texel a, float scale) { return { a[0] * scale, a[1] * scale, a[2] * scale, a[3] * scale }; }
+#endif
+
+// the texels of level 0, rgba8 converted to the space they are filtered in as they are read
+struct Rgba8Source
+{
+	const uint8_t* texels;
+	const std::array<std::array<float, 256>, 4>& toFilter;
+
+	inline Texel Load(uint64_t texel) const
+	{
+		const uint8_t* channels = texels + texel * 4;
+		return MakeTexel(
+			toFilter[0][channels[0]], toFilter[1][channels[1]], toFilter[2][channels[2]], toFilter[3][channels[3]]);
+	}
+};
+
+// the texels of a level filtered from level 0
+struct FilterSource
+{
+	const float* texels;
+
+	inline Texel Load(uint64_t texel) const { return LoadTexel(texels + texel * 4); }
+};
+
+static float SrgbToLinear(float value)
+{
+	return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSrgb(float value)
+{
+	return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+}
+
+static uint8_t ToUnorm8(float value)
+{
+	return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+static uint8_t LinearToSrgb8(float value)
+{
+	// std::pow per channel is most of the time of a box filtered level, so it is tabulated
+	static const std::array<uint8_t, LINEAR_TO_SRGB_SIZE> s_Table = [] {
+		std::array<uint8_t, LINEAR_TO_SRGB_SIZE> table{};
+		for (uint32_t i = 0; i < LINEAR_TO_SRGB_SIZE; ++i)
+			table[i] = ToUnorm8(LinearToSrgb(static_cast<float>(i) / static_cast<float>(LINEAR_TO_SRGB_SIZE - 1)));
+		return table;
+	}();
+
+	const float index = std::clamp(value, 0.0f, 1.0f) * static_cast<float>(LINEAR_TO_SRGB_SIZE - 1);
+	return s_Table[static_cast<uint32_t>(index + 0.5f)];
+}
+
+// the modified bessel function of the first kind of order 0, by its power series
+static float BesselI0(float x)
+{
+	const float quarterSquared = x * x * 0.25f;
+	float sum = 1.0f;
+	float term = 1.0f;
+	for (uint32_t k = 1; k < 32 && term > sum * 1e-7f; ++k)
+	{
+		term *= quarterSquared / static_cast<float>(k * k);
+		sum += term;
+	}
+
+	return sum;
+}
+
+// the normalized weights of the taps of a texel of the smaller level, the same on both axes and for every texel
+static const std::array<float, KAISER_TAPS>& GetKaiserWeights()
+{
+	static const std::array<float, KAISER_TAPS> s_Weights = [] {
+		std::array<float, KAISER_TAPS> weights{};
+		float sum = 0.0f;
+		for (int32_t tap = 0; tap < KAISER_TAPS; ++tap)
+		{
+			// from the center of the tap to the center of the smaller texel (`x * 2 + 1`), in texels of the smaller
+			// level
+			const float distance = (static_cast<float>(KAISER_FIRST_TAP + tap) - 0.5f) * 0.5f;
+			const float sinc = std::sin(MIPMAPS_PI * distance) / (MIPMAPS_PI * distance);
+			const float ratio = distance / KAISER_WIDTH;
+			const float window =
+				BesselI0(KAISER_ALPHA * std::sqrt(std::max(1.0f - ratio * ratio, 0.0f))) / BesselI0(KAISER_ALPHA);
+			weights[tap] = sinc * window;
+			sum += weights[tap];
+		}
+
+		for (float& weight : weights)
+			weight /= sum;
+		return weights;
+	}();
+
+	return s_Weights;
+}
+
+template<typename Source>
+static FilterLevel DownsampleBox(const Source& source,
+	uint32_t sourceWidth,
+	uint32_t sourceHeight,
+	uint32_t width,
+	uint32_t height)
+{
+	FilterLevel texels(static_cast<uint64_t>(width) * height * 4);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		const uint64_t row0 = static_cast<uint64_t>(std::min(y * 2, sourceHeight - 1)) * sourceWidth;
+		const uint64_t row1 = static_cast<uint64_t>(std::min(y * 2 + 1, sourceHeight - 1)) * sourceWidth;
+		float* row = texels.data() + static_cast<uint64_t>(y) * width * 4;
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			const uint32_t x0 = std::min(x * 2, sourceWidth - 1);
+			const uint32_t x1 = std::min(x * 2 + 1, sourceWidth - 1);
+			const Texel sum = Add(Add(source.Load(row0 + x0), source.Load(row0 + x1)),
+				Add(source.Load(row1 + x0), source.Load(row1 + x1)));
+			StoreTexel(row + static_cast<uint64_t>(x) * 4, Scale(sum, 0.25f));
+		}
+	}
+
+	return texels;
+}
+
+// separable, the rows are filtered first (into a level as wide as the smaller one and as tall as the larger one)
+template<typename Source>
+static FilterLevel DownsampleKaiser(const Source& source,
+	uint32_t sourceWidth,
+	uint32_t sourceHeight,
+	uint32_t width,
+	uint32_t height)
+{
+	const std::array<float, KAISER_TAPS>& weights = GetKaiserWeights();
+	const int32_t lastColumn = static_cast<int32_t>(sourceWidth) - 1;
+	const int32_t lastRow = static_cast<int32_t>(sourceHeight) - 1;
+
+	FilterLevel rows(static_cast<uint64_t>(width) * sourceHeight * 4);
+	for (uint32_t y = 0; y < sourceHeight; ++y)
+	{
+		const uint64_t sourceRow = static_cast<uint64_t>(y) * sourceWidth;
+		float* row = rows.data() + static_cast<uint64_t>(y) * width * 4;
+		for (uint32_t x = 0; x < width; ++x)
+		{
+			Texel sum = ZeroTexel();
+			for (int32_t tap = 0; tap < KAISER_TAPS; ++tap)
+			{
+				const int32_t column = std::clamp(static_cast<int32_t>(x * 2) + KAISER_FIRST_TAP + tap, 0, lastColumn);
+				sum = Add(sum, Scale(source.Load(sourceRow + static_cast<uint32_t>(column)), weights[tap]));
+			}
+			StoreTexel(row + static_cast<uint64_t>(x) * 4, sum);
+		}
+	}
+
+	// the columns, a row of taps at a time so that the rows are read in order
+	FilterLevel texels(static_cast<uint64_t>(width) * height * 4, 0.0f);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		float* row = texels.data() + static_cast<uint64_t>(y) * width * 4;
+		for (int32_t tap = 0; tap < KAISER_TAPS; ++tap)
+		{
+			const int32_t tapRow = std::clamp(static_cast<int32_t>(y * 2) + KAISER_FIRST_TAP + tap, 0, lastRow);
+			const float* filteredRow = rows.data() + static_cast<uint64_t>(tapRow) * width * 4;
+			for (uint64_t texel = 0; texel < static_cast<uint64_t>(width) * 4; texel += 4)
+			{
+				const Texel weighted = Scale(LoadTexel(filteredRow + texel), weights[tap]);
+				StoreTexel(row + texel, Add(LoadTexel(row + texel), weighted));
+			}
+		}
+	}
+
+	return texels;
+}
+
+template<typename Source>
+static FilterLevel Downsample(const Source& source,
+	uint32_t sourceWidth,
+	uint32_t sourceHeight,
+	uint32_t width,
+	uint32_t height,
+	MipFilter filter)
+{
+	if (filter == MipFilter::KAISER)
+		return DownsampleKaiser(source, sourceWidth, sourceHeight, width, height);
+
+	return DownsampleBox(source, sourceWidth, sourceHeight, width, height);
+}
+
+// the filtered unit vectors are shorter, a flat normal if they cancel out
+static void Renormalize(FilterLevel& level)
+{
+	for (uint64_t texel = 0; texel < level.size(); texel += 4)
+	{
+		float* normal = level.data() + texel;
+		const float length = std::sqrt(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+		for (uint32_t c = 0; c < 3; ++c)
+			normal[c] = length > 1e-6f ? normal[c] / length : (c == 2 ? 1.0f : 0.0f);
+	}
+}
+
+static std::vector<uint8_t> ToRgba8(const FilterLevel& level, MipColorSpace colorSpace)
+{
+	std::vector<uint8_t> texels(level.size());
+	for (uint64_t texel = 0; texel < level.size(); texel += 4)
+	{
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			if (colorSpace == MipColorSpace::SRGB)
+				texels[texel + c] = LinearToSrgb8(level[texel + c]);
+			else if (colorSpace == MipColorSpace::NORMAL)
+				texels[texel + c] = ToUnorm8(level[texel + c] * 0.5f + 0.5f);
+			else
+				texels[texel + c] = ToUnorm8(level[texel + c]);
+		}
+		texels[texel + 3] = ToUnorm8(level[texel + 3]);
+	}
+
+	return texels;
+}
+
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height)
+{
+	uint32_t levelCount = 1;
+	while ((std::max(width, height) >> levelCount) > 0)
+		++levelCount;
+
+	return levelCount;
+}
+
+std::vector<std::vector<uint8_t>> GenerateMipChain(const uint8_t* rgba,
+	uint32_t width,
+	uint32_t height,
+	MipColorSpace colorSpace,
+	MipFilter filter)
+{
+	const uint32_t levelCount = GetMipLevelCount(width, height);
+	std::vector<std::vector<uint8_t>> levels{};
+	levels.reserve(levelCount);
+	levels.emplace_back(rgba, rgba + static_cast<uint64_t>(width) * height * 4);
+
+	// the 8 bit values of every channel in the space they are filtered in
+	std::array<std::array<float, 256>, 4> toFilter{};
+	for (uint32_t value = 0; value < 256; ++value)
+	{
+		const float unorm = static_cast<float>(value) / 255.0f;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			if (colorSpace == MipColorSpace::SRGB && c < 3)
+				toFilter[c][value] = SrgbToLinear(unorm);
+			else if (colorSpace == MipColorSpace::NORMAL && c < 3)
+				toFilter[c][value] = unorm * 2.0f - 1.0f;
+			else
+				toFilter[c][value] = unorm;
+		}
+	}
+
+	// level 0 is converted as it is read, every other level is kept in float for the next one
+	FilterLevel previous{};
+	uint32_t previousWidth = width;
+	uint32_t previousHeight = height;
+	for (uint32_t level = 1; level < levelCount; ++level)
+	{
+		const uint32_t levelWidth = std::max(previousWidth / 2, 1u);
+		const uint32_t levelHeight = std::max(previousHeight / 2, 1u);
+		FilterLevel texels{};
+		if (level == 1)
+			texels = Downsample(Rgba8Source{ rgba, toFilter }, width, height, levelWidth, levelHeight, filter);
+		else
+			texels = Downsample(
+				FilterSource{ previous.data() }, previousWidth, previousHeight, levelWidth, levelHeight, filter);
+		if (colorSpace == MipColorSpace::NORMAL)
+			Renormalize(texels);
+
+		levels.push_back(ToRgba8(texels, colorSpace));
+		previous = std::move(texels);
+		previousWidth = levelWidth;
+		previousHeight = levelHeight;
+	}
+
+	return levels;
+}
+
+} // namespace utils
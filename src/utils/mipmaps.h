@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+namespace utils {
+
+// how the texels of an image are averaged into its mips
+enum class MipColorSpace
+{
+	SRGB, // rgb are converted to linear before they are filtered, alpha is linear
+	LINEAR,
+	// unorm tangent space normals, the filtered normals are renormalized (rgb = xyz * 0.5 + 0.5)
+	NORMAL,
+};
+
+enum class MipFilter
+{
+	BOX, // the 2x2 texels a texel covers
+	// a kaiser windowed sinc over 12x12 texels (in 2 passes), sharper than the box but about 3 times slower
+	KAISER,
+};
+
+// number of mips down to 1x1, including level 0
+uint32_t GetMipLevelCount(uint32_t width, uint32_t height);
+
+// the full mip chain of an rgba8 image, level 0 is a copy of `rgba`
+// the levels are filtered from each other in linear float (4 channels at once with sse2, when it is available) and
+// only rounded to 8 bits for the output, the texels past the edges repeat the last column / row (an odd size drops
+// its last column / row), a side of 1 texel stays 1 texel
+std::vector<std::vector<uint8_t>> GenerateMipChain(const uint8_t* rgba,
+	uint32_t width,
+	uint32_t height,
+	MipColorSpace colorSpace,
+	MipFilter filter = MipFilter::BOX);
+
+} // namespace utils
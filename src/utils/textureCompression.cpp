@@ -0,0 +1,725 @@
+#include "utils/textureCompression.h"
+
+#include <array>
+#include <cmath>
+#include <limits>
+#include <atomic>
+#include <thread>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define TEXTURE_COMPRESSION_SSE2
+#include <emmintrin.h>
+#endif
+
+
+namespace utils {
+
+constexpr uint32_t BLOCK_TEXELS = BLOCK_DIM * BLOCK_DIM;
+constexpr uint32_t MAX_PALETTE_SIZE = 16;
+constexpr uint32_t ENDPOINT_REFINEMENTS = 2; // least squares passes after the principal axis fit
+// interpolation weights of the 4 bit indices of bc7, out of 64
+constexpr std::array<uint32_t, 16> BC7_WEIGHTS{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+using Color = std::array<float, 4>;
+using Weights = std::array<float, 4>; // of the channels in the error, 0 ignores a channel
+using BlockIndices = std::array<uint8_t, BLOCK_TEXELS>;
+
+// the texels of a block by channel, so that 4 texels of a channel are loaded at once
+struct BlockTexels
+{
+	alignas(16) std::array<std::array<float, BLOCK_TEXELS>, 4> channels{};
+};
+
+// the colors that the indices of a block pick from
+struct Palette
+{
+	std::array<Color, MAX_PALETTE_SIZE> colors{};
+	uint32_t size = 0;
+};
+
+// writes the fields of a block from its least significant bit on, the block has to be zeroed
+class BlockBitWriter
+{
+public:
+	explicit BlockBitWriter(uint8_t* block)
+		: m_Block{ block }
+	{
+	}
+
+	void Write(uint32_t value, uint32_t bitCount)
+	{
+		for (uint32_t i = 0; i < bitCount; ++i, ++m_Offset)
+		{
+			if ((value >> i) & 1u)
+				m_Block[m_Offset / 8] = static_cast<uint8_t>(m_Block[m_Offset / 8] | (1u << (m_Offset % 8)));
+		}
+	}
+
+private:
+	uint8_t* m_Block;
+	uint32_t m_Offset = 0;
+};
+
+class BlockBitReader
+{
+public:
+	explicit BlockBitReader(const uint8_t* block)
+		: m_Block{ block }
+	{
+	}
+
+	uint32_t Read(uint32_t bitCount)
+	{
+		uint32_t value = 0;
+		for (uint32_t i = 0; i < bitCount; ++i, ++m_Offset)
+			value |= static_cast<uint32_t>((m_Block[m_Offset / 8] >> (m_Offset % 8)) & 1u) << i;
+
+		return value;
+	}
+
+private:
+	const uint8_t* m_Block;
+	uint32_t m_Offset = 0;
+};
+
+
+static BlockTexels LoadTexels(const uint8_t* rgba)
+{
+	BlockTexels texels{};
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+	{
+		for (uint32_t c = 0; c < 4; ++c)
+			texels.channels[c][t] = static_cast<float>(rgba[t * 4 + c]);
+	}
+
+	return texels;
+}
+
+// picks the nearest palette color of every texel, returns the weighted squared error of the block
+static float SelectIndices(const BlockTexels& texels,
+	const Palette& palette,
+	const Weights& weights,
+	BlockIndices& indices)
+{
+	float error = 0.0f;
+#ifdef TEXTURE_COMPRESSION_SSE2
+	// 4 texels at a time, the nearest color so far and its index are kept per lane
+	for (uint32_t t = 0; t < BLOCK_TEXELS; t += 4)
+	{
+		__m128 channels[4];
+		for (uint32_t c = 0; c < 4; ++c)
+			channels[c] = _mm_load_ps(&texels.channels[c][t]);
+
+		__m128 bestDistance = _mm_set1_ps(std::numeric_limits<float>::max());
+		__m128i bestIndex = _mm_setzero_si128();
+		for (uint32_t i = 0; i < palette.size; ++i)
+		{
+			__m128 distance = _mm_setzero_ps();
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				const __m128 delta = _mm_sub_ps(channels[c], _mm_set1_ps(palette.colors[i][c]));
+				distance = _mm_add_ps(distance, _mm_mul_ps(_mm_mul_ps(delta, delta), _mm_set1_ps(weights[c])));
+			}
+
+			const __m128i closer = _mm_castps_si128(_mm_cmplt_ps(distance, bestDistance));
+			bestDistance = _mm_min_ps(distance, bestDistance);
+			bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(static_cast<int32_t>(i))),
+				_mm_andnot_si128(closer, bestIndex));
+		}
+
+		alignas(16) std::array<int32_t, 4> laneIndices{};
+		alignas(16) std::array<float, 4> laneDistances{};
+		_mm_store_si128(reinterpret_cast<__m128i*>(laneIndices.data()), bestIndex);
+		_mm_store_ps(laneDistances.data(), bestDistance);
+		for (uint32_t lane = 0; lane < 4; ++lane)
+		{
+			indices[t + lane] = static_cast<uint8_t>(laneIndices[lane]);
+			error += laneDistances[lane];
+		}
+	}
+#else
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+	{
+		float bestDistance = std::numeric_limits<float>::max();
+		for (uint32_t i = 0; i < palette.size; ++i)
+		{
+			float distance = 0.0f;
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				const float delta = texels.channels[c][t] - palette.colors[i][c];
+				distance += delta * delta * weights[c];
+			}
+
+			if (distance < bestDistance)
+			{
+				bestDistance = distance;
+				indices[t] = static_cast<uint8_t>(i);
+			}
+		}
+		error += bestDistance;
+	}
+#endif
+
+	return error;
+}
+
+// the extremes of the texels along their principal axis (power iteration on their covariance)
+static void FitEndpoints(const BlockTexels& texels, const Weights& weights, Color& first, Color& last)
+{
+	Color mean{};
+	Color minimum{};
+	Color maximum{};
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		const auto& channel = texels.channels[c];
+		float sum = 0.0f;
+		for (float value : channel)
+			sum += value;
+		mean[c] = sum / static_cast<float>(BLOCK_TEXELS);
+		minimum[c] = *std::min_element(channel.begin(), channel.end());
+		maximum[c] = *std::max_element(channel.begin(), channel.end());
+	}
+
+	std::array<Color, 4> covariance{};
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+	{
+		Color delta{};
+		for (uint32_t c = 0; c < 4; ++c)
+			delta[c] = weights[c] > 0.0f ? texels.channels[c][t] - mean[c] : 0.0f;
+		for (uint32_t row = 0; row < 4; ++row)
+		{
+			for (uint32_t column = 0; column < 4; ++column)
+				covariance[row][column] += delta[row] * delta[column];
+		}
+	}
+
+	// the diagonal of the bounding box is a good start, it is close to the axis of most blocks
+	Color axis{};
+	for (uint32_t c = 0; c < 4; ++c)
+		axis[c] = weights[c] > 0.0f ? maximum[c] - minimum[c] : 0.0f;
+	for (uint32_t iteration = 0; iteration < 8; ++iteration)
+	{
+		Color next{};
+		float largest = 0.0f;
+		for (uint32_t row = 0; row < 4; ++row)
+		{
+			for (uint32_t column = 0; column < 4; ++column)
+				next[row] += covariance[row][column] * axis[column];
+			largest = std::max(largest, std::abs(next[row]));
+		}
+		if (largest == 0.0f)
+			break;
+
+		for (uint32_t c = 0; c < 4; ++c)
+			axis[c] = next[c] / largest;
+	}
+
+	float axisLength = 0.0f;
+	for (float value : axis)
+		axisLength += value * value;
+	if (axisLength < 1e-6f)
+	{
+		first = mean;
+		last = mean;
+		return;
+	}
+
+	float minProjection = std::numeric_limits<float>::max();
+	float maxProjection = std::numeric_limits<float>::lowest();
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+	{
+		float projection = 0.0f;
+		for (uint32_t c = 0; c < 4; ++c)
+			projection += (texels.channels[c][t] - mean[c]) * axis[c];
+		projection /= axisLength;
+		minProjection = std::min(minProjection, projection);
+		maxProjection = std::max(maxProjection, projection);
+	}
+
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		first[c] = std::clamp(mean[c] + axis[c] * minProjection, 0.0f, 255.0f);
+		last[c] = std::clamp(mean[c] + axis[c] * maxProjection, 0.0f, 255.0f);
+	}
+}
+
+// the endpoints with the least squared error for the picked indices, `positions` are the positions of the indices
+// between the endpoints (0 = `first`, 1 = `last`)
+// the endpoints are kept if every texel picked the same position
+static void RefineEndpoints(const BlockTexels& texels,
+	const BlockIndices& indices,
+	const float* positions,
+	Color& first,
+	Color& last)
+{
+	float firstFirst = 0.0f;
+	float firstLast = 0.0f;
+	float lastLast = 0.0f;
+	Color firstSum{};
+	Color lastSum{};
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+	{
+		const float position = positions[indices[t]];
+		const float inverse = 1.0f - position;
+		firstFirst += inverse * inverse;
+		firstLast += inverse * position;
+		lastLast += position * position;
+		for (uint32_t c = 0; c < 4; ++c)
+		{
+			firstSum[c] += inverse * texels.channels[c][t];
+			lastSum[c] += position * texels.channels[c][t];
+		}
+	}
+
+	const float determinant = firstFirst * lastLast - firstLast * firstLast;
+	if (std::abs(determinant) < 1e-6f)
+		return;
+
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		first[c] = std::clamp((lastLast * firstSum[c] - firstLast * lastSum[c]) / determinant, 0.0f, 255.0f);
+		last[c] = std::clamp((firstFirst * lastSum[c] - firstLast * firstSum[c]) / determinant, 0.0f, 255.0f);
+	}
+}
+
+
+// bc1
+
+// positions of the indices of the 4 color mode between the endpoints
+constexpr std::array<float, 4> BC1_POSITIONS{ 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+static uint16_t PackRGB565(const Color& color)
+{
+	const auto quantize = [](float value, float maxValue) {
+		return static_cast<uint32_t>(std::lround(value * maxValue / 255.0f));
+	};
+
+	return static_cast<uint16_t>(
+		(quantize(color[0], 31.0f) << 11) | (quantize(color[1], 63.0f) << 5) | quantize(color[2], 31.0f));
+}
+
+static std::array<uint32_t, 3> UnpackRGB565(uint16_t packed)
+{
+	const uint32_t r = (packed >> 11) & 31u;
+	const uint32_t g = (packed >> 5) & 63u;
+	const uint32_t b = packed & 31u;
+	return { (r << 3) | (r >> 2), (g << 2) | (g >> 4), (b << 3) | (b >> 2) };
+}
+
+// the palette of the 4 color mode (`c0` > `c1`) or of the 3 color mode with black
+static Palette GetPaletteBC1(uint16_t c0, uint16_t c1)
+{
+	const std::array<uint32_t, 3> color0 = UnpackRGB565(c0);
+	const std::array<uint32_t, 3> color1 = UnpackRGB565(c1);
+
+	Palette palette{};
+	palette.size = 4;
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		palette.colors[0][c] = static_cast<float>(color0[c]);
+		palette.colors[1][c] = static_cast<float>(color1[c]);
+		if (c0 > c1)
+		{
+			palette.colors[2][c] = static_cast<float>((2 * color0[c] + color1[c]) / 3);
+			palette.colors[3][c] = static_cast<float>((color0[c] + 2 * color1[c]) / 3);
+		}
+		else
+		{
+			palette.colors[2][c] = static_cast<float>((color0[c] + color1[c]) / 2);
+			palette.colors[3][c] = 0.0f;
+		}
+	}
+	for (auto& color : palette.colors)
+		color[3] = 255.0f;
+
+	return palette;
+}
+
+void CompressBlockBC1(const uint8_t* rgba, uint8_t* block)
+{
+	constexpr Weights weights{ 1.0f, 1.0f, 1.0f, 0.0f };
+	const BlockTexels texels = LoadTexels(rgba);
+	Color first{};
+	Color last{};
+	FitEndpoints(texels, weights, first, last);
+
+	float bestError = std::numeric_limits<float>::max();
+	uint16_t bestC0 = 0;
+	uint16_t bestC1 = 0;
+	BlockIndices bestIndices{};
+	for (uint32_t iteration = 0; iteration <= ENDPOINT_REFINEMENTS; ++iteration)
+	{
+		// the 4 color mode needs `c0` > `c1`, equal endpoints can only be the 3 color mode (every index picks c0)
+		uint16_t c0 = PackRGB565(last);
+		uint16_t c1 = PackRGB565(first);
+		if (c0 < c1)
+		{
+			std::swap(c0, c1);
+			std::swap(first, last);
+		}
+
+		BlockIndices indices{};
+		const float error = SelectIndices(texels, GetPaletteBC1(c0, c1), weights, indices);
+		if (error < bestError)
+		{
+			bestError = error;
+			bestC0 = c0;
+			bestC1 = c1;
+			bestIndices = indices;
+		}
+		if (c0 == c1 || error == 0.0f)
+			break;
+
+		// the positions of `c0` and `c1` are 0 and 1, `last` is packed into `c0`
+		RefineEndpoints(texels, indices, BC1_POSITIONS.data(), last, first);
+	}
+
+	uint32_t packedIndices = 0;
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+		packedIndices |= static_cast<uint32_t>(bestC0 == bestC1 ? 0 : bestIndices[t]) << (t * 2);
+
+	block[0] = static_cast<uint8_t>(bestC0 & 0xff);
+	block[1] = static_cast<uint8_t>(bestC0 >> 8);
+	block[2] = static_cast<uint8_t>(bestC1 & 0xff);
+	block[3] = static_cast<uint8_t>(bestC1 >> 8);
+	for (uint32_t i = 0; i < 4; ++i)
+		block[4 + i] = static_cast<uint8_t>((packedIndices >> (i * 8)) & 0xff);
+}
+
+static void DecompressBlockBC1(const uint8_t* block, uint8_t* rgba)
+{
+	const uint16_t c0 = static_cast<uint16_t>(block[0] | (block[1] << 8));
+	const uint16_t c1 = static_cast<uint16_t>(block[2] | (block[3] << 8));
+	const Palette palette = GetPaletteBC1(c0, c1);
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+	{
+		const uint32_t index = (block[4 + t / 4] >> ((t % 4) * 2)) & 3u;
+		for (uint32_t c = 0; c < 4; ++c)
+			rgba[t * 4 + c] = static_cast<uint8_t>(palette.colors[index][c]);
+	}
+}
+
+
+// bc4, the two channels of bc5
+
+static Palette GetPaletteBC4(uint32_t a0, uint32_t a1)
+{
+	Palette palette{};
+	palette.size = 8;
+	palette.colors[0][0] = static_cast<float>(a0);
+	palette.colors[1][0] = static_cast<float>(a1);
+	for (uint32_t i = 2; i < 8; ++i)
+	{
+		// 8 values between the endpoints, or 6 values and the extremes of the range
+		uint32_t value = 0;
+		if (a0 > a1)
+			value = ((8 - i) * a0 + (i - 1) * a1) / 7;
+		else if (i < 6)
+			value = ((6 - i) * a0 + (i - 1) * a1) / 5;
+		else
+			value = i == 6 ? 0 : 255;
+		palette.colors[i][0] = static_cast<float>(value);
+	}
+
+	return palette;
+}
+
+// channel 0 of `texels`, the 8 value mode between the extremes of the block
+static void CompressChannelBC4(const BlockTexels& texels, uint8_t* block)
+{
+	const auto& channel = texels.channels[0];
+	const uint32_t a0 = static_cast<uint32_t>(*std::max_element(channel.begin(), channel.end()));
+	const uint32_t a1 = static_cast<uint32_t>(*std::min_element(channel.begin(), channel.end()));
+
+	BlockIndices indices{};
+	if (a0 != a1)
+		SelectIndices(texels, GetPaletteBC4(a0, a1), Weights{ 1.0f, 0.0f, 0.0f, 0.0f }, indices);
+
+	block[0] = static_cast<uint8_t>(a0);
+	block[1] = static_cast<uint8_t>(a1);
+	uint64_t packedIndices = 0;
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+		packedIndices |= static_cast<uint64_t>(indices[t]) << (t * 3);
+	for (uint32_t i = 0; i < 6; ++i)
+		block[2 + i] = static_cast<uint8_t>((packedIndices >> (i * 8)) & 0xff);
+}
+
+static void DecompressChannelBC4(const uint8_t* block, uint8_t* rgba, uint32_t channel)
+{
+	const Palette palette = GetPaletteBC4(block[0], block[1]);
+	uint64_t packedIndices = 0;
+	for (uint32_t i = 0; i < 6; ++i)
+		packedIndices |= static_cast<uint64_t>(block[2 + i]) << (i * 8);
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+		rgba[t * 4 + channel] = static_cast<uint8_t>(palette.colors[(packedIndices >> (t * 3)) & 7u][0]);
+}
+
+void CompressBlockBC5(const uint8_t* rgba, uint8_t* block)
+{
+	BlockTexels texels = LoadTexels(rgba);
+	CompressChannelBC4(texels, block);
+	texels.channels[0] = texels.channels[1];
+	CompressChannelBC4(texels, block + 8);
+}
+
+static void DecompressBlockBC5(const uint8_t* block, uint8_t* rgba)
+{
+	DecompressChannelBC4(block, rgba, 0);
+	DecompressChannelBC4(block + 8, rgba, 1);
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+	{
+		rgba[t * 4 + 2] = 0;
+		rgba[t * 4 + 3] = 255;
+	}
+}
+
+
+// bc7 mode 6
+
+constexpr uint32_t BC7_MODE_6 = 1u << 6; // the mode is the index of the lowest set bit
+
+// 7 bit endpoints (rgba) and their p-bits (the lowest bit of every channel of the endpoint)
+struct BC7Endpoints
+{
+	std::array<uint32_t, 4> first{};
+	std::array<uint32_t, 4> last{};
+	uint32_t firstP = 0;
+	uint32_t lastP = 0;
+};
+
+static std::array<uint32_t, 4> QuantizeBC7(const Color& color, uint32_t p)
+{
+	std::array<uint32_t, 4> quantized{};
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		const float value = std::round((color[c] - static_cast<float>(p)) / 2.0f);
+		quantized[c] = static_cast<uint32_t>(std::clamp(value, 0.0f, 127.0f));
+	}
+
+	return quantized;
+}
+
+static Palette GetPaletteBC7(const BC7Endpoints& endpoints)
+{
+	Palette palette{};
+	palette.size = static_cast<uint32_t>(BC7_WEIGHTS.size());
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		const uint32_t first = (endpoints.first[c] << 1) | endpoints.firstP;
+		const uint32_t last = (endpoints.last[c] << 1) | endpoints.lastP;
+		for (uint32_t i = 0; i < palette.size; ++i)
+		{
+			const uint32_t weight = BC7_WEIGHTS[i];
+			palette.colors[i][c] = static_cast<float>(((64 - weight) * first + weight * last + 32) >> 6);
+		}
+	}
+
+	return palette;
+}
+
+void CompressBlockBC7(const uint8_t* rgba, uint8_t* block)
+{
+	constexpr Weights weights{ 1.0f, 1.0f, 1.0f, 1.0f };
+	std::array<float, BC7_WEIGHTS.size()> positions{};
+	for (size_t i = 0; i < positions.size(); ++i)
+		positions[i] = static_cast<float>(BC7_WEIGHTS[i]) / 64.0f;
+
+	const BlockTexels texels = LoadTexels(rgba);
+	Color first{};
+	Color last{};
+	FitEndpoints(texels, weights, first, last);
+
+	float bestError = std::numeric_limits<float>::max();
+	BC7Endpoints bestEndpoints{};
+	BlockIndices bestIndices{};
+	for (uint32_t iteration = 0; iteration <= ENDPOINT_REFINEMENTS; ++iteration)
+	{
+		// every combination of the p-bits, they move the endpoints by half a step of the 7 bit grid
+		BlockIndices iterationIndices{};
+		float iterationError = std::numeric_limits<float>::max();
+		for (uint32_t p = 0; p < 4; ++p)
+		{
+			BC7Endpoints endpoints{};
+			endpoints.firstP = p & 1u;
+			endpoints.lastP = p >> 1;
+			endpoints.first = QuantizeBC7(first, endpoints.firstP);
+			endpoints.last = QuantizeBC7(last, endpoints.lastP);
+
+			BlockIndices indices{};
+			const float error = SelectIndices(texels, GetPaletteBC7(endpoints), weights, indices);
+			if (error < iterationError)
+			{
+				iterationError = error;
+				iterationIndices = indices;
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				bestEndpoints = endpoints;
+				bestIndices = indices;
+			}
+		}
+		if (bestError == 0.0f)
+			break;
+
+		RefineEndpoints(texels, iterationIndices, positions.data(), first, last);
+	}
+
+	// the highest bit of the index of texel 0 (the anchor) is implied to be 0, the endpoints are swapped otherwise
+	if (bestIndices[0] >= BC7_WEIGHTS.size() / 2)
+	{
+		std::swap(bestEndpoints.first, bestEndpoints.last);
+		std::swap(bestEndpoints.firstP, bestEndpoints.lastP);
+		for (auto& index : bestIndices)
+			index = static_cast<uint8_t>(BC7_WEIGHTS.size() - 1 - index);
+	}
+
+	std::fill(block, block + 16, static_cast<uint8_t>(0));
+	BlockBitWriter writer{ block };
+	writer.Write(BC7_MODE_6, 7);
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		writer.Write(bestEndpoints.first[c], 7);
+		writer.Write(bestEndpoints.last[c], 7);
+	}
+	writer.Write(bestEndpoints.firstP, 1);
+	writer.Write(bestEndpoints.lastP, 1);
+	writer.Write(bestIndices[0], 3);
+	for (uint32_t t = 1; t < BLOCK_TEXELS; ++t)
+		writer.Write(bestIndices[t], 4);
+}
+
+static void DecompressBlockBC7(const uint8_t* block, uint8_t* rgba)
+{
+	BlockBitReader reader{ block };
+	if (reader.Read(7) != BC7_MODE_6)
+	{
+		std::fill(rgba, rgba + BLOCK_TEXELS * 4, static_cast<uint8_t>(0));
+		return;
+	}
+
+	BC7Endpoints endpoints{};
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		endpoints.first[c] = reader.Read(7);
+		endpoints.last[c] = reader.Read(7);
+	}
+	endpoints.firstP = reader.Read(1);
+	endpoints.lastP = reader.Read(1);
+
+	const Palette palette = GetPaletteBC7(endpoints);
+	for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+	{
+		const uint32_t index = reader.Read(t == 0 ? 3 : 4);
+		for (uint32_t c = 0; c < 4; ++c)
+			rgba[t * 4 + c] = static_cast<uint8_t>(palette.colors[index][c]);
+	}
+}
+
+
+uint32_t GetBlockBytes(BlockFormat format)
+{
+	return format == BlockFormat::BC1 ? 8 : 16;
+}
+
+uint64_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height)
+{
+	const uint64_t blocksX = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+	const uint64_t blocksY = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+	return blocksX * blocksY * GetBlockBytes(format);
+}
+
+std::vector<uint8_t> CompressImage(const uint8_t* rgba,
+	uint32_t width,
+	uint32_t height,
+	BlockFormat format,
+	uint32_t threadCount)
+{
+	std::vector<uint8_t> blocks(GetCompressedSize(format, width, height), 0);
+	if (width == 0 || height == 0)
+		return blocks;
+
+	const uint32_t blocksX = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+	const uint32_t blocksY = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+	const uint32_t blockBytes = GetBlockBytes(format);
+	void (*compressBlock)(const uint8_t*, uint8_t*) = CompressBlockBC7;
+	if (format == BlockFormat::BC1)
+		compressBlock = CompressBlockBC1;
+	else if (format == BlockFormat::BC5)
+		compressBlock = CompressBlockBC5;
+
+	// the threads take the next row of blocks until there are none left
+	std::atomic<uint32_t> nextRow{ 0 };
+	const auto compressRows = [&]() {
+		std::array<uint8_t, BLOCK_TEXELS * 4> blockTexels{};
+		for (uint32_t by = nextRow++; by < blocksY; by = nextRow++)
+		{
+			for (uint32_t bx = 0; bx < blocksX; ++bx)
+			{
+				for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+				{
+					const uint32_t x = std::min(bx * BLOCK_DIM + t % BLOCK_DIM, width - 1);
+					const uint32_t y = std::min(by * BLOCK_DIM + t / BLOCK_DIM, height - 1);
+					const uint8_t* texel = rgba + (static_cast<uint64_t>(y) * width + x) * 4;
+					std::copy(texel, texel + 4, blockTexels.begin() + t * 4);
+				}
+				compressBlock(blockTexels.data(), &blocks[(static_cast<uint64_t>(by) * blocksX + bx) * blockBytes]);
+			}
+		}
+	};
+
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	threadCount = std::min(threadCount, blocksY);
+
+	std::vector<std::thread> threads{};
+	threads.reserve(threadCount - 1);
+	for (uint32_t t = 1; t < threadCount; ++t)
+		threads.emplace_back(compressRows);
+	compressRows();
+	for (auto& thread : threads)
+		thread.join();
+
+	return blocks;
+}
+
+std::vector<uint8_t> DecompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, BlockFormat format)
+{
+	std::vector<uint8_t> rgba(static_cast<uint64_t>(width) * height * 4, 0);
+	const uint32_t blocksX = (width + BLOCK_DIM - 1) / BLOCK_DIM;
+	const uint32_t blocksY = (height + BLOCK_DIM - 1) / BLOCK_DIM;
+	const uint32_t blockBytes = GetBlockBytes(format);
+
+	std::array<uint8_t, BLOCK_TEXELS * 4> blockTexels{};
+	for (uint32_t by = 0; by < blocksY; ++by)
+	{
+		for (uint32_t bx = 0; bx < blocksX; ++bx)
+		{
+			const uint8_t* block = blocks + (static_cast<uint64_t>(by) * blocksX + bx) * blockBytes;
+			if (format == BlockFormat::BC1)
+				DecompressBlockBC1(block, blockTexels.data());
+			else if (format == BlockFormat::BC5)
+				DecompressBlockBC5(block, blockTexels.data());
+			else
+				DecompressBlockBC7(block, blockTexels.data());
+
+			// the padding texels past the edges are dropped
+			for (uint32_t t = 0; t < BLOCK_TEXELS; ++t)
+			{
+				const uint32_t x = bx * BLOCK_DIM + t % BLOCK_DIM;
+				const uint32_t y = by * BLOCK_DIM + t / BLOCK_DIM;
+				if (x < width && y < height)
+				{
+					std::copy(blockTexels.begin() + t * 4,
+						blockTexels.begin() + t * 4 + 4,
+						rgba.begin() + static_cast<int64_t>((static_cast<uint64_t>(y) * width + x) * 4));
+				}
+			}
+		}
+	}
+
+	return rgba;
+}
+
+} // namespace utils
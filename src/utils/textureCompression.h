@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+
+namespace utils {
+
+constexpr uint32_t BLOCK_DIM = 4; // texels per side of a block
+
+// block compressed formats of the cooked textures
+enum class BlockFormat
+{
+	BC1, // rgb, 8 bytes per block (4 bits per texel), opaque
+	BC5, // two unorm channels (rg), 16 bytes per block, eg: the xy of tangent space normal maps
+	// rgba, 16 bytes per block (8 bits per texel), only mode 6 is written (one subset, 7.7.7.7 endpoints with a
+	// p-bit each, 4 bit indices), the mode that suits smooth blocks and alpha best
+	BC7,
+};
+
+uint32_t GetBlockBytes(BlockFormat format);
+// size of the blocks of an image, the partial blocks at the right and bottom edges are padded
+uint64_t GetCompressedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+// compresses rgba8 texels (row by row), the texels past the edges repeat the last column and row
+// the endpoints of a block are fitted along the principal axis of its texels and refined by least squares, the
+// indices of 4 texels are picked at once with sse2 (when it is available)
+// the rows of blocks are split between `threadCount` threads (0: one per core)
+std::vector<uint8_t> CompressImage(const uint8_t* rgba,
+	uint32_t width,
+	uint32_t height,
+	BlockFormat format,
+	uint32_t threadCount = 0);
+// decompresses the blocks written by `CompressImage()` to rgba8 (bc5: b = 0, a = 255), eg: to measure the error
+// only bc7 mode 6 is decoded, the blocks of the other modes are black
+std::vector<uint8_t> DecompressImage(const uint8_t* blocks, uint32_t width, uint32_t height, BlockFormat format);
+
+// a single block, `rgba` holds its 16 texels row by row
+void CompressBlockBC1(const uint8_t* rgba, uint8_t* block);
+void CompressBlockBC5(const uint8_t* rgba, uint8_t* block);
+void CompressBlockBC7(const uint8_t* rgba, uint8_t* block);
+
+} // namespace utils
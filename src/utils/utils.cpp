@@ -1,34 +1,327 @@
 #include "utils/utils.h"
 
+#include <cmath>
+#include <limits>
+#include <thread>
+#include <cstring>
 #include <utility>
+#include <fstream>
+#include <algorithm>
+#include <functional>
+#include <glm/gtc/packing.hpp>
 #include "core/core.h"
 #include "renderer/device.h"
 #include "renderer/commandPool.h"
 
 namespace utils {
 
-std::pair<std::vector<uint32_t>, std::vector<Vertex>> GetModelData(const std::vector<Vertex>& vertices)
+// size of the live allocations made by `CreateImage()` and `CreateBuffer()`
+static std::unordered_map<VkDeviceMemory, VkDeviceSize> s_Allocations{};
+static DeviceMemoryStats s_DeviceMemoryStats{};
+
+static void TrackAllocation(VkDeviceMemory memory, VkDeviceSize size)
+{
+	s_Allocations[memory] = size;
+	s_DeviceMemoryStats.allocatedBytes += size;
+	s_DeviceMemoryStats.peakBytes = std::max(s_DeviceMemoryStats.peakBytes, s_DeviceMemoryStats.allocatedBytes);
+	++s_DeviceMemoryStats.allocationCount;
+}
+
+static_assert(sizeof(Vertex) == 8 * sizeof(uint32_t), "the vertices are hashed and compared as 8 words");
+
+constexpr uint32_t WELD_EMPTY_SLOT = UINT32_MAX;
+constexpr size_t WELD_MIN_VERTICES_PER_THREAD = 1 << 16; // smaller inputs are welded on fewer threads
+
+// hashes the bits of the vertex, every word goes through a multiply and the result through a finalizer (murmur3)
+// so that vertices that differ in a single bit land in different slots
+static uint64_t HashVertex(const Vertex& vertex)
+{
+	uint32_t words[8];
+	std::memcpy(words, &vertex, sizeof(words));
+
+	uint64_t hash = 0x9e3779b97f4a7c15ull;
+	for (uint32_t word : words)
+		hash = (hash ^ word) * 0xff51afd7ed558ccdull;
+
+	hash ^= hash >> 33;
+	hash *= 0xc4ceb9fe1a85ec53ull;
+	hash ^= hash >> 33;
+	return hash;
+}
+
+static bool IsSameVertex(const Vertex& lhs, const Vertex& rhs)
+{
+	return std::memcmp(&lhs, &rhs, sizeof(Vertex)) == 0;
+}
+
+// smallest power of 2 that keeps the table at most half full
+static size_t WeldTableSize(size_t count)
+{
+	size_t size = 16;
+	while (size < count * 2)
+		size <<= 1;
+
+	return size;
+}
+
+// runs `fn(threadIndex)` on `threadCount` threads (the calling thread is one of them) and waits for all of them
+static void ParallelFor(uint32_t threadCount, const std::function<void(uint32_t)>& fn)
+{
+	std::vector<std::thread> threads{};
+	threads.reserve(threadCount - 1);
+	for (uint32_t t = 1; t < threadCount; ++t)
+		threads.emplace_back(fn, t);
+
+	fn(0);
+	for (auto& thread : threads)
+		thread.join();
+}
+
+static std::pair<std::vector<uint32_t>, std::vector<Vertex>> WeldVertices(const std::vector<Vertex>& vertices)
 {
-	std::unordered_map<Vertex, uint32_t> vertexLookup{};
-	std::vector<uint32_t> indices{};
+	std::vector<uint32_t> indices(vertices.size());
 	std::vector<Vertex> uniqueVertices{};
-	uint32_t i = 0;
+	uniqueVertices.reserve(vertices.size());
 
-	for (const auto& vertex : vertices)
+	// open addressing with linear probing, a slot holds the index of a unique vertex
+	std::vector<uint32_t> table(WeldTableSize(vertices.size()), WELD_EMPTY_SLOT);
+	const size_t mask = table.size() - 1;
+
+	for (size_t i = 0; i < vertices.size(); ++i)
 	{
-		if (vertexLookup.count(vertex) == 0)
+		const Vertex& vertex = vertices[i];
+		size_t slot = static_cast<size_t>(HashVertex(vertex)) & mask;
+		while (true)
+		{
+			uint32_t index = table[slot];
+			if (index == WELD_EMPTY_SLOT)
+			{
+				index = static_cast<uint32_t>(uniqueVertices.size());
+				table[slot] = index;
+				uniqueVertices.push_back(vertex);
+				indices[i] = index;
+				break;
+			}
+
+			if (IsSameVertex(uniqueVertices[index], vertex))
+			{
+				indices[i] = index;
+				break;
+			}
+
+			slot = (slot + 1) & mask;
+		}
+	}
+
+	return { indices, uniqueVertices };
+}
+
+// the vertices are split into `threadCount` partitions by their hash, a thread welds one partition into its own table
+// and finds the first occurrence of every vertex, the unique vertices are then numbered in the order of their first
+// occurrence, so the result is the same as the one of `WeldVertices()`
+static std::pair<std::vector<uint32_t>, std::vector<Vertex>> WeldVerticesParallel(const std::vector<Vertex>& vertices,
+	uint32_t threadCount)
+{
+	const size_t count = vertices.size();
+	const size_t chunkSize = (count + threadCount - 1) / threadCount;
+	auto chunkBegin = [count, chunkSize](uint32_t t) { return std::min(count, t * chunkSize); };
+
+	// the high bits pick the partition, the low bits the slot
+	std::vector<uint64_t> hashes(count);
+	std::vector<uint32_t> partitions(count);
+	std::vector<size_t> partitionCounts(static_cast<size_t>(threadCount) * threadCount, 0); // [chunk][partition]
+	ParallelFor(threadCount, [&](uint32_t t) {
+		size_t* counts = &partitionCounts[static_cast<size_t>(t) * threadCount];
+		for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
 		{
-			vertexLookup[vertex] = i;
-			uniqueVertices.push_back(vertex);
-			++i;
+			hashes[i] = HashVertex(vertices[i]);
+			partitions[i] = static_cast<uint32_t>((hashes[i] >> 32) % threadCount);
+			++counts[partitions[i]];
 		}
+	});
 
-		indices.push_back(vertexLookup[vertex]);
+	// a partition is stored contiguously, its vertices from the earlier chunks first, so they stay in input order
+	std::vector<size_t> partitionBegins(static_cast<size_t>(threadCount) + 1, 0);
+	std::vector<size_t> scatterOffsets(partitionCounts.size());
+	size_t offset = 0;
+	for (uint32_t p = 0; p < threadCount; ++p)
+	{
+		partitionBegins[p] = offset;
+		for (uint32_t t = 0; t < threadCount; ++t)
+		{
+			scatterOffsets[static_cast<size_t>(t) * threadCount + p] = offset;
+			offset += partitionCounts[static_cast<size_t>(t) * threadCount + p];
+		}
+	}
+	partitionBegins[threadCount] = offset;
+
+	std::vector<uint32_t> partitionedVertices(count);
+	ParallelFor(threadCount, [&](uint32_t t) {
+		size_t* offsets = &scatterOffsets[static_cast<size_t>(t) * threadCount];
+		for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+			partitionedVertices[offsets[partitions[i]]++] = static_cast<uint32_t>(i);
+	});
+
+	std::vector<uint32_t> firstOccurrence(count);
+	ParallelFor(threadCount, [&](uint32_t t) {
+		std::vector<uint32_t> table(WeldTableSize(partitionBegins[t + 1] - partitionBegins[t]), WELD_EMPTY_SLOT);
+		const size_t mask = table.size() - 1;
+		for (size_t j = partitionBegins[t]; j < partitionBegins[t + 1]; ++j)
+		{
+			const uint32_t i = partitionedVertices[j];
+			size_t slot = static_cast<size_t>(hashes[i]) & mask;
+			while (true)
+			{
+				const uint32_t first = table[slot];
+				if (first == WELD_EMPTY_SLOT)
+				{
+					table[slot] = i;
+					firstOccurrence[i] = i;
+					break;
+				}
+
+				if (hashes[first] == hashes[i] && IsSameVertex(vertices[first], vertices[i]))
+				{
+					firstOccurrence[i] = first;
+					break;
+				}
+
+				slot = (slot + 1) & mask;
+			}
+		}
+	});
+
+	// number the unique vertices, each thread counts the ones in its chunk, then offsets them by the earlier chunks
+	std::vector<uint32_t> uniqueCounts(threadCount, 0);
+	ParallelFor(threadCount, [&](uint32_t t) {
+		for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+			uniqueCounts[t] += firstOccurrence[i] == i ? 1 : 0;
+	});
+
+	std::vector<uint32_t> chunkOffsets(threadCount, 0);
+	uint32_t uniqueCount = 0;
+	for (uint32_t t = 0; t < threadCount; ++t)
+	{
+		chunkOffsets[t] = uniqueCount;
+		uniqueCount += uniqueCounts[t];
 	}
 
+	std::vector<uint32_t> indices(count);
+	std::vector<Vertex> uniqueVertices(uniqueCount);
+	ParallelFor(threadCount, [&](uint32_t t) {
+		uint32_t index = chunkOffsets[t];
+		for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+		{
+			if (firstOccurrence[i] != i)
+				continue;
+
+			uniqueVertices[index] = vertices[i];
+			indices[i] = index++;
+		}
+	});
+
+	// the first occurrence can be in an earlier chunk, so its index is only known after the pass above
+	// only the duplicates are written, the unique vertices are read by the other threads
+	ParallelFor(threadCount, [&](uint32_t t) {
+		for (size_t i = chunkBegin(t); i < chunkBegin(t + 1); ++i)
+		{
+			if (firstOccurrence[i] != i)
+				indices[i] = indices[firstOccurrence[i]];
+		}
+	});
+
 	return { indices, uniqueVertices };
 }
 
+std::pair<std::vector<uint32_t>, std::vector<Vertex>> GetModelData(const std::vector<Vertex>& vertices,
+	uint32_t threadCount)
+{
+	THROW(vertices.size() >= WELD_EMPTY_SLOT, "Too many vertices to weld: {}", vertices.size())
+
+	if (threadCount == 0)
+		threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+	threadCount = static_cast<uint32_t>(
+		std::min<size_t>(threadCount, std::max<size_t>(vertices.size() / WELD_MIN_VERTICES_PER_THREAD, 1)));
+
+	if (threadCount == 1)
+		return WeldVertices(vertices);
+
+	return WeldVerticesParallel(vertices, threadCount);
+}
+
+std::vector<glm::vec3> GetPositions(const std::vector<Vertex>& vertices)
+{
+	std::vector<glm::vec3> positions{};
+	positions.reserve(vertices.size());
+
+	for (const auto& vertex : vertices)
+		positions.push_back(vertex.pos);
+
+	return positions;
+}
+
+std::vector<CompactVertex> CompressVertices(const std::vector<Vertex>& vertices, VertexDecode& decode)
+{
+	glm::vec3 boundsMin{ std::numeric_limits<float>::max() };
+	glm::vec3 boundsMax{ std::numeric_limits<float>::lowest() };
+	for (const auto& vertex : vertices)
+	{
+		boundsMin = glm::min(boundsMin, vertex.pos);
+		boundsMax = glm::max(boundsMax, vertex.pos);
+	}
+
+	const glm::vec3 extent = vertices.empty() ? glm::vec3(1.0f) : boundsMax - boundsMin;
+	decode.offset = glm::vec4(vertices.empty() ? glm::vec3(0.0f) : boundsMin, 1.0f);
+	decode.scale = glm::vec4(extent, 0.0f);
+	// flat meshes have no extent along an axis, every position is then 0 on it
+	const glm::vec3 invExtent = glm::vec3(extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+		extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+		extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+	std::vector<CompactVertex> compactVertices{};
+	compactVertices.reserve(vertices.size());
+	for (const auto& vertex : vertices)
+	{
+		const glm::vec3 pos = glm::round(glm::clamp((vertex.pos - boundsMin) * invExtent, 0.0f, 1.0f) * 65535.0f);
+		const glm::vec2 normal = glm::round(OctahedralEncode(vertex.normal) * 32767.0f);
+
+		CompactVertex compactVertex{};
+		compactVertex.pos = glm::u16vec4(glm::u16vec3(pos), 0);
+		compactVertex.normal = glm::i16vec2(normal);
+		compactVertex.texCoord =
+			glm::u16vec2(glm::packHalf1x16(vertex.texCoord.x), glm::packHalf1x16(vertex.texCoord.y));
+		compactVertices.push_back(compactVertex);
+	}
+
+	return compactVertices;
+}
+
+std::vector<glm::u16vec4> GetPositions(const std::vector<CompactVertex>& vertices)
+{
+	std::vector<glm::u16vec4> positions{};
+	positions.reserve(vertices.size());
+
+	for (const auto& vertex : vertices)
+		positions.push_back(vertex.pos);
+
+	return positions;
+}
+
+glm::vec2 OctahedralEncode(const glm::vec3& normal)
+{
+	const float l1Norm = std::abs(normal.x) + std::abs(normal.y) + std::abs(normal.z);
+	if (l1Norm == 0.0f)
+		return glm::vec2(0.0f);
+
+	// project onto the octahedron, then fold the lower half over the diagonals
+	const glm::vec3 n = normal / l1Norm;
+	if (n.z >= 0.0f)
+		return glm::vec2(n.x, n.y);
+
+	return glm::vec2((1.0f - std::abs(n.y)) * (n.x >= 0.0f ? 1.0f : -1.0f),
+		(1.0f - std::abs(n.x)) * (n.y >= 0.0f ? 1.0f : -1.0f));
+}
+
 void CreateImage(uint32_t width,
 	uint32_t height,
 	uint32_t miplevels,
@@ -38,7 +331,9 @@ void CreateImage(uint32_t width,
 	VkImageUsageFlags usage,
 	VkMemoryPropertyFlags properties,
 	VkImage& image,
-	VkDeviceMemory& imageMemory)
+	VkDeviceMemory& imageMemory,
+	uint32_t arrayLayers,
+	VkImageCreateFlags flags)
 {
 	VkImageCreateInfo imgInfo{};
 	imgInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
@@ -47,14 +342,14 @@ void CreateImage(uint32_t width,
 	imgInfo.extent.height = height;
 	imgInfo.extent.depth = 1;
 	imgInfo.mipLevels = miplevels;
-	imgInfo.arrayLayers = 1;
+	imgInfo.arrayLayers = arrayLayers;
 	imgInfo.format = format;
 	imgInfo.tiling = tiling;
 	imgInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 	imgInfo.usage = usage;
 	imgInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
 	imgInfo.samples = numSamples;
-	imgInfo.flags = 0; // for sparse images
+	imgInfo.flags = flags; // eg: cube compatible, sparse images
 
 	THROW(vkCreateImage(Device::GetDevice(), &imgInfo, nullptr, &image) != VK_SUCCESS, "Failed to create image object!")
 
@@ -69,22 +364,29 @@ void CreateImage(uint32_t width,
 
 	THROW(vkAllocateMemory(Device::GetDevice(), &memAllocInfo, nullptr, &imageMemory) != VK_SUCCESS,
 		"Failed to allocate image memory!")
+	TrackAllocation(imageMemory, memRequirements.size);
 
 	vkBindImageMemory(Device::GetDevice(), image, imageMemory, 0);
 }
 
-VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t miplevels)
+VkImageView CreateImageView(VkImage image,
+	VkFormat format,
+	VkImageAspectFlags aspectFlags,
+	uint32_t miplevels,
+	VkImageViewType viewType,
+	uint32_t baseArrayLayer,
+	uint32_t layerCount)
 {
 	VkImageViewCreateInfo imgViewInfo{};
 	imgViewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
 	imgViewInfo.image = image;
 	imgViewInfo.format = format;
-	imgViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	imgViewInfo.viewType = viewType;
 	imgViewInfo.subresourceRange.aspectMask = aspectFlags;
 	imgViewInfo.subresourceRange.baseMipLevel = 0;
 	imgViewInfo.subresourceRange.levelCount = miplevels;
-	imgViewInfo.subresourceRange.baseArrayLayer = 0;
-	imgViewInfo.subresourceRange.layerCount = 1;
+	imgViewInfo.subresourceRange.baseArrayLayer = baseArrayLayer;
+	imgViewInfo.subresourceRange.layerCount = layerCount;
 
 	VkImageView imageView;
 	THROW(vkCreateImageView(Device::GetDevice(), &imgViewInfo, nullptr, &imageView) != VK_SUCCESS,
@@ -118,10 +420,43 @@ void CreateBuffer(VkDeviceSize size,
 
 	THROW(vkAllocateMemory(Device::GetDevice(), &allocMemory, nullptr, &bufferMemory) != VK_SUCCESS,
 		"Failed to allocate memory!")
+	TrackAllocation(bufferMemory, memRequirements.size);
 
 	vkBindBufferMemory(Device::GetDevice(), buffer, bufferMemory, 0);
 }
 
+VkDeviceMemory AllocateMemory(VkDeviceSize size, uint32_t memoryTypeBits, VkMemoryPropertyFlags properties)
+{
+	VkMemoryAllocateInfo allocMemory{};
+	allocMemory.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocMemory.allocationSize = size;
+	allocMemory.memoryTypeIndex = Device::FindMemoryType(Device::GetPhysicalDevice(), memoryTypeBits, properties);
+
+	VkDeviceMemory memory{};
+	THROW(vkAllocateMemory(Device::GetDevice(), &allocMemory, nullptr, &memory) != VK_SUCCESS,
+		"Failed to allocate memory!")
+	TrackAllocation(memory, size);
+	return memory;
+}
+
+void FreeMemory(VkDeviceMemory memory)
+{
+	auto it = s_Allocations.find(memory);
+	if (it != s_Allocations.end())
+	{
+		s_DeviceMemoryStats.allocatedBytes -= it->second;
+		--s_DeviceMemoryStats.allocationCount;
+		s_Allocations.erase(it);
+	}
+
+	vkFreeMemory(Device::GetDevice(), memory, nullptr);
+}
+
+DeviceMemoryStats GetDeviceMemoryStats()
+{
+	return s_DeviceMemoryStats;
+}
+
 VkCommandBuffer BeginSingleTimeCommands()
 {
 	VkCommandBufferAllocateInfo cmdBuffAllocInfo{};
@@ -195,127 +530,15 @@ void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t
 	EndSingleTimeCommands(cmdBuff);
 }
 
-void GenerateMipmaps(VkImage image, VkFormat format, int32_t width, int32_t height, uint32_t mipLevels)
+void CopyBufferToImage(VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy>& regions)
 {
-	// TODO: load mipmaps from a file instead of generating them
-
-	VkFormatProperties formatProperties;
-	vkGetPhysicalDeviceFormatProperties(Device::GetPhysicalDevice(), format, &formatProperties);
-	// check image format's support for linear filter
-	THROW(!(formatProperties.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT),
-		"Texture image format does not support linear blitting!");
-
 	VkCommandBuffer cmdBuff = BeginSingleTimeCommands();
-
-	VkImageMemoryBarrier imgBarrier{};
-	imgBarrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
-	imgBarrier.image = image;
-	imgBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	imgBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-	imgBarrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-	imgBarrier.subresourceRange.baseArrayLayer = 0;
-	imgBarrier.subresourceRange.layerCount = 1;
-	imgBarrier.subresourceRange.levelCount = 1;
-
-	int32_t mipWidth = width;
-	int32_t mipHeight = height;
-
-	for (uint32_t i = 1; i < mipLevels; ++i)
-	{
-		// transition the `i - 1` mip level to
-		// `VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL`
-		imgBarrier.subresourceRange.baseMipLevel = i - 1;
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-		imgBarrier.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-
-		vkCmdPipelineBarrier(cmdBuff,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			0,
-			0,
-			nullptr,
-			0,
-			nullptr,
-			1,
-			&imgBarrier);
-
-		// specify the region to be used in blit operation
-		// the src mip level is `i - 1`
-		// the dst mip level is `i`
-		VkImageBlit blit{};
-		blit.srcOffsets[0] = { 0, 0, 0 };
-		blit.srcOffsets[1] = { mipWidth, mipHeight, 1 };
-		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		blit.srcSubresource.mipLevel = i - 1;
-		blit.srcSubresource.baseArrayLayer = 0;
-		blit.srcSubresource.layerCount = 1;
-		blit.dstOffsets[0] = { 0, 0, 0 };
-		blit.dstOffsets[1] = { mipWidth > 1 ? mipWidth / 2 : 1, mipHeight > 1 ? mipHeight / 2 : 1, 1 };
-		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-		blit.dstSubresource.mipLevel = i;
-		blit.dstSubresource.baseArrayLayer = 0;
-		blit.dstSubresource.layerCount = 1;
-
-		vkCmdBlitImage(cmdBuff,
-			image,
-			VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-			image,
-			VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-			1,
-			&blit,
-			VK_FILTER_LINEAR);
-
-		// trasition the `i - 1` mip level to
-		// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL` all the sampling
-		// operations will wait on this transition to finish
-		imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
-		imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
-		imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-		vkCmdPipelineBarrier(cmdBuff,
-			VK_PIPELINE_STAGE_TRANSFER_BIT,
-			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-			0,
-			0,
-			nullptr,
-			0,
-			nullptr,
-			1,
-			&imgBarrier);
-
-		// one of the dimensions will reach 1 before the other, so keep it 1
-		// when it does (because the image is not a square)
-		if (mipWidth > 1)
-			mipWidth /= 2;
-
-		if (mipHeight > 1)
-			mipHeight /= 2;
-	}
-
-	// this barrier transitions the last mip level from
-	// `VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL` to
-	// `VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL` the loop doesnt handle
-	// this
-	imgBarrier.subresourceRange.baseMipLevel = mipLevels - 1;
-	imgBarrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-	imgBarrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-	imgBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-	imgBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-
-	vkCmdPipelineBarrier(cmdBuff,
-		VK_PIPELINE_STAGE_TRANSFER_BIT,
-		VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-		0,
-		0,
-		nullptr,
-		0,
-		nullptr,
-		1,
-		&imgBarrier);
-
+	vkCmdCopyBufferToImage(cmdBuff,
+		buffer,
+		image,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+		static_cast<uint32_t>(regions.size()),
+		regions.data());
 	EndSingleTimeCommands(cmdBuff);
 }
 
@@ -368,4 +591,89 @@ void TransitionImageLayout(VkImage image,
 	EndSingleTimeCommands(cmdBuff);
 }
 
+// the image data is stored uncompressed (deflate "stored" blocks), it only has to be readable, not small
+void WritePng(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba)
+{
+	THROW(rgba.size() != static_cast<size_t>(width) * height * 4, "The pixels don't match the size of the image!")
+
+	std::ofstream file{ path, std::ios::out | std::ios::binary | std::ios::trunc };
+	THROW(!file.is_open(), "Failed to open {}!", path)
+
+	auto crc32 = [](const uint8_t* data, size_t size, uint32_t crc) {
+		for (size_t i = 0; i < size; ++i)
+		{
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; ++bit)
+				crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1u)));
+		}
+		return crc;
+	};
+	auto appendU32 = [](std::vector<uint8_t>& out, uint32_t value) {
+		out.insert(out.end(),
+			{ static_cast<uint8_t>(value >> 24),
+				static_cast<uint8_t>(value >> 16),
+				static_cast<uint8_t>(value >> 8),
+				static_cast<uint8_t>(value) });
+	};
+	auto writeChunk = [&](const char* type, const std::vector<uint8_t>& data) {
+		std::vector<uint8_t> chunk{};
+		appendU32(chunk, static_cast<uint32_t>(data.size()));
+		chunk.insert(chunk.end(), type, type + 4);
+		chunk.insert(chunk.end(), data.begin(), data.end());
+		// the crc covers the type and the data
+		appendU32(chunk, ~crc32(chunk.data() + 4, chunk.size() - 4, 0xffffffffu));
+		file.write(reinterpret_cast<const char*>(chunk.data()), static_cast<std::streamsize>(chunk.size()));
+	};
+
+	// every row starts with its filter type (0 = none)
+	const size_t rowSize = static_cast<size_t>(width) * 4;
+	std::vector<uint8_t> raw{};
+	raw.reserve((rowSize + 1) * height);
+	for (uint32_t y = 0; y < height; ++y)
+	{
+		raw.push_back(0);
+		raw.insert(raw.end(), rgba.begin() + static_cast<ptrdiff_t>(y * rowSize),
+			rgba.begin() + static_cast<ptrdiff_t>((y + 1) * rowSize));
+	}
+
+	// zlib stream of stored blocks of at most 65535 bytes
+	std::vector<uint8_t> idat{ 0x78, 0x01 };
+	idat.reserve(raw.size() + raw.size() / 65535 * 5 + 16);
+	size_t offset = 0;
+	do
+	{
+		uint16_t blockSize = static_cast<uint16_t>(std::min<size_t>(raw.size() - offset, 65535));
+		bool last = offset + blockSize == raw.size();
+		idat.insert(idat.end(),
+			{ static_cast<uint8_t>(last ? 1 : 0),
+				static_cast<uint8_t>(blockSize),
+				static_cast<uint8_t>(blockSize >> 8),
+				static_cast<uint8_t>(~blockSize),
+				static_cast<uint8_t>(~blockSize >> 8) });
+		idat.insert(idat.end(), raw.begin() + static_cast<ptrdiff_t>(offset),
+			raw.begin() + static_cast<ptrdiff_t>(offset + blockSize));
+		offset += blockSize;
+	} while (offset < raw.size());
+
+	uint32_t a = 1;
+	uint32_t b = 0;
+	for (uint8_t byte : raw)
+	{
+		a = (a + byte) % 65521;
+		b = (b + a) % 65521;
+	}
+	appendU32(idat, (b << 16) | a);
+
+	std::vector<uint8_t> ihdr{};
+	appendU32(ihdr, width);
+	appendU32(ihdr, height);
+	ihdr.insert(ihdr.end(), { 8, 6, 0, 0, 0 }); // 8 bits per channel, rgba, deflate, no filter, no interlace
+
+	const uint8_t signature[]{ 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	file.write(reinterpret_cast<const char*>(signature), sizeof(signature));
+	writeChunk("IHDR", ihdr);
+	writeChunk("IDAT", idat);
+	writeChunk("IEND", {});
+}
+
 } // namespace utils
\ No newline at end of file
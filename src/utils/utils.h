@@ -1,5 +1,6 @@
 #pragma once
 
+#include <string>
 #include <vector>
 #include <unordered_map>
 #include <vulkan/vulkan.h>
@@ -8,7 +9,29 @@
 
 namespace utils {
 
-std::pair<std::vector<uint32_t>, std::vector<Vertex>> GetModelData(const std::vector<Vertex>& vertices);
+// the memory allocated with `CreateImage()`, `CreateBuffer()` and `AllocateMemory()`
+struct DeviceMemoryStats
+{
+	VkDeviceSize allocatedBytes = 0;
+	VkDeviceSize peakBytes = 0;
+	uint32_t allocationCount = 0;
+};
+
+// welds the identical vertices (bitwise equal, eg: 0.0 and -0.0 are different) of unindexed triangles
+// returns the indices and the unique vertices, in the order of their first occurrence
+// the vertices are welded on `threadCount` threads (0: one per core) when there are enough of them
+// the result doesn't depend on the number of threads
+std::pair<std::vector<uint32_t>, std::vector<Vertex>> GetModelData(const std::vector<Vertex>& vertices,
+	uint32_t threadCount = 1);
+// position only stream of the vertices (same indices)
+std::vector<glm::vec3> GetPositions(const std::vector<Vertex>& vertices);
+// quantizes the vertices (see `CompactVertex`), the positions relative to the bounds of `vertices`
+// `decode` receives the transform back to object space
+std::vector<CompactVertex> CompressVertices(const std::vector<Vertex>& vertices, VertexDecode& decode);
+// position only stream of the compact vertices (same indices)
+std::vector<glm::u16vec4> GetPositions(const std::vector<CompactVertex>& vertices);
+// octahedral encoding of a unit vector, the square [-1, 1]^2, (0, 0) for a zero vector
+glm::vec2 OctahedralEncode(const glm::vec3& normal);
 
 void CreateImage(uint32_t width,
 	uint32_t height,
@@ -19,9 +42,17 @@ void CreateImage(uint32_t width,
 	VkImageUsageFlags usage,
 	VkMemoryPropertyFlags properties,
 	VkImage& image,
-	VkDeviceMemory& imageMemory);
+	VkDeviceMemory& imageMemory,
+	uint32_t arrayLayers = 1,
+	VkImageCreateFlags flags = 0);
 
-VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t miplevels);
+VkImageView CreateImageView(VkImage image,
+	VkFormat format,
+	VkImageAspectFlags aspectFlags,
+	uint32_t miplevels,
+	VkImageViewType viewType = VK_IMAGE_VIEW_TYPE_2D,
+	uint32_t baseArrayLayer = 0,
+	uint32_t layerCount = 1);
 
 VkCommandBuffer BeginSingleTimeCommands();
 void EndSingleTimeCommands(VkCommandBuffer cmdBuff);
@@ -32,10 +63,16 @@ void CreateBuffer(VkDeviceSize size,
 	VkBuffer& buffer,
 	VkDeviceMemory& bufferMemory);
 
+// memory that isn't bound yet (eg: shared by several images), tracked like the memory of `CreateImage()`
+VkDeviceMemory AllocateMemory(VkDeviceSize size, uint32_t memoryTypeBits, VkMemoryPropertyFlags properties);
+// frees the memory of `CreateImage()`, `CreateBuffer()` and `AllocateMemory()`
+void FreeMemory(VkDeviceMemory memory);
+DeviceMemoryStats GetDeviceMemoryStats();
+
 void CopyBuffer(VkBuffer srcBuffer, VkBuffer dstBuffer, VkDeviceSize size);
 void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
-
-void GenerateMipmaps(VkImage image, VkFormat format, int32_t width, int32_t height, uint32_t mipLevels);
+// eg: every mip level of a texture in one copy, the image has to be in `VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL`
+void CopyBufferToImage(VkBuffer buffer, VkImage image, const std::vector<VkBufferImageCopy>& regions);
 
 void TransitionImageLayout(VkImage image,
 	VkFormat format,
@@ -43,4 +80,7 @@ void TransitionImageLayout(VkImage image,
 	VkImageLayout newLayout,
 	uint32_t miplevels);
 
+// `rgba` is tightly packed, 8 bits per channel, the first row is the top of the image
+void WritePng(const std::string& path, uint32_t width, uint32_t height, const std::vector<uint8_t>& rgba);
+
 } // namespace utils
\ No newline at end of file